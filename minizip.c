@@ -24,6 +24,10 @@
 
 /***************************************************************************/
 
+#define MINIZIP_LIST_BATCH  (64)
+
+/***************************************************************************/
+
 typedef struct minizip_opt_s {
     uint8_t     include_path;
     int16_t     compress_level;
@@ -46,6 +50,7 @@ typedef struct minizip_opt_s {
 int32_t minizip_banner(void);
 int32_t minizip_help(void);
 
+int32_t minizip_list_print(const mz_zip_file_lite *file_info);
 int32_t minizip_list(const char *path);
 
 int32_t minizip_add_entry_cb(void *handle, void *userdata, mz_zip_file *file_info);
@@ -71,7 +76,7 @@ int32_t minizip_banner(void)
 
 int32_t minizip_help(void)
 {
-    printf("Usage: minizip [-x][-d dir|-l|-e][-o][-f][-y][-c cp][-a][-j][-0 to -9][-b|-m][-k 512][-p pwd][-s] file.zip [files]\n\n" \
+    printf("Usage: minizip [-x][-d dir|-l|-e][-o][-f][-y][-c cp][-a][-j][-0 to -9][-b|-m|-t][-k 512][-p pwd][-s] file.zip [files]\n\n" \
            "  -x  Extract files\n" \
            "  -l  List files\n" \
            "  -d  Destination directory\n" \
@@ -92,22 +97,85 @@ int32_t minizip_help(void)
            "  -h  PKCS12 certificate path\n" \
            "  -w  PKCS12 certificate password\n" \
            "  -b  BZIP2 compression\n" \
-           "  -m  LZMA compression\n\n");
+           "  -m  LZMA compression\n" \
+           "  -t  ZSTD compression\n\n");
     return MZ_OK;
 }
 
 /***************************************************************************/
 
-int32_t minizip_list(const char *path)
+int32_t minizip_list_print(const mz_zip_file_lite *file_info)
 {
-    mz_zip_file *file_info = NULL;
     uint32_t ratio = 0;
     int16_t level = 0;
-    int32_t err = MZ_OK;
     struct tm tmu_date;
     const char *string_method = NULL;
     char crypt = ' ';
+
+    ratio = 0;
+    if (file_info->uncompressed_size > 0)
+        ratio = (uint32_t)((file_info->compressed_size * 100) / file_info->uncompressed_size);
+
+    /* Display a '*' if the file is encrypted */
+    if (file_info->flag & MZ_ZIP_FLAG_ENCRYPTED)
+        crypt = '*';
+    else
+        crypt = ' ';
+
+    switch (file_info->compression_method)
+    {
+    case MZ_COMPRESS_METHOD_STORE:
+        string_method = "Stored";
+        break;
+    case MZ_COMPRESS_METHOD_DEFLATE:
+        level = (int16_t)((file_info->flag & 0x6) / 2);
+        if (level == 0)
+            string_method = "Defl:N";
+        else if (level == 1)
+            string_method = "Defl:X";
+        else if ((level == 2) || (level == 3))
+            string_method = "Defl:F"; /* 2: fast , 3: extra fast */
+        else
+            string_method = "Defl:?";
+        break;
+    case MZ_COMPRESS_METHOD_BZIP2:
+        string_method = "BZip2";
+        break;
+    case MZ_COMPRESS_METHOD_LZMA:
+        string_method = "LZMA";
+        break;
+    case MZ_COMPRESS_METHOD_ZSTD:
+        string_method = "ZStd";
+        break;
+    default:
+        string_method = "?";
+    }
+
+    mz_zip_time_t_to_tm(file_info->modified_date, &tmu_date);
+
+    /* Print entry information */
+    printf("%12" PRId64 " %12" PRId64 "  %3" PRIu32 "%% %6s%c %8" PRIx32 " %2.2" PRIu32 \
+           "-%2.2" PRIu32 "-%2.2" PRIu32 " %2.2" PRIu32 ":%2.2" PRIu32 " %8.8" PRIx32 "   %s\n",
+            file_info->compressed_size, file_info->uncompressed_size, ratio,
+            string_method, crypt, file_info->external_fa,
+            (uint32_t)tmu_date.tm_mon + 1, (uint32_t)tmu_date.tm_mday,
+            (uint32_t)tmu_date.tm_year % 100,
+            (uint32_t)tmu_date.tm_hour, (uint32_t)tmu_date.tm_min,
+            file_info->crc, file_info->filename);
+    return MZ_OK;
+}
+
+int32_t minizip_list(const char *path)
+{
+    mz_zip_file_lite entries[MINIZIP_LIST_BATCH];
+    mz_zip_file *file_info = NULL;
+    uint64_t first = 0;
+    uint8_t table_built = 1;
+    int32_t count = 0;
+    int32_t i = 0;
+    int32_t err = MZ_OK;
     void *reader = NULL;
+    void *zip_handle = NULL;
 
 
     mz_zip_reader_create(&reader);
@@ -119,86 +187,74 @@ int32_t minizip_list(const char *path)
         return err;
     }
 
-    err = mz_zip_reader_goto_first_entry(reader);
-
-    if (err != MZ_OK && err != MZ_END_OF_LIST)
+    /* Entry info is read in batches from the packed entry table, if the table can't be built
+       because of a damaged central dir the entries are walked up to the bad one */
+    err = mz_zip_reader_get_zip_handle(reader, &zip_handle);
+    if (err == MZ_OK)
+        err = mz_zip_set_entry_table(zip_handle, 1);
+    if (err != MZ_OK)
     {
-        printf("Error %" PRId32 " going to first entry in archive\n", err);
-        mz_zip_reader_delete(&reader);
-        return err;
+        table_built = 0;
+        mz_zip_set_entry_table(zip_handle, 0);
+        err = mz_zip_reader_goto_first_entry(reader);
+
+        if (err != MZ_OK && err != MZ_END_OF_LIST)
+        {
+            printf("Error %" PRId32 " going to first entry in archive\n", err);
+            mz_zip_reader_delete(&reader);
+            return err;
+        }
     }
 
     printf("      Packed     Unpacked Ratio Method   Attribs Date     Time  CRC-32     Name\n");
     printf("      ------     -------- ----- ------   ------- ----     ----  ------     ----\n");
 
     /* Enumerate all entries in the archive */
-    do
+    if (!table_built)
     {
-        err = mz_zip_reader_entry_get_info(reader, &file_info);
-
-        if (err != MZ_OK)
+        while (err == MZ_OK)
         {
-            printf("Error %" PRId32 " getting entry info in archive\n", err);
-            break;
-        }
+            err = mz_zip_reader_entry_get_info(reader, &file_info);
+            if (err != MZ_OK)
+            {
+                printf("Error %" PRId32 " getting entry info in archive\n", err);
+                break;
+            }
 
-        ratio = 0;
-        if (file_info->uncompressed_size > 0)
-            ratio = (uint32_t)((file_info->compressed_size * 100) / file_info->uncompressed_size);
+            memset(entries, 0, sizeof(entries[0]));
+            entries[0].flag = file_info->flag;
+            entries[0].compression_method = file_info->compression_method;
+            entries[0].crc = file_info->crc;
+            entries[0].external_fa = file_info->external_fa;
+            entries[0].compressed_size = file_info->compressed_size;
+            entries[0].uncompressed_size = file_info->uncompressed_size;
+            entries[0].modified_date = file_info->modified_date;
+            entries[0].filename = file_info->filename;
+            minizip_list_print(&entries[0]);
+
+            err = mz_zip_reader_goto_next_entry(reader);
+            if (err != MZ_OK && err != MZ_END_OF_LIST)
+                printf("Error %" PRId32 " going to next entry in archive\n", err);
+        }
+    }
 
-        /* Display a '*' if the file is encrypted */
-        if (file_info->flag & MZ_ZIP_FLAG_ENCRYPTED)
-            crypt = '*';
-        else
-            crypt = ' ';
+    while (table_built && err == MZ_OK)
+    {
+        count = mz_zip_get_entries_info(zip_handle, first, MINIZIP_LIST_BATCH, entries);
 
-        switch (file_info->compression_method)
+        if (count < 0)
         {
-        case MZ_COMPRESS_METHOD_STORE:
-            string_method = "Stored";
+            if (count != MZ_END_OF_LIST)
+                printf("Error %" PRId32 " getting entry info in archive\n", count);
+            err = count;
             break;
-        case MZ_COMPRESS_METHOD_DEFLATE:
-            level = (int16_t)((file_info->flag & 0x6) / 2);
-            if (level == 0)
-                string_method = "Defl:N";
-            else if (level == 1)
-                string_method = "Defl:X";
-            else if ((level == 2) || (level == 3))
-                string_method = "Defl:F"; /* 2: fast , 3: extra fast */
-            else
-                string_method = "Defl:?";
-            break;
-        case MZ_COMPRESS_METHOD_BZIP2:
-            string_method = "BZip2";
-            break;
-        case MZ_COMPRESS_METHOD_LZMA:
-            string_method = "LZMA";
-            break;
-        default:
-            string_method = "?";
         }
 
-        mz_zip_time_t_to_tm(file_info->modified_date, &tmu_date);
+        first += count;
 
-        /* Print entry information */
-        printf("%12" PRId64 " %12" PRId64 "  %3" PRIu32 "%% %6s%c %8" PRIx32 " %2.2" PRIu32 \
-               "-%2.2" PRIu32 "-%2.2" PRIu32 " %2.2" PRIu32 ":%2.2" PRIu32 " %8.8" PRIx32 "   %s\n",
-                file_info->compressed_size, file_info->uncompressed_size, ratio,
-                string_method, crypt, file_info->external_fa,
-                (uint32_t)tmu_date.tm_mon + 1, (uint32_t)tmu_date.tm_mday,
-                (uint32_t)tmu_date.tm_year % 100,
-                (uint32_t)tmu_date.tm_hour, (uint32_t)tmu_date.tm_min,
-                file_info->crc, file_info->filename);
-
-        err = mz_zip_reader_goto_next_entry(reader);
-
-        if (err != MZ_OK && err != MZ_END_OF_LIST)
-        {
-            printf("Error %" PRId32 " going to next entry in archive\n", err);
-            break;
-        }
+        for (i = 0; i < count; i += 1)
+            minizip_list_print(&entries[i]);
     }
-    while (err == MZ_OK);
 
     mz_zip_reader_delete(&reader);
 
@@ -659,6 +715,12 @@ int main(int argc, const char *argv[])
                 options.compress_method = MZ_COMPRESS_METHOD_LZMA;
 #else
                 err = MZ_SUPPORT_ERROR;
+#endif
+            else if ((c == 't') || (c == 'T'))
+#ifdef HAVE_ZSTD
+                options.compress_method = MZ_COMPRESS_METHOD_ZSTD;
+#else
+                err = MZ_SUPPORT_ERROR;
 #endif
             else if ((c == 's') || (c == 'S'))
 #ifdef HAVE_WZAES
@@ -53,6 +53,7 @@
 #define MZ_OPEN_MODE_APPEND             (0x04)
 #define MZ_OPEN_MODE_CREATE             (0x08)
 #define MZ_OPEN_MODE_EXISTING           (0x10)
+#define MZ_OPEN_MODE_DIRECT             (0x20)
 
 /* MZ_SEEK */
 #define MZ_SEEK_SET                     (0)
@@ -64,6 +65,7 @@
 #define MZ_COMPRESS_METHOD_DEFLATE      (8)
 #define MZ_COMPRESS_METHOD_BZIP2        (12)
 #define MZ_COMPRESS_METHOD_LZMA         (14)
+#define MZ_COMPRESS_METHOD_ZSTD         (93)
 #define MZ_COMPRESS_METHOD_AES          (99)
 
 #define MZ_COMPRESS_LEVEL_DEFAULT       (-1)
@@ -83,6 +85,14 @@
 #define MZ_ZIP_FLAG_UTF8                (1 << 11)
 #define MZ_ZIP_FLAG_MASK_LOCAL_INFO     (1 << 13)
 
+/* MZ_ZIP_PATH */
+#define MZ_ZIP_PATH_FLAG_DUPLICATE      (1 << 0)
+#define MZ_ZIP_PATH_FLAG_COLLISION      (1 << 1)
+#define MZ_ZIP_PATH_FLAG_TRAVERSAL      (1 << 2)
+
+#define MZ_ZIP_PATH_CHECK_REJECT        (1)
+#define MZ_ZIP_PATH_CHECK_SKIP          (2)
+
 /* MZ_ZIP_EXTENSION */
 #define MZ_ZIP_EXTENSION_ZIP64          (0x0001)
 #define MZ_ZIP_EXTENSION_NTFS           (0x000a)
@@ -135,6 +145,11 @@
 #define MZ_ENCODING_CODEPAGE_950        (950)
 #define MZ_ENCODING_UTF8                (65001)
 
+/* MZ_PATH_GLOB */
+#define MZ_PATH_GLOB_EXCLUDE            (1 << 0)
+#define MZ_PATH_GLOB_IGNORE_CASE        (1 << 1)
+#define MZ_PATH_GLOB_WC                 (1 << 2)
+
 /* MZ_UTILITY */
 #define MZ_UNUSED(SYMBOL)               ((void)SYMBOL)
 
@@ -807,6 +807,22 @@ int unzLocateFile(unzFile file, const char *filename, unzFileNameComparer filena
 
     preserve_index = compat->entry_index;
 
+    if (filename_compare_func == NULL)
+    {
+        /* Use filename index to jump directly to the entry */
+        mz_zip_set_index(compat->handle, 1);
+        err = mz_zip_locate_entry(compat->handle, filename, 0);
+        if (err == MZ_OK)
+            err = mz_zip_entry_get_info(compat->handle, &file_info);
+        if ((err == MZ_OK) && (strcmp(filename, file_info->filename) == 0))
+            return MZ_OK;
+        if (err == MZ_END_OF_LIST)
+        {
+            compat->entry_index = preserve_index;
+            return err;
+        }
+    }
+
     err = mz_zip_goto_first_entry(compat->handle);
     while (err == MZ_OK)
     {
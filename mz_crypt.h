@@ -19,6 +19,7 @@ extern "C" {
 /***************************************************************************/
 
 uint32_t mz_crypt_crc32_update(uint32_t value, const uint8_t *buf, int32_t size);
+uint32_t mz_crypt_crc32_combine(uint32_t crc1, uint32_t crc2, int64_t len2);
 
 int32_t  mz_crypt_pbkdf2(uint8_t *password, int32_t password_length, uint8_t *salt,
             int32_t salt_length, int32_t iteration_count, uint8_t *key, int32_t key_length);
@@ -142,6 +142,506 @@ int32_t mz_path_compare_wc(const char *path, const char *wildcard, uint8_t ignor
     return MZ_OK;
 }
 
+/***************************************************************************/
+
+#define MZ_PATH_GLOB_TOKEN_CHAR         (0)
+#define MZ_PATH_GLOB_TOKEN_ANY          (1)
+#define MZ_PATH_GLOB_TOKEN_CLASS        (2)
+#define MZ_PATH_GLOB_TOKEN_STAR         (3)
+#define MZ_PATH_GLOB_TOKEN_STAR_ANY     (4)
+#define MZ_PATH_GLOB_TOKEN_GLOBSTAR     (5)     /* ** as a whole path component */
+
+#define MZ_PATH_GLOB_STATE_ADVANCE      (1 << 0)
+#define MZ_PATH_GLOB_STATE_LOOP         (1 << 1)
+
+typedef struct mz_path_glob_token_s {
+    uint8_t  type;
+    uint8_t  value;                 /* folded character */
+    int32_t  class_index;
+} mz_path_glob_token;
+
+typedef struct mz_path_glob_pattern_s {
+    mz_path_glob_token *tokens;
+    int32_t  token_count;
+    uint8_t  (*classes)[32];        /* bitmap of folded characters for each class */
+    int32_t  class_count;
+    int32_t  prefix_len;            /* number of leading character tokens */
+    int32_t  flags;
+} mz_path_glob_pattern;
+
+typedef struct mz_path_glob_s {
+    mz_path_glob_pattern *patterns;
+    int32_t  pattern_count;
+    int32_t  include_count;
+    char     *prefix;
+    int32_t  prefix_len;
+    uint8_t  prefix_ignore_case;
+    uint8_t  *states;               /* current and next state sets used while matching */
+    int32_t  states_size;
+} mz_path_glob;
+
+/***************************************************************************/
+
+static uint8_t mz_path_glob_fold(uint8_t c, int32_t flags)
+{
+    /* Ignore differences in path slashes on platforms */
+    if (c == '\\')
+        return '/';
+    if (flags & MZ_PATH_GLOB_IGNORE_CASE)
+        return (uint8_t)tolower(c);
+    return c;
+}
+
+static void mz_path_glob_class_set(uint8_t *bitmap, uint8_t c, int32_t flags)
+{
+    c = mz_path_glob_fold(c, flags);
+    bitmap[c >> 3] |= (uint8_t)(1 << (c & 7));
+}
+
+static const char *mz_path_glob_compile_class(const char *pattern, uint8_t *bitmap, int32_t flags)
+{
+    const char *p = pattern + 1;
+    uint8_t negate = 0;
+    uint8_t start = 0;
+    uint8_t end = 0;
+    int32_t c = 0;
+    int32_t i = 0;
+
+    memset(bitmap, 0, 32);
+
+    if (*p == '!' || *p == '^')
+    {
+        negate = 1;
+        p += 1;
+    }
+
+    /* Closing bracket is literal when it is the first character of the class */
+    do
+    {
+        if (*p == 0)
+            return NULL;
+
+        start = (uint8_t)*p;
+        end = start;
+        if (*(p + 1) == '-' && *(p + 2) != ']' && *(p + 2) != 0)
+        {
+            end = (uint8_t)*(p + 2);
+            p += 2;
+        }
+        p += 1;
+
+        for (c = start; c <= end; c += 1)
+            mz_path_glob_class_set(bitmap, (uint8_t)c, flags);
+    }
+    while (*p != ']');
+
+    if (negate)
+    {
+        for (i = 0; i < 32; i += 1)
+            bitmap[i] = (uint8_t)~bitmap[i];
+    }
+
+    /* Classes never match a path slash, just like ? */
+    bitmap['/' >> 3] &= (uint8_t)~(1 << ('/' & 7));
+
+    return p + 1;
+}
+
+static void mz_path_glob_pattern_free(mz_path_glob_pattern *compiled)
+{
+    if (compiled->tokens != NULL)
+        MZ_FREE(compiled->tokens);
+    if (compiled->classes != NULL)
+        MZ_FREE(compiled->classes);
+    memset(compiled, 0, sizeof(mz_path_glob_pattern));
+}
+
+static int32_t mz_path_glob_compile(mz_path_glob_pattern *compiled, const char *pattern, int32_t flags)
+{
+    mz_path_glob_token *token = NULL;
+    const char *p = pattern;
+    const char *class_end = NULL;
+    const char *star = NULL;
+    int32_t pattern_len = 0;
+    int32_t class_max = 0;
+    uint8_t type = 0;
+
+    memset(compiled, 0, sizeof(mz_path_glob_pattern));
+    compiled->flags = flags;
+
+    pattern_len = (int32_t)strlen(pattern);
+    for (p = pattern; *p != 0; p += 1)
+    {
+        if (*p == '[')
+            class_max += 1;
+    }
+
+    /* Each character in the pattern produces at most one token */
+    compiled->tokens = (mz_path_glob_token *)MZ_ALLOC((pattern_len + 1) * sizeof(mz_path_glob_token));
+    compiled->classes = (uint8_t (*)[32])MZ_ALLOC((class_max + 1) * 32);
+    if (compiled->tokens == NULL || compiled->classes == NULL)
+    {
+        mz_path_glob_pattern_free(compiled);
+        return MZ_MEM_ERROR;
+    }
+
+    p = pattern;
+    while (*p != 0)
+    {
+        if (*p == '*')
+        {
+            type = MZ_PATH_GLOB_TOKEN_STAR;
+            if ((flags & MZ_PATH_GLOB_WC) || (*(p + 1) == '*'))
+                type = MZ_PATH_GLOB_TOKEN_STAR_ANY;
+            star = p;
+            while (*p == '*')
+                p += 1;
+
+            /* Whole path component of ** matches zero or more directories */
+            if (!(flags & MZ_PATH_GLOB_WC) && (p - star > 1) && (*p == '/' || *p == '\\') &&
+                (star == pattern || *(star - 1) == '/' || *(star - 1) == '\\'))
+                type = MZ_PATH_GLOB_TOKEN_GLOBSTAR;
+
+            /* Consecutive stars are the same as the widest one */
+            if (token != NULL && (token->type == MZ_PATH_GLOB_TOKEN_STAR ||
+                token->type == MZ_PATH_GLOB_TOKEN_STAR_ANY))
+            {
+                if (type == MZ_PATH_GLOB_TOKEN_STAR_ANY)
+                    token->type = type;
+                continue;
+            }
+
+            token = &compiled->tokens[compiled->token_count++];
+            token->type = type;
+            continue;
+        }
+
+        token = &compiled->tokens[compiled->token_count++];
+
+        if (!(flags & MZ_PATH_GLOB_WC))
+        {
+            if (*p == '?')
+            {
+                token->type = MZ_PATH_GLOB_TOKEN_ANY;
+                p += 1;
+                continue;
+            }
+            if (*p == '[')
+            {
+                class_end = mz_path_glob_compile_class(p, compiled->classes[compiled->class_count], flags);
+                if (class_end != NULL)
+                {
+                    token->type = MZ_PATH_GLOB_TOKEN_CLASS;
+                    token->class_index = compiled->class_count++;
+                    p = class_end;
+                    continue;
+                }
+                /* Unterminated class is treated as a literal bracket */
+            }
+        }
+
+        token->type = MZ_PATH_GLOB_TOKEN_CHAR;
+        token->value = mz_path_glob_fold((uint8_t)*p, flags);
+        p += 1;
+    }
+
+    while (compiled->prefix_len < compiled->token_count &&
+        compiled->tokens[compiled->prefix_len].type == MZ_PATH_GLOB_TOKEN_CHAR)
+        compiled->prefix_len += 1;
+
+    return MZ_OK;
+}
+
+static void mz_path_glob_closure(const mz_path_glob_pattern *compiled, uint8_t *states)
+{
+    int32_t i = 0;
+
+    /* Stars can match nothing so the token after them is also reachable */
+    for (i = compiled->prefix_len; i < compiled->token_count; i += 1)
+    {
+        if (states[i] == 0)
+            continue;
+        if (compiled->tokens[i].type == MZ_PATH_GLOB_TOKEN_STAR ||
+            compiled->tokens[i].type == MZ_PATH_GLOB_TOKEN_STAR_ANY ||
+            compiled->tokens[i].type == MZ_PATH_GLOB_TOKEN_GLOBSTAR)
+            states[i + 1] |= states[i];
+        /* Slash after ** is skipped too when it has not matched any directory yet */
+        if (compiled->tokens[i].type == MZ_PATH_GLOB_TOKEN_GLOBSTAR &&
+            (states[i] & MZ_PATH_GLOB_STATE_ADVANCE))
+            states[i + 2] |= MZ_PATH_GLOB_STATE_ADVANCE;
+    }
+}
+
+static int32_t mz_path_glob_match_pattern(mz_path_glob *glob, const mz_path_glob_pattern *compiled, const char *path)
+{
+    const mz_path_glob_token *token = NULL;
+    const uint8_t *p = (const uint8_t *)path;
+    uint8_t *current = NULL;
+    uint8_t *next = NULL;
+    uint8_t *swap = NULL;
+    uint8_t active = 0;
+    uint8_t matched = 0;
+    uint8_t c = 0;
+    int32_t count = compiled->token_count;
+    int32_t i = 0;
+
+
+    /* Compare literal prefix without any state tracking */
+    for (i = 0; i < compiled->prefix_len; i += 1, p += 1)
+    {
+        if (*p == 0 || mz_path_glob_fold(*p, compiled->flags) != compiled->tokens[i].value)
+            return MZ_EXIST_ERROR;
+    }
+
+    if (compiled->prefix_len == count)
+        return (*p == 0) ? MZ_OK : MZ_EXIST_ERROR;
+
+    /* Single trailing star only has to check the remaining characters for slashes */
+    if (compiled->prefix_len + 1 == count)
+    {
+        if (compiled->tokens[compiled->prefix_len].type == MZ_PATH_GLOB_TOKEN_STAR_ANY)
+            return MZ_OK;
+        if (compiled->tokens[compiled->prefix_len].type == MZ_PATH_GLOB_TOKEN_STAR)
+            return (strpbrk((const char *)p, "/\\") == NULL) ? MZ_OK : MZ_EXIST_ERROR;
+    }
+
+    /* Simulate all positions in the pattern at once to avoid backtracking */
+    current = glob->states;
+    next = glob->states + count + 1;
+    memset(current, 0, count + 1);
+    current[compiled->prefix_len] = MZ_PATH_GLOB_STATE_ADVANCE;
+    mz_path_glob_closure(compiled, current);
+
+    for (; *p != 0; p += 1)
+    {
+        c = mz_path_glob_fold(*p, compiled->flags);
+        memset(next, 0, count + 1);
+        active = 0;
+
+        for (i = compiled->prefix_len; i < count; i += 1)
+        {
+            if (current[i] == 0)
+                continue;
+
+            token = &compiled->tokens[i];
+            matched = 0;
+
+            switch (token->type)
+            {
+            case MZ_PATH_GLOB_TOKEN_STAR_ANY:
+            case MZ_PATH_GLOB_TOKEN_GLOBSTAR:
+                next[i] |= MZ_PATH_GLOB_STATE_LOOP;
+                active = 1;
+                break;
+            case MZ_PATH_GLOB_TOKEN_STAR:
+                if (c != '/')
+                {
+                    next[i] |= MZ_PATH_GLOB_STATE_LOOP;
+                    active = 1;
+                }
+                break;
+            case MZ_PATH_GLOB_TOKEN_ANY:
+                matched = (c != '/');
+                break;
+            case MZ_PATH_GLOB_TOKEN_CLASS:
+                matched = (compiled->classes[token->class_index][c >> 3] & (1 << (c & 7))) != 0;
+                break;
+            default:
+                matched = (token->value == c);
+                break;
+            }
+
+            if (matched)
+            {
+                next[i + 1] |= MZ_PATH_GLOB_STATE_ADVANCE;
+                active = 1;
+            }
+        }
+
+        if (!active)
+            return MZ_EXIST_ERROR;
+
+        mz_path_glob_closure(compiled, next);
+
+        swap = current;
+        current = next;
+        next = swap;
+    }
+
+    if (current[count] != 0)
+        return MZ_OK;
+
+    /* Like mz_path_compare_wc, reaching the end of the path right at a star is a match */
+    if (compiled->flags & MZ_PATH_GLOB_WC)
+    {
+        for (i = compiled->prefix_len; i < count; i += 1)
+        {
+            if ((compiled->tokens[i].type == MZ_PATH_GLOB_TOKEN_STAR_ANY) &&
+                (current[i] & MZ_PATH_GLOB_STATE_ADVANCE))
+                return MZ_OK;
+        }
+    }
+
+    return MZ_EXIST_ERROR;
+}
+
+int32_t mz_path_glob_add(void *handle, const char *pattern, int32_t flags)
+{
+    mz_path_glob *glob = (mz_path_glob *)handle;
+    mz_path_glob_pattern *patterns = NULL;
+    mz_path_glob_pattern *compiled = NULL;
+    uint8_t *states = NULL;
+    int32_t prefix_len = 0;
+    int32_t err = MZ_OK;
+    int32_t i = 0;
+
+
+    if (glob == NULL || pattern == NULL)
+        return MZ_PARAM_ERROR;
+
+    patterns = (mz_path_glob_pattern *)MZ_ALLOC((glob->pattern_count + 1) * sizeof(mz_path_glob_pattern));
+    if (patterns == NULL)
+        return MZ_MEM_ERROR;
+    if (glob->patterns != NULL)
+    {
+        memcpy(patterns, glob->patterns, glob->pattern_count * sizeof(mz_path_glob_pattern));
+        MZ_FREE(glob->patterns);
+    }
+    glob->patterns = patterns;
+
+    compiled = &glob->patterns[glob->pattern_count];
+    err = mz_path_glob_compile(compiled, pattern, flags);
+    if (err != MZ_OK)
+        return err;
+
+    if (compiled->token_count + 1 > glob->states_size)
+    {
+        states = (uint8_t *)MZ_ALLOC((compiled->token_count + 1) * 2);
+        if (states == NULL)
+        {
+            mz_path_glob_pattern_free(compiled);
+            return MZ_MEM_ERROR;
+        }
+        if (glob->states != NULL)
+            MZ_FREE(glob->states);
+        glob->states = states;
+        glob->states_size = compiled->token_count + 1;
+    }
+
+    glob->pattern_count += 1;
+
+    if (flags & MZ_PATH_GLOB_EXCLUDE)
+        return MZ_OK;
+
+    /* Keep only the part of the literal prefix shared by all include patterns */
+    if (glob->include_count == 0)
+    {
+        glob->prefix = (char *)MZ_ALLOC(compiled->prefix_len + 1);
+        if (glob->prefix == NULL)
+            return MZ_MEM_ERROR;
+        for (i = 0; i < compiled->prefix_len; i += 1)
+            glob->prefix[i] = (char)compiled->tokens[i].value;
+        prefix_len = compiled->prefix_len;
+    }
+    else
+    {
+        while (prefix_len < glob->prefix_len && prefix_len < compiled->prefix_len &&
+            glob->prefix[prefix_len] == (char)compiled->tokens[prefix_len].value)
+            prefix_len += 1;
+    }
+
+    glob->prefix[prefix_len] = 0;
+    glob->prefix_len = prefix_len;
+    if (flags & MZ_PATH_GLOB_IGNORE_CASE)
+        glob->prefix_ignore_case = 1;
+    glob->include_count += 1;
+    return MZ_OK;
+}
+
+int32_t mz_path_glob_match(void *handle, const char *path)
+{
+    mz_path_glob *glob = (mz_path_glob *)handle;
+    mz_path_glob_pattern *compiled = NULL;
+    uint8_t included = 0;
+    int32_t i = 0;
+
+    if (glob == NULL || path == NULL)
+        return MZ_PARAM_ERROR;
+
+    included = (glob->include_count == 0);
+    for (i = 0; (i < glob->pattern_count) && !included; i += 1)
+    {
+        compiled = &glob->patterns[i];
+        if (compiled->flags & MZ_PATH_GLOB_EXCLUDE)
+            continue;
+        if (mz_path_glob_match_pattern(glob, compiled, path) == MZ_OK)
+            included = 1;
+    }
+
+    if (!included)
+        return MZ_EXIST_ERROR;
+
+    for (i = 0; i < glob->pattern_count; i += 1)
+    {
+        compiled = &glob->patterns[i];
+        if (!(compiled->flags & MZ_PATH_GLOB_EXCLUDE))
+            continue;
+        if (mz_path_glob_match_pattern(glob, compiled, path) == MZ_OK)
+            return MZ_EXIST_ERROR;
+    }
+
+    return MZ_OK;
+}
+
+int32_t mz_path_glob_get_prefix(void *handle, const char **prefix, uint8_t *ignore_case)
+{
+    mz_path_glob *glob = (mz_path_glob *)handle;
+    if (glob == NULL || prefix == NULL)
+        return MZ_PARAM_ERROR;
+    *prefix = (glob->prefix != NULL) ? glob->prefix : "";
+    if (ignore_case != NULL)
+        *ignore_case = glob->prefix_ignore_case;
+    return MZ_OK;
+}
+
+void *mz_path_glob_create(void **handle)
+{
+    mz_path_glob *glob = NULL;
+
+    glob = (mz_path_glob *)MZ_ALLOC(sizeof(mz_path_glob));
+    if (glob != NULL)
+        memset(glob, 0, sizeof(mz_path_glob));
+    if (handle != NULL)
+        *handle = glob;
+
+    return glob;
+}
+
+void mz_path_glob_delete(void **handle)
+{
+    mz_path_glob *glob = NULL;
+    int32_t i = 0;
+
+    if (handle == NULL)
+        return;
+    glob = (mz_path_glob *)*handle;
+    if (glob != NULL)
+    {
+        for (i = 0; i < glob->pattern_count; i += 1)
+            mz_path_glob_pattern_free(&glob->patterns[i]);
+        if (glob->patterns != NULL)
+            MZ_FREE(glob->patterns);
+        if (glob->prefix != NULL)
+            MZ_FREE(glob->prefix);
+        if (glob->states != NULL)
+            MZ_FREE(glob->states);
+        MZ_FREE(glob);
+    }
+    *handle = NULL;
+}
+
+/***************************************************************************/
+
 int32_t mz_path_resolve(const char *path, char *output, int32_t max_output)
 {
     const char *source = path;
@@ -28,7 +28,7 @@ extern "C" {
 #  define MZ_VERSION_MADEBY_HOST_SYSTEM (MZ_HOST_SYSTEM_WINDOWS_NTFS)
 #endif
 
-#if defined(HAVE_LZMA)
+#if defined(HAVE_LZMA) || defined(HAVE_ZSTD)
 #  define MZ_VERSION_MADEBY_ZIP_VERSION (63)
 #elif defined(HAVE_WZAES)
 #  define MZ_VERSION_MADEBY_ZIP_VERSION (51)
@@ -80,6 +80,23 @@ int32_t mz_path_convert_slashes(char *path, char slash);
 int32_t mz_path_compare_wc(const char *path, const char *wildcard, uint8_t ignore_case);
 /* Compare two paths with wildcard */
 
+void *  mz_path_glob_create(void **handle);
+/* Create compiled set of include and exclude patterns */
+
+void    mz_path_glob_delete(void **handle);
+/* Delete compiled set of patterns */
+
+int32_t mz_path_glob_add(void *handle, const char *pattern, int32_t flags);
+/* Compiles and adds a pattern supporting *, **, ? and [] classes, or only * as in mz_path_compare_wc
+   when MZ_PATH_GLOB_WC is set, ** followed by a slash as a whole path component also matches no
+   directory at all */
+
+int32_t mz_path_glob_match(void *handle, const char *path);
+/* Checks whether the path matches any include pattern, or there are none, and no exclude pattern */
+
+int32_t mz_path_glob_get_prefix(void *handle, const char **prefix, uint8_t *ignore_case);
+/* Gets the literal prefix that all paths matching the include patterns begin with */
+
 int32_t mz_path_resolve(const char *path, char *target, int32_t max_target);
 /* Resolves path */
 
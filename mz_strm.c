@@ -44,6 +44,39 @@ int32_t mz_stream_read(void *stream, void *buf, int32_t size)
     return strm->vtbl->read(strm, buf, size);
 }
 
+int32_t mz_stream_read_ptr(void *stream, const void **ptr, int32_t size)
+{
+    /* Lends up to size bytes at the current position without copying, the bytes stay valid until
+       the next read, seek or close and are only consumed when released */
+    mz_stream *strm = (mz_stream *)stream;
+    if (strm == NULL || strm->vtbl == NULL || strm->vtbl->read_ptr == NULL)
+        return MZ_SUPPORT_ERROR;
+    if (mz_stream_is_open(stream) != MZ_OK)
+        return MZ_STREAM_ERROR;
+    return strm->vtbl->read_ptr(strm, ptr, size);
+}
+
+int32_t mz_stream_release(void *stream, int32_t size)
+{
+    mz_stream *strm = (mz_stream *)stream;
+    if (strm == NULL || strm->vtbl == NULL || strm->vtbl->release == NULL)
+        return MZ_SUPPORT_ERROR;
+    return strm->vtbl->release(strm, size);
+}
+
+int32_t mz_stream_read_at(void *stream, int64_t offset, void *buf, int32_t size)
+{
+    /* Reads at an offset without moving the stream position so it can be shared between threads */
+    mz_stream *strm = (mz_stream *)stream;
+    if (strm == NULL || strm->vtbl == NULL || strm->vtbl->read_at == NULL)
+        return MZ_SUPPORT_ERROR;
+    if (mz_stream_is_open(stream) != MZ_OK)
+        return MZ_STREAM_ERROR;
+    if (offset < 0)
+        return MZ_PARAM_ERROR;
+    return strm->vtbl->read_at(strm, offset, buf, size);
+}
+
 static int32_t mz_stream_read_value(void *stream, uint64_t *value, int32_t len)
 {
     uint8_t buf[8];
@@ -171,6 +204,34 @@ int32_t mz_stream_write_uint64(void *stream, uint64_t value)
     return mz_stream_write_value(stream, value, sizeof(uint64_t));
 }
 
+int32_t mz_stream_writev(void *stream, const mz_stream_iovec *iov, int32_t iov_count)
+{
+    /* Writes the buffers in order as one write where the stream supports it, returns the
+       total number of bytes written */
+    mz_stream *strm = (mz_stream *)stream;
+    int32_t total_written = 0;
+    int32_t written = 0;
+    int32_t i = 0;
+
+    if (strm == NULL || strm->vtbl == NULL || iov == NULL || iov_count < 0)
+        return MZ_PARAM_ERROR;
+    if (mz_stream_is_open(stream) != MZ_OK)
+        return MZ_STREAM_ERROR;
+    if (strm->vtbl->writev != NULL && iov_count <= MZ_STREAM_IOV_MAX)
+        return strm->vtbl->writev(strm, iov, iov_count);
+
+    for (i = 0; i < iov_count; i += 1)
+    {
+        written = mz_stream_write(stream, iov[i].buf, iov[i].size);
+        if (written < 0)
+            return written;
+        total_written += written;
+        if (written != iov[i].size)
+            break;
+    }
+    return total_written;
+}
+
 int32_t mz_stream_copy(void *target, void *source, int32_t len)
 {
     return mz_stream_copy_stream(target, NULL, source, NULL, len);
@@ -238,6 +299,34 @@ int32_t mz_stream_copy_stream_to_end(void *target, mz_stream_write_cb write_cb,
     return MZ_OK;
 }
 
+int32_t mz_stream_copy_from(void *target, void *source, int32_t size)
+{
+    /* Copies up to size bytes from the source position to the target position without passing them
+       through user memory, returns the number of bytes copied or MZ_SUPPORT_ERROR if the streams
+       can't do it so the caller can fall back to reading and writing */
+    mz_stream *strm = (mz_stream *)target;
+    if (strm == NULL || strm->vtbl == NULL || strm->vtbl->copy_from == NULL)
+        return MZ_SUPPORT_ERROR;
+    if (mz_stream_is_open(target) != MZ_OK || mz_stream_is_open(source) != MZ_OK)
+        return MZ_STREAM_ERROR;
+    if (size <= 0)
+        return 0;
+    return strm->vtbl->copy_from(strm, source, size);
+}
+
+int32_t mz_stream_copy_to(void *source, void *target, int32_t size)
+{
+    /* Source side of mz_stream_copy_from, called once the target chain reaches its file stream */
+    mz_stream *strm = (mz_stream *)source;
+    if (strm == NULL || strm->vtbl == NULL || strm->vtbl->copy_to == NULL)
+        return MZ_SUPPORT_ERROR;
+    if (mz_stream_is_open(source) != MZ_OK)
+        return MZ_STREAM_ERROR;
+    if (size <= 0)
+        return 0;
+    return strm->vtbl->copy_to(strm, target, size);
+}
+
 int64_t mz_stream_tell(void *stream)
 {
     mz_stream *strm = (mz_stream *)stream;
@@ -467,10 +556,27 @@ typedef struct mz_stream_raw_s {
     int64_t     total_in;
     int64_t     total_out;
     int64_t     max_total_in;
+    const void  *prefix;        /* written to the base ahead of the first data */
+    int32_t     prefix_size;
 } mz_stream_raw;
 
 /***************************************************************************/
 
+static int32_t mz_stream_raw_write_prefix(void *stream)
+{
+    mz_stream_raw *raw = (mz_stream_raw *)stream;
+    int32_t prefix_size = raw->prefix_size;
+
+    if (prefix_size == 0)
+        return MZ_OK;
+    raw->prefix_size = 0;
+    if (mz_stream_write(raw->stream.base, raw->prefix, prefix_size) != prefix_size)
+        return MZ_WRITE_ERROR;
+    return MZ_OK;
+}
+
+/***************************************************************************/
+
 int32_t mz_stream_raw_open(void *stream, const char *path, int32_t mode)
 {
     MZ_UNUSED(stream);
@@ -509,11 +615,47 @@ int32_t mz_stream_raw_read(void *stream, void *buf, int32_t size)
     return read;
 }
 
+int32_t mz_stream_raw_read_ptr(void *stream, const void **ptr, int32_t size)
+{
+    mz_stream_raw *raw = (mz_stream_raw *)stream;
+    int32_t bytes_to_read = size;
+
+    if (raw->max_total_in > 0)
+    {
+        if ((int64_t)bytes_to_read > (raw->max_total_in - raw->total_in))
+            bytes_to_read = (int32_t)(raw->max_total_in - raw->total_in);
+    }
+
+    return mz_stream_read_ptr(raw->stream.base, ptr, bytes_to_read);
+}
+
+int32_t mz_stream_raw_release(void *stream, int32_t size)
+{
+    mz_stream_raw *raw = (mz_stream_raw *)stream;
+    int32_t err = MZ_OK;
+
+    err = mz_stream_release(raw->stream.base, size);
+    if (err == MZ_OK)
+    {
+        raw->total_in += size;
+        raw->total_out += size;
+    }
+    return err;
+}
+
 int32_t mz_stream_raw_write(void *stream, const void *buf, int32_t size)
 {
     mz_stream_raw *raw = (mz_stream_raw *)stream;
+    mz_stream_iovec iov;
     int32_t written = 0;
 
+    if (raw->prefix_size > 0)
+    {
+        iov.buf = buf;
+        iov.size = size;
+        return mz_stream_raw_writev(stream, &iov, 1);
+    }
+
     written = mz_stream_write(raw->stream.base, buf, size);
 
     if (written > 0)
@@ -525,15 +667,106 @@ int32_t mz_stream_raw_write(void *stream, const void *buf, int32_t size)
     return written;
 }
 
+int32_t mz_stream_raw_writev(void *stream, const mz_stream_iovec *iov, int32_t iov_count)
+{
+    mz_stream_raw *raw = (mz_stream_raw *)stream;
+    mz_stream_iovec prefix_iov[MZ_STREAM_IOV_MAX];
+    int32_t prefix_size = raw->prefix_size;
+    int32_t written = 0;
+    int32_t err = MZ_OK;
+
+    /* Pending prefix goes out in the same write as the first data */
+    if ((prefix_size > 0) && (iov_count < MZ_STREAM_IOV_MAX))
+    {
+        prefix_iov[0].buf = raw->prefix;
+        prefix_iov[0].size = prefix_size;
+        memcpy(prefix_iov + 1, iov, iov_count * sizeof(mz_stream_iovec));
+        raw->prefix_size = 0;
+
+        written = mz_stream_writev(raw->stream.base, prefix_iov, iov_count + 1);
+        if (written < prefix_size)
+            return MZ_WRITE_ERROR;
+        written -= prefix_size;
+    }
+    else
+    {
+        err = mz_stream_raw_write_prefix(stream);
+        if (err != MZ_OK)
+            return err;
+        written = mz_stream_writev(raw->stream.base, iov, iov_count);
+    }
+
+    if (written > 0)
+    {
+        raw->total_out += written;
+        raw->total_in += written;
+    }
+
+    return written;
+}
+
+int32_t mz_stream_raw_copy_from(void *stream, void *source, int32_t size)
+{
+    mz_stream_raw *raw = (mz_stream_raw *)stream;
+    int32_t copied = 0;
+    int32_t err = MZ_OK;
+
+    err = mz_stream_raw_write_prefix(stream);
+    if (err != MZ_OK)
+        return err;
+
+    copied = mz_stream_copy_from(raw->stream.base, source, size);
+
+    if (copied > 0)
+    {
+        raw->total_out += copied;
+        raw->total_in += copied;
+    }
+
+    return copied;
+}
+
+int32_t mz_stream_raw_copy_to(void *stream, void *target, int32_t size)
+{
+    mz_stream_raw *raw = (mz_stream_raw *)stream;
+    int32_t bytes_to_copy = size;
+    int32_t copied = 0;
+
+    if (raw->max_total_in > 0)
+    {
+        if ((int64_t)bytes_to_copy > (raw->max_total_in - raw->total_in))
+            bytes_to_copy = (int32_t)(raw->max_total_in - raw->total_in);
+    }
+
+    if (bytes_to_copy == 0)
+        return 0;
+
+    copied = mz_stream_copy_to(raw->stream.base, target, bytes_to_copy);
+
+    if (copied > 0)
+    {
+        raw->total_in += copied;
+        raw->total_out += copied;
+    }
+
+    return copied;
+}
+
 int64_t mz_stream_raw_tell(void *stream)
 {
     mz_stream_raw *raw = (mz_stream_raw *)stream;
-    return mz_stream_tell(raw->stream.base);
+    int64_t position = mz_stream_tell(raw->stream.base);
+    if (position >= 0)
+        position += raw->prefix_size;
+    return position;
 }
 
 int32_t mz_stream_raw_seek(void *stream, int64_t offset, int32_t origin)
 {
     mz_stream_raw *raw = (mz_stream_raw *)stream;
+    int32_t err = mz_stream_raw_write_prefix(stream);
+    if (err != MZ_OK)
+        return err;
     return mz_stream_seek(raw->stream.base, offset, origin);
 }
 
@@ -560,6 +793,9 @@ int32_t mz_stream_raw_get_prop_int64(void *stream, int32_t prop, int64_t *value)
     case MZ_STREAM_PROP_TOTAL_OUT:
         *value = raw->total_out;
         return MZ_OK;
+    case MZ_STREAM_PROP_HEADER_SIZE:
+        *value = raw->prefix_size;
+        return MZ_OK;
     }
     return MZ_EXIST_ERROR;
 }
@@ -576,6 +812,13 @@ int32_t mz_stream_raw_set_prop_int64(void *stream, int32_t prop, int64_t value)
     return MZ_EXIST_ERROR;
 }
 
+void mz_stream_raw_set_prefix(void *stream, const void *buf, int32_t size)
+{
+    mz_stream_raw *raw = (mz_stream_raw *)stream;
+    raw->prefix = buf;
+    raw->prefix_size = size;
+}
+
 /***************************************************************************/
 
 static mz_stream_vtbl mz_stream_raw_vtbl = {
@@ -590,7 +833,13 @@ static mz_stream_vtbl mz_stream_raw_vtbl = {
     mz_stream_raw_create,
     mz_stream_raw_delete,
     mz_stream_raw_get_prop_int64,
-    mz_stream_raw_set_prop_int64
+    mz_stream_raw_set_prop_int64,
+    mz_stream_raw_read_ptr,
+    mz_stream_raw_release,
+    NULL,
+    mz_stream_raw_copy_from,
+    mz_stream_raw_copy_to,
+    mz_stream_raw_writev
 };
 
 /***************************************************************************/
@@ -621,3 +870,149 @@ void mz_stream_raw_delete(void **stream)
         MZ_FREE(raw);
     *stream = NULL;
 }
+
+/***************************************************************************/
+
+typedef struct mz_stream_view_s {
+    mz_stream   stream;
+    int64_t     position;
+} mz_stream_view;
+
+/***************************************************************************/
+
+int32_t mz_stream_view_open(void *stream, const char *path, int32_t mode)
+{
+    mz_stream_view *view = (mz_stream_view *)stream;
+
+    MZ_UNUSED(path);
+
+    if (mode & MZ_OPEN_MODE_WRITE)
+        return MZ_SUPPORT_ERROR;
+
+    view->position = 0;
+    return MZ_OK;
+}
+
+int32_t mz_stream_view_is_open(void *stream)
+{
+    mz_stream_view *view = (mz_stream_view *)stream;
+    return mz_stream_is_open(view->stream.base);
+}
+
+int32_t mz_stream_view_read(void *stream, void *buf, int32_t size)
+{
+    mz_stream_view *view = (mz_stream_view *)stream;
+    int32_t read = 0;
+
+    /* Base position is never used so many views can read the same base at once */
+    read = mz_stream_read_at(view->stream.base, view->position, buf, size);
+    if (read > 0)
+        view->position += read;
+    return read;
+}
+
+int32_t mz_stream_view_read_at(void *stream, int64_t offset, void *buf, int32_t size)
+{
+    mz_stream_view *view = (mz_stream_view *)stream;
+    return mz_stream_read_at(view->stream.base, offset, buf, size);
+}
+
+int32_t mz_stream_view_write(void *stream, const void *buf, int32_t size)
+{
+    MZ_UNUSED(stream);
+    MZ_UNUSED(buf);
+    MZ_UNUSED(size);
+    return MZ_SUPPORT_ERROR;
+}
+
+int64_t mz_stream_view_tell(void *stream)
+{
+    mz_stream_view *view = (mz_stream_view *)stream;
+    return view->position;
+}
+
+int32_t mz_stream_view_seek(void *stream, int64_t offset, int32_t origin)
+{
+    mz_stream_view *view = (mz_stream_view *)stream;
+
+    switch (origin)
+    {
+        case MZ_SEEK_CUR:
+            offset += view->position;
+            break;
+        case MZ_SEEK_SET:
+            break;
+        default:
+            return MZ_SEEK_ERROR;
+    }
+
+    if (offset < 0)
+        return MZ_SEEK_ERROR;
+
+    view->position = offset;
+    return MZ_OK;
+}
+
+int32_t mz_stream_view_close(void *stream)
+{
+    MZ_UNUSED(stream);
+    return MZ_OK;
+}
+
+int32_t mz_stream_view_error(void *stream)
+{
+    mz_stream_view *view = (mz_stream_view *)stream;
+    return mz_stream_error(view->stream.base);
+}
+
+/***************************************************************************/
+
+static mz_stream_vtbl mz_stream_view_vtbl = {
+    mz_stream_view_open,
+    mz_stream_view_is_open,
+    mz_stream_view_read,
+    mz_stream_view_write,
+    mz_stream_view_tell,
+    mz_stream_view_seek,
+    mz_stream_view_close,
+    mz_stream_view_error,
+    mz_stream_view_create,
+    mz_stream_view_delete,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    mz_stream_view_read_at,
+    NULL,
+    NULL,
+    NULL
+};
+
+/***************************************************************************/
+
+void *mz_stream_view_create(void **stream)
+{
+    mz_stream_view *view = NULL;
+
+    view = (mz_stream_view *)MZ_ALLOC(sizeof(mz_stream_view));
+    if (view != NULL)
+    {
+        memset(view, 0, sizeof(mz_stream_view));
+        view->stream.vtbl = &mz_stream_view_vtbl;
+    }
+    if (stream != NULL)
+        *stream = view;
+
+    return view;
+}
+
+void mz_stream_view_delete(void **stream)
+{
+    mz_stream_view *view = NULL;
+    if (stream == NULL)
+        return;
+    view = (mz_stream_view *)*stream;
+    if (view != NULL)
+        MZ_FREE(view);
+    *stream = NULL;
+}
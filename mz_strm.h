@@ -29,6 +29,22 @@ extern "C" {
 #define MZ_STREAM_PROP_COMPRESS_LEVEL       (9)
 #define MZ_STREAM_PROP_COMPRESS_ALGORITHM   (10)
 #define MZ_STREAM_PROP_COMPRESS_WINDOW      (11)
+#define MZ_STREAM_PROP_READ_BUFFER_SIZE     (12)
+#define MZ_STREAM_PROP_WRITE_BUFFER_SIZE    (13)
+#define MZ_STREAM_PROP_BUFFER_ADAPTIVE      (14)
+#define MZ_STREAM_PROP_WRITE_ALIGNMENT      (15)
+#define MZ_STREAM_PROP_COMPRESS_THREADS     (16)
+#define MZ_STREAM_PROP_CRC                  (17)
+
+#define MZ_STREAM_IOV_MAX                   (16)
+
+/***************************************************************************/
+
+typedef struct mz_stream_iovec_s
+{
+    const void  *buf;
+    int32_t     size;
+} mz_stream_iovec;
 
 /***************************************************************************/
 
@@ -46,6 +62,13 @@ typedef void    (*mz_stream_destroy_cb)        (void **stream);
 typedef int32_t (*mz_stream_get_prop_int64_cb) (void *stream, int32_t prop, int64_t *value);
 typedef int32_t (*mz_stream_set_prop_int64_cb) (void *stream, int32_t prop, int64_t value);
 
+typedef int32_t (*mz_stream_read_ptr_cb)       (void *stream, const void **ptr, int32_t size);
+typedef int32_t (*mz_stream_release_cb)        (void *stream, int32_t size);
+typedef int32_t (*mz_stream_read_at_cb)        (void *stream, int64_t offset, void *buf, int32_t size);
+typedef int32_t (*mz_stream_copy_from_cb)      (void *stream, void *source, int32_t size);
+typedef int32_t (*mz_stream_copy_to_cb)        (void *stream, void *target, int32_t size);
+typedef int32_t (*mz_stream_writev_cb)         (void *stream, const mz_stream_iovec *iov, int32_t iov_count);
+
 typedef int32_t (*mz_stream_find_cb)           (void *stream, const void *find, int32_t find_size,
                                                 int64_t max_seek, int64_t *position);
 
@@ -66,6 +89,13 @@ typedef struct mz_stream_vtbl_s
 
     mz_stream_get_prop_int64_cb get_prop_int64;
     mz_stream_set_prop_int64_cb set_prop_int64;
+
+    mz_stream_read_ptr_cb       read_ptr;
+    mz_stream_release_cb        release;
+    mz_stream_read_at_cb        read_at;
+    mz_stream_copy_from_cb      copy_from;
+    mz_stream_copy_to_cb        copy_to;
+    mz_stream_writev_cb         writev;
 } mz_stream_vtbl;
 
 typedef struct mz_stream_s {
@@ -78,6 +108,9 @@ typedef struct mz_stream_s {
 int32_t mz_stream_open(void *stream, const char *path, int32_t mode);
 int32_t mz_stream_is_open(void *stream);
 int32_t mz_stream_read(void *stream, void *buf, int32_t size);
+int32_t mz_stream_read_ptr(void *stream, const void **ptr, int32_t size);
+int32_t mz_stream_release(void *stream, int32_t size);
+int32_t mz_stream_read_at(void *stream, int64_t offset, void *buf, int32_t size);
 int32_t mz_stream_read_uint8(void *stream, uint8_t *value);
 int32_t mz_stream_read_uint16(void *stream, uint16_t *value);
 int32_t mz_stream_read_uint32(void *stream, uint32_t *value);
@@ -89,10 +122,13 @@ int32_t mz_stream_write_uint16(void *stream, uint16_t value);
 int32_t mz_stream_write_uint32(void *stream, uint32_t value);
 int32_t mz_stream_write_int64(void *stream, int64_t value);
 int32_t mz_stream_write_uint64(void *stream, uint64_t value);
+int32_t mz_stream_writev(void *stream, const mz_stream_iovec *iov, int32_t iov_count);
 int32_t mz_stream_copy(void *target, void *source, int32_t len);
 int32_t mz_stream_copy_to_end(void *target, void *source);
 int32_t mz_stream_copy_stream(void *target, mz_stream_write_cb write_cb, void *source, mz_stream_read_cb read_cb, int32_t len);
 int32_t mz_stream_copy_stream_to_end(void *target, mz_stream_write_cb write_cb, void *source, mz_stream_read_cb read_cb);
+int32_t mz_stream_copy_from(void *target, void *source, int32_t size);
+int32_t mz_stream_copy_to(void *source, void *target, int32_t size);
 int64_t mz_stream_tell(void *stream);
 int32_t mz_stream_seek(void *stream, int64_t offset, int32_t origin);
 int32_t mz_stream_find(void *stream, const void *find, int32_t find_size, int64_t max_seek, int64_t *position);
@@ -113,7 +149,12 @@ void    mz_stream_delete(void **stream);
 int32_t mz_stream_raw_open(void *stream, const char *filename, int32_t mode);
 int32_t mz_stream_raw_is_open(void *stream);
 int32_t mz_stream_raw_read(void *stream, void *buf, int32_t size);
+int32_t mz_stream_raw_read_ptr(void *stream, const void **ptr, int32_t size);
+int32_t mz_stream_raw_release(void *stream, int32_t size);
 int32_t mz_stream_raw_write(void *stream, const void *buf, int32_t size);
+int32_t mz_stream_raw_writev(void *stream, const mz_stream_iovec *iov, int32_t iov_count);
+int32_t mz_stream_raw_copy_from(void *stream, void *source, int32_t size);
+int32_t mz_stream_raw_copy_to(void *stream, void *target, int32_t size);
 int64_t mz_stream_raw_tell(void *stream);
 int32_t mz_stream_raw_seek(void *stream, int64_t offset, int32_t origin);
 int32_t mz_stream_raw_close(void *stream);
@@ -122,11 +163,28 @@ int32_t mz_stream_raw_error(void *stream);
 int32_t mz_stream_raw_get_prop_int64(void *stream, int32_t prop, int64_t *value);
 int32_t mz_stream_raw_set_prop_int64(void *stream, int32_t prop, int64_t value);
 
+void    mz_stream_raw_set_prefix(void *stream, const void *buf, int32_t size);
+
 void*   mz_stream_raw_create(void **stream);
 void    mz_stream_raw_delete(void **stream);
 
 /***************************************************************************/
 
+int32_t mz_stream_view_open(void *stream, const char *path, int32_t mode);
+int32_t mz_stream_view_is_open(void *stream);
+int32_t mz_stream_view_read(void *stream, void *buf, int32_t size);
+int32_t mz_stream_view_read_at(void *stream, int64_t offset, void *buf, int32_t size);
+int32_t mz_stream_view_write(void *stream, const void *buf, int32_t size);
+int64_t mz_stream_view_tell(void *stream);
+int32_t mz_stream_view_seek(void *stream, int64_t offset, int32_t origin);
+int32_t mz_stream_view_close(void *stream);
+int32_t mz_stream_view_error(void *stream);
+
+void*   mz_stream_view_create(void **stream);
+void    mz_stream_view_delete(void **stream);
+
+/***************************************************************************/
+
 #ifdef __cplusplus
 }
 #endif
@@ -28,8 +28,14 @@ static mz_stream_vtbl mz_stream_buffered_vtbl = {
     mz_stream_buffered_error,
     mz_stream_buffered_create,
     mz_stream_buffered_delete,
-    NULL,
-    NULL
+    mz_stream_buffered_get_prop_int64,
+    mz_stream_buffered_set_prop_int64,
+    mz_stream_buffered_read_ptr,
+    mz_stream_buffered_release,
+    mz_stream_buffered_read_at,
+    mz_stream_buffered_copy_from,
+    mz_stream_buffered_copy_to,
+    mz_stream_buffered_writev
 };
 
 /***************************************************************************/
@@ -37,16 +43,24 @@ static mz_stream_vtbl mz_stream_buffered_vtbl = {
 typedef struct mz_stream_buffered_s {
     mz_stream stream;
     int32_t   error;
-    char      readbuf[INT16_MAX];
+    char      *readbuf;
+    void      *readbuf_alloc;
+    int32_t   readbuf_size;
+    int32_t   readbuf_base_size;    /* size requested, adaptive buffer starts here */
     int32_t   readbuf_len;
     int32_t   readbuf_pos;
     int32_t   readbuf_hits;
     int32_t   readbuf_misses;
-    char      writebuf[INT16_MAX];
+    int32_t   readbuf_sequential;   /* number of fills in a row that followed a fully used buffer */
+    uint8_t   adaptive;
+    char      *writebuf;
+    void      *writebuf_alloc;
+    int32_t   writebuf_size;
     int32_t   writebuf_len;
     int32_t   writebuf_pos;
     int32_t   writebuf_hits;
     int32_t   writebuf_misses;
+    int32_t   write_align;          /* base only writes whole blocks of this size efficiently */
     int64_t   position;
 } mz_stream_buffered;
 
@@ -60,14 +74,109 @@ typedef struct mz_stream_buffered_s {
 
 /***************************************************************************/
 
+static char *mz_stream_buffered_alloc(void **alloc, int32_t size)
+{
+    uintptr_t aligned = 0;
+
+    /* Buffers start on a page boundary so reads through to the base are aligned */
+    *alloc = MZ_ALLOC((size_t)size + MZ_STREAM_BUFFERED_ALIGNMENT);
+    if (*alloc == NULL)
+        return NULL;
+
+    aligned = (uintptr_t)*alloc + MZ_STREAM_BUFFERED_ALIGNMENT - 1;
+    aligned -= aligned % MZ_STREAM_BUFFERED_ALIGNMENT;
+    return (char *)aligned;
+}
+
+static void mz_stream_buffered_free(void **alloc, char **buf)
+{
+    if (*alloc != NULL)
+        MZ_FREE(*alloc);
+    *alloc = NULL;
+    *buf = NULL;
+}
+
+static int32_t mz_stream_buffered_readbuf_get(void *stream)
+{
+    mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
+    int32_t new_size = buffered->readbuf_size;
+
+    /* Each time the whole buffer is used before the next fill, reads are
+       likely sequential so the buffer is doubled to reduce calls to the base */
+    if (buffered->adaptive && buffered->readbuf_size > 0 &&
+        buffered->readbuf_len == buffered->readbuf_size && buffered->readbuf_pos == buffered->readbuf_len)
+    {
+        buffered->readbuf_sequential += 1;
+        if ((buffered->readbuf_sequential >= MZ_STREAM_BUFFERED_ADAPTIVE_FILLS) &&
+            (buffered->readbuf_size <= MZ_STREAM_BUFFERED_ADAPTIVE_MAX / 2))
+        {
+            new_size = buffered->readbuf_size * 2;
+            buffered->readbuf_sequential = 0;
+        }
+    }
+    else if (buffered->readbuf_len == 0)
+    {
+        buffered->readbuf_sequential = 0;
+    }
+
+    if (buffered->readbuf != NULL && new_size == buffered->readbuf_size)
+        return MZ_OK;
+
+    mz_stream_buffered_print("Buffered - Read buffer size %" PRId32 " (hits %" PRId32 " misses %" PRId32 ")\n",
+        new_size, buffered->readbuf_hits, buffered->readbuf_misses);
+
+    mz_stream_buffered_free(&buffered->readbuf_alloc, &buffered->readbuf);
+    buffered->readbuf = mz_stream_buffered_alloc(&buffered->readbuf_alloc, new_size);
+    if (buffered->readbuf == NULL)
+        return MZ_MEM_ERROR;
+
+    buffered->readbuf_size = new_size;
+    buffered->readbuf_len = 0;
+    buffered->readbuf_pos = 0;
+    return MZ_OK;
+}
+
+static int32_t mz_stream_buffered_writebuf_get(void *stream)
+{
+    mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
+
+    if (buffered->writebuf != NULL)
+        return MZ_OK;
+
+    buffered->writebuf = mz_stream_buffered_alloc(&buffered->writebuf_alloc, buffered->writebuf_size);
+    if (buffered->writebuf == NULL)
+        return MZ_MEM_ERROR;
+    return MZ_OK;
+}
+
+static void mz_stream_buffered_readbuf_discard(void *stream)
+{
+    mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
+
+    /* Seeking away from a buffer that was mostly unused means access is random,
+       so an adaptive buffer goes back to its original size */
+    if (buffered->adaptive && buffered->readbuf_size > buffered->readbuf_base_size &&
+        buffered->readbuf_pos < buffered->readbuf_len / 2)
+    {
+        mz_stream_buffered_free(&buffered->readbuf_alloc, &buffered->readbuf);
+        buffered->readbuf_size = buffered->readbuf_base_size;
+    }
+
+    buffered->readbuf_sequential = 0;
+    buffered->readbuf_len = 0;
+    buffered->readbuf_pos = 0;
+}
+
 static int32_t mz_stream_buffered_reset(void *stream)
 {
     mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
 
     buffered->readbuf_len = 0;
     buffered->readbuf_pos = 0;
+    buffered->readbuf_sequential = 0;
     buffered->writebuf_len = 0;
     buffered->writebuf_pos = 0;
+    buffered->write_align = 0;
     buffered->position = 0;
 
     return MZ_OK;
@@ -76,9 +185,24 @@ static int32_t mz_stream_buffered_reset(void *stream)
 int32_t mz_stream_buffered_open(void *stream, const char *path, int32_t mode)
 {
     mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
+    int64_t write_align = 0;
+    int32_t err = MZ_OK;
+
     mz_stream_buffered_print("Buffered - Open (mode %" PRId32 ")\n", mode);
     mz_stream_buffered_reset(buffered);
-    return mz_stream_open(buffered->stream.base, path, mode);
+
+    err = mz_stream_open(buffered->stream.base, path, mode);
+    if (err != MZ_OK)
+        return err;
+
+    /* Flushes are kept on block boundaries when the base asks for it, which requires
+       the buffer to start at an address aligned to the block size */
+    if (mz_stream_get_prop_int64(buffered->stream.base, MZ_STREAM_PROP_WRITE_ALIGNMENT, &write_align) == MZ_OK &&
+        write_align > 0 && (MZ_STREAM_BUFFERED_ALIGNMENT % write_align) == 0)
+    {
+        buffered->write_align = (int32_t)write_align;
+    }
+    return MZ_OK;
 }
 
 int32_t mz_stream_buffered_is_open(void *stream)
@@ -122,6 +246,43 @@ static int32_t mz_stream_buffered_flush(void *stream, int32_t *written)
     return MZ_OK;
 }
 
+static int32_t mz_stream_buffered_flush_aligned(void *stream, int32_t *written)
+{
+    mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
+    int32_t bytes_to_write = 0;
+    int32_t bytes_written = 0;
+    int32_t unaligned = (int32_t)(buffered->position % buffered->write_align);
+
+    *written = 0;
+
+    /* Only whole blocks are written and once after a seek the bytes up to the next
+       boundary, so every later flush starts on a block boundary */
+    if (unaligned > 0)
+        bytes_to_write = buffered->write_align - unaligned;
+    else
+        bytes_to_write = buffered->writebuf_len - (buffered->writebuf_len % buffered->write_align);
+    if (bytes_to_write > buffered->writebuf_len)
+        bytes_to_write = buffered->writebuf_len;
+
+    bytes_written = mz_stream_write(buffered->stream.base, buffered->writebuf, bytes_to_write);
+    if (bytes_written != bytes_to_write)
+        return MZ_WRITE_ERROR;
+
+    buffered->writebuf_misses += 1;
+
+    mz_stream_buffered_print("Buffered - Write flush aligned (%" PRId32 " len %" PRId32 " pos %" PRId64 ")\n",
+        bytes_written, buffered->writebuf_len, buffered->position);
+
+    /* Remaining bytes move to the start of the buffer which is aligned in memory */
+    buffered->position += bytes_written;
+    buffered->writebuf_len -= bytes_written;
+    memmove(buffered->writebuf, buffered->writebuf + bytes_written, buffered->writebuf_len);
+    buffered->writebuf_pos = buffered->writebuf_len;
+
+    *written = bytes_written;
+    return MZ_OK;
+}
+
 int32_t mz_stream_buffered_read(void *stream, void *buf, int32_t size)
 {
     mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
@@ -130,6 +291,7 @@ int32_t mz_stream_buffered_read(void *stream, void *buf, int32_t size)
     int32_t bytes_to_copy = 0;
     int32_t bytes_left_to_read = size;
     int32_t bytes_read = 0;
+    int32_t err = MZ_OK;
 
     mz_stream_buffered_print("Buffered - Read (size %" PRId32 " pos %" PRId64 ")\n", size, buffered->position);
 
@@ -141,15 +303,43 @@ int32_t mz_stream_buffered_read(void *stream, void *buf, int32_t size)
 
     while (bytes_left_to_read > 0)
     {
+        if ((buffered->readbuf_pos == buffered->readbuf_len) &&
+            (bytes_left_to_read >= buffered->readbuf_size))
+        {
+            /* Large reads go directly to the caller's buffer to avoid extra reads and copies */
+            bytes_read = mz_stream_read(buffered->stream.base, (char *)buf + buf_len, bytes_left_to_read);
+            if (bytes_read < 0)
+                return bytes_read;
+
+            buffered->readbuf_misses += 1;
+            buffered->readbuf_len = 0;
+            buffered->readbuf_pos = 0;
+            buffered->position += bytes_read;
+
+            mz_stream_buffered_print("Buffered - Read direct (read %" PRId32 "/%" PRId32 " pos %" PRId64 ")\n",
+                bytes_read, bytes_left_to_read, buffered->position);
+
+            buf_len += bytes_read;
+            bytes_left_to_read -= bytes_read;
+
+            if (bytes_read == 0)
+                break;
+            continue;
+        }
+
         if ((buffered->readbuf_len == 0) || (buffered->readbuf_pos == buffered->readbuf_len))
         {
-            if (buffered->readbuf_len == sizeof(buffered->readbuf))
+            err = mz_stream_buffered_readbuf_get(stream);
+            if (err != MZ_OK)
+                return err;
+
+            if (buffered->readbuf_len == buffered->readbuf_size)
             {
                 buffered->readbuf_pos = 0;
                 buffered->readbuf_len = 0;
             }
 
-            bytes_to_read = (int32_t)sizeof(buffered->readbuf) - (buffered->readbuf_len - buffered->readbuf_pos);
+            bytes_to_read = buffered->readbuf_size - buffered->readbuf_len;
             bytes_read = mz_stream_read(buffered->stream.base, buffered->readbuf + buffered->readbuf_pos, bytes_to_read);
             if (bytes_read < 0)
                 return bytes_read;
@@ -187,6 +377,73 @@ int32_t mz_stream_buffered_read(void *stream, void *buf, int32_t size)
     return size - bytes_left_to_read;
 }
 
+int32_t mz_stream_buffered_read_at(void *stream, int64_t offset, void *buf, int32_t size)
+{
+    mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
+
+    /* Buffers belong to the stream position so positional reads go straight to the base */
+    if (buffered->writebuf_len > 0)
+        return MZ_SUPPORT_ERROR;
+    return mz_stream_read_at(buffered->stream.base, offset, buf, size);
+}
+
+int32_t mz_stream_buffered_read_ptr(void *stream, const void **ptr, int32_t size)
+{
+    mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
+    int32_t bytes_to_read = 0;
+    int32_t bytes_read = 0;
+    int32_t bytes_avail = 0;
+    int32_t err = MZ_OK;
+
+    mz_stream_buffered_print("Buffered - Read ptr (size %" PRId32 " pos %" PRId64 ")\n", size, buffered->position);
+
+    if (buffered->writebuf_len > 0)
+        return MZ_SUPPORT_ERROR;
+    if (size <= 0)
+        return 0;
+
+    if (buffered->readbuf_pos == buffered->readbuf_len)
+    {
+        err = mz_stream_buffered_readbuf_get(stream);
+        if (err != MZ_OK)
+            return err;
+
+        if (buffered->readbuf_len == buffered->readbuf_size)
+        {
+            buffered->readbuf_pos = 0;
+            buffered->readbuf_len = 0;
+        }
+
+        bytes_to_read = buffered->readbuf_size - buffered->readbuf_len;
+        bytes_read = mz_stream_read(buffered->stream.base, buffered->readbuf + buffered->readbuf_pos, bytes_to_read);
+        if (bytes_read < 0)
+            return bytes_read;
+
+        buffered->readbuf_misses += 1;
+        buffered->readbuf_len += bytes_read;
+        buffered->position += bytes_read;
+    }
+
+    bytes_avail = buffered->readbuf_len - buffered->readbuf_pos;
+    if (bytes_avail > size)
+        bytes_avail = size;
+    if (bytes_avail <= 0)
+        return 0;
+
+    *ptr = buffered->readbuf + buffered->readbuf_pos;
+    return bytes_avail;
+}
+
+int32_t mz_stream_buffered_release(void *stream, int32_t size)
+{
+    mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
+    if (size < 0 || size > buffered->readbuf_len - buffered->readbuf_pos)
+        return MZ_PARAM_ERROR;
+    buffered->readbuf_hits += 1;
+    buffered->readbuf_pos += size;
+    return MZ_OK;
+}
+
 int32_t mz_stream_buffered_write(void *stream, const void *buf, int32_t size)
 {
     mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
@@ -206,8 +463,7 @@ int32_t mz_stream_buffered_write(void *stream, const void *buf, int32_t size)
         buffered->position -= buffered->readbuf_len;
         buffered->position += buffered->readbuf_pos;
 
-        buffered->readbuf_len = 0;
-        buffered->readbuf_pos = 0;
+        mz_stream_buffered_readbuf_discard(stream);
 
         mz_stream_buffered_print("Buffered - Switch from read to write (pos %" PRId64 ")\n", buffered->position);
 
@@ -216,18 +472,25 @@ int32_t mz_stream_buffered_write(void *stream, const void *buf, int32_t size)
             return err;
     }
 
+    err = mz_stream_buffered_writebuf_get(stream);
+    if (err != MZ_OK)
+        return err;
+
     while (bytes_left_to_write > 0)
     {
         bytes_used = buffered->writebuf_len;
         if (bytes_used > buffered->writebuf_pos)
             bytes_used = buffered->writebuf_pos;
-        bytes_to_copy = (int32_t)sizeof(buffered->writebuf) - bytes_used;
+        bytes_to_copy = buffered->writebuf_size - bytes_used;
         if (bytes_to_copy > bytes_left_to_write)
             bytes_to_copy = bytes_left_to_write;
 
         if (bytes_to_copy == 0)
         {
-            err = mz_stream_buffered_flush(stream, &bytes_flushed);
+            if ((buffered->write_align > 0) && (buffered->writebuf_size >= buffered->write_align))
+                err = mz_stream_buffered_flush_aligned(stream, &bytes_flushed);
+            else
+                err = mz_stream_buffered_flush(stream, &bytes_flushed);
             if (err != MZ_OK)
                 return err;
             if (bytes_flushed == 0)
@@ -253,6 +516,123 @@ int32_t mz_stream_buffered_write(void *stream, const void *buf, int32_t size)
     return size - bytes_left_to_write;
 }
 
+int32_t mz_stream_buffered_writev(void *stream, const mz_stream_iovec *iov, int32_t iov_count)
+{
+    mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
+    mz_stream_iovec flush_iov[MZ_STREAM_IOV_MAX];
+    int32_t total_size = 0;
+    int32_t written = 0;
+    int32_t i = 0;
+
+    for (i = 0; i < iov_count; i += 1)
+        total_size += iov[i].size;
+
+    mz_stream_buffered_print("Buffered - Writev (count %" PRId32 " size %" PRId32 " len %" PRId32 " pos %" PRId64 ")\n",
+        iov_count, total_size, buffered->writebuf_len, buffered->position);
+
+    /* Vectors that fit are gathered in the buffer, larger ones are written to the base together
+       with the buffered data in a single write unless the buffer is being rewritten or aligned */
+    if ((total_size <= buffered->writebuf_size - buffered->writebuf_len) || (iov_count >= MZ_STREAM_IOV_MAX) ||
+        (buffered->readbuf_len > 0) || (buffered->writebuf_pos != buffered->writebuf_len) ||
+        (buffered->write_align > 0))
+    {
+        for (i = 0; i < iov_count; i += 1)
+        {
+            written = mz_stream_buffered_write(stream, iov[i].buf, iov[i].size);
+            if (written != iov[i].size)
+                return (written < 0) ? written : MZ_WRITE_ERROR;
+        }
+        return total_size;
+    }
+
+    flush_iov[0].buf = buffered->writebuf;
+    flush_iov[0].size = buffered->writebuf_len;
+    memcpy(flush_iov + 1, iov, iov_count * sizeof(mz_stream_iovec));
+
+    written = mz_stream_writev(buffered->stream.base, flush_iov, iov_count + 1);
+    if (written != buffered->writebuf_len + total_size)
+        return MZ_WRITE_ERROR;
+
+    buffered->writebuf_misses += 1;
+    buffered->position += written;
+    buffered->writebuf_len = 0;
+    buffered->writebuf_pos = 0;
+    return total_size;
+}
+
+int32_t mz_stream_buffered_copy_from(void *stream, void *source, int32_t size)
+{
+    mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
+    int32_t bytes_flushed = 0;
+    int32_t copied = 0;
+    int32_t err = MZ_OK;
+
+    mz_stream_buffered_print("Buffered - Copy from (size %" PRId32 " pos %" PRId64 ")\n", size, buffered->position);
+
+    /* Buffered data goes out first so the copy lands after it */
+    if (buffered->writebuf_pos != buffered->writebuf_len)
+        return MZ_SUPPORT_ERROR;
+
+    if (buffered->readbuf_len > 0)
+    {
+        buffered->position -= buffered->readbuf_len;
+        buffered->position += buffered->readbuf_pos;
+
+        mz_stream_buffered_readbuf_discard(stream);
+
+        err = mz_stream_seek(buffered->stream.base, buffered->position, MZ_SEEK_SET);
+        if (err != MZ_OK)
+            return err;
+    }
+
+    err = mz_stream_buffered_flush(stream, &bytes_flushed);
+    if (err != MZ_OK)
+        return err;
+
+    copied = mz_stream_copy_from(buffered->stream.base, source, size);
+    if (copied > 0)
+        buffered->position += copied;
+    return copied;
+}
+
+int32_t mz_stream_buffered_copy_to(void *stream, void *target, int32_t size)
+{
+    mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
+    int32_t bytes_to_write = 0;
+    int32_t written = 0;
+    int32_t copied = 0;
+
+    mz_stream_buffered_print("Buffered - Copy to (size %" PRId32 " pos %" PRId64 ")\n", size, buffered->position);
+
+    if (buffered->writebuf_len > 0)
+        return MZ_SUPPORT_ERROR;
+
+    /* Bytes already read into the buffer are written out from it, the rest is copied from the base */
+    bytes_to_write = buffered->readbuf_len - buffered->readbuf_pos;
+    if (bytes_to_write > size)
+        bytes_to_write = size;
+    if (bytes_to_write > 0)
+    {
+        written = mz_stream_write(target, buffered->readbuf + buffered->readbuf_pos, bytes_to_write);
+        if (written != bytes_to_write)
+            return MZ_WRITE_ERROR;
+
+        buffered->readbuf_hits += 1;
+        buffered->readbuf_pos += written;
+
+        if (written == size)
+            return written;
+    }
+
+    copied = mz_stream_copy_to(buffered->stream.base, target, size - written);
+    if (copied <= 0)
+        return (written > 0) ? written : copied;
+
+    mz_stream_buffered_readbuf_discard(stream);
+    buffered->position += copied;
+    return written + copied;
+}
+
 int64_t mz_stream_buffered_tell(void *stream)
 {
     mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
@@ -316,7 +696,6 @@ int32_t mz_stream_buffered_seek(void *stream, int64_t offset, int32_t origin)
                     return MZ_OK;
                 }
                 offset -= ((int64_t)buffered->readbuf_len - buffered->readbuf_pos);
-                buffered->position += offset;
             }
             if (buffered->writebuf_len > 0)
             {
@@ -332,6 +711,7 @@ int32_t mz_stream_buffered_seek(void *stream, int64_t offset, int32_t origin)
             if (err != MZ_OK)
                 return err;
 
+            buffered->position += offset;
             break;
 
         case MZ_SEEK_END:
@@ -344,12 +724,15 @@ int32_t mz_stream_buffered_seek(void *stream, int64_t offset, int32_t origin)
             break;
     }
 
-    buffered->readbuf_len = 0;
-    buffered->readbuf_pos = 0;
+    mz_stream_buffered_readbuf_discard(stream);
     buffered->writebuf_len = 0;
     buffered->writebuf_pos = 0;
 
-    return mz_stream_seek(buffered->stream.base, offset, origin);
+    err = mz_stream_seek(buffered->stream.base, offset, origin);
+    /* Aligned flushes need to know where the end of the stream is */
+    if ((err == MZ_OK) && (origin == MZ_SEEK_END) && (buffered->write_align > 0))
+        buffered->position = mz_stream_tell(buffered->stream.base);
+    return err;
 }
 
 int32_t mz_stream_buffered_close(void *stream)
@@ -383,6 +766,61 @@ int32_t mz_stream_buffered_error(void *stream)
     return mz_stream_error(buffered->stream.base);
 }
 
+int32_t mz_stream_buffered_get_prop_int64(void *stream, int32_t prop, int64_t *value)
+{
+    mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
+    switch (prop)
+    {
+    case MZ_STREAM_PROP_READ_BUFFER_SIZE:
+        *value = buffered->readbuf_size;
+        break;
+    case MZ_STREAM_PROP_WRITE_BUFFER_SIZE:
+        *value = buffered->writebuf_size;
+        break;
+    case MZ_STREAM_PROP_BUFFER_ADAPTIVE:
+        *value = buffered->adaptive;
+        break;
+    default:
+        return MZ_EXIST_ERROR;
+    }
+    return MZ_OK;
+}
+
+int32_t mz_stream_buffered_set_prop_int64(void *stream, int32_t prop, int64_t value)
+{
+    mz_stream_buffered *buffered = (mz_stream_buffered *)stream;
+    switch (prop)
+    {
+    case MZ_STREAM_PROP_READ_BUFFER_SIZE:
+        if (value <= 0 || value > MZ_STREAM_BUFFERED_ADAPTIVE_MAX)
+            return MZ_PARAM_ERROR;
+        /* Buffer can only be resized while it holds no data */
+        if (buffered->readbuf_pos != buffered->readbuf_len)
+            return MZ_SUPPORT_ERROR;
+        mz_stream_buffered_free(&buffered->readbuf_alloc, &buffered->readbuf);
+        buffered->readbuf_size = (int32_t)value;
+        buffered->readbuf_base_size = (int32_t)value;
+        buffered->readbuf_len = 0;
+        buffered->readbuf_pos = 0;
+        break;
+    case MZ_STREAM_PROP_WRITE_BUFFER_SIZE:
+        if (value <= 0 || value > MZ_STREAM_BUFFERED_ADAPTIVE_MAX)
+            return MZ_PARAM_ERROR;
+        if (buffered->writebuf_len > 0)
+            return MZ_SUPPORT_ERROR;
+        mz_stream_buffered_free(&buffered->writebuf_alloc, &buffered->writebuf);
+        buffered->writebuf_size = (int32_t)value;
+        break;
+    case MZ_STREAM_PROP_BUFFER_ADAPTIVE:
+        buffered->adaptive = (value != 0);
+        buffered->readbuf_sequential = 0;
+        break;
+    default:
+        return MZ_EXIST_ERROR;
+    }
+    return MZ_OK;
+}
+
 void *mz_stream_buffered_create(void **stream)
 {
     mz_stream_buffered *buffered = NULL;
@@ -392,6 +830,9 @@ void *mz_stream_buffered_create(void **stream)
     {
         memset(buffered, 0, sizeof(mz_stream_buffered));
         buffered->stream.vtbl = &mz_stream_buffered_vtbl;
+        buffered->readbuf_size = MZ_STREAM_BUFFERED_SIZE;
+        buffered->readbuf_base_size = MZ_STREAM_BUFFERED_SIZE;
+        buffered->writebuf_size = MZ_STREAM_BUFFERED_SIZE;
     }
     if (stream != NULL)
         *stream = buffered;
@@ -406,7 +847,11 @@ void mz_stream_buffered_delete(void **stream)
         return;
     buffered = (mz_stream_buffered *)*stream;
     if (buffered != NULL)
+    {
+        mz_stream_buffered_free(&buffered->readbuf_alloc, &buffered->readbuf);
+        mz_stream_buffered_free(&buffered->writebuf_alloc, &buffered->writebuf);
         MZ_FREE(buffered);
+    }
     *stream = NULL;
 }
 
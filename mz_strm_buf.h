@@ -20,15 +20,37 @@ extern "C" {
 
 /***************************************************************************/
 
+#define MZ_STREAM_BUFFERED_SIZE             (64 * 1024)
+#define MZ_STREAM_BUFFERED_ALIGNMENT        (4096)
+#define MZ_STREAM_BUFFERED_ADAPTIVE_FILLS   (2)
+#define MZ_STREAM_BUFFERED_ADAPTIVE_MAX     (4 * 1024 * 1024)
+
+/* With MZ_STREAM_PROP_BUFFER_ADAPTIVE the read buffer doubles, up to MZ_STREAM_BUFFERED_ADAPTIVE_MAX,
+   after MZ_STREAM_BUFFERED_ADAPTIVE_FILLS fills in a row that each followed a full buffer read to
+   its end. Seeking away from a buffer of which less than half was read returns it to its configured
+   size. Hit and miss counts are only kept for the debug output, they count calls rather than bytes
+   so they can't tell sequential reads from random ones. */
+
+/***************************************************************************/
+
 int32_t mz_stream_buffered_open(void *stream, const char *path, int32_t mode);
 int32_t mz_stream_buffered_is_open(void *stream);
 int32_t mz_stream_buffered_read(void *stream, void *buf, int32_t size);
+int32_t mz_stream_buffered_read_at(void *stream, int64_t offset, void *buf, int32_t size);
+int32_t mz_stream_buffered_read_ptr(void *stream, const void **ptr, int32_t size);
+int32_t mz_stream_buffered_release(void *stream, int32_t size);
 int32_t mz_stream_buffered_write(void *stream, const void *buf, int32_t size);
+int32_t mz_stream_buffered_writev(void *stream, const mz_stream_iovec *iov, int32_t iov_count);
+int32_t mz_stream_buffered_copy_from(void *stream, void *source, int32_t size);
+int32_t mz_stream_buffered_copy_to(void *stream, void *target, int32_t size);
 int64_t mz_stream_buffered_tell(void *stream);
 int32_t mz_stream_buffered_seek(void *stream, int64_t offset, int32_t origin);
 int32_t mz_stream_buffered_close(void *stream);
 int32_t mz_stream_buffered_error(void *stream);
 
+int32_t mz_stream_buffered_get_prop_int64(void *stream, int32_t prop, int64_t *value);
+int32_t mz_stream_buffered_set_prop_int64(void *stream, int32_t prop, int64_t value);
+
 void*   mz_stream_buffered_create(void **stream);
 void    mz_stream_buffered_delete(void **stream);
 
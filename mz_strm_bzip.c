@@ -30,7 +30,13 @@ static mz_stream_vtbl mz_stream_bzip_vtbl = {
     mz_stream_bzip_create,
     mz_stream_bzip_delete,
     mz_stream_bzip_get_prop_int64,
-    mz_stream_bzip_set_prop_int64
+    mz_stream_bzip_set_prop_int64,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
 };
 
 /***************************************************************************/
@@ -76,6 +82,7 @@ int32_t mz_stream_bzip_open(void *stream, const char *path, int32_t mode)
 #else
         bzip->bzstream.next_out = (char *)bzip->buffer;
         bzip->bzstream.avail_out = sizeof(bzip->buffer);
+        bzip->buffer_len = 0;
 
         bzip->error = BZ2_bzCompressInit(&bzip->bzstream, bzip->level, 0, 0);
 #endif
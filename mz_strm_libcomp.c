@@ -30,7 +30,13 @@ static mz_stream_vtbl mz_stream_libcomp_vtbl = {
     mz_stream_libcomp_create,
     mz_stream_libcomp_delete,
     mz_stream_libcomp_get_prop_int64,
-    mz_stream_libcomp_set_prop_int64
+    mz_stream_libcomp_set_prop_int64,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
 };
 
 /***************************************************************************/
@@ -398,7 +404,13 @@ static mz_stream_vtbl mz_stream_zlib_vtbl = {
     mz_stream_zlib_create,
     mz_stream_libcomp_delete,
     mz_stream_libcomp_get_prop_int64,
-    mz_stream_libcomp_set_prop_int64
+    mz_stream_libcomp_set_prop_int64,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
 };
 
 void *mz_stream_zlib_create(void **stream)
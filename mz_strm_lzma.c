@@ -34,7 +34,13 @@ static mz_stream_vtbl mz_stream_lzma_vtbl = {
     mz_stream_lzma_create,
     mz_stream_lzma_delete,
     mz_stream_lzma_get_prop_int64,
-    mz_stream_lzma_set_prop_int64
+    mz_stream_lzma_set_prop_int64,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
 };
 
 /***************************************************************************/
@@ -85,6 +91,7 @@ int32_t mz_stream_lzma_open(void *stream, const char *path, int32_t mode)
 #else
         lzma->lstream.next_out = lzma->buffer;
         lzma->lstream.avail_out = sizeof(lzma->buffer);
+        lzma->buffer_len = 0;
 
         if (lzma_lzma_preset(&opt_lzma, lzma->preset))
             return MZ_OPEN_ERROR;
@@ -324,19 +331,17 @@ int32_t mz_stream_lzma_close(void *stream)
 #else
         mz_stream_lzma_code(stream, LZMA_FINISH);
         mz_stream_lzma_flush(stream);
-
-        lzma_end(&lzma->lstream);
 #endif
     }
     else if (lzma->mode & MZ_OPEN_MODE_READ)
     {
 #ifdef MZ_ZIP_NO_DECOMPRESSION
         return MZ_SUPPORT_ERROR;
-#else
-        lzma_end(&lzma->lstream);
 #endif
     }
 
+    /* Coder is ended on delete, reopening reinitializes it in place reusing its memory */
+
     lzma->initialized = 0;
 
     if (lzma->error != LZMA_OK)
@@ -426,7 +431,10 @@ void mz_stream_lzma_delete(void **stream)
         return;
     lzma = (mz_stream_lzma *)*stream;
     if (lzma != NULL)
+    {
+        lzma_end(&lzma->lstream);
         MZ_FREE(lzma);
+    }
     *stream = NULL;
 }
 
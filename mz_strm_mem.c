@@ -36,6 +36,12 @@ static mz_stream_vtbl mz_stream_mem_vtbl = {
     mz_stream_mem_create,
     mz_stream_mem_delete,
     NULL,
+    NULL,
+    mz_stream_mem_read_ptr,
+    mz_stream_mem_release,
+    mz_stream_mem_read_at,
+    NULL,
+    NULL,
     NULL
 };
 
@@ -120,6 +126,43 @@ int32_t mz_stream_mem_read(void *stream, void *buf, int32_t size)
     return size;
 }
 
+int32_t mz_stream_mem_read_at(void *stream, int64_t offset, void *buf, int32_t size)
+{
+    mz_stream_mem *mem = (mz_stream_mem *)stream;
+
+    if (offset >= mem->limit)
+        return 0;
+    if (size > mem->limit - (int32_t)offset)
+        size = mem->limit - (int32_t)offset;
+    if (size <= 0)
+        return 0;
+
+    memcpy(buf, mem->buffer + offset, size);
+    return size;
+}
+
+int32_t mz_stream_mem_read_ptr(void *stream, const void **ptr, int32_t size)
+{
+    mz_stream_mem *mem = (mz_stream_mem *)stream;
+
+    if (size > mem->limit - mem->position)
+        size = mem->limit - mem->position;
+    if (size <= 0)
+        return 0;
+
+    *ptr = mem->buffer + mem->position;
+    return size;
+}
+
+int32_t mz_stream_mem_release(void *stream, int32_t size)
+{
+    mz_stream_mem *mem = (mz_stream_mem *)stream;
+    if (size < 0 || size > mem->limit - mem->position)
+        return MZ_PARAM_ERROR;
+    mem->position += size;
+    return MZ_OK;
+}
+
 int32_t mz_stream_mem_write(void *stream, const void *buf, int32_t size)
 {
     mz_stream_mem *mem = (mz_stream_mem *)stream;
@@ -0,0 +1,57 @@
+/* mz_strm_mmap.h -- Stream for memory mapped file access
+   part of the MiniZip project
+
+   Copyright (C) 2026 The MiniZip contributors
+      https://github.com/nmoinvaz/minizip
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+*/
+
+#ifndef MZ_STREAM_MMAP_H
+#define MZ_STREAM_MMAP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************/
+
+#define MZ_STREAM_MMAP_ADVICE_NORMAL        (0)
+#define MZ_STREAM_MMAP_ADVICE_SEQUENTIAL    (1)
+#define MZ_STREAM_MMAP_ADVICE_RANDOM        (2)
+#define MZ_STREAM_MMAP_ADVICE_WILLNEED      (3)
+
+/***************************************************************************/
+
+int32_t mz_stream_mmap_open(void *stream, const char *path, int32_t mode);
+int32_t mz_stream_mmap_is_open(void *stream);
+int32_t mz_stream_mmap_read(void *stream, void *buf, int32_t size);
+int32_t mz_stream_mmap_read_at(void *stream, int64_t offset, void *buf, int32_t size);
+int32_t mz_stream_mmap_read_ptr(void *stream, const void **ptr, int32_t size);
+int32_t mz_stream_mmap_release(void *stream, int32_t size);
+int32_t mz_stream_mmap_copy_to(void *stream, void *target, int32_t size);
+int32_t mz_stream_mmap_write(void *stream, const void *buf, int32_t size);
+int64_t mz_stream_mmap_tell(void *stream);
+int32_t mz_stream_mmap_seek(void *stream, int64_t offset, int32_t origin);
+int32_t mz_stream_mmap_close(void *stream);
+int32_t mz_stream_mmap_error(void *stream);
+
+void    mz_stream_mmap_set_advice(void *stream, int32_t advice);
+int32_t mz_stream_mmap_get_buffer(void *stream, const void **buf);
+int32_t mz_stream_mmap_get_buffer_at(void *stream, int64_t position, const void **buf);
+int32_t mz_stream_mmap_get_buffer_at_current(void *stream, const void **buf);
+void    mz_stream_mmap_get_buffer_length(void *stream, int64_t *length);
+
+void*   mz_stream_mmap_create(void **stream);
+void    mz_stream_mmap_delete(void **stream);
+
+void*   mz_stream_mmap_get_interface(void);
+
+/***************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
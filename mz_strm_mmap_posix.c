@@ -0,0 +1,378 @@
+/* mz_strm_mmap_posix.c -- Stream for memory mapped file access for posix/linux
+   part of the MiniZip project
+
+   This version of ioapi maps a file into memory for reading so that reads
+   are copied straight from the page cache and callers can use pointers
+   into the mapping instead of reading at all.
+
+   Copyright (C) 2026 The MiniZip contributors
+     https://github.com/nmoinvaz/minizip
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+*/
+
+
+#include "mz.h"
+#include "mz_strm.h"
+#include "mz_strm_mmap.h"
+
+#include <errno.h>
+#include <fcntl.h>      /* open */
+#include <sys/mman.h>   /* mmap, posix_madvise */
+#include <sys/stat.h>   /* fstat */
+#include <unistd.h>     /* close */
+
+/***************************************************************************/
+
+static mz_stream_vtbl mz_stream_mmap_vtbl = {
+    mz_stream_mmap_open,
+    mz_stream_mmap_is_open,
+    mz_stream_mmap_read,
+    mz_stream_mmap_write,
+    mz_stream_mmap_tell,
+    mz_stream_mmap_seek,
+    mz_stream_mmap_close,
+    mz_stream_mmap_error,
+    mz_stream_mmap_create,
+    mz_stream_mmap_delete,
+    NULL,
+    NULL,
+    mz_stream_mmap_read_ptr,
+    mz_stream_mmap_release,
+    mz_stream_mmap_read_at,
+    NULL,
+    mz_stream_mmap_copy_to,
+    NULL
+};
+
+/***************************************************************************/
+
+typedef struct mz_stream_mmap_s
+{
+    mz_stream   stream;
+    int32_t     error;
+    int32_t     advice;
+    uint8_t     opened;
+    uint8_t     *data;          /* start of the mapping, NULL for empty files */
+    int64_t     size;
+    int64_t     position;
+} mz_stream_mmap;
+
+/***************************************************************************/
+
+static int32_t mz_stream_mmap_advise(void *stream, void *addr, int64_t length, int32_t advice)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+    int posix_advice = POSIX_MADV_NORMAL;
+
+    switch (advice)
+    {
+        case MZ_STREAM_MMAP_ADVICE_SEQUENTIAL:
+            posix_advice = POSIX_MADV_SEQUENTIAL;
+            break;
+        case MZ_STREAM_MMAP_ADVICE_RANDOM:
+            posix_advice = POSIX_MADV_RANDOM;
+            break;
+        case MZ_STREAM_MMAP_ADVICE_WILLNEED:
+            posix_advice = POSIX_MADV_WILLNEED;
+            break;
+        default:
+            break;
+    }
+
+    /* Hints are optional so failures are only recorded */
+    mmapped->error = posix_madvise(addr, (size_t)length, posix_advice);
+    if (mmapped->error != 0)
+        return MZ_SUPPORT_ERROR;
+    return MZ_OK;
+}
+
+int32_t mz_stream_mmap_open(void *stream, const char *path, int32_t mode)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+    struct stat file_stat;
+    void *data = NULL;
+    int fd = -1;
+
+
+    if (path == NULL)
+        return MZ_PARAM_ERROR;
+
+    /* Mappings are only used for reading */
+    if ((mode & MZ_OPEN_MODE_READWRITE) != MZ_OPEN_MODE_READ)
+        return MZ_SUPPORT_ERROR;
+
+    mz_stream_mmap_close(stream);
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1)
+    {
+        mmapped->error = errno;
+        return MZ_OPEN_ERROR;
+    }
+
+    if (fstat(fd, &file_stat) != 0)
+    {
+        mmapped->error = errno;
+        close(fd);
+        return MZ_OPEN_ERROR;
+    }
+
+    if ((uint64_t)file_stat.st_size > (uint64_t)SIZE_MAX)
+    {
+        close(fd);
+        return MZ_SUPPORT_ERROR;
+    }
+
+    /* Zero length mappings are not allowed */
+    if (file_stat.st_size > 0)
+    {
+        data = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            mmapped->error = errno;
+            close(fd);
+            return MZ_OPEN_ERROR;
+        }
+    }
+
+    /* Mapping stays valid after the descriptor is closed */
+    close(fd);
+
+    mmapped->data = (uint8_t *)data;
+    mmapped->size = (int64_t)file_stat.st_size;
+    mmapped->position = 0;
+    mmapped->opened = 1;
+
+    if ((mmapped->data != NULL) && (mmapped->advice != MZ_STREAM_MMAP_ADVICE_NORMAL))
+        mz_stream_mmap_advise(stream, mmapped->data, mmapped->size, mmapped->advice);
+
+    return MZ_OK;
+}
+
+int32_t mz_stream_mmap_is_open(void *stream)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+    if (!mmapped->opened)
+        return MZ_OPEN_ERROR;
+    return MZ_OK;
+}
+
+int32_t mz_stream_mmap_read(void *stream, void *buf, int32_t size)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+
+    if (!mmapped->opened)
+        return MZ_OPEN_ERROR;
+
+    if (size > mmapped->size - mmapped->position)
+        size = (int32_t)(mmapped->size - mmapped->position);
+    if (size <= 0)
+        return 0;
+
+    memcpy(buf, mmapped->data + mmapped->position, size);
+    mmapped->position += size;
+    return size;
+}
+
+int32_t mz_stream_mmap_read_at(void *stream, int64_t offset, void *buf, int32_t size)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+
+    if (!mmapped->opened)
+        return MZ_OPEN_ERROR;
+
+    if (offset >= mmapped->size)
+        return 0;
+    if (size > mmapped->size - offset)
+        size = (int32_t)(mmapped->size - offset);
+    if (size <= 0)
+        return 0;
+
+    memcpy(buf, mmapped->data + offset, size);
+    return size;
+}
+
+int32_t mz_stream_mmap_read_ptr(void *stream, const void **ptr, int32_t size)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+
+    if (!mmapped->opened)
+        return MZ_OPEN_ERROR;
+
+    if (size > mmapped->size - mmapped->position)
+        size = (int32_t)(mmapped->size - mmapped->position);
+    if (size <= 0)
+        return 0;
+
+    *ptr = mmapped->data + mmapped->position;
+    return size;
+}
+
+int32_t mz_stream_mmap_release(void *stream, int32_t size)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+    if (size < 0 || size > mmapped->size - mmapped->position)
+        return MZ_PARAM_ERROR;
+    mmapped->position += size;
+    return MZ_OK;
+}
+
+int32_t mz_stream_mmap_copy_to(void *stream, void *target, int32_t size)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+    int32_t written = 0;
+
+    if (!mmapped->opened)
+        return MZ_OPEN_ERROR;
+
+    if (size > mmapped->size - mmapped->position)
+        size = (int32_t)(mmapped->size - mmapped->position);
+    if (size <= 0)
+        return 0;
+
+    /* Target is written straight from the mapping without an intermediate buffer */
+    written = mz_stream_write(target, mmapped->data + mmapped->position, size);
+    if (written > 0)
+        mmapped->position += written;
+    return written;
+}
+
+int32_t mz_stream_mmap_write(void *stream, const void *buf, int32_t size)
+{
+    MZ_UNUSED(stream);
+    MZ_UNUSED(buf);
+    MZ_UNUSED(size);
+    return MZ_SUPPORT_ERROR;
+}
+
+int64_t mz_stream_mmap_tell(void *stream)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+    return mmapped->position;
+}
+
+int32_t mz_stream_mmap_seek(void *stream, int64_t offset, int32_t origin)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+    int64_t new_pos = 0;
+
+    switch (origin)
+    {
+        case MZ_SEEK_CUR:
+            new_pos = mmapped->position + offset;
+            break;
+        case MZ_SEEK_END:
+            new_pos = mmapped->size + offset;
+            break;
+        case MZ_SEEK_SET:
+            new_pos = offset;
+            break;
+        default:
+            return MZ_SEEK_ERROR;
+    }
+
+    /* Mapping can't grow so seeking past the end is not allowed */
+    if (new_pos < 0 || new_pos > mmapped->size)
+        return MZ_SEEK_ERROR;
+
+    mmapped->position = new_pos;
+    return MZ_OK;
+}
+
+int32_t mz_stream_mmap_close(void *stream)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+    int32_t err = MZ_OK;
+
+    if (mmapped->data != NULL)
+    {
+        if (munmap(mmapped->data, (size_t)mmapped->size) != 0)
+        {
+            mmapped->error = errno;
+            err = MZ_CLOSE_ERROR;
+        }
+    }
+
+    mmapped->data = NULL;
+    mmapped->size = 0;
+    mmapped->position = 0;
+    mmapped->opened = 0;
+    return err;
+}
+
+int32_t mz_stream_mmap_error(void *stream)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+    return mmapped->error;
+}
+
+void mz_stream_mmap_set_advice(void *stream, int32_t advice)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+    mmapped->advice = advice;
+    if (mmapped->data != NULL)
+        mz_stream_mmap_advise(stream, mmapped->data, mmapped->size, advice);
+}
+
+int32_t mz_stream_mmap_get_buffer(void *stream, const void **buf)
+{
+    return mz_stream_mmap_get_buffer_at(stream, 0, buf);
+}
+
+int32_t mz_stream_mmap_get_buffer_at(void *stream, int64_t position, const void **buf)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+    if (buf == NULL || position < 0 || position >= mmapped->size)
+        return MZ_SEEK_ERROR;
+    *buf = mmapped->data + position;
+    return MZ_OK;
+}
+
+int32_t mz_stream_mmap_get_buffer_at_current(void *stream, const void **buf)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+    return mz_stream_mmap_get_buffer_at(stream, mmapped->position, buf);
+}
+
+void mz_stream_mmap_get_buffer_length(void *stream, int64_t *length)
+{
+    mz_stream_mmap *mmapped = (mz_stream_mmap *)stream;
+    *length = mmapped->size;
+}
+
+void *mz_stream_mmap_create(void **stream)
+{
+    mz_stream_mmap *mmapped = NULL;
+
+    mmapped = (mz_stream_mmap *)MZ_ALLOC(sizeof(mz_stream_mmap));
+    if (mmapped != NULL)
+    {
+        memset(mmapped, 0, sizeof(mz_stream_mmap));
+        mmapped->stream.vtbl = &mz_stream_mmap_vtbl;
+    }
+    if (stream != NULL)
+        *stream = mmapped;
+
+    return mmapped;
+}
+
+void mz_stream_mmap_delete(void **stream)
+{
+    mz_stream_mmap *mmapped = NULL;
+    if (stream == NULL)
+        return;
+    mmapped = (mz_stream_mmap *)*stream;
+    if (mmapped != NULL)
+    {
+        mz_stream_mmap_close(mmapped);
+        MZ_FREE(mmapped);
+    }
+    *stream = NULL;
+}
+
+void *mz_stream_mmap_get_interface(void)
+{
+    return (void *)&mz_stream_mmap_vtbl;
+}
@@ -18,15 +18,35 @@ extern "C" {
 
 /***************************************************************************/
 
+#define MZ_STREAM_OS_ADVICE_NORMAL      (0)
+#define MZ_STREAM_OS_ADVICE_SEQUENTIAL  (1)
+#define MZ_STREAM_OS_ADVICE_RANDOM      (2)
+#define MZ_STREAM_OS_ADVICE_NOREUSE     (4)     /* data read is dropped from the page cache */
+
+#define MZ_STREAM_OS_DROP_SIZE          (8 * 1024 * 1024)
+#define MZ_STREAM_OS_DIRECT_ALIGNMENT   (4096)  /* used when the filesystem reports no direct I/O alignment */
+
+/***************************************************************************/
+
 int32_t mz_stream_os_open(void *stream, const char *path, int32_t mode);
 int32_t mz_stream_os_is_open(void *stream);
 int32_t mz_stream_os_read(void *stream, void *buf, int32_t size);
+int32_t mz_stream_os_read_at(void *stream, int64_t offset, void *buf, int32_t size);
 int32_t mz_stream_os_write(void *stream, const void *buf, int32_t size);
+int32_t mz_stream_os_writev(void *stream, const mz_stream_iovec *iov, int32_t iov_count);
+int32_t mz_stream_os_copy_from(void *stream, void *source, int32_t size);
+int32_t mz_stream_os_copy_to(void *stream, void *target, int32_t size);
 int64_t mz_stream_os_tell(void *stream);
 int32_t mz_stream_os_seek(void *stream, int64_t offset, int32_t origin);
 int32_t mz_stream_os_close(void *stream);
 int32_t mz_stream_os_error(void *stream);
 
+int32_t mz_stream_os_get_prop_int64(void *stream, int32_t prop, int64_t *value);
+
+void    mz_stream_os_set_advice(void *stream, int32_t advice);
+void    mz_stream_os_set_write_behind(void *stream, int32_t write_behind);
+int32_t mz_stream_os_preallocate(void *stream, int64_t size);
+
 void*   mz_stream_os_create(void **stream);
 void    mz_stream_os_delete(void **stream);
 
@@ -14,6 +14,10 @@
    See the accompanying LICENSE file for the full text of the license.
 */
 
+#if (defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_FALLOCATE) || defined(HAVE_SYNC_FILE_RANGE) || \
+     defined(HAVE_O_DIRECT)) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE /* copy_file_range, fallocate, sync_file_range, O_DIRECT */
+#endif
 
 #include "mz.h"
 #include "mz_strm.h"
@@ -21,6 +25,13 @@
 
 #include <stdio.h> /* fopen, fread.. */
 #include <errno.h>
+#include <fcntl.h> /* posix_fadvise, posix_fallocate */
+#include <unistd.h> /* pread, copy_file_range */
+#include <sys/uio.h> /* writev */
+#include <sys/stat.h> /* fstat, statx */
+#ifdef HAVE_SENDFILE
+#  include <sys/sendfile.h>
+#endif
 
 /***************************************************************************/
 
@@ -54,8 +65,14 @@ static mz_stream_vtbl mz_stream_os_vtbl = {
     mz_stream_os_error,
     mz_stream_os_create,
     mz_stream_os_delete,
+    mz_stream_os_get_prop_int64,
+    NULL,
+    NULL,
     NULL,
-    NULL
+    mz_stream_os_read_at,
+    mz_stream_os_copy_from,
+    mz_stream_os_copy_to,
+    mz_stream_os_writev
 };
 
 /***************************************************************************/
@@ -65,10 +82,223 @@ typedef struct mz_stream_posix_s
     mz_stream   stream;
     int32_t     error;
     FILE        *handle;
+    int32_t     advice;
+    int64_t     advice_pos;     /* data before it was dropped from the page cache */
+    int32_t     read_pending;   /* bytes read since data was last dropped */
+    int32_t     write_behind;
+    int64_t     write_pending;  /* bytes written since the last write out */
+    int64_t     sync_start;     /* window being written out by the system */
+    int64_t     sync_end;
+    uint8_t     truncate;       /* space was preallocated past what is written */
+    uint8_t     direct;         /* opened for direct I/O */
+    uint8_t     direct_set;     /* direct I/O is enabled on the descriptor */
+    int         direct_flags;   /* descriptor flags without direct I/O */
+    int32_t     direct_mem_align;
+    int32_t     direct_offset_align;
 } mz_stream_posix;
 
 /***************************************************************************/
 
+static void mz_stream_os_advise(void *stream, int64_t offset, int64_t length, int32_t advice)
+{
+#ifdef HAVE_POSIX_FADVISE
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    int posix_advice = POSIX_FADV_NORMAL;
+
+    if (advice & MZ_STREAM_OS_ADVICE_SEQUENTIAL)
+        posix_advice = POSIX_FADV_SEQUENTIAL;
+    else if (advice & MZ_STREAM_OS_ADVICE_RANDOM)
+        posix_advice = POSIX_FADV_RANDOM;
+
+    posix_fadvise(fileno(posix->handle), (off_t)offset, (off_t)length, posix_advice);
+    if (advice & MZ_STREAM_OS_ADVICE_NOREUSE)
+        posix_fadvise(fileno(posix->handle), (off_t)offset, (off_t)length, POSIX_FADV_NOREUSE);
+#else
+    MZ_UNUSED(stream);
+    MZ_UNUSED(offset);
+    MZ_UNUSED(length);
+    MZ_UNUSED(advice);
+#endif
+}
+
+static void mz_stream_os_drop_behind(void *stream)
+{
+#ifdef HAVE_POSIX_FADVISE
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    int64_t position = ftello64(posix->handle);
+
+    /* Data already read won't be read again so it doesn't need to stay cached */
+    posix->read_pending = 0;
+    if (position > posix->advice_pos)
+        posix_fadvise(fileno(posix->handle), (off_t)posix->advice_pos,
+            (off_t)(position - posix->advice_pos), POSIX_FADV_DONTNEED);
+    if (position >= 0)
+        posix->advice_pos = position;
+#else
+    MZ_UNUSED(stream);
+#endif
+}
+
+static void mz_stream_os_write_out(void *stream)
+{
+#ifdef HAVE_SYNC_FILE_RANGE
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    int64_t position = 0;
+    int fd = fileno(posix->handle);
+
+    posix->write_pending = 0;
+    if (fflush(posix->handle) != 0)
+        return;
+    position = ftello64(posix->handle);
+    if (position <= posix->sync_end)
+        return;
+
+    /* Start writing out the latest window, then wait on the window before it so that dirty
+       pages never pile up and drop it from the page cache since it won't be read again */
+    sync_file_range(fd, posix->sync_end, position - posix->sync_end, SYNC_FILE_RANGE_WRITE);
+    if (posix->sync_end > posix->sync_start)
+    {
+        sync_file_range(fd, posix->sync_start, posix->sync_end - posix->sync_start,
+            SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+#ifdef HAVE_POSIX_FADVISE
+        posix_fadvise(fd, (off_t)posix->sync_start, (off_t)(posix->sync_end - posix->sync_start),
+            POSIX_FADV_DONTNEED);
+#endif
+    }
+
+    posix->sync_start = posix->sync_end;
+    posix->sync_end = position;
+#else
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    posix->write_pending = 0;
+#endif
+}
+
+static int32_t mz_stream_os_direct_aligned(void *stream, const void *buf, int64_t offset, int32_t size)
+{
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    return ((uintptr_t)buf % posix->direct_mem_align == 0) &&
+        (offset >= 0) && (offset % posix->direct_offset_align == 0) &&
+        (size % posix->direct_offset_align == 0);
+}
+
+static int32_t mz_stream_os_direct_set(void *stream, int32_t enable)
+{
+#ifdef HAVE_O_DIRECT
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    int flags = posix->direct_flags;
+
+    if (!posix->direct || posix->direct_set == (enable != 0))
+        return MZ_OK;
+
+    /* Only whole blocks at aligned offsets can bypass the page cache, anything else
+       such as the tail of the file or a rewritten header goes through it */
+    if (enable)
+        flags |= O_DIRECT;
+    if (fcntl(fileno(posix->handle), F_SETFL, flags) == -1)
+    {
+        /* Descriptor that refuses direct I/O stays buffered from then on */
+        if (enable && errno == EINVAL)
+        {
+            posix->direct = 0;
+            return MZ_OK;
+        }
+        posix->error = errno;
+        return MZ_INTERNAL_ERROR;
+    }
+    posix->direct_set = (enable != 0);
+#else
+    MZ_UNUSED(stream);
+    MZ_UNUSED(enable);
+#endif
+    return MZ_OK;
+}
+
+static int32_t mz_stream_os_direct_refused(void *stream)
+{
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+
+    /* Transfers the filesystem rejects with direct I/O are done buffered for the rest of the stream */
+    if (!posix->direct_set || errno != EINVAL)
+        return 0;
+    if (mz_stream_os_direct_set(stream, 0) != MZ_OK)
+        return 0;
+    posix->direct = 0;
+    clearerr(posix->handle);
+    return 1;
+}
+
+#ifdef HAVE_O_DIRECT
+static void mz_stream_os_direct_align(void *stream, int fd)
+{
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+#ifdef HAVE_STATX_DIOALIGN
+    struct statx stx;
+#endif
+    long align = -1;
+
+    /* Alignment is asked of the filesystem, the default is kept when it doesn't tell */
+    posix->direct_mem_align = MZ_STREAM_OS_DIRECT_ALIGNMENT;
+    posix->direct_offset_align = MZ_STREAM_OS_DIRECT_ALIGNMENT;
+#ifdef HAVE_STATX_DIOALIGN
+    memset(&stx, 0, sizeof(stx));
+    if ((statx(fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0) && (stx.stx_mask & STATX_DIOALIGN) &&
+        (stx.stx_dio_mem_align > 0) && (stx.stx_dio_offset_align > 0))
+    {
+        posix->direct_mem_align = (int32_t)stx.stx_dio_mem_align;
+        posix->direct_offset_align = (int32_t)stx.stx_dio_offset_align;
+        return;
+    }
+#endif
+#ifdef _PC_REC_XFER_ALIGN
+    align = fpathconf(fd, _PC_REC_XFER_ALIGN);
+#endif
+    if ((align > 0) && (align <= INT16_MAX))
+    {
+        posix->direct_mem_align = (int32_t)align;
+        posix->direct_offset_align = (int32_t)align;
+    }
+}
+
+static FILE *mz_stream_os_open_direct(void *stream, const char *path, int32_t mode, const char *mode_fopen)
+{
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    FILE *handle = NULL;
+    int flags = O_RDONLY;
+    int fd = -1;
+
+    if ((mode & MZ_OPEN_MODE_READWRITE) == MZ_OPEN_MODE_READ)
+        flags = O_RDONLY;
+    else if (mode & MZ_OPEN_MODE_APPEND)
+        flags = O_RDWR;
+    else
+        flags = O_WRONLY | O_CREAT | O_TRUNC;
+
+    /* Filesystems without direct I/O support refuse it and are opened normally instead */
+    fd = open(path, flags | O_DIRECT, 0666);
+    if (fd == -1)
+        return NULL;
+    flags = fcntl(fd, F_GETFL);
+    if (flags != -1)
+        handle = fdopen(fd, mode_fopen);
+    if (handle == NULL)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    /* Without a stdio buffer reads and writes are passed through with the caller's buffer */
+    setvbuf(handle, NULL, _IONBF, 0);
+    posix->direct = 1;
+    posix->direct_set = 1;
+    posix->direct_flags = flags & ~O_DIRECT;
+    mz_stream_os_direct_align(stream, fd);
+    return handle;
+}
+#endif
+
+/***************************************************************************/
+
 int32_t mz_stream_os_open(void *stream, const char *path, int32_t mode)
 {
     mz_stream_posix *posix = (mz_stream_posix *)stream;
@@ -86,15 +316,38 @@ int32_t mz_stream_os_open(void *stream, const char *path, int32_t mode)
     else
         return MZ_OPEN_ERROR;
 
-    posix->handle = fopen64(path, mode_fopen);
+    posix->handle = NULL;
+    posix->direct = 0;
+    posix->direct_set = 0;
+#ifdef HAVE_O_DIRECT
+    if (mode & MZ_OPEN_MODE_DIRECT)
+        posix->handle = mz_stream_os_open_direct(stream, path, mode, mode_fopen);
+#endif
+    if (posix->handle == NULL)
+        posix->handle = fopen64(path, mode_fopen);
     if (posix->handle == NULL)
     {
         posix->error = errno;
         return MZ_OPEN_ERROR;
     }
 
+    posix->advice_pos = 0;
+    posix->read_pending = 0;
+    posix->write_pending = 0;
+    posix->sync_start = 0;
+    posix->sync_end = 0;
+    posix->truncate = 0;
+
+    if (posix->advice != MZ_STREAM_OS_ADVICE_NORMAL)
+        mz_stream_os_advise(stream, 0, 0, posix->advice);
+
     if (mode & MZ_OPEN_MODE_APPEND)
-        return mz_stream_os_seek(stream, 0, MZ_SEEK_END);
+    {
+        if (mz_stream_os_seek(stream, 0, MZ_SEEK_END) != MZ_OK)
+            return MZ_SEEK_ERROR;
+        posix->sync_start = ftello64(posix->handle);
+        posix->sync_end = posix->sync_start;
+    }
 
     return MZ_OK;
 }
@@ -110,27 +363,276 @@ int32_t mz_stream_os_is_open(void *stream)
 int32_t mz_stream_os_read(void *stream, void *buf, int32_t size)
 {
     mz_stream_posix *posix = (mz_stream_posix*)stream;
-    int32_t read = (int32_t)fread(buf, 1, (size_t)size, posix->handle);
+    int32_t read = 0;
+    if (posix->direct && mz_stream_os_direct_set(stream,
+        mz_stream_os_direct_aligned(stream, buf, ftello64(posix->handle), size)) != MZ_OK)
+        return MZ_READ_ERROR;
+    read = (int32_t)fread(buf, 1, (size_t)size, posix->handle);
+    if (read == 0 && ferror(posix->handle) && mz_stream_os_direct_refused(stream))
+        read = (int32_t)fread(buf, 1, (size_t)size, posix->handle);
     if (read < size && ferror(posix->handle))
     {
         posix->error = errno;
         return MZ_READ_ERROR;
     }
+    if (posix->advice & MZ_STREAM_OS_ADVICE_NOREUSE)
+    {
+        posix->read_pending += read;
+        if (posix->read_pending >= MZ_STREAM_OS_DROP_SIZE)
+            mz_stream_os_drop_behind(stream);
+    }
     return read;
 }
 
+int32_t mz_stream_os_read_at(void *stream, int64_t offset, void *buf, int32_t size)
+{
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    int32_t total_read = 0;
+    ssize_t read = 0;
+
+    if (posix->direct && mz_stream_os_direct_set(stream,
+        mz_stream_os_direct_aligned(stream, buf, offset, size)) != MZ_OK)
+        return MZ_READ_ERROR;
+
+    /* Reads through the descriptor do not use or move the shared file position */
+    while (total_read < size)
+    {
+        read = pread(fileno(posix->handle), (uint8_t *)buf + total_read,
+            (size_t)(size - total_read), (off_t)(offset + total_read));
+        if (read < 0)
+        {
+            if (errno == EINTR || mz_stream_os_direct_refused(stream))
+                continue;
+            posix->error = errno;
+            return MZ_READ_ERROR;
+        }
+        if (read == 0)
+            break;
+        total_read += (int32_t)read;
+    }
+    return total_read;
+}
+
 int32_t mz_stream_os_write(void *stream, const void *buf, int32_t size)
 {
     mz_stream_posix *posix = (mz_stream_posix*)stream;
-    int32_t written = (int32_t)fwrite(buf, 1, (size_t)size, posix->handle);
+    int32_t written = 0;
+    if (posix->direct && mz_stream_os_direct_set(stream,
+        mz_stream_os_direct_aligned(stream, buf, ftello64(posix->handle), size)) != MZ_OK)
+        return MZ_WRITE_ERROR;
+    written = (int32_t)fwrite(buf, 1, (size_t)size, posix->handle);
+    if (written == 0 && ferror(posix->handle) && mz_stream_os_direct_refused(stream))
+        written = (int32_t)fwrite(buf, 1, (size_t)size, posix->handle);
     if (written < size && ferror(posix->handle))
     {
         posix->error = errno;
         return MZ_WRITE_ERROR;
     }
+    if (posix->write_behind > 0)
+    {
+        posix->write_pending += written;
+        if (posix->write_pending >= posix->write_behind)
+            mz_stream_os_write_out(stream);
+    }
     return written;
 }
 
+int32_t mz_stream_os_writev(void *stream, const mz_stream_iovec *iov, int32_t iov_count)
+{
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    struct iovec vec[MZ_STREAM_IOV_MAX];
+    int64_t position = 0;
+    int32_t total_size = 0;
+    int32_t total_written = 0;
+    int32_t written = 0;
+    int32_t count = 0;
+    int32_t i = 0;
+    ssize_t result = 0;
+
+    /* Direct I/O needs each buffer aligned so they are written one at a time */
+    if (posix->direct || iov_count > MZ_STREAM_IOV_MAX)
+    {
+        for (i = 0; i < iov_count; i += 1)
+        {
+            written = mz_stream_os_write(stream, iov[i].buf, iov[i].size);
+            if (written < 0)
+                return written;
+            total_written += written;
+        }
+        return total_written;
+    }
+
+    for (i = 0; i < iov_count; i += 1)
+    {
+        if (iov[i].size <= 0)
+            continue;
+        vec[count].iov_base = (void *)iov[i].buf;
+        vec[count].iov_len = (size_t)iov[i].size;
+        total_size += iov[i].size;
+        count += 1;
+    }
+    if (count == 0)
+        return 0;
+
+    /* Descriptor offset only matches the file position once stdio buffers are flushed,
+       stdio is told where the write ended after */
+    if (fflush(posix->handle) != 0)
+    {
+        posix->error = errno;
+        return MZ_WRITE_ERROR;
+    }
+    position = ftello64(posix->handle);
+    if (position < 0)
+    {
+        posix->error = errno;
+        return MZ_TELL_ERROR;
+    }
+
+    i = 0;
+    while (i < count)
+    {
+        result = writev(fileno(posix->handle), vec + i, count - i);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            posix->error = errno;
+            return MZ_WRITE_ERROR;
+        }
+        total_written += (int32_t)result;
+        if (total_written == total_size)
+            break;
+
+        /* Continue a short write where it stopped */
+        while (result >= (ssize_t)vec[i].iov_len)
+        {
+            result -= (ssize_t)vec[i].iov_len;
+            i += 1;
+        }
+        vec[i].iov_base = (uint8_t *)vec[i].iov_base + result;
+        vec[i].iov_len -= (size_t)result;
+    }
+
+    if (fseeko64(posix->handle, position + total_written, SEEK_SET) != 0)
+    {
+        posix->error = errno;
+        return MZ_SEEK_ERROR;
+    }
+
+    if (posix->write_behind > 0)
+    {
+        posix->write_pending += total_written;
+        if (posix->write_pending >= posix->write_behind)
+            mz_stream_os_write_out(stream);
+    }
+    return total_written;
+}
+
+static int32_t mz_stream_os_copy_range(int source_fd, int64_t *offset_in, int target_fd,
+    int64_t *offset_out, int32_t size)
+{
+#ifdef HAVE_COPY_FILE_RANGE
+    loff_t off_in = (loff_t)*offset_in;
+    loff_t off_out = (loff_t)*offset_out;
+    ssize_t result = 0;
+
+    /* Shares extents instead of copying on filesystems with reflink support */
+    do
+        result = copy_file_range(source_fd, &off_in, target_fd, &off_out, (size_t)size, 0);
+    while (result < 0 && errno == EINTR);
+    if (result >= 0)
+    {
+        *offset_in += result;
+        *offset_out += result;
+        return (int32_t)result;
+    }
+#endif
+#ifdef HAVE_SENDFILE
+    {
+        off_t send_off = (off_t)*offset_in;
+        ssize_t sent = 0;
+
+        /* Older kernels can't copy across filesystems, sendfile writes at the target file offset */
+        if (lseek(target_fd, (off_t)*offset_out, SEEK_SET) < 0)
+            return MZ_SUPPORT_ERROR;
+        do
+            sent = sendfile(target_fd, source_fd, &send_off, (size_t)size);
+        while (sent < 0 && errno == EINTR);
+        if (sent >= 0)
+        {
+            *offset_in += sent;
+            *offset_out += sent;
+            return (int32_t)sent;
+        }
+    }
+#endif
+    MZ_UNUSED(source_fd);
+    MZ_UNUSED(offset_in);
+    MZ_UNUSED(target_fd);
+    MZ_UNUSED(offset_out);
+    MZ_UNUSED(size);
+    return MZ_SUPPORT_ERROR;
+}
+
+int32_t mz_stream_os_copy_from(void *stream, void *source, int32_t size)
+{
+    /* Only the source chain knows where its data is, it calls back into mz_stream_os_copy_to */
+    return mz_stream_copy_to(source, stream, size);
+}
+
+int32_t mz_stream_os_copy_to(void *stream, void *target, int32_t size)
+{
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    mz_stream_posix *target_posix = (mz_stream_posix*)target;
+    int64_t offset_in = 0;
+    int64_t offset_out = 0;
+    int32_t total_copied = 0;
+    int32_t copied = 0;
+
+    if (mz_stream_get_interface(target) != (void *)&mz_stream_os_vtbl)
+        return MZ_SUPPORT_ERROR;
+
+    /* Copies at arbitrary offsets can't be done with direct I/O */
+    if (mz_stream_os_direct_set(stream, 0) != MZ_OK || mz_stream_os_direct_set(target, 0) != MZ_OK)
+        return MZ_SUPPORT_ERROR;
+
+    /* Descriptor offsets only match the file positions once stdio buffers are flushed */
+    if (fflush(target_posix->handle) != 0)
+    {
+        target_posix->error = errno;
+        return MZ_WRITE_ERROR;
+    }
+    offset_in = ftello64(posix->handle);
+    offset_out = ftello64(target_posix->handle);
+    if (offset_in < 0 || offset_out < 0)
+        return MZ_SUPPORT_ERROR;
+
+    while (total_copied < size)
+    {
+        copied = mz_stream_os_copy_range(fileno(posix->handle), &offset_in,
+            fileno(target_posix->handle), &offset_out, size - total_copied);
+        if (copied <= 0)
+            break;
+        total_copied += copied;
+    }
+
+    if (total_copied == 0)
+        return (copied == 0) ? 0 : MZ_SUPPORT_ERROR;
+
+    if (fseeko64(posix->handle, offset_in, SEEK_SET) != 0)
+    {
+        posix->error = errno;
+        return MZ_SEEK_ERROR;
+    }
+    if (fseeko64(target_posix->handle, offset_out, SEEK_SET) != 0)
+    {
+        target_posix->error = errno;
+        return MZ_SEEK_ERROR;
+    }
+
+    return total_copied;
+}
+
 int64_t mz_stream_os_tell(void *stream)
 {
     mz_stream_posix *posix = (mz_stream_posix*)stream;
@@ -172,12 +674,39 @@ int32_t mz_stream_os_seek(void *stream, int64_t offset, int32_t origin)
     return MZ_OK;
 }
 
+static void mz_stream_os_trim(void *stream)
+{
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    int64_t position = 0;
+#if defined(HAVE_FALLOCATE)
+    struct stat file_stat;
+
+    /* Size was kept so truncating to it drops the blocks reserved past the end */
+    if (fstat(fileno(posix->handle), &file_stat) != 0)
+    {
+        posix->error = errno;
+        return;
+    }
+    position = (int64_t)file_stat.st_size;
+#else
+    /* File was extended so it is cut back to where writing stopped */
+    position = ftello64(posix->handle);
+    if (position < 0)
+        return;
+#endif
+    if (ftruncate(fileno(posix->handle), (off_t)position) != 0)
+        posix->error = errno;
+}
+
 int32_t mz_stream_os_close(void *stream)
 {
     mz_stream_posix *posix = (mz_stream_posix*)stream;
     int32_t closed = 0;
     if (posix->handle != NULL)
     {
+        /* Space preallocated past the end of what was written is given back */
+        if (posix->truncate && fflush(posix->handle) == 0)
+            mz_stream_os_trim(stream);
         closed = fclose(posix->handle);
         posix->handle = NULL;
     }
@@ -195,6 +724,70 @@ int32_t mz_stream_os_error(void *stream)
     return posix->error;
 }
 
+int32_t mz_stream_os_get_prop_int64(void *stream, int32_t prop, int64_t *value)
+{
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    switch (prop)
+    {
+    case MZ_STREAM_PROP_WRITE_ALIGNMENT:
+        if (!posix->direct)
+            return MZ_EXIST_ERROR;
+        *value = posix->direct_offset_align;
+        if (posix->direct_mem_align > posix->direct_offset_align)
+            *value = posix->direct_mem_align;
+        break;
+    default:
+        return MZ_EXIST_ERROR;
+    }
+    return MZ_OK;
+}
+
+void mz_stream_os_set_advice(void *stream, int32_t advice)
+{
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    posix->advice = advice;
+    if (posix->handle != NULL)
+        mz_stream_os_advise(stream, 0, 0, advice);
+}
+
+void mz_stream_os_set_write_behind(void *stream, int32_t write_behind)
+{
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    posix->write_behind = write_behind;
+}
+
+int32_t mz_stream_os_preallocate(void *stream, int64_t size)
+{
+    mz_stream_posix *posix = (mz_stream_posix*)stream;
+    int64_t position = 0;
+    int32_t err = MZ_SUPPORT_ERROR;
+
+    if (posix->handle == NULL)
+        return MZ_OPEN_ERROR;
+    if (size <= 0)
+        return MZ_OK;
+
+    position = ftello64(posix->handle);
+    if (position < 0)
+        return MZ_TELL_ERROR;
+
+#if defined(HAVE_FALLOCATE)
+    /* Blocks are reserved without changing the file size */
+    if (fallocate(fileno(posix->handle), FALLOC_FL_KEEP_SIZE, (off_t)position, (off_t)size) == 0)
+        err = MZ_OK;
+    else
+        posix->error = errno;
+#elif defined(HAVE_POSIX_FALLOCATE)
+    /* File is extended and trimmed back to what was written on close */
+    posix->error = posix_fallocate(fileno(posix->handle), (off_t)position, (off_t)size);
+    if (posix->error == 0)
+        err = MZ_OK;
+#endif
+    if (err == MZ_OK)
+        posix->truncate = 1;
+    return err;
+}
+
 void *mz_stream_os_create(void **stream)
 {
     mz_stream_posix *posix = NULL;
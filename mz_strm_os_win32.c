@@ -51,8 +51,14 @@ static mz_stream_vtbl mz_stream_os_vtbl = {
     mz_stream_os_error,
     mz_stream_os_create,
     mz_stream_os_delete,
+    mz_stream_os_get_prop_int64,
     NULL,
-    NULL
+    NULL,
+    NULL,
+    mz_stream_os_read_at,
+    mz_stream_os_copy_from,
+    mz_stream_os_copy_to,
+    mz_stream_os_writev
 };
 
 /***************************************************************************/
@@ -166,6 +172,32 @@ int32_t mz_stream_os_read(void *stream, void *buf, int32_t size)
     return read;
 }
 
+int32_t mz_stream_os_read_at(void *stream, int64_t offset, void *buf, int32_t size)
+{
+    /* Overlapped reads on synchronous handles still move the file pointer */
+    MZ_UNUSED(stream);
+    MZ_UNUSED(offset);
+    MZ_UNUSED(buf);
+    MZ_UNUSED(size);
+    return MZ_SUPPORT_ERROR;
+}
+
+int32_t mz_stream_os_copy_from(void *stream, void *source, int32_t size)
+{
+    MZ_UNUSED(stream);
+    MZ_UNUSED(source);
+    MZ_UNUSED(size);
+    return MZ_SUPPORT_ERROR;
+}
+
+int32_t mz_stream_os_copy_to(void *stream, void *target, int32_t size)
+{
+    MZ_UNUSED(stream);
+    MZ_UNUSED(target);
+    MZ_UNUSED(size);
+    return MZ_SUPPORT_ERROR;
+}
+
 int32_t mz_stream_os_write(void *stream, const void *buf, int32_t size)
 {
     mz_stream_win32 *win32 = (mz_stream_win32 *)stream;
@@ -186,6 +218,25 @@ int32_t mz_stream_os_write(void *stream, const void *buf, int32_t size)
     return written;
 }
 
+int32_t mz_stream_os_writev(void *stream, const mz_stream_iovec *iov, int32_t iov_count)
+{
+    int32_t total_written = 0;
+    int32_t written = 0;
+    int32_t i = 0;
+
+    /* Gathered writes need unbuffered files so the buffers are written one at a time */
+    for (i = 0; i < iov_count; i += 1)
+    {
+        written = mz_stream_os_write(stream, iov[i].buf, iov[i].size);
+        if (written < 0)
+            return written;
+        total_written += written;
+        if (written != iov[i].size)
+            break;
+    }
+    return total_written;
+}
+
 static int32_t mz_stream_os_seekinternal(HANDLE handle, LARGE_INTEGER large_pos,
     LARGE_INTEGER *new_pos, uint32_t move_method)
 {
@@ -286,6 +337,33 @@ int32_t mz_stream_os_error(void *stream)
     return win32->error;
 }
 
+int32_t mz_stream_os_get_prop_int64(void *stream, int32_t prop, int64_t *value)
+{
+    MZ_UNUSED(stream);
+    MZ_UNUSED(prop);
+    MZ_UNUSED(value);
+    return MZ_EXIST_ERROR;
+}
+
+void mz_stream_os_set_advice(void *stream, int32_t advice)
+{
+    MZ_UNUSED(stream);
+    MZ_UNUSED(advice);
+}
+
+void mz_stream_os_set_write_behind(void *stream, int32_t write_behind)
+{
+    MZ_UNUSED(stream);
+    MZ_UNUSED(write_behind);
+}
+
+int32_t mz_stream_os_preallocate(void *stream, int64_t size)
+{
+    MZ_UNUSED(stream);
+    MZ_UNUSED(size);
+    return MZ_SUPPORT_ERROR;
+}
+
 void *mz_stream_os_create(void **stream)
 {
     mz_stream_win32 *win32 = NULL;
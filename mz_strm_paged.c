@@ -0,0 +1,385 @@
+/* mz_strm_paged.c -- Stream for reading through a page cache
+   part of the MiniZip project
+
+   This version of ioapi is designed to read large regions of a stream
+   using a bounded amount of memory. Fixed size pages are read from the
+   base stream on demand and the least recently used page is evicted
+   once the memory limit is reached.
+
+   Copyright (C) 2026 The MiniZip contributors
+      https://github.com/nmoinvaz/minizip
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+*/
+
+
+#include "mz.h"
+#include "mz_strm.h"
+#include "mz_strm_paged.h"
+
+/***************************************************************************/
+
+#define MZ_STREAM_PAGED_PAGE_SIZE   (64 * 1024)
+#define MZ_STREAM_PAGED_MEMORY_MAX  (4 * 1024 * 1024)
+
+/***************************************************************************/
+
+static mz_stream_vtbl mz_stream_paged_vtbl = {
+    mz_stream_paged_open,
+    mz_stream_paged_is_open,
+    mz_stream_paged_read,
+    mz_stream_paged_write,
+    mz_stream_paged_tell,
+    mz_stream_paged_seek,
+    mz_stream_paged_close,
+    mz_stream_paged_error,
+    mz_stream_paged_create,
+    mz_stream_paged_delete,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+/***************************************************************************/
+
+typedef struct mz_stream_paged_page_s {
+    uint8_t  *data;
+    int64_t  position;      /* position of the page in the base stream */
+    int32_t  length;        /* number of bytes read into the page */
+    uint64_t last_used;     /* access counter value when last used */
+} mz_stream_paged_page;
+
+typedef struct mz_stream_paged_s {
+    mz_stream stream;
+    int32_t   page_size;
+    int64_t   memory_max;
+    mz_stream_paged_page
+              *pages;
+    int32_t   page_count;
+    int32_t   page_current;
+    uint64_t  access_count;
+    int32_t   page_hits;
+    int32_t   page_misses;
+    int64_t   position;
+    int64_t   size;         /* size of the base stream */
+} mz_stream_paged;
+
+/***************************************************************************/
+
+#if 0
+#  define mz_stream_paged_print printf
+#else
+#  define mz_stream_paged_print(fmt,...)
+#endif
+
+/***************************************************************************/
+
+static void mz_stream_paged_free(void *stream)
+{
+    mz_stream_paged *paged = (mz_stream_paged *)stream;
+    int32_t i = 0;
+
+    if (paged->pages != NULL)
+    {
+        for (i = 0; i < paged->page_count; i += 1)
+        {
+            if (paged->pages[i].data != NULL)
+                MZ_FREE(paged->pages[i].data);
+        }
+        MZ_FREE(paged->pages);
+    }
+
+    paged->pages = NULL;
+    paged->page_count = 0;
+    paged->page_current = 0;
+    paged->position = 0;
+    paged->size = 0;
+}
+
+static int32_t mz_stream_paged_fetch(void *stream, int64_t page_pos, mz_stream_paged_page **page)
+{
+    mz_stream_paged *paged = (mz_stream_paged *)stream;
+    mz_stream_paged_page *victim = NULL;
+    int64_t length = 0;
+    int32_t i = 0;
+    int32_t err = MZ_OK;
+
+
+    *page = &paged->pages[paged->page_current];
+    if (((*page)->data == NULL) || ((*page)->position != page_pos))
+    {
+        *page = NULL;
+
+        for (i = 0; i < paged->page_count; i += 1)
+        {
+            if ((paged->pages[i].data != NULL) && (paged->pages[i].position == page_pos))
+            {
+                *page = &paged->pages[i];
+                break;
+            }
+            /* Prefer unused pages, otherwise evict the least recently used page */
+            if ((victim == NULL) || ((victim->data != NULL) &&
+                ((paged->pages[i].data == NULL) || (paged->pages[i].last_used < victim->last_used))))
+                victim = &paged->pages[i];
+        }
+    }
+
+    if (*page == NULL)
+    {
+        if (victim->data == NULL)
+            victim->data = (uint8_t *)MZ_ALLOC(paged->page_size);
+        if (victim->data == NULL)
+            return MZ_MEM_ERROR;
+
+        length = paged->size - page_pos;
+        if (length > paged->page_size)
+            length = paged->page_size;
+
+        victim->position = -1;
+        victim->length = 0;
+
+        err = mz_stream_seek(paged->stream.base, page_pos, MZ_SEEK_SET);
+        if ((err == MZ_OK) && (mz_stream_read(paged->stream.base, victim->data, (int32_t)length) != (int32_t)length))
+            err = MZ_READ_ERROR;
+        if (err != MZ_OK)
+            return err;
+
+        victim->position = page_pos;
+        victim->length = (int32_t)length;
+
+        paged->page_misses += 1;
+
+        mz_stream_paged_print("Paged - Fetch (pos %" PRId64 " len %" PRId32 ")\n", page_pos, victim->length);
+
+        *page = victim;
+    }
+    else
+    {
+        paged->page_hits += 1;
+    }
+
+    paged->access_count += 1;
+    (*page)->last_used = paged->access_count;
+    paged->page_current = (int32_t)(*page - paged->pages);
+    return MZ_OK;
+}
+
+int32_t mz_stream_paged_open(void *stream, const char *path, int32_t mode)
+{
+    mz_stream_paged *paged = (mz_stream_paged *)stream;
+    int64_t page_count = 0;
+    int32_t i = 0;
+    int32_t err = MZ_OK;
+
+
+    mz_stream_paged_print("Paged - Open (mode %" PRId32 ")\n", mode);
+
+    /* Pages are never written back */
+    if (mode & MZ_OPEN_MODE_WRITE)
+        return MZ_SUPPORT_ERROR;
+
+    mz_stream_paged_free(stream);
+
+    /* Base stream can already be open when only caching reads */
+    if (path != NULL)
+        err = mz_stream_open(paged->stream.base, path, mode);
+    if (err == MZ_OK)
+        err = mz_stream_seek(paged->stream.base, 0, MZ_SEEK_END);
+    if (err == MZ_OK)
+    {
+        paged->size = mz_stream_tell(paged->stream.base);
+        if (paged->size < 0)
+            err = MZ_TELL_ERROR;
+    }
+    if (err != MZ_OK)
+        return err;
+
+    if ((paged->memory_max > 0) && (paged->memory_max < paged->page_size))
+        paged->page_size = (int32_t)paged->memory_max;
+
+    page_count = paged->memory_max / paged->page_size;
+    if (page_count < 1)
+        page_count = 1;
+    if (page_count > INT32_MAX / (int64_t)sizeof(mz_stream_paged_page))
+        page_count = INT32_MAX / (int64_t)sizeof(mz_stream_paged_page);
+
+    paged->pages = (mz_stream_paged_page *)MZ_ALLOC((size_t)page_count * sizeof(mz_stream_paged_page));
+    if (paged->pages == NULL)
+        return MZ_MEM_ERROR;
+
+    memset(paged->pages, 0, (size_t)page_count * sizeof(mz_stream_paged_page));
+    for (i = 0; i < (int32_t)page_count; i += 1)
+        paged->pages[i].position = -1;
+
+    paged->page_count = (int32_t)page_count;
+    return MZ_OK;
+}
+
+int32_t mz_stream_paged_is_open(void *stream)
+{
+    mz_stream_paged *paged = (mz_stream_paged *)stream;
+    if (paged->pages == NULL)
+        return MZ_OPEN_ERROR;
+    return MZ_OK;
+}
+
+int32_t mz_stream_paged_read(void *stream, void *buf, int32_t size)
+{
+    mz_stream_paged *paged = (mz_stream_paged *)stream;
+    mz_stream_paged_page *page = NULL;
+    int64_t page_pos = 0;
+    int32_t bytes_left_to_read = size;
+    int32_t bytes_to_copy = 0;
+    int32_t page_offset = 0;
+    int32_t err = MZ_OK;
+
+
+    mz_stream_paged_print("Paged - Read (size %" PRId32 " pos %" PRId64 ")\n", size, paged->position);
+
+    if (paged->pages == NULL)
+        return MZ_OPEN_ERROR;
+
+    while ((bytes_left_to_read > 0) && (paged->position < paged->size))
+    {
+        page_pos = paged->position - (paged->position % paged->page_size);
+
+        err = mz_stream_paged_fetch(stream, page_pos, &page);
+        if (err != MZ_OK)
+            return err;
+
+        page_offset = (int32_t)(paged->position - page_pos);
+        bytes_to_copy = page->length - page_offset;
+        if (bytes_to_copy <= 0)
+            break;
+        if (bytes_to_copy > bytes_left_to_read)
+            bytes_to_copy = bytes_left_to_read;
+
+        memcpy((uint8_t *)buf + (size - bytes_left_to_read), page->data + page_offset, bytes_to_copy);
+
+        bytes_left_to_read -= bytes_to_copy;
+        paged->position += bytes_to_copy;
+    }
+
+    return size - bytes_left_to_read;
+}
+
+int32_t mz_stream_paged_write(void *stream, const void *buf, int32_t size)
+{
+    MZ_UNUSED(stream);
+    MZ_UNUSED(buf);
+    MZ_UNUSED(size);
+    return MZ_SUPPORT_ERROR;
+}
+
+int64_t mz_stream_paged_tell(void *stream)
+{
+    mz_stream_paged *paged = (mz_stream_paged *)stream;
+    return paged->position;
+}
+
+int32_t mz_stream_paged_seek(void *stream, int64_t offset, int32_t origin)
+{
+    mz_stream_paged *paged = (mz_stream_paged *)stream;
+    int64_t new_pos = 0;
+
+    mz_stream_paged_print("Paged - Seek (origin %" PRId32 " offset %" PRId64 " pos %" PRId64 ")\n",
+        origin, offset, paged->position);
+
+    switch (origin)
+    {
+        case MZ_SEEK_CUR:
+            new_pos = paged->position + offset;
+            break;
+        case MZ_SEEK_END:
+            new_pos = paged->size + offset;
+            break;
+        case MZ_SEEK_SET:
+            new_pos = offset;
+            break;
+        default:
+            return MZ_SEEK_ERROR;
+    }
+
+    if (new_pos < 0)
+        return MZ_SEEK_ERROR;
+
+    paged->position = new_pos;
+    return MZ_OK;
+}
+
+int32_t mz_stream_paged_close(void *stream)
+{
+    mz_stream_paged *paged = (mz_stream_paged *)stream;
+
+    if (paged->page_hits + paged->page_misses > 0)
+    {
+        mz_stream_paged_print("Paged - Read efficiency %.02f%%\n",
+            (paged->page_hits / ((float)paged->page_hits + paged->page_misses)) * 100);
+    }
+
+    mz_stream_paged_free(stream);
+
+    return mz_stream_close(paged->stream.base);
+}
+
+int32_t mz_stream_paged_error(void *stream)
+{
+    mz_stream_paged *paged = (mz_stream_paged *)stream;
+    return mz_stream_error(paged->stream.base);
+}
+
+void mz_stream_paged_set_page_size(void *stream, int32_t page_size)
+{
+    mz_stream_paged *paged = (mz_stream_paged *)stream;
+    if (page_size > 0)
+        paged->page_size = page_size;
+}
+
+void mz_stream_paged_set_memory_max(void *stream, int64_t memory_max)
+{
+    mz_stream_paged *paged = (mz_stream_paged *)stream;
+    paged->memory_max = memory_max;
+}
+
+void *mz_stream_paged_create(void **stream)
+{
+    mz_stream_paged *paged = NULL;
+
+    paged = (mz_stream_paged *)MZ_ALLOC(sizeof(mz_stream_paged));
+    if (paged != NULL)
+    {
+        memset(paged, 0, sizeof(mz_stream_paged));
+        paged->stream.vtbl = &mz_stream_paged_vtbl;
+        paged->page_size = MZ_STREAM_PAGED_PAGE_SIZE;
+        paged->memory_max = MZ_STREAM_PAGED_MEMORY_MAX;
+    }
+    if (stream != NULL)
+        *stream = paged;
+
+    return paged;
+}
+
+void mz_stream_paged_delete(void **stream)
+{
+    mz_stream_paged *paged = NULL;
+    if (stream == NULL)
+        return;
+    paged = (mz_stream_paged *)*stream;
+    if (paged != NULL)
+    {
+        mz_stream_paged_free(paged);
+        MZ_FREE(paged);
+    }
+    *stream = NULL;
+}
+
+void *mz_stream_paged_get_interface(void)
+{
+    return (void *)&mz_stream_paged_vtbl;
+}
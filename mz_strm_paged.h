@@ -0,0 +1,46 @@
+/* mz_strm_paged.h -- Stream for reading through a page cache
+   part of the MiniZip project
+
+   This version of ioapi is designed to read large regions of a stream
+   using a bounded amount of memory.
+
+   Copyright (C) 2026 The MiniZip contributors
+      https://github.com/nmoinvaz/minizip
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+*/
+
+#ifndef MZ_STREAM_PAGED_H
+#define MZ_STREAM_PAGED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************/
+
+int32_t mz_stream_paged_open(void *stream, const char *path, int32_t mode);
+int32_t mz_stream_paged_is_open(void *stream);
+int32_t mz_stream_paged_read(void *stream, void *buf, int32_t size);
+int32_t mz_stream_paged_write(void *stream, const void *buf, int32_t size);
+int64_t mz_stream_paged_tell(void *stream);
+int32_t mz_stream_paged_seek(void *stream, int64_t offset, int32_t origin);
+int32_t mz_stream_paged_close(void *stream);
+int32_t mz_stream_paged_error(void *stream);
+
+void    mz_stream_paged_set_page_size(void *stream, int32_t page_size);
+void    mz_stream_paged_set_memory_max(void *stream, int64_t memory_max);
+
+void*   mz_stream_paged_create(void **stream);
+void    mz_stream_paged_delete(void **stream);
+
+void*   mz_stream_paged_get_interface(void);
+
+/***************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
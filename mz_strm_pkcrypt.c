@@ -42,7 +42,13 @@ static mz_stream_vtbl mz_stream_pkcrypt_vtbl = {
     mz_stream_pkcrypt_create,
     mz_stream_pkcrypt_delete,
     mz_stream_pkcrypt_get_prop_int64,
-    mz_stream_pkcrypt_set_prop_int64
+    mz_stream_pkcrypt_set_prop_int64,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
 };
 
 /***************************************************************************/
@@ -211,14 +217,40 @@ int32_t mz_stream_pkcrypt_read(void *stream, void *buf, int32_t size)
 {
     mz_stream_pkcrypt *pkcrypt = (mz_stream_pkcrypt *)stream;
     uint8_t *buf_ptr = (uint8_t *)buf;
+    const uint8_t *lent = NULL;
     int32_t bytes_to_read = size;
     int32_t read = 0;
+    int32_t total_read = 0;
     int32_t i = 0;
+    uint8_t c = 0;
 
 
     if ((int64_t)bytes_to_read > (pkcrypt->max_total_in - pkcrypt->total_in))
         bytes_to_read = (int32_t)(pkcrypt->max_total_in - pkcrypt->total_in);
 
+    /* Decrypt straight out of the base stream's buffer when it can be lent */
+    while (total_read < bytes_to_read)
+    {
+        read = mz_stream_read_ptr(pkcrypt->stream.base, (const void **)&lent, bytes_to_read - total_read);
+        if (read == MZ_SUPPORT_ERROR && total_read == 0)
+            break;
+        if (read <= 0)
+            return (total_read > 0) ? total_read : read;
+
+        for (i = 0; i < read; i++)
+        {
+            c = lent[i];
+            buf_ptr[total_read + i] = mz_stream_pkcrypt_decode(stream, c);
+        }
+
+        mz_stream_release(pkcrypt->stream.base, read);
+
+        total_read += read;
+        pkcrypt->total_in += read;
+    }
+    if (total_read > 0 || bytes_to_read <= 0)
+        return total_read;
+
     read = mz_stream_read(pkcrypt->stream.base, buf, bytes_to_read);
 
     for (i = 0; i < read; i++)
@@ -0,0 +1,50 @@
+/* mz_strm_readahead.h -- Stream for reading ahead on a background thread
+   part of the MiniZip project
+
+   Copyright (C) 2026 The MiniZip contributors
+      https://github.com/nmoinvaz/minizip
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+*/
+
+#ifndef MZ_STREAM_READAHEAD_H
+#define MZ_STREAM_READAHEAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************/
+
+#define MZ_STREAM_READAHEAD_BLOCK_SIZE  (256 * 1024)
+#define MZ_STREAM_READAHEAD_SIZE        (4 * 1024 * 1024)
+
+/***************************************************************************/
+
+int32_t mz_stream_readahead_open(void *stream, const char *path, int32_t mode);
+int32_t mz_stream_readahead_is_open(void *stream);
+int32_t mz_stream_readahead_read(void *stream, void *buf, int32_t size);
+int32_t mz_stream_readahead_read_at(void *stream, int64_t offset, void *buf, int32_t size);
+int32_t mz_stream_readahead_read_ptr(void *stream, const void **ptr, int32_t size);
+int32_t mz_stream_readahead_release(void *stream, int32_t size);
+int32_t mz_stream_readahead_write(void *stream, const void *buf, int32_t size);
+int64_t mz_stream_readahead_tell(void *stream);
+int32_t mz_stream_readahead_seek(void *stream, int64_t offset, int32_t origin);
+int32_t mz_stream_readahead_close(void *stream);
+int32_t mz_stream_readahead_error(void *stream);
+
+void    mz_stream_readahead_set_size(void *stream, int32_t size, int32_t block_size);
+
+void*   mz_stream_readahead_create(void **stream);
+void    mz_stream_readahead_delete(void **stream);
+
+void*   mz_stream_readahead_get_interface(void);
+
+/***************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,547 @@
+/* mz_strm_readahead_posix.c -- Stream for reading ahead on a background thread for posix/linux
+   part of the MiniZip project
+
+   This version of ioapi reads the base stream on a helper thread into a
+   ring of blocks ahead of the stream position, so that reading from the
+   base overlaps with whatever the caller does with the data. Seeking inside
+   the data already read ahead skips forward, any other seek redirects the
+   thread to the new position.
+
+   Copyright (C) 2026 The MiniZip contributors
+     https://github.com/nmoinvaz/minizip
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+*/
+
+
+#include "mz.h"
+#include "mz_strm.h"
+#include "mz_strm_readahead.h"
+
+#include <pthread.h>
+
+/***************************************************************************/
+
+static mz_stream_vtbl mz_stream_readahead_vtbl = {
+    mz_stream_readahead_open,
+    mz_stream_readahead_is_open,
+    mz_stream_readahead_read,
+    mz_stream_readahead_write,
+    mz_stream_readahead_tell,
+    mz_stream_readahead_seek,
+    mz_stream_readahead_close,
+    mz_stream_readahead_error,
+    mz_stream_readahead_create,
+    mz_stream_readahead_delete,
+    NULL,
+    NULL,
+    mz_stream_readahead_read_ptr,
+    mz_stream_readahead_release,
+    mz_stream_readahead_read_at,
+    NULL,
+    NULL,
+    NULL
+};
+
+/***************************************************************************/
+
+typedef struct mz_stream_readahead_block_s
+{
+    uint8_t     *data;
+    int64_t     offset;
+    int32_t     length;
+} mz_stream_readahead_block;
+
+typedef struct mz_stream_readahead_s
+{
+    mz_stream   stream;
+    int32_t     error;
+    int32_t     block_size;
+    int32_t     block_count;
+    uint8_t     *buffer;
+    mz_stream_readahead_block
+                *blocks;
+    int32_t     head;           /* oldest filled block */
+    int32_t     filled;         /* number of filled blocks starting at head */
+    int32_t     head_pos;       /* read position within the head block */
+    int64_t     position;
+    int64_t     fill_offset;    /* base offset the thread reads next */
+    uint32_t    generation;     /* changed on each redirect so reads in progress are dropped */
+    uint8_t     redirect;       /* base must be seeked before the next read */
+    uint8_t     end;            /* thread reached the end of the base or an error */
+    int32_t     end_err;
+    uint8_t     busy;           /* thread is reading from the base */
+    uint8_t     stop;
+    uint8_t     running;
+    uint8_t     sync_init;
+    pthread_t   thread;
+    pthread_mutex_t
+                mutex;
+    pthread_cond_t
+                fill_cond;      /* wakes the thread */
+    pthread_cond_t
+                ready_cond;     /* wakes the reader */
+} mz_stream_readahead;
+
+/***************************************************************************/
+
+static void *mz_stream_readahead_thread(void *arg)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)arg;
+    mz_stream_readahead_block *block = NULL;
+    uint32_t generation = 0;
+    int64_t offset = 0;
+    int32_t bytes_read = 0;
+    int32_t err = MZ_OK;
+    uint8_t seek = 0;
+
+    pthread_mutex_lock(&readahead->mutex);
+
+    for (;;)
+    {
+        while (!readahead->stop && (readahead->end || readahead->filled == readahead->block_count))
+            pthread_cond_wait(&readahead->fill_cond, &readahead->mutex);
+        if (readahead->stop)
+            break;
+
+        /* Blocks that aren't filled belong to the thread so the base can be
+           read without holding the lock */
+        block = &readahead->blocks[(readahead->head + readahead->filled) % readahead->block_count];
+        generation = readahead->generation;
+        offset = readahead->fill_offset;
+        seek = readahead->redirect;
+        readahead->redirect = 0;
+        readahead->busy = 1;
+
+        pthread_mutex_unlock(&readahead->mutex);
+
+        err = MZ_OK;
+        if (seek)
+            err = mz_stream_seek(readahead->stream.base, offset, MZ_SEEK_SET);
+        if (err == MZ_OK)
+            bytes_read = mz_stream_read(readahead->stream.base, block->data, readahead->block_size);
+        else
+            bytes_read = err;
+
+        pthread_mutex_lock(&readahead->mutex);
+
+        readahead->busy = 0;
+        if (generation == readahead->generation)
+        {
+            if (bytes_read <= 0)
+            {
+                readahead->end = 1;
+                readahead->end_err = bytes_read;
+            }
+            else
+            {
+                block->offset = offset;
+                block->length = bytes_read;
+                readahead->filled += 1;
+                readahead->fill_offset += bytes_read;
+            }
+        }
+        pthread_cond_broadcast(&readahead->ready_cond);
+    }
+
+    pthread_mutex_unlock(&readahead->mutex);
+    return NULL;
+}
+
+static int32_t mz_stream_readahead_start(void *stream)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    int32_t i = 0;
+
+    if (readahead->buffer == NULL || readahead->blocks == NULL)
+    {
+        MZ_FREE(readahead->buffer);
+        MZ_FREE(readahead->blocks);
+        readahead->buffer = (uint8_t *)MZ_ALLOC((size_t)readahead->block_count * readahead->block_size);
+        readahead->blocks = (mz_stream_readahead_block *)MZ_ALLOC(
+            sizeof(mz_stream_readahead_block) * readahead->block_count);
+        if (readahead->buffer == NULL || readahead->blocks == NULL)
+            return MZ_MEM_ERROR;
+        for (i = 0; i < readahead->block_count; i += 1)
+            readahead->blocks[i].data = readahead->buffer + ((size_t)i * readahead->block_size);
+    }
+
+    readahead->head = 0;
+    readahead->filled = 0;
+    readahead->head_pos = 0;
+    readahead->position = mz_stream_tell(readahead->stream.base);
+    if (readahead->position < 0)
+        return MZ_TELL_ERROR;
+    readahead->fill_offset = readahead->position;
+    readahead->redirect = 0;
+    readahead->end = 0;
+    readahead->end_err = MZ_OK;
+    readahead->busy = 0;
+    readahead->stop = 0;
+
+    if (pthread_create(&readahead->thread, NULL, mz_stream_readahead_thread, readahead) != 0)
+        return MZ_SUPPORT_ERROR;
+
+    readahead->running = 1;
+    return MZ_OK;
+}
+
+static void mz_stream_readahead_stop(void *stream)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+
+    if (!readahead->running)
+        return;
+
+    pthread_mutex_lock(&readahead->mutex);
+    readahead->stop = 1;
+    pthread_cond_signal(&readahead->fill_cond);
+    pthread_mutex_unlock(&readahead->mutex);
+
+    pthread_join(readahead->thread, NULL);
+    readahead->running = 0;
+}
+
+static int32_t mz_stream_readahead_next(void *stream, const uint8_t **ptr)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    mz_stream_readahead_block *block = NULL;
+    int32_t bytes_avail = 0;
+
+    pthread_mutex_lock(&readahead->mutex);
+
+    while (readahead->filled == 0 && !readahead->end)
+        pthread_cond_wait(&readahead->ready_cond, &readahead->mutex);
+
+    if (readahead->filled > 0)
+    {
+        block = &readahead->blocks[readahead->head];
+        *ptr = block->data + readahead->head_pos;
+        bytes_avail = block->length - readahead->head_pos;
+    }
+    else
+    {
+        bytes_avail = readahead->end_err;
+    }
+
+    pthread_mutex_unlock(&readahead->mutex);
+    return bytes_avail;
+}
+
+static void mz_stream_readahead_consume(void *stream, int32_t size)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+
+    /* Filled blocks belong to the reader so only handing the block back needs the lock */
+    readahead->head_pos += size;
+    readahead->position += size;
+
+    if (readahead->head_pos < readahead->blocks[readahead->head].length)
+        return;
+
+    pthread_mutex_lock(&readahead->mutex);
+    readahead->head = (readahead->head + 1) % readahead->block_count;
+    readahead->filled -= 1;
+    readahead->head_pos = 0;
+    pthread_cond_signal(&readahead->fill_cond);
+    pthread_mutex_unlock(&readahead->mutex);
+}
+
+/***************************************************************************/
+
+int32_t mz_stream_readahead_open(void *stream, const char *path, int32_t mode)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    int32_t err = MZ_OK;
+
+    err = mz_stream_open(readahead->stream.base, path, mode);
+    if (err != MZ_OK)
+        return err;
+
+    /* Writing goes straight through to the base */
+    if ((mode & MZ_OPEN_MODE_READWRITE) != MZ_OPEN_MODE_READ)
+        return MZ_OK;
+    if (!readahead->sync_init)
+        return MZ_OK;
+
+    /* Without a thread reads still work, just without reading ahead */
+    if (mz_stream_readahead_start(stream) != MZ_OK)
+        readahead->running = 0;
+    return MZ_OK;
+}
+
+int32_t mz_stream_readahead_is_open(void *stream)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    return mz_stream_is_open(readahead->stream.base);
+}
+
+int32_t mz_stream_readahead_read(void *stream, void *buf, int32_t size)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    const uint8_t *ptr = NULL;
+    int32_t bytes_avail = 0;
+    int32_t total = 0;
+
+    if (!readahead->running)
+        return mz_stream_read(readahead->stream.base, buf, size);
+
+    while (total < size)
+    {
+        bytes_avail = mz_stream_readahead_next(stream, &ptr);
+        if (bytes_avail <= 0)
+        {
+            if (total == 0)
+                return bytes_avail;
+            break;
+        }
+
+        if (bytes_avail > size - total)
+            bytes_avail = size - total;
+
+        memcpy((uint8_t *)buf + total, ptr, bytes_avail);
+        mz_stream_readahead_consume(stream, bytes_avail);
+        total += bytes_avail;
+    }
+
+    return total;
+}
+
+int32_t mz_stream_readahead_read_at(void *stream, int64_t offset, void *buf, int32_t size)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    /* Positional reads don't move the base so they can run alongside the thread */
+    return mz_stream_read_at(readahead->stream.base, offset, buf, size);
+}
+
+int32_t mz_stream_readahead_read_ptr(void *stream, const void **ptr, int32_t size)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    const uint8_t *block_ptr = NULL;
+    int32_t bytes_avail = 0;
+
+    if (!readahead->running)
+        return mz_stream_read_ptr(readahead->stream.base, ptr, size);
+    if (size <= 0)
+        return 0;
+
+    bytes_avail = mz_stream_readahead_next(stream, &block_ptr);
+    if (bytes_avail <= 0)
+        return bytes_avail;
+    if (bytes_avail > size)
+        bytes_avail = size;
+
+    *ptr = block_ptr;
+    return bytes_avail;
+}
+
+int32_t mz_stream_readahead_release(void *stream, int32_t size)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    int32_t bytes_avail = 0;
+
+    if (!readahead->running)
+        return mz_stream_release(readahead->stream.base, size);
+
+    pthread_mutex_lock(&readahead->mutex);
+    if (readahead->filled > 0)
+        bytes_avail = readahead->blocks[readahead->head].length - readahead->head_pos;
+    pthread_mutex_unlock(&readahead->mutex);
+
+    if (size < 0 || size > bytes_avail)
+        return MZ_PARAM_ERROR;
+    if (size > 0)
+        mz_stream_readahead_consume(stream, size);
+    return MZ_OK;
+}
+
+int32_t mz_stream_readahead_write(void *stream, const void *buf, int32_t size)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    if (readahead->running)
+        return MZ_SUPPORT_ERROR;
+    return mz_stream_write(readahead->stream.base, buf, size);
+}
+
+int64_t mz_stream_readahead_tell(void *stream)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    if (!readahead->running)
+        return mz_stream_tell(readahead->stream.base);
+    return readahead->position;
+}
+
+int32_t mz_stream_readahead_seek(void *stream, int64_t offset, int32_t origin)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    mz_stream_readahead_block *block = NULL;
+    int64_t new_pos = 0;
+    int32_t err = MZ_OK;
+
+    if (!readahead->running)
+        return mz_stream_seek(readahead->stream.base, offset, origin);
+
+    pthread_mutex_lock(&readahead->mutex);
+
+    switch (origin)
+    {
+        case MZ_SEEK_CUR:
+            new_pos = readahead->position + offset;
+            break;
+        case MZ_SEEK_END:
+            /* Size of the base is only known by seeking it, which can't
+               happen while the thread is reading from it */
+            while (readahead->busy)
+                pthread_cond_wait(&readahead->ready_cond, &readahead->mutex);
+            err = mz_stream_seek(readahead->stream.base, offset, MZ_SEEK_END);
+            if (err == MZ_OK)
+                new_pos = mz_stream_tell(readahead->stream.base);
+            readahead->redirect = 1;
+            break;
+        case MZ_SEEK_SET:
+            new_pos = offset;
+            break;
+        default:
+            err = MZ_SEEK_ERROR;
+            break;
+    }
+
+    if (err == MZ_OK && new_pos < 0)
+        err = MZ_SEEK_ERROR;
+    if (err != MZ_OK)
+    {
+        pthread_mutex_unlock(&readahead->mutex);
+        return err;
+    }
+
+    /* Skip forward through data that has already been read ahead */
+    while (readahead->filled > 0)
+    {
+        block = &readahead->blocks[readahead->head];
+        if (new_pos < block->offset)
+            break;
+        if (new_pos < block->offset + block->length)
+        {
+            readahead->head_pos = (int32_t)(new_pos - block->offset);
+            readahead->position = new_pos;
+            pthread_mutex_unlock(&readahead->mutex);
+            return MZ_OK;
+        }
+        readahead->head = (readahead->head + 1) % readahead->block_count;
+        readahead->filled -= 1;
+        readahead->head_pos = 0;
+        pthread_cond_signal(&readahead->fill_cond);
+    }
+
+    /* Anywhere else the thread starts over from the new position */
+    if (readahead->filled > 0 || new_pos != readahead->fill_offset || readahead->redirect)
+    {
+        readahead->generation += 1;
+        readahead->head = 0;
+        readahead->filled = 0;
+        readahead->fill_offset = new_pos;
+        readahead->redirect = 1;
+        readahead->end = 0;
+        readahead->end_err = MZ_OK;
+        pthread_cond_signal(&readahead->fill_cond);
+    }
+
+    readahead->head_pos = 0;
+    readahead->position = new_pos;
+
+    pthread_mutex_unlock(&readahead->mutex);
+    return MZ_OK;
+}
+
+int32_t mz_stream_readahead_close(void *stream)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    mz_stream_readahead_stop(stream);
+    return mz_stream_close(readahead->stream.base);
+}
+
+int32_t mz_stream_readahead_error(void *stream)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+    if (readahead->error != MZ_OK)
+        return readahead->error;
+    return mz_stream_error(readahead->stream.base);
+}
+
+void mz_stream_readahead_set_size(void *stream, int32_t size, int32_t block_size)
+{
+    mz_stream_readahead *readahead = (mz_stream_readahead *)stream;
+
+    if (readahead->running || size <= 0 || block_size <= 0)
+        return;
+
+    MZ_FREE(readahead->buffer);
+    MZ_FREE(readahead->blocks);
+    readahead->buffer = NULL;
+    readahead->blocks = NULL;
+
+    /* Two blocks at least so one can be read while the other is filled */
+    readahead->block_size = block_size;
+    readahead->block_count = size / block_size;
+    if (readahead->block_count < 2)
+        readahead->block_count = 2;
+}
+
+void *mz_stream_readahead_create(void **stream)
+{
+    mz_stream_readahead *readahead = NULL;
+
+    readahead = (mz_stream_readahead *)MZ_ALLOC(sizeof(mz_stream_readahead));
+    if (readahead != NULL)
+    {
+        memset(readahead, 0, sizeof(mz_stream_readahead));
+        readahead->stream.vtbl = &mz_stream_readahead_vtbl;
+        readahead->block_size = MZ_STREAM_READAHEAD_BLOCK_SIZE;
+        readahead->block_count = MZ_STREAM_READAHEAD_SIZE / MZ_STREAM_READAHEAD_BLOCK_SIZE;
+
+        if (pthread_mutex_init(&readahead->mutex, NULL) == 0)
+        {
+            if (pthread_cond_init(&readahead->fill_cond, NULL) == 0)
+            {
+                if (pthread_cond_init(&readahead->ready_cond, NULL) == 0)
+                    readahead->sync_init = 1;
+                else
+                    pthread_cond_destroy(&readahead->fill_cond);
+            }
+            if (!readahead->sync_init)
+                pthread_mutex_destroy(&readahead->mutex);
+        }
+    }
+    if (stream != NULL)
+        *stream = readahead;
+
+    return readahead;
+}
+
+void mz_stream_readahead_delete(void **stream)
+{
+    mz_stream_readahead *readahead = NULL;
+    if (stream == NULL)
+        return;
+    readahead = (mz_stream_readahead *)*stream;
+    if (readahead != NULL)
+    {
+        mz_stream_readahead_stop(readahead);
+        if (readahead->sync_init)
+        {
+            pthread_cond_destroy(&readahead->ready_cond);
+            pthread_cond_destroy(&readahead->fill_cond);
+            pthread_mutex_destroy(&readahead->mutex);
+        }
+        MZ_FREE(readahead->buffer);
+        MZ_FREE(readahead->blocks);
+        MZ_FREE(readahead);
+    }
+    *stream = NULL;
+}
+
+void *mz_stream_readahead_get_interface(void)
+{
+    return (void *)&mz_stream_readahead_vtbl;
+}
@@ -39,7 +39,13 @@ static mz_stream_vtbl mz_stream_split_vtbl = {
     mz_stream_split_create,
     mz_stream_split_delete,
     mz_stream_split_get_prop_int64,
-    mz_stream_split_set_prop_int64
+    mz_stream_split_set_prop_int64,
+    mz_stream_split_read_ptr,
+    mz_stream_split_release,
+    mz_stream_split_read_at,
+    mz_stream_split_copy_from,
+    mz_stream_split_copy_to,
+    mz_stream_split_writev
 };
 
 /***************************************************************************/
@@ -287,6 +293,59 @@ int32_t mz_stream_split_read(void *stream, void *buf, int32_t size)
     return size - bytes_left;
 }
 
+int32_t mz_stream_split_read_at(void *stream, int64_t offset, void *buf, int32_t size)
+{
+    mz_stream_split *split = (mz_stream_split *)stream;
+
+    /* Only the disk with the central directory can be read without switching disks */
+    if ((split->mode & MZ_OPEN_MODE_WRITE) || (split->current_disk != -1))
+        return MZ_SUPPORT_ERROR;
+    return mz_stream_read_at(split->stream.base, offset, buf, size);
+}
+
+int32_t mz_stream_split_read_ptr(void *stream, const void **ptr, int32_t size)
+{
+    mz_stream_split *split = (mz_stream_split *)stream;
+    int32_t read = 0;
+    int32_t err = MZ_OK;
+
+    err = mz_stream_split_goto_disk(stream, split->number_disk);
+    if (err != MZ_OK)
+        return err;
+
+    for (;;)
+    {
+        read = mz_stream_read_ptr(split->stream.base, ptr, size);
+        if (read != 0 || size <= 0)
+            break;
+        if (split->current_disk < 0) /* No more disks to goto */
+            break;
+        err = mz_stream_split_goto_disk(stream, split->current_disk + 1);
+        if (err == MZ_EXIST_ERROR)
+        {
+            split->current_disk = -1;
+            break;
+        }
+        if (err != MZ_OK)
+            return err;
+    }
+    return read;
+}
+
+int32_t mz_stream_split_release(void *stream, int32_t size)
+{
+    mz_stream_split *split = (mz_stream_split *)stream;
+    int32_t err = MZ_OK;
+
+    err = mz_stream_release(split->stream.base, size);
+    if (err == MZ_OK)
+    {
+        split->total_in += size;
+        split->total_in_disk += size;
+    }
+    return err;
+}
+
 int32_t mz_stream_split_write(void *stream, const void *buf, int32_t size)
 {
     mz_stream_split *split = (mz_stream_split *)stream;
@@ -338,6 +397,76 @@ int32_t mz_stream_split_write(void *stream, const void *buf, int32_t size)
     return size - bytes_left;
 }
 
+int32_t mz_stream_split_writev(void *stream, const mz_stream_iovec *iov, int32_t iov_count)
+{
+    mz_stream_split *split = (mz_stream_split *)stream;
+    int32_t total_written = 0;
+    int32_t written = 0;
+    int32_t i = 0;
+
+    /* Buffers may need to be cut at disk boundaries so they are written one at a time when splitting */
+    if (split->disk_size > 0)
+    {
+        for (i = 0; i < iov_count; i += 1)
+        {
+            written = mz_stream_split_write(stream, iov[i].buf, iov[i].size);
+            if (written < 0)
+                return written;
+            total_written += written;
+        }
+        return total_written;
+    }
+
+    written = mz_stream_writev(split->stream.base, iov, iov_count);
+    if (written > 0)
+    {
+        split->total_out += written;
+        split->total_out_disk += written;
+    }
+    return written;
+}
+
+int32_t mz_stream_split_copy_from(void *stream, void *source, int32_t size)
+{
+    mz_stream_split *split = (mz_stream_split *)stream;
+    int32_t copied = 0;
+
+    /* Copies can't be cut at disk boundaries so they are only done when not splitting */
+    if (split->disk_size > 0)
+        return MZ_SUPPORT_ERROR;
+
+    copied = mz_stream_copy_from(split->stream.base, source, size);
+    if (copied > 0)
+    {
+        split->total_out += copied;
+        split->total_out_disk += copied;
+    }
+    return copied;
+}
+
+int32_t mz_stream_split_copy_to(void *stream, void *target, int32_t size)
+{
+    mz_stream_split *split = (mz_stream_split *)stream;
+    int32_t copied = 0;
+    int32_t err = MZ_OK;
+
+    err = mz_stream_split_goto_disk(stream, split->number_disk);
+    if (err != MZ_OK)
+        return err;
+
+    /* Only the disk with the central directory has no following disk to continue on */
+    if ((split->mode & MZ_OPEN_MODE_WRITE) || (split->current_disk != -1))
+        return MZ_SUPPORT_ERROR;
+
+    copied = mz_stream_copy_to(split->stream.base, target, size);
+    if (copied > 0)
+    {
+        split->total_in += copied;
+        split->total_in_disk += copied;
+    }
+    return copied;
+}
+
 int64_t mz_stream_split_tell(void *stream)
 {
     mz_stream_split *split = (mz_stream_split *)stream;
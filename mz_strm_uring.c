@@ -0,0 +1,924 @@
+/* mz_strm_uring.c -- Stream for asynchronous filesystem access using io_uring
+   part of the MiniZip project
+
+   This version of ioapi hands reads and writes to the kernel through an
+   io_uring submission queue. Reads are served from a small set of buffers
+   registered with the ring that are filled ahead of the stream position,
+   or ahead of time for ranges passed to mz_stream_uring_prefetch. Writes
+   are copied into a buffer and completed in the background. When the ring
+   can't be set up the stream falls back to pread and pwrite.
+
+   Copyright (C) 2026 The MiniZip contributors
+     https://github.com/nmoinvaz/minizip
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+*/
+
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE   /* syscall */
+#endif
+
+#include "mz.h"
+#include "mz_strm.h"
+#include "mz_strm_uring.h"
+
+#include <errno.h>
+#include <fcntl.h>              /* open, posix_fadvise */
+#include <linux/io_uring.h>
+#include <sys/mman.h>           /* mmap */
+#include <sys/stat.h>           /* fstat */
+#include <sys/syscall.h>
+#include <sys/uio.h>            /* iovec */
+#include <unistd.h>             /* close, pread, pwrite, syscall */
+
+/***************************************************************************/
+
+#define MZ_URING_SLOT_FREE              (0)
+#define MZ_URING_SLOT_READING           (1)
+#define MZ_URING_SLOT_READY             (2)
+#define MZ_URING_SLOT_WRITING           (3)
+
+/***************************************************************************/
+
+static mz_stream_vtbl mz_stream_uring_vtbl = {
+    mz_stream_uring_open,
+    mz_stream_uring_is_open,
+    mz_stream_uring_read,
+    mz_stream_uring_write,
+    mz_stream_uring_tell,
+    mz_stream_uring_seek,
+    mz_stream_uring_close,
+    mz_stream_uring_error,
+    mz_stream_uring_create,
+    mz_stream_uring_delete,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    mz_stream_uring_read_at,
+    NULL,
+    NULL,
+    NULL
+};
+
+/***************************************************************************/
+
+typedef struct mz_stream_uring_slot_s
+{
+    struct iovec iov;           /* buffer and length of the request */
+    int32_t     state;
+    int64_t     offset;
+    int32_t     length;         /* bytes requested, bytes read once ready */
+    uint8_t     consumed;       /* read from at least once since filled */
+    uint64_t    last_used;
+} mz_stream_uring_slot;
+
+typedef struct mz_stream_uring_s
+{
+    mz_stream   stream;
+    int32_t     error;
+    uint8_t     write_failed;
+    int         fd;
+    int         ring_fd;
+    int32_t     queue_depth;
+    int32_t     buffer_size;
+    int64_t     position;
+    int64_t     file_size;
+    uint8_t     *buffers;
+    mz_stream_uring_slot *slots;
+    uint8_t     fixed;          /* buffers are registered with the ring */
+    int32_t     in_flight;
+    int32_t     to_submit;
+    uint64_t    tick;
+    void        *sq_ring;
+    size_t      sq_ring_size;
+    void        *cq_ring;
+    size_t      cq_ring_size;
+    unsigned    *sq_tail;
+    unsigned    *sq_mask;
+    unsigned    *sq_array;
+    struct io_uring_sqe *sqes;
+    size_t      sqes_size;
+    unsigned    *cq_head;
+    unsigned    *cq_tail;
+    unsigned    *cq_mask;
+    struct io_uring_cqe *cqes;
+} mz_stream_uring;
+
+/***************************************************************************/
+
+static void mz_stream_uring_ring_teardown(void *stream)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+
+    if (uring->sqes != NULL)
+        munmap(uring->sqes, uring->sqes_size);
+    if (uring->cq_ring != NULL && uring->cq_ring != uring->sq_ring)
+        munmap(uring->cq_ring, uring->cq_ring_size);
+    if (uring->sq_ring != NULL)
+        munmap(uring->sq_ring, uring->sq_ring_size);
+    if (uring->ring_fd != -1)
+        close(uring->ring_fd);
+
+    uring->sqes = NULL;
+    uring->cq_ring = NULL;
+    uring->sq_ring = NULL;
+    uring->ring_fd = -1;
+    uring->fixed = 0;
+    uring->in_flight = 0;
+    uring->to_submit = 0;
+}
+
+static int32_t mz_stream_uring_ring_setup(void *stream)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    struct io_uring_params params;
+    struct iovec *iovecs = NULL;
+    uint8_t *sq_ring = NULL;
+    uint8_t *cq_ring = NULL;
+    void *ptr = NULL;
+    int32_t i = 0;
+
+    memset(&params, 0, sizeof(params));
+
+    uring->ring_fd = (int)syscall(__NR_io_uring_setup, (unsigned)uring->queue_depth, &params);
+    if (uring->ring_fd < 0)
+    {
+        uring->ring_fd = -1;
+        return MZ_SUPPORT_ERROR;
+    }
+
+    uring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    uring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    /* Newer kernels map both rings with a single call */
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (uring->cq_ring_size > uring->sq_ring_size)
+            uring->sq_ring_size = uring->cq_ring_size;
+        uring->cq_ring_size = uring->sq_ring_size;
+    }
+
+    ptr = mmap(NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+        uring->ring_fd, IORING_OFF_SQ_RING);
+    if (ptr == MAP_FAILED)
+        return MZ_SUPPORT_ERROR;
+    uring->sq_ring = ptr;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        uring->cq_ring = uring->sq_ring;
+    else
+    {
+        ptr = mmap(NULL, uring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+            uring->ring_fd, IORING_OFF_CQ_RING);
+        if (ptr == MAP_FAILED)
+            return MZ_SUPPORT_ERROR;
+        uring->cq_ring = ptr;
+    }
+
+    uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ptr = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+        uring->ring_fd, IORING_OFF_SQES);
+    if (ptr == MAP_FAILED)
+        return MZ_SUPPORT_ERROR;
+    uring->sqes = (struct io_uring_sqe *)ptr;
+
+    sq_ring = (uint8_t *)uring->sq_ring;
+    uring->sq_tail = (unsigned *)(sq_ring + params.sq_off.tail);
+    uring->sq_mask = (unsigned *)(sq_ring + params.sq_off.ring_mask);
+    uring->sq_array = (unsigned *)(sq_ring + params.sq_off.array);
+
+    cq_ring = (uint8_t *)uring->cq_ring;
+    uring->cq_head = (unsigned *)(cq_ring + params.cq_off.head);
+    uring->cq_tail = (unsigned *)(cq_ring + params.cq_off.tail);
+    uring->cq_mask = (unsigned *)(cq_ring + params.cq_off.ring_mask);
+    uring->cqes = (struct io_uring_cqe *)(cq_ring + params.cq_off.cqes);
+
+    /* Registered buffers save the kernel from mapping pages on every request,
+       if registration is refused (memlock limits) plain requests are used */
+    iovecs = (struct iovec *)MZ_ALLOC(sizeof(struct iovec) * uring->queue_depth);
+    if (iovecs != NULL)
+    {
+        for (i = 0; i < uring->queue_depth; i += 1)
+        {
+            iovecs[i].iov_base = uring->buffers + ((size_t)i * uring->buffer_size);
+            iovecs[i].iov_len = (size_t)uring->buffer_size;
+        }
+        if (syscall(__NR_io_uring_register, uring->ring_fd, IORING_REGISTER_BUFFERS,
+            iovecs, (unsigned)uring->queue_depth) == 0)
+            uring->fixed = 1;
+        MZ_FREE(iovecs);
+    }
+
+    return MZ_OK;
+}
+
+static int32_t mz_stream_uring_submit(void *stream, int32_t slot_index, uint8_t is_write)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    mz_stream_uring_slot *slot = &uring->slots[slot_index];
+    struct io_uring_sqe *sqe = NULL;
+    unsigned tail = 0;
+    unsigned index = 0;
+
+    tail = *uring->sq_tail;
+    index = tail & *uring->sq_mask;
+    sqe = &uring->sqes[index];
+
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->fd = uring->fd;
+    sqe->off = (uint64_t)slot->offset;
+    sqe->user_data = (uint64_t)slot_index;
+
+    slot->iov.iov_len = (size_t)slot->length;
+
+    if (uring->fixed)
+    {
+        sqe->opcode = (is_write) ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+        sqe->addr = (uint64_t)(uintptr_t)slot->iov.iov_base;
+        sqe->len = (uint32_t)slot->length;
+        sqe->buf_index = (uint16_t)slot_index;
+    }
+    else
+    {
+        sqe->opcode = (is_write) ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe->addr = (uint64_t)(uintptr_t)&slot->iov;
+        sqe->len = 1;
+    }
+
+    uring->sq_array[index] = index;
+    __atomic_store_n(uring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    uring->to_submit += 1;
+    uring->in_flight += 1;
+    return MZ_OK;
+}
+
+static int32_t mz_stream_uring_enter(void *stream, uint32_t wait_count)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    unsigned flags = 0;
+    int result = 0;
+
+    if (uring->to_submit == 0 && wait_count == 0)
+        return MZ_OK;
+    if (wait_count > 0)
+        flags |= IORING_ENTER_GETEVENTS;
+
+    do
+    {
+        result = (int)syscall(__NR_io_uring_enter, uring->ring_fd, (unsigned)uring->to_submit,
+            wait_count, flags, NULL, 0);
+    }
+    while (result < 0 && errno == EINTR);
+
+    if (result < 0)
+    {
+        uring->error = errno;
+        return MZ_STREAM_ERROR;
+    }
+
+    uring->to_submit -= result;
+    return MZ_OK;
+}
+
+static int32_t mz_stream_uring_reap(void *stream)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    mz_stream_uring_slot *slot = NULL;
+    struct io_uring_cqe *cqe = NULL;
+    unsigned head = 0;
+    unsigned tail = 0;
+    int32_t completed = 0;
+
+    head = *uring->cq_head;
+    tail = __atomic_load_n(uring->cq_tail, __ATOMIC_ACQUIRE);
+
+    while (head != tail)
+    {
+        cqe = &uring->cqes[head & *uring->cq_mask];
+        slot = &uring->slots[cqe->user_data];
+
+        if (slot->state == MZ_URING_SLOT_READING)
+        {
+            /* A failed read only drops its block, the range is read again
+               synchronously if it is ever requested */
+            if (cqe->res < 0)
+                slot->state = MZ_URING_SLOT_FREE;
+            else
+            {
+                slot->length = cqe->res;
+                slot->state = MZ_URING_SLOT_READY;
+            }
+        }
+        else if (slot->state == MZ_URING_SLOT_WRITING)
+        {
+            if (cqe->res != slot->length)
+            {
+                uring->error = (cqe->res < 0) ? -cqe->res : EIO;
+                uring->write_failed = 1;
+            }
+            slot->state = MZ_URING_SLOT_FREE;
+        }
+
+        uring->in_flight -= 1;
+        completed += 1;
+        head += 1;
+    }
+
+    __atomic_store_n(uring->cq_head, head, __ATOMIC_RELEASE);
+    return completed;
+}
+
+static int32_t mz_stream_uring_wait(void *stream)
+{
+    int32_t err = MZ_OK;
+
+    err = mz_stream_uring_enter(stream, 1);
+    if (err == MZ_OK)
+        mz_stream_uring_reap(stream);
+    return err;
+}
+
+static int32_t mz_stream_uring_slot_overlaps(void *stream, int32_t slot_index, int64_t offset, int64_t size)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    mz_stream_uring_slot *slot = &uring->slots[slot_index];
+    int64_t slot_size = slot->length;
+
+    /* Reads always cover a whole block, even after a short read at the end of file */
+    if (slot->state != MZ_URING_SLOT_WRITING)
+        slot_size = uring->buffer_size;
+
+    if (slot->offset >= offset + size || offset >= slot->offset + slot_size)
+        return 0;
+    return 1;
+}
+
+static int32_t mz_stream_uring_wait_range(void *stream, int32_t state, int64_t offset, int64_t size)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    int32_t err = MZ_OK;
+    int32_t found = 0;
+    int32_t i = 0;
+
+    do
+    {
+        found = 0;
+        for (i = 0; i < uring->queue_depth && !found; i += 1)
+        {
+            if (uring->slots[i].state != state)
+                continue;
+            if (mz_stream_uring_slot_overlaps(stream, i, offset, size))
+                found = 1;
+        }
+        if (found)
+            err = mz_stream_uring_wait(stream);
+    }
+    while (found && err == MZ_OK);
+
+    return err;
+}
+
+static int32_t mz_stream_uring_slot_find(void *stream, int64_t position)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    mz_stream_uring_slot *slot = NULL;
+    int32_t i = 0;
+
+    for (i = 0; i < uring->queue_depth; i += 1)
+    {
+        slot = &uring->slots[i];
+        if (slot->state != MZ_URING_SLOT_READING && slot->state != MZ_URING_SLOT_READY)
+            continue;
+        if (position >= slot->offset && position < slot->offset + uring->buffer_size)
+            return i;
+    }
+
+    return -1;
+}
+
+static int32_t mz_stream_uring_slot_get(void *stream, uint8_t evict_unread, uint8_t wait)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    mz_stream_uring_slot *slot = NULL;
+    int32_t oldest = -1;
+    int32_t i = 0;
+
+    for (;;)
+    {
+        oldest = -1;
+        for (i = 0; i < uring->queue_depth; i += 1)
+        {
+            slot = &uring->slots[i];
+            if (slot->state == MZ_URING_SLOT_FREE)
+                return i;
+            if (slot->state != MZ_URING_SLOT_READY)
+                continue;
+            if (!evict_unread && !slot->consumed)
+                continue;
+            if (oldest == -1 || slot->last_used < uring->slots[oldest].last_used)
+                oldest = i;
+        }
+
+        if (oldest != -1)
+        {
+            uring->slots[oldest].state = MZ_URING_SLOT_FREE;
+            return oldest;
+        }
+
+        if (!wait || uring->in_flight == 0)
+            return -1;
+        if (mz_stream_uring_wait(stream) != MZ_OK)
+            return -1;
+    }
+}
+
+static int32_t mz_stream_uring_submit_read(void *stream, int32_t slot_index, int64_t offset, uint8_t consumed)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    mz_stream_uring_slot *slot = &uring->slots[slot_index];
+
+    slot->state = MZ_URING_SLOT_READING;
+    slot->offset = offset;
+    slot->length = uring->buffer_size;
+    slot->consumed = consumed;
+    slot->last_used = ++uring->tick;
+
+    return mz_stream_uring_submit(stream, slot_index, 0);
+}
+
+static int32_t mz_stream_uring_read_ahead(void *stream, int64_t position)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    int64_t block = 0;
+    int32_t read_ahead = 0;
+    int32_t slot_index = 0;
+    int32_t i = 0;
+
+    block = position - (position % uring->buffer_size);
+
+    if (mz_stream_uring_wait_range(stream, MZ_URING_SLOT_WRITING, block, uring->buffer_size) != MZ_OK)
+        return MZ_READ_ERROR;
+
+    slot_index = mz_stream_uring_slot_get(stream, 1, 1);
+    if (slot_index < 0)
+        return MZ_READ_ERROR;
+    mz_stream_uring_submit_read(stream, slot_index, block, 1);
+
+    /* Keep the following blocks in flight while this one is being used,
+       leaving the other half of the slots for prefetched ranges */
+    read_ahead = uring->queue_depth / 2;
+    for (i = 0; i < uring->queue_depth; i += 1)
+    {
+        if (uring->slots[i].state == MZ_URING_SLOT_WRITING)
+            read_ahead = 0;
+    }
+    for (i = 1; i <= read_ahead; i += 1)
+    {
+        block += uring->buffer_size;
+        if (block >= uring->file_size)
+            break;
+        if (mz_stream_uring_slot_find(stream, block) >= 0)
+            continue;
+        slot_index = mz_stream_uring_slot_get(stream, 0, 0);
+        if (slot_index < 0)
+            break;
+        mz_stream_uring_submit_read(stream, slot_index, block, 1);
+    }
+
+    return mz_stream_uring_enter(stream, 0);
+}
+
+/***************************************************************************/
+
+int32_t mz_stream_uring_open(void *stream, const char *path, int32_t mode)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    struct stat file_stat;
+    int flags = 0;
+    int32_t i = 0;
+
+    if (path == NULL)
+        return MZ_PARAM_ERROR;
+
+    if ((mode & MZ_OPEN_MODE_READWRITE) == MZ_OPEN_MODE_READ)
+        flags = O_RDONLY;
+    else if (mode & MZ_OPEN_MODE_APPEND)
+        flags = O_RDWR;
+    else if (mode & MZ_OPEN_MODE_CREATE)
+        flags = O_RDWR | O_CREAT | O_TRUNC;
+    else
+        return MZ_OPEN_ERROR;
+
+    uring->fd = open(path, flags | O_CLOEXEC, 0666);
+    if (uring->fd == -1)
+    {
+        uring->error = errno;
+        return MZ_OPEN_ERROR;
+    }
+
+    if (fstat(uring->fd, &file_stat) != 0)
+    {
+        uring->error = errno;
+        mz_stream_uring_close(stream);
+        return MZ_OPEN_ERROR;
+    }
+
+    uring->file_size = file_stat.st_size;
+    uring->position = 0;
+    uring->write_failed = 0;
+
+    if (posix_memalign((void **)&uring->buffers, (size_t)sysconf(_SC_PAGESIZE),
+        (size_t)uring->queue_depth * uring->buffer_size) != 0)
+        uring->buffers = NULL;
+    uring->slots = (mz_stream_uring_slot *)MZ_ALLOC(sizeof(mz_stream_uring_slot) * uring->queue_depth);
+
+    if (uring->buffers != NULL && uring->slots != NULL)
+    {
+        memset(uring->slots, 0, sizeof(mz_stream_uring_slot) * uring->queue_depth);
+        for (i = 0; i < uring->queue_depth; i += 1)
+            uring->slots[i].iov.iov_base = uring->buffers + ((size_t)i * uring->buffer_size);
+
+        /* Kernels without io_uring, or with it disabled, use the synchronous path */
+        if (mz_stream_uring_ring_setup(stream) != MZ_OK)
+            mz_stream_uring_ring_teardown(stream);
+    }
+
+    if (mode & MZ_OPEN_MODE_APPEND)
+        uring->position = uring->file_size;
+
+    return MZ_OK;
+}
+
+int32_t mz_stream_uring_is_open(void *stream)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    if (uring->fd == -1)
+        return MZ_OPEN_ERROR;
+    return MZ_OK;
+}
+
+int32_t mz_stream_uring_read(void *stream, void *buf, int32_t size)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    mz_stream_uring_slot *slot = NULL;
+    int64_t bytes_avail = 0;
+    int32_t bytes_to_copy = 0;
+    int32_t slot_index = 0;
+    int32_t total = 0;
+    int32_t err = MZ_OK;
+
+    if (uring->ring_fd == -1)
+    {
+        total = mz_stream_uring_read_at(stream, uring->position, buf, size);
+        if (total > 0)
+            uring->position += total;
+        return total;
+    }
+
+    /* Reads can't pass writes of the same data that are still in flight */
+    err = mz_stream_uring_wait_range(stream, MZ_URING_SLOT_WRITING, uring->position, size);
+    if (err != MZ_OK)
+        return MZ_READ_ERROR;
+
+    while (total < size)
+    {
+        slot_index = mz_stream_uring_slot_find(stream, uring->position);
+        if (slot_index < 0)
+        {
+            err = mz_stream_uring_read_ahead(stream, uring->position);
+            if (err != MZ_OK)
+                return MZ_READ_ERROR;
+            continue;
+        }
+
+        slot = &uring->slots[slot_index];
+        if (slot->state == MZ_URING_SLOT_READING)
+        {
+            if (mz_stream_uring_wait(stream) != MZ_OK)
+                return MZ_READ_ERROR;
+            if (slot->state != MZ_URING_SLOT_FREE)
+                continue;
+
+            /* The block holding the requested range failed, retry it without the ring */
+            err = mz_stream_uring_read_at(stream, uring->position, (uint8_t *)buf + total, size - total);
+            if (err < 0)
+                return MZ_READ_ERROR;
+            uring->position += err;
+            total += err;
+            break;
+        }
+
+        /* A short block is the end of the file */
+        bytes_avail = slot->offset + slot->length - uring->position;
+        if (bytes_avail <= 0)
+            break;
+
+        bytes_to_copy = size - total;
+        if (bytes_to_copy > bytes_avail)
+            bytes_to_copy = (int32_t)bytes_avail;
+
+        memcpy((uint8_t *)buf + total, (uint8_t *)slot->iov.iov_base + (uring->position - slot->offset),
+            bytes_to_copy);
+
+        slot->consumed = 1;
+        slot->last_used = ++uring->tick;
+
+        uring->position += bytes_to_copy;
+        total += bytes_to_copy;
+    }
+
+    return total;
+}
+
+int32_t mz_stream_uring_read_at(void *stream, int64_t offset, void *buf, int32_t size)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    ssize_t bytes_read = 0;
+    int32_t total = 0;
+
+    /* Positional reads go straight to the file without touching the ring,
+       so they are safe to call from other threads */
+    while (total < size)
+    {
+        bytes_read = pread(uring->fd, (uint8_t *)buf + total, (size_t)(size - total), offset + total);
+        if (bytes_read < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            uring->error = errno;
+            return MZ_READ_ERROR;
+        }
+        if (bytes_read == 0)
+            break;
+        total += (int32_t)bytes_read;
+    }
+
+    return total;
+}
+
+int32_t mz_stream_uring_write(void *stream, const void *buf, int32_t size)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    mz_stream_uring_slot *slot = NULL;
+    ssize_t bytes_written = 0;
+    int32_t bytes_to_copy = 0;
+    int32_t slot_index = 0;
+    int32_t total = 0;
+    int32_t i = 0;
+
+    if (uring->ring_fd == -1)
+    {
+        while (total < size)
+        {
+            bytes_written = pwrite(uring->fd, (const uint8_t *)buf + total, (size_t)(size - total),
+                uring->position + total);
+            if (bytes_written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                uring->error = errno;
+                return MZ_WRITE_ERROR;
+            }
+            total += (int32_t)bytes_written;
+        }
+    }
+    else
+    {
+        if (uring->write_failed)
+            return MZ_WRITE_ERROR;
+
+        /* Writes can't pass reads or writes of the same data that are still in flight */
+        if (mz_stream_uring_wait_range(stream, MZ_URING_SLOT_READING, uring->position, size) != MZ_OK)
+            return MZ_WRITE_ERROR;
+        if (mz_stream_uring_wait_range(stream, MZ_URING_SLOT_WRITING, uring->position, size) != MZ_OK)
+            return MZ_WRITE_ERROR;
+
+        for (i = 0; i < uring->queue_depth; i += 1)
+        {
+            if (uring->slots[i].state != MZ_URING_SLOT_READY)
+                continue;
+            if (mz_stream_uring_slot_overlaps(stream, i, uring->position, size))
+                uring->slots[i].state = MZ_URING_SLOT_FREE;
+        }
+
+        while (total < size)
+        {
+            slot_index = mz_stream_uring_slot_get(stream, 1, 1);
+            if (slot_index < 0)
+                return MZ_WRITE_ERROR;
+
+            bytes_to_copy = size - total;
+            if (bytes_to_copy > uring->buffer_size)
+                bytes_to_copy = uring->buffer_size;
+
+            slot = &uring->slots[slot_index];
+            memcpy(slot->iov.iov_base, (const uint8_t *)buf + total, bytes_to_copy);
+
+            slot->state = MZ_URING_SLOT_WRITING;
+            slot->offset = uring->position + total;
+            slot->length = bytes_to_copy;
+            slot->consumed = 0;
+
+            mz_stream_uring_submit(stream, slot_index, 1);
+            total += bytes_to_copy;
+        }
+
+        if (mz_stream_uring_enter(stream, 0) != MZ_OK)
+            return MZ_WRITE_ERROR;
+    }
+
+    uring->position += total;
+    if (uring->position > uring->file_size)
+        uring->file_size = uring->position;
+
+    return total;
+}
+
+int64_t mz_stream_uring_tell(void *stream)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    return uring->position;
+}
+
+int32_t mz_stream_uring_seek(void *stream, int64_t offset, int32_t origin)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    int64_t new_pos = 0;
+
+    switch (origin)
+    {
+        case MZ_SEEK_CUR:
+            new_pos = uring->position + offset;
+            break;
+        case MZ_SEEK_END:
+            new_pos = uring->file_size + offset;
+            break;
+        case MZ_SEEK_SET:
+            new_pos = offset;
+            break;
+        default:
+            return MZ_SEEK_ERROR;
+    }
+
+    if (new_pos < 0)
+        return MZ_SEEK_ERROR;
+
+    uring->position = new_pos;
+    return MZ_OK;
+}
+
+int32_t mz_stream_uring_prefetch(void *stream, int64_t offset, int64_t size)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    int64_t block = 0;
+    int32_t slot_index = 0;
+    int32_t i = 0;
+
+    if (uring->fd == -1)
+        return MZ_OPEN_ERROR;
+    if (offset < 0 || size <= 0)
+        return MZ_PARAM_ERROR;
+
+    if (uring->ring_fd == -1)
+    {
+        posix_fadvise(uring->fd, offset, size, POSIX_FADV_WILLNEED);
+        return MZ_OK;
+    }
+
+    /* Prefetching is only a hint, skip it while writes are outstanding */
+    for (i = 0; i < uring->queue_depth; i += 1)
+    {
+        if (uring->slots[i].state == MZ_URING_SLOT_WRITING)
+            return MZ_OK;
+    }
+
+    mz_stream_uring_reap(stream);
+
+    block = offset - (offset % uring->buffer_size);
+    for (; block < offset + size && block < uring->file_size; block += uring->buffer_size)
+    {
+        if (mz_stream_uring_slot_find(stream, block) >= 0)
+            continue;
+        /* Never wait for a slot or evict data that hasn't been read yet */
+        slot_index = mz_stream_uring_slot_get(stream, 0, 0);
+        if (slot_index < 0)
+            break;
+        mz_stream_uring_submit_read(stream, slot_index, block, 0);
+    }
+
+    return mz_stream_uring_enter(stream, 0);
+}
+
+int32_t mz_stream_uring_complete(void *stream, uint8_t wait)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+
+    if (uring->ring_fd == -1)
+        return 0;
+
+    if (mz_stream_uring_enter(stream, 0) == MZ_OK)
+        mz_stream_uring_reap(stream);
+
+    while (wait && uring->in_flight > 0)
+    {
+        if (mz_stream_uring_wait(stream) != MZ_OK)
+            break;
+    }
+
+    return uring->in_flight;
+}
+
+int32_t mz_stream_uring_close(void *stream)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    int32_t closed = 1;
+
+    if (uring->ring_fd != -1)
+    {
+        mz_stream_uring_complete(stream, 1);
+        mz_stream_uring_ring_teardown(stream);
+    }
+
+    if (uring->fd != -1)
+    {
+        closed = (close(uring->fd) == 0);
+        if (!closed)
+            uring->error = errno;
+        uring->fd = -1;
+    }
+
+    if (uring->buffers != NULL)
+        free(uring->buffers);
+    uring->buffers = NULL;
+    if (uring->slots != NULL)
+        MZ_FREE(uring->slots);
+    uring->slots = NULL;
+
+    if (!closed || uring->write_failed)
+        return MZ_CLOSE_ERROR;
+    return MZ_OK;
+}
+
+int32_t mz_stream_uring_error(void *stream)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    return uring->error;
+}
+
+void mz_stream_uring_set_queue_depth(void *stream, int32_t queue_depth)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    if (uring->fd != -1 || queue_depth <= 0)
+        return;
+    uring->queue_depth = queue_depth;
+}
+
+void mz_stream_uring_set_buffer_size(void *stream, int32_t buffer_size)
+{
+    mz_stream_uring *uring = (mz_stream_uring *)stream;
+    if (uring->fd != -1 || buffer_size <= 0)
+        return;
+    uring->buffer_size = buffer_size;
+}
+
+void *mz_stream_uring_create(void **stream)
+{
+    mz_stream_uring *uring = NULL;
+
+    uring = (mz_stream_uring *)MZ_ALLOC(sizeof(mz_stream_uring));
+    if (uring != NULL)
+    {
+        memset(uring, 0, sizeof(mz_stream_uring));
+        uring->stream.vtbl = &mz_stream_uring_vtbl;
+        uring->fd = -1;
+        uring->ring_fd = -1;
+        uring->queue_depth = MZ_STREAM_URING_QUEUE_DEPTH;
+        uring->buffer_size = MZ_STREAM_URING_BUFFER_SIZE;
+    }
+    if (stream != NULL)
+        *stream = uring;
+
+    return uring;
+}
+
+void mz_stream_uring_delete(void **stream)
+{
+    mz_stream_uring *uring = NULL;
+    if (stream == NULL)
+        return;
+    uring = (mz_stream_uring *)*stream;
+    if (uring != NULL)
+    {
+        mz_stream_uring_close(uring);
+        MZ_FREE(uring);
+    }
+    *stream = NULL;
+}
+
+void *mz_stream_uring_get_interface(void)
+{
+    return (void *)&mz_stream_uring_vtbl;
+}
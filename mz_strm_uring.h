@@ -0,0 +1,51 @@
+/* mz_strm_uring.h -- Stream for asynchronous filesystem access using io_uring
+   part of the MiniZip project
+
+   Copyright (C) 2026 The MiniZip contributors
+      https://github.com/nmoinvaz/minizip
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+*/
+
+#ifndef MZ_STREAM_URING_H
+#define MZ_STREAM_URING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************/
+
+#define MZ_STREAM_URING_QUEUE_DEPTH     (8)
+#define MZ_STREAM_URING_BUFFER_SIZE     (64 * 1024)
+
+/***************************************************************************/
+
+int32_t mz_stream_uring_open(void *stream, const char *path, int32_t mode);
+int32_t mz_stream_uring_is_open(void *stream);
+int32_t mz_stream_uring_read(void *stream, void *buf, int32_t size);
+int32_t mz_stream_uring_read_at(void *stream, int64_t offset, void *buf, int32_t size);
+int32_t mz_stream_uring_write(void *stream, const void *buf, int32_t size);
+int64_t mz_stream_uring_tell(void *stream);
+int32_t mz_stream_uring_seek(void *stream, int64_t offset, int32_t origin);
+int32_t mz_stream_uring_close(void *stream);
+int32_t mz_stream_uring_error(void *stream);
+
+void    mz_stream_uring_set_queue_depth(void *stream, int32_t queue_depth);
+void    mz_stream_uring_set_buffer_size(void *stream, int32_t buffer_size);
+int32_t mz_stream_uring_prefetch(void *stream, int64_t offset, int64_t size);
+int32_t mz_stream_uring_complete(void *stream, uint8_t wait);
+
+void*   mz_stream_uring_create(void **stream);
+void    mz_stream_uring_delete(void **stream);
+
+void*   mz_stream_uring_get_interface(void);
+
+/***************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
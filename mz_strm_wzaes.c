@@ -39,7 +39,13 @@ static mz_stream_vtbl mz_stream_wzaes_vtbl = {
     mz_stream_wzaes_create,
     mz_stream_wzaes_delete,
     mz_stream_wzaes_get_prop_int64,
-    mz_stream_wzaes_set_prop_int64
+    mz_stream_wzaes_set_prop_int64,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
 };
 
 /***************************************************************************/
@@ -175,7 +181,7 @@ int32_t mz_stream_wzaes_is_open(void *stream)
     return MZ_OK;
 }
 
-static int32_t mz_stream_wzaes_ctr_encrypt(void *stream, uint8_t *buf, int32_t size)
+static int32_t mz_stream_wzaes_ctr_encrypt(void *stream, const uint8_t *src, uint8_t *dst, int32_t size)
 {
     mz_stream_wzaes *wzaes = (mz_stream_wzaes *)stream;
     uint32_t pos = wzaes->crypt_pos;
@@ -198,7 +204,8 @@ static int32_t mz_stream_wzaes_ctr_encrypt(void *stream, uint8_t *buf, int32_t s
             pos = 0;
         }
 
-        buf[i++] ^= wzaes->crypt_block[pos++];
+        dst[i] = src[i] ^ wzaes->crypt_block[pos++];
+        i += 1;
     }
 
     wzaes->crypt_pos = pos;
@@ -208,20 +215,41 @@ static int32_t mz_stream_wzaes_ctr_encrypt(void *stream, uint8_t *buf, int32_t s
 int32_t mz_stream_wzaes_read(void *stream, void *buf, int32_t size)
 {
     mz_stream_wzaes *wzaes = (mz_stream_wzaes *)stream;
+    const uint8_t *lent = NULL;
     int64_t max_total_in = 0;
     int32_t bytes_to_read = size;
     int32_t read = 0;
+    int32_t total_read = 0;
 
     max_total_in = wzaes->max_total_in - MZ_AES_FOOTER_SIZE;
     if ((int64_t)bytes_to_read > (max_total_in - wzaes->total_in))
         bytes_to_read = (int32_t)(max_total_in - wzaes->total_in);
 
+    /* Decrypt straight out of the base stream's buffer when it can be lent */
+    while (total_read < bytes_to_read)
+    {
+        read = mz_stream_read_ptr(wzaes->stream.base, (const void **)&lent, bytes_to_read - total_read);
+        if (read == MZ_SUPPORT_ERROR && total_read == 0)
+            break;
+        if (read <= 0)
+            return (total_read > 0) ? total_read : read;
+
+        mz_crypt_hmac_update(wzaes->hmac, lent, read);
+        mz_stream_wzaes_ctr_encrypt(stream, lent, (uint8_t *)buf + total_read, read);
+        mz_stream_release(wzaes->stream.base, read);
+
+        total_read += read;
+        wzaes->total_in += read;
+    }
+    if (total_read > 0 || bytes_to_read <= 0)
+        return total_read;
+
     read = mz_stream_read(wzaes->stream.base, buf, bytes_to_read);
 
     if (read > 0)
     {
         mz_crypt_hmac_update(wzaes->hmac, (uint8_t *)buf, read);
-        mz_stream_wzaes_ctr_encrypt(stream, (uint8_t *)buf, read);
+        mz_stream_wzaes_ctr_encrypt(stream, (uint8_t *)buf, (uint8_t *)buf, read);
 
         wzaes->total_in += read;
     }
@@ -248,7 +276,7 @@ int32_t mz_stream_wzaes_write(void *stream, const void *buf, int32_t size)
         memcpy(wzaes->buffer, buf_ptr, bytes_to_write);
         buf_ptr += bytes_to_write;
 
-        mz_stream_wzaes_ctr_encrypt(stream, (uint8_t *)wzaes->buffer, bytes_to_write);
+        mz_stream_wzaes_ctr_encrypt(stream, wzaes->buffer, wzaes->buffer, bytes_to_write);
         mz_crypt_hmac_update(wzaes->hmac, wzaes->buffer, bytes_to_write);
 
         written = mz_stream_write(wzaes->stream.base, wzaes->buffer, bytes_to_write);
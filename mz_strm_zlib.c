@@ -11,6 +11,7 @@
 
 
 #include "mz.h"
+#include "mz_crypt.h"
 #include "mz_strm.h"
 #include "mz_strm_zlib.h"
 
@@ -19,6 +20,15 @@
 #  include "zlib-ng.h"
 #endif
 
+#ifdef HAVE_LIBDEFLATE
+#  include <libdeflate.h>
+#endif
+
+#if defined(HAVE_PTHREAD) && !defined(MZ_ZIP_NO_COMPRESSION)
+#  include <pthread.h>
+#  define MZ_STREAM_ZLIB_PARALLEL
+#endif
+
 /***************************************************************************/
 
 #if defined(ZLIBNG_VERNUM) && !defined(ZLIB_COMPAT)
@@ -37,6 +47,10 @@
 #  endif
 #endif
 
+#define MZ_STREAM_ZLIB_BLOCK_SIZE   (128 * 1024)
+#define MZ_STREAM_ZLIB_DICT_SIZE    (32 * 1024)
+#define MZ_STREAM_ZLIB_THREADS_MAX  (64)
+
 /***************************************************************************/
 
 static mz_stream_vtbl mz_stream_zlib_vtbl = {
@@ -51,11 +65,52 @@ static mz_stream_vtbl mz_stream_zlib_vtbl = {
     mz_stream_zlib_create,
     mz_stream_zlib_delete,
     mz_stream_zlib_get_prop_int64,
-    mz_stream_zlib_set_prop_int64
+    mz_stream_zlib_set_prop_int64,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
 };
 
 /***************************************************************************/
 
+#ifdef MZ_STREAM_ZLIB_PARALLEL
+typedef struct mz_stream_zlib_job_s
+{
+    uint8_t     *in;            /* preset dictionary followed by the block */
+    int32_t     dict_len;
+    int32_t     in_len;
+    uint8_t     *out;
+    int32_t     out_len;
+    uint32_t    crc;
+    uint8_t     last;
+    uint8_t     done;
+    int32_t     error;
+} mz_stream_zlib_job;
+
+typedef struct mz_stream_zlib_pool_s
+{
+    mz_stream_zlib_job
+                *jobs;
+    int32_t     job_count;
+    int32_t     out_size;
+    int16_t     level;
+    int32_t     window_bits;
+    pthread_t   *threads;
+    int32_t     thread_count;   /* workers started, blocks are compressed inline while zero */
+    int64_t     fill_seq;       /* block being filled by the caller */
+    int64_t     run_seq;        /* next block picked up by a worker */
+    int64_t     head_seq;       /* next block written to the base */
+    uint8_t     stop;
+    pthread_mutex_t
+                mutex;
+    pthread_cond_t
+                cond;           /* signalled when a block is queued or finished */
+} mz_stream_zlib_pool;
+#endif
+
 typedef struct mz_stream_zlib_s {
     mz_stream   stream;
     zlib_stream zstream;
@@ -69,10 +124,358 @@ typedef struct mz_stream_zlib_s {
     int32_t     window_bits;
     int32_t     mode;
     int32_t     error;
+    int32_t     context_mode;   /* zlib state kept across close, reset when reopened alike */
+    int16_t     context_level;
+    int32_t     context_window_bits;
+    int32_t     threads;
+    uint8_t     parallel;       /* blocks compressed independently, crc computed along */
+    uint8_t     has_crc;        /* crc of the blocks is kept after close until reopened */
+    uint32_t    crc;
+#ifdef MZ_STREAM_ZLIB_PARALLEL
+    mz_stream_zlib_pool
+                *pool;
+#endif
+#ifdef HAVE_LIBDEFLATE
+    struct libdeflate_compressor
+                *compressor;    /* buffer coders kept until the stream is deleted */
+    int16_t     compressor_level;
+    struct libdeflate_decompressor
+                *decompressor;
+#endif
 } mz_stream_zlib;
 
 /***************************************************************************/
 
+static void mz_stream_zlib_context_end(mz_stream_zlib *zlib)
+{
+    if (zlib->context_mode == MZ_OPEN_MODE_WRITE)
+        ZLIB_PREFIX(deflateEnd)(&zlib->zstream);
+    else if (zlib->context_mode == MZ_OPEN_MODE_READ)
+        ZLIB_PREFIX(inflateEnd)(&zlib->zstream);
+    zlib->context_mode = 0;
+}
+
+static int32_t mz_stream_zlib_context_init(mz_stream_zlib *zlib, int32_t mode)
+{
+    int32_t err = Z_OK;
+
+    /* Reopening with the same parameters resets the state instead of reallocating it */
+    if ((zlib->context_mode == mode) && (zlib->context_level == zlib->level) &&
+        (zlib->context_window_bits == zlib->window_bits))
+    {
+        if (mode == MZ_OPEN_MODE_WRITE)
+            return ZLIB_PREFIX(deflateReset)(&zlib->zstream);
+        return ZLIB_PREFIX(inflateReset)(&zlib->zstream);
+    }
+
+    mz_stream_zlib_context_end(zlib);
+
+    zlib->zstream.zalloc = Z_NULL;
+    zlib->zstream.zfree = Z_NULL;
+    zlib->zstream.opaque = Z_NULL;
+
+    if (mode == MZ_OPEN_MODE_WRITE)
+        err = ZLIB_PREFIX(deflateInit2)(&zlib->zstream, (int8_t)zlib->level, Z_DEFLATED,
+            zlib->window_bits, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    else
+        err = ZLIB_PREFIX(inflateInit2)(&zlib->zstream, zlib->window_bits);
+
+    if (err == Z_OK)
+    {
+        zlib->context_mode = mode;
+        zlib->context_level = zlib->level;
+        zlib->context_window_bits = zlib->window_bits;
+    }
+    return err;
+}
+
+/***************************************************************************/
+
+#ifdef MZ_STREAM_ZLIB_PARALLEL
+static int32_t mz_stream_zlib_job_run(zlib_stream *zstream, mz_stream_zlib_job *job, int32_t out_size)
+{
+    int32_t err = Z_OK;
+
+    err = ZLIB_PREFIX(deflateReset)(zstream);
+    if ((err == Z_OK) && (job->dict_len > 0))
+        err = ZLIB_PREFIX(deflateSetDictionary)(zstream, job->in, (uInt)job->dict_len);
+
+    zstream->next_in = job->in + job->dict_len;
+    zstream->avail_in = (uInt)job->in_len;
+    zstream->next_out = job->out;
+    zstream->avail_out = (uInt)out_size;
+
+    /* Blocks other than the last end on a byte boundary so they can be concatenated */
+    if (err == Z_OK)
+        err = ZLIB_PREFIX(deflate)(zstream, job->last ? Z_FINISH : Z_SYNC_FLUSH);
+    if (job->last && err == Z_STREAM_END)
+        err = Z_OK;
+    else if (err == Z_OK && (zstream->avail_in > 0 || zstream->avail_out == 0))
+        err = Z_BUF_ERROR;
+
+    job->out_len = out_size - (int32_t)zstream->avail_out;
+    job->crc = mz_crypt_crc32_update(0, job->in + job->dict_len, job->in_len);
+    return err;
+}
+
+static void *mz_stream_zlib_worker(void *arg)
+{
+    mz_stream_zlib_pool *pool = (mz_stream_zlib_pool *)arg;
+    mz_stream_zlib_job *job = NULL;
+    zlib_stream zstream;
+    int32_t init_err = Z_OK;
+    int32_t err = Z_OK;
+
+    memset(&zstream, 0, sizeof(zstream));
+    init_err = ZLIB_PREFIX(deflateInit2)(&zstream, (int8_t)pool->level, Z_DEFLATED,
+        pool->window_bits, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+
+    pthread_mutex_lock(&pool->mutex);
+    for (;;)
+    {
+        while (!pool->stop && pool->run_seq == pool->fill_seq)
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+        if (pool->run_seq == pool->fill_seq)
+            break;
+
+        job = &pool->jobs[pool->run_seq % pool->job_count];
+        pool->run_seq += 1;
+        pthread_mutex_unlock(&pool->mutex);
+
+        err = init_err;
+        if (err == Z_OK)
+            err = mz_stream_zlib_job_run(&zstream, job, pool->out_size);
+
+        pthread_mutex_lock(&pool->mutex);
+        job->error = err;
+        job->done = 1;
+        pthread_cond_broadcast(&pool->cond);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (init_err == Z_OK)
+        ZLIB_PREFIX(deflateEnd)(&zstream);
+    return NULL;
+}
+
+static int32_t mz_stream_zlib_pool_job_init(mz_stream_zlib_pool *pool, mz_stream_zlib_job *job)
+{
+    if (job->in == NULL)
+        job->in = (uint8_t *)MZ_ALLOC(MZ_STREAM_ZLIB_DICT_SIZE + MZ_STREAM_ZLIB_BLOCK_SIZE);
+    if (job->out == NULL)
+        job->out = (uint8_t *)MZ_ALLOC(pool->out_size);
+    if (job->in == NULL || job->out == NULL)
+        return MZ_MEM_ERROR;
+    job->dict_len = 0;
+    job->in_len = 0;
+    job->last = 0;
+    job->done = 0;
+    job->error = Z_OK;
+    return MZ_OK;
+}
+
+static void mz_stream_zlib_pool_delete(mz_stream_zlib_pool **pool)
+{
+    mz_stream_zlib_pool *zpool = *pool;
+    int32_t i = 0;
+
+    if (zpool->thread_count > 0)
+    {
+        pthread_mutex_lock(&zpool->mutex);
+        zpool->stop = 1;
+        pthread_cond_broadcast(&zpool->cond);
+        pthread_mutex_unlock(&zpool->mutex);
+
+        for (i = 0; i < zpool->thread_count; i += 1)
+            pthread_join(zpool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&zpool->cond);
+    pthread_mutex_destroy(&zpool->mutex);
+
+    for (i = 0; i < zpool->job_count; i += 1)
+    {
+        if (zpool->jobs[i].in != NULL)
+            MZ_FREE(zpool->jobs[i].in);
+        if (zpool->jobs[i].out != NULL)
+            MZ_FREE(zpool->jobs[i].out);
+    }
+    MZ_FREE(zpool->jobs);
+    if (zpool->threads != NULL)
+        MZ_FREE(zpool->threads);
+    MZ_FREE(zpool);
+    *pool = NULL;
+}
+
+static int32_t mz_stream_zlib_pool_create(mz_stream_zlib *zlib)
+{
+    mz_stream_zlib_pool *pool = NULL;
+
+    pool = (mz_stream_zlib_pool *)MZ_ALLOC(sizeof(mz_stream_zlib_pool));
+    if (pool == NULL)
+        return MZ_MEM_ERROR;
+    memset(pool, 0, sizeof(mz_stream_zlib_pool));
+
+    /* Twice as many blocks as workers keeps them busy while blocks are written in order */
+    pool->job_count = zlib->threads * 2;
+    pool->out_size = MZ_STREAM_ZLIB_BLOCK_SIZE + (MZ_STREAM_ZLIB_BLOCK_SIZE >> 12) +
+        (MZ_STREAM_ZLIB_BLOCK_SIZE >> 14) + 64;
+    pool->level = zlib->level;
+    pool->window_bits = zlib->window_bits;
+    pool->jobs = (mz_stream_zlib_job *)MZ_ALLOC(pool->job_count * sizeof(mz_stream_zlib_job));
+    pool->threads = (pthread_t *)MZ_ALLOC(zlib->threads * sizeof(pthread_t));
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cond, NULL);
+
+    if (pool->jobs != NULL)
+        memset(pool->jobs, 0, pool->job_count * sizeof(mz_stream_zlib_job));
+    if (pool->jobs == NULL || pool->threads == NULL ||
+        mz_stream_zlib_pool_job_init(pool, &pool->jobs[0]) != MZ_OK)
+    {
+        if (pool->jobs == NULL)
+            pool->job_count = 0;
+        mz_stream_zlib_pool_delete(&pool);
+        return MZ_MEM_ERROR;
+    }
+
+    zlib->pool = pool;
+    return MZ_OK;
+}
+
+static void mz_stream_zlib_pool_start(mz_stream_zlib *zlib)
+{
+    mz_stream_zlib_pool *pool = zlib->pool;
+
+    /* Blocks keep being compressed inline if no worker could be started */
+    while (pool->thread_count < zlib->threads)
+    {
+        if (pthread_create(&pool->threads[pool->thread_count], NULL, mz_stream_zlib_worker, pool) != 0)
+            break;
+        pool->thread_count += 1;
+    }
+}
+
+/* Writes finished blocks to the base in order, waiting until at least min_head_seq is written */
+static int32_t mz_stream_zlib_pool_drain(mz_stream_zlib *zlib, int64_t min_head_seq)
+{
+    mz_stream_zlib_pool *pool = zlib->pool;
+    mz_stream_zlib_job *job = NULL;
+    uint8_t done = 0;
+
+    while (pool->head_seq < pool->fill_seq)
+    {
+        job = &pool->jobs[pool->head_seq % pool->job_count];
+
+        pthread_mutex_lock(&pool->mutex);
+        while (!job->done && pool->head_seq < min_head_seq)
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+        done = job->done;
+        pthread_mutex_unlock(&pool->mutex);
+
+        if (!done)
+            break;
+
+        /* Errors stick to the stream so no block after a failed one is written or waited for */
+        if (job->error != Z_OK)
+        {
+            zlib->error = job->error;
+            return MZ_DATA_ERROR;
+        }
+        if (mz_stream_write(zlib->stream.base, job->out, job->out_len) != job->out_len)
+        {
+            zlib->error = Z_STREAM_ERROR;
+            return MZ_WRITE_ERROR;
+        }
+
+        job->done = 0;
+        zlib->total_out += job->out_len;
+        zlib->crc = mz_crypt_crc32_combine(zlib->crc, job->crc, job->in_len);
+        pool->head_seq += 1;
+    }
+    return MZ_OK;
+}
+
+static int32_t mz_stream_zlib_pool_submit(mz_stream_zlib *zlib, uint8_t last)
+{
+    mz_stream_zlib_pool *pool = zlib->pool;
+    mz_stream_zlib_job *job = &pool->jobs[pool->fill_seq % pool->job_count];
+    mz_stream_zlib_job *next = NULL;
+    int32_t dict_len = 0;
+    int32_t err = MZ_OK;
+
+    job->last = last;
+
+    if (!last)
+        mz_stream_zlib_pool_start(zlib);
+
+    if (pool->thread_count == 0)
+    {
+        /* Entries that fit in one block are not worth starting workers for */
+        if (!zlib->initialized)
+        {
+            if (mz_stream_zlib_context_init(zlib, MZ_OPEN_MODE_WRITE) != Z_OK)
+                return MZ_DATA_ERROR;
+            zlib->initialized = 1;
+        }
+        job->error = mz_stream_zlib_job_run(&zlib->zstream, job, pool->out_size);
+        job->done = 1;
+        pool->fill_seq += 1;
+    }
+    else
+    {
+        pthread_mutex_lock(&pool->mutex);
+        pool->fill_seq += 1;
+        pthread_cond_broadcast(&pool->cond);
+        pthread_mutex_unlock(&pool->mutex);
+    }
+
+    if (last)
+        return mz_stream_zlib_pool_drain(zlib, pool->fill_seq);
+
+    /* Slot for the next block must have been written out before it is reused */
+    err = mz_stream_zlib_pool_drain(zlib, pool->fill_seq - pool->job_count + 1);
+    if (err != MZ_OK)
+        return err;
+
+    next = &pool->jobs[pool->fill_seq % pool->job_count];
+    err = mz_stream_zlib_pool_job_init(pool, next);
+    if (err != MZ_OK)
+        return err;
+
+    /* Next block is primed with the tail of this one so compression carries across */
+    dict_len = job->in_len;
+    if (dict_len > MZ_STREAM_ZLIB_DICT_SIZE)
+        dict_len = MZ_STREAM_ZLIB_DICT_SIZE;
+    memcpy(next->in, job->in + job->dict_len + job->in_len - dict_len, dict_len);
+    next->dict_len = dict_len;
+    return MZ_OK;
+}
+
+static int32_t mz_stream_zlib_pool_write(mz_stream_zlib *zlib, const uint8_t *buf, int32_t size)
+{
+    mz_stream_zlib_pool *pool = zlib->pool;
+    mz_stream_zlib_job *job = NULL;
+    int32_t bytes_to_copy = 0;
+    int32_t err = MZ_OK;
+
+    while (size > 0 && err == MZ_OK)
+    {
+        job = &pool->jobs[pool->fill_seq % pool->job_count];
+
+        bytes_to_copy = MZ_STREAM_ZLIB_BLOCK_SIZE - job->in_len;
+        if (bytes_to_copy > size)
+            bytes_to_copy = size;
+        memcpy(job->in + job->dict_len + job->in_len, buf, bytes_to_copy);
+        job->in_len += bytes_to_copy;
+        buf += bytes_to_copy;
+        size -= bytes_to_copy;
+
+        if (job->in_len == MZ_STREAM_ZLIB_BLOCK_SIZE)
+            err = mz_stream_zlib_pool_submit(zlib, 0);
+    }
+    return err;
+}
+#endif
+
 int32_t mz_stream_zlib_open(void *stream, const char *path, int32_t mode)
 {
     mz_stream_zlib *zlib = (mz_stream_zlib *)stream;
@@ -80,14 +483,12 @@ int32_t mz_stream_zlib_open(void *stream, const char *path, int32_t mode)
     MZ_UNUSED(path);
 
     zlib->zstream.data_type = Z_BINARY;
-    zlib->zstream.zalloc = Z_NULL;
-    zlib->zstream.zfree = Z_NULL;
-    zlib->zstream.opaque = Z_NULL;
     zlib->zstream.total_in = 0;
     zlib->zstream.total_out = 0;
 
     zlib->total_in = 0;
     zlib->total_out = 0;
+    zlib->has_crc = 0;
 
     if (mode & MZ_OPEN_MODE_WRITE)
     {
@@ -96,9 +497,27 @@ int32_t mz_stream_zlib_open(void *stream, const char *path, int32_t mode)
 #else
         zlib->zstream.next_out = zlib->buffer;
         zlib->zstream.avail_out = sizeof(zlib->buffer);
+        zlib->buffer_len = 0;
 
-        zlib->error = ZLIB_PREFIX(deflateInit2)(&zlib->zstream, (int8_t)zlib->level, Z_DEFLATED,
-            zlib->window_bits, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+#ifdef MZ_STREAM_ZLIB_PARALLEL
+        /* Raw deflate can be split into blocks compressed on worker threads */
+        zlib->parallel = (zlib->threads > 1 && zlib->window_bits < 0);
+        zlib->crc = 0;
+        if (zlib->parallel)
+        {
+            zlib->error = Z_OK;
+            zlib->initialized = 0;
+            if (mz_stream_zlib_pool_create(zlib) != MZ_OK)
+            {
+                zlib->parallel = 0;
+                return MZ_MEM_ERROR;
+            }
+            zlib->has_crc = 1;
+            zlib->mode = mode;
+            return MZ_OK;
+        }
+#endif
+        zlib->error = mz_stream_zlib_context_init(zlib, MZ_OPEN_MODE_WRITE);
 #endif
     }
     else if (mode & MZ_OPEN_MODE_READ)
@@ -109,7 +528,7 @@ int32_t mz_stream_zlib_open(void *stream, const char *path, int32_t mode)
         zlib->zstream.next_in = zlib->buffer;
         zlib->zstream.avail_in = 0;
 
-        zlib->error = ZLIB_PREFIX(inflateInit2)(&zlib->zstream, zlib->window_bits);
+        zlib->error = mz_stream_zlib_context_init(zlib, MZ_OPEN_MODE_READ);
 #endif
     }
 
@@ -124,6 +543,10 @@ int32_t mz_stream_zlib_open(void *stream, const char *path, int32_t mode)
 int32_t mz_stream_zlib_is_open(void *stream)
 {
     mz_stream_zlib *zlib = (mz_stream_zlib *)stream;
+#ifdef MZ_STREAM_ZLIB_PARALLEL
+    if (zlib->pool != NULL)
+        return MZ_OK;
+#endif
     if (zlib->initialized != 1)
         return MZ_OPEN_ERROR;
     return MZ_OK;
@@ -149,6 +572,8 @@ int32_t mz_stream_zlib_read(void *stream, void *buf, int32_t size)
     int32_t bytes_to_read = sizeof(zlib->buffer);
     int32_t read = 0;
     int32_t err = Z_OK;
+    const void *lent = NULL;
+    uint8_t lending = 0;
 
 
     zlib->zstream.next_out = (Bytef*)buf;
@@ -164,12 +589,26 @@ int32_t mz_stream_zlib_read(void *stream, void *buf, int32_t size)
                     bytes_to_read = (int32_t)(zlib->max_total_in - zlib->total_in);
             }
 
-            read = mz_stream_read(zlib->stream.base, zlib->buffer, bytes_to_read);
+            /* Inflate directly from the base stream's buffer when it can be lent */
+            read = mz_stream_read_ptr(zlib->stream.base, &lent, bytes_to_read);
+            lending = (read >= 0);
+            if (lending)
+            {
+                zlib->zstream.next_in = (Bytef *)lent;
+            }
+            else
+            {
+                if (read != MZ_SUPPORT_ERROR)
+                    return read;
+
+                read = mz_stream_read(zlib->stream.base, zlib->buffer, bytes_to_read);
 
-            if (read < 0)
-                return read;
+                if (read < 0)
+                    return read;
+
+                zlib->zstream.next_in = zlib->buffer;
+            }
 
-            zlib->zstream.next_in = zlib->buffer;
             zlib->zstream.avail_in = read;
         }
 
@@ -179,6 +618,8 @@ int32_t mz_stream_zlib_read(void *stream, void *buf, int32_t size)
         err = ZLIB_PREFIX(inflate)(&zlib->zstream, Z_SYNC_FLUSH);
         if ((err >= Z_OK) && (zlib->zstream.msg != NULL))
         {
+            if (lending)
+                zlib->zstream.avail_in = 0;
             zlib->error = Z_DATA_ERROR;
             break;
         }
@@ -189,6 +630,15 @@ int32_t mz_stream_zlib_read(void *stream, void *buf, int32_t size)
         in_bytes = (uint32_t)(total_in_before - total_in_after);
         out_bytes = (uint32_t)(total_out_after - total_out_before);
 
+        if (lending)
+        {
+            /* Only consumed input is released, the rest is lent again next time */
+            lending = 0;
+            zlib->zstream.avail_in = 0;
+            if (mz_stream_release(zlib->stream.base, (int32_t)in_bytes) != MZ_OK)
+                return MZ_READ_ERROR;
+        }
+
         total_in += in_bytes;
         total_out += out_bytes;
 
@@ -280,6 +730,21 @@ int32_t mz_stream_zlib_write(void *stream, const void *buf, int32_t size)
     MZ_UNUSED(buf);
     err = MZ_SUPPORT_ERROR;
 #else
+#ifdef MZ_STREAM_ZLIB_PARALLEL
+    if (zlib->pool != NULL)
+    {
+        if (zlib->error != Z_OK)
+            return MZ_WRITE_ERROR;
+        if (mz_stream_zlib_pool_write(zlib, (const uint8_t *)buf, size) != MZ_OK)
+        {
+            if (zlib->error == Z_OK)
+                zlib->error = Z_STREAM_ERROR;
+            return MZ_WRITE_ERROR;
+        }
+        zlib->total_in += size;
+        return size;
+    }
+#endif
     zlib->zstream.next_in = (Bytef*)(intptr_t)buf;
     zlib->zstream.avail_in = (uInt)size;
 
@@ -311,23 +776,35 @@ int32_t mz_stream_zlib_close(void *stream)
     mz_stream_zlib *zlib = (mz_stream_zlib *)stream;
 
 
+    /* Closing a closed stream only reports how it was closed */
+    if (mz_stream_zlib_is_open(stream) != MZ_OK)
+        return (zlib->error != Z_OK) ? MZ_CLOSE_ERROR : MZ_OK;
+
     if (zlib->mode & MZ_OPEN_MODE_WRITE)
     {
 #ifdef MZ_ZIP_NO_COMPRESSION
         return MZ_SUPPORT_ERROR;
 #else
-        mz_stream_zlib_deflate(stream, Z_FINISH);
-        mz_stream_zlib_flush(stream);
-
-        ZLIB_PREFIX(deflateEnd)(&zlib->zstream);
+#ifdef MZ_STREAM_ZLIB_PARALLEL
+        if (zlib->pool != NULL)
+        {
+            if (zlib->error == Z_OK && mz_stream_zlib_pool_submit(zlib, 1) != MZ_OK && zlib->error == Z_OK)
+                zlib->error = Z_STREAM_ERROR;
+            mz_stream_zlib_pool_delete(&zlib->pool);
+            zlib->parallel = 0;
+        }
+        else
+#endif
+        {
+            mz_stream_zlib_deflate(stream, Z_FINISH);
+            mz_stream_zlib_flush(stream);
+        }
 #endif
     }
     else if (zlib->mode & MZ_OPEN_MODE_READ)
     {
 #ifdef MZ_ZIP_NO_DECOMPRESSION
         return MZ_SUPPORT_ERROR;
-#else
-        ZLIB_PREFIX(inflateEnd)(&zlib->zstream);
 #endif
     }
 
@@ -364,6 +841,14 @@ int32_t mz_stream_zlib_get_prop_int64(void *stream, int32_t prop, int64_t *value
     case MZ_STREAM_PROP_COMPRESS_WINDOW:
         *value = zlib->window_bits;
          break;
+    case MZ_STREAM_PROP_COMPRESS_THREADS:
+        *value = zlib->threads;
+        break;
+    case MZ_STREAM_PROP_CRC:
+        if (!zlib->has_crc)
+            return MZ_EXIST_ERROR;
+        *value = zlib->crc;
+        break;
     default:
         return MZ_EXIST_ERROR;
     }
@@ -384,12 +869,172 @@ int32_t mz_stream_zlib_set_prop_int64(void *stream, int32_t prop, int64_t value)
     case MZ_STREAM_PROP_COMPRESS_WINDOW:
         zlib->window_bits = (int32_t)value;
         break;
+    case MZ_STREAM_PROP_COMPRESS_THREADS:
+        if (value < 0 || value > MZ_STREAM_ZLIB_THREADS_MAX)
+            return MZ_PARAM_ERROR;
+        zlib->threads = (int32_t)value;
+        break;
     default:
         return MZ_EXIST_ERROR;
     }
     return MZ_OK;
 }
 
+/***************************************************************************/
+
+#if defined(HAVE_LIBDEFLATE) && !defined(MZ_ZIP_NO_COMPRESSION)
+static struct libdeflate_compressor *mz_stream_zlib_compressor(mz_stream_zlib *zlib)
+{
+    int16_t level = zlib->level;
+
+    if (level < 0)
+        level = MZ_COMPRESS_LEVEL_NORMAL;
+    if (zlib->compressor != NULL && zlib->compressor_level != level)
+    {
+        libdeflate_free_compressor(zlib->compressor);
+        zlib->compressor = NULL;
+    }
+    if (zlib->compressor == NULL)
+    {
+        zlib->compressor = libdeflate_alloc_compressor(level);
+        zlib->compressor_level = level;
+    }
+    return zlib->compressor;
+}
+#endif
+
+int32_t mz_stream_zlib_inflate_buffer(void *stream, const void *source, int32_t source_size,
+    void *target, int32_t target_size)
+{
+#ifdef MZ_ZIP_NO_DECOMPRESSION
+    MZ_UNUSED(stream);
+    MZ_UNUSED(source);
+    MZ_UNUSED(source_size);
+    MZ_UNUSED(target);
+    MZ_UNUSED(target_size);
+    return MZ_SUPPORT_ERROR;
+#else
+    mz_stream_zlib *zlib = (mz_stream_zlib *)stream;
+#ifdef HAVE_LIBDEFLATE
+    enum libdeflate_result result = LIBDEFLATE_SUCCESS;
+    size_t actual_size = 0;
+#else
+    int32_t err = Z_OK;
+#endif
+
+    /* Stream may be open for reading as long as it is not read through */
+    if ((mz_stream_zlib_is_open(stream) == MZ_OK) && !(zlib->mode & MZ_OPEN_MODE_READ))
+        return MZ_PARAM_ERROR;
+
+#ifdef HAVE_LIBDEFLATE
+    if (zlib->decompressor == NULL)
+        zlib->decompressor = libdeflate_alloc_decompressor();
+    if (zlib->decompressor == NULL)
+        return MZ_MEM_ERROR;
+    result = libdeflate_deflate_decompress(zlib->decompressor, source, (size_t)source_size,
+        target, (size_t)target_size, &actual_size);
+
+    if (result != LIBDEFLATE_SUCCESS)
+        return (result == LIBDEFLATE_INSUFFICIENT_SPACE) ? MZ_BUF_ERROR : MZ_DATA_ERROR;
+    return (int32_t)actual_size;
+#else
+    if (mz_stream_zlib_context_init(zlib, MZ_OPEN_MODE_READ) != Z_OK)
+        return MZ_MEM_ERROR;
+
+    zlib->zstream.next_in = (Bytef *)(intptr_t)source;
+    zlib->zstream.avail_in = (uInt)source_size;
+    zlib->zstream.next_out = (Bytef *)target;
+    zlib->zstream.avail_out = (uInt)target_size;
+
+    /* Whole output space is available so no window needs to be kept */
+    err = ZLIB_PREFIX(inflate)(&zlib->zstream, Z_FINISH);
+
+    if (err != Z_STREAM_END)
+        return (err == Z_BUF_ERROR && zlib->zstream.avail_out == 0) ? MZ_BUF_ERROR : MZ_DATA_ERROR;
+    return target_size - (int32_t)zlib->zstream.avail_out;
+#endif
+#endif
+}
+
+int32_t mz_stream_zlib_deflate_bound(void *stream, int32_t source_size)
+{
+#ifdef MZ_ZIP_NO_COMPRESSION
+    MZ_UNUSED(stream);
+    MZ_UNUSED(source_size);
+    return MZ_SUPPORT_ERROR;
+#else
+    mz_stream_zlib *zlib = (mz_stream_zlib *)stream;
+    uint64_t bound = 0;
+
+    if (mz_stream_zlib_is_open(stream) == MZ_OK)
+        return MZ_PARAM_ERROR;
+
+#ifdef HAVE_LIBDEFLATE
+    if (mz_stream_zlib_compressor(zlib) == NULL)
+        return MZ_MEM_ERROR;
+    bound = libdeflate_deflate_compress_bound(zlib->compressor, (size_t)source_size);
+#else
+    if (mz_stream_zlib_context_init(zlib, MZ_OPEN_MODE_WRITE) != Z_OK)
+        return MZ_MEM_ERROR;
+    bound = ZLIB_PREFIX(deflateBound)(&zlib->zstream, (uLong)source_size);
+#endif
+
+    if (bound > INT32_MAX)
+        return MZ_BUF_ERROR;
+    return (int32_t)bound;
+#endif
+}
+
+int32_t mz_stream_zlib_deflate_buffer(void *stream, const void *source, int32_t source_size,
+    void *target, int32_t target_size)
+{
+#ifdef MZ_ZIP_NO_COMPRESSION
+    MZ_UNUSED(stream);
+    MZ_UNUSED(source);
+    MZ_UNUSED(source_size);
+    MZ_UNUSED(target);
+    MZ_UNUSED(target_size);
+    return MZ_SUPPORT_ERROR;
+#else
+    mz_stream_zlib *zlib = (mz_stream_zlib *)stream;
+#ifdef HAVE_LIBDEFLATE
+    size_t compressed_size = 0;
+#else
+    int32_t err = Z_OK;
+#endif
+
+    if (mz_stream_zlib_is_open(stream) == MZ_OK)
+        return MZ_PARAM_ERROR;
+
+#ifdef HAVE_LIBDEFLATE
+    if (mz_stream_zlib_compressor(zlib) == NULL)
+        return MZ_MEM_ERROR;
+    compressed_size = libdeflate_deflate_compress(zlib->compressor, source, (size_t)source_size,
+        target, (size_t)target_size);
+
+    if (compressed_size == 0)
+        return MZ_BUF_ERROR;
+    return (int32_t)compressed_size;
+#else
+    if (mz_stream_zlib_context_init(zlib, MZ_OPEN_MODE_WRITE) != Z_OK)
+        return MZ_MEM_ERROR;
+
+    zlib->zstream.next_in = (Bytef *)(intptr_t)source;
+    zlib->zstream.avail_in = (uInt)source_size;
+    zlib->zstream.next_out = (Bytef *)target;
+    zlib->zstream.avail_out = (uInt)target_size;
+
+    err = ZLIB_PREFIX(deflate)(&zlib->zstream, Z_FINISH);
+
+    if (err != Z_STREAM_END)
+        return MZ_BUF_ERROR;
+    return target_size - (int32_t)zlib->zstream.avail_out;
+#endif
+#endif
+}
+
+/***************************************************************************/
+
 void *mz_stream_zlib_create(void **stream)
 {
     mz_stream_zlib *zlib = NULL;
@@ -415,7 +1060,20 @@ void mz_stream_zlib_delete(void **stream)
         return;
     zlib = (mz_stream_zlib *)*stream;
     if (zlib != NULL)
+    {
+        mz_stream_zlib_context_end(zlib);
+#ifdef MZ_STREAM_ZLIB_PARALLEL
+        if (zlib->pool != NULL)
+            mz_stream_zlib_pool_delete(&zlib->pool);
+#endif
+#ifdef HAVE_LIBDEFLATE
+        if (zlib->compressor != NULL)
+            libdeflate_free_compressor(zlib->compressor);
+        if (zlib->decompressor != NULL)
+            libdeflate_free_decompressor(zlib->decompressor);
+#endif
         MZ_FREE(zlib);
+    }
     *stream = NULL;
 }
 
@@ -35,6 +35,12 @@ void    mz_stream_zlib_delete(void **stream);
 
 void*   mz_stream_zlib_get_interface(void);
 
+int32_t mz_stream_zlib_inflate_buffer(void *stream, const void *source, int32_t source_size,
+    void *target, int32_t target_size);
+int32_t mz_stream_zlib_deflate_bound(void *stream, int32_t source_size);
+int32_t mz_stream_zlib_deflate_buffer(void *stream, const void *source, int32_t source_size,
+    void *target, int32_t target_size);
+
 /***************************************************************************/
 
 #ifdef __cplusplus
@@ -0,0 +1,420 @@
+/* mz_strm_zstd.c -- Stream for zstd compress/decompress
+   part of the MiniZip project
+
+   Copyright (C) 2026 The MiniZip contributors
+      https://github.com/nmoinvaz/minizip
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+*/
+
+
+#include "mz.h"
+#include "mz_strm.h"
+#include "mz_strm_zstd.h"
+
+#include <zstd.h>
+
+/***************************************************************************/
+
+static mz_stream_vtbl mz_stream_zstd_vtbl = {
+    mz_stream_zstd_open,
+    mz_stream_zstd_is_open,
+    mz_stream_zstd_read,
+    mz_stream_zstd_write,
+    mz_stream_zstd_tell,
+    mz_stream_zstd_seek,
+    mz_stream_zstd_close,
+    mz_stream_zstd_error,
+    mz_stream_zstd_create,
+    mz_stream_zstd_delete,
+    mz_stream_zstd_get_prop_int64,
+    mz_stream_zstd_set_prop_int64,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+/***************************************************************************/
+
+typedef struct mz_stream_zstd_s {
+    mz_stream       stream;
+    ZSTD_CStream    *cstream;
+    ZSTD_DStream    *dstream;
+    ZSTD_inBuffer   in;
+    ZSTD_outBuffer  out;
+    uint8_t         buffer[INT16_MAX];
+    int32_t         mode;
+    int32_t         error;
+    int8_t          stream_end;
+    int64_t         total_in;
+    int64_t         total_out;
+    int64_t         max_total_in;
+    int8_t          initialized;
+    int16_t         level;
+    int32_t         threads;
+} mz_stream_zstd;
+
+/***************************************************************************/
+
+int32_t mz_stream_zstd_open(void *stream, const char *path, int32_t mode)
+{
+    mz_stream_zstd *zstd = (mz_stream_zstd *)stream;
+
+    MZ_UNUSED(path);
+
+    zstd->total_in = 0;
+    zstd->total_out = 0;
+    zstd->error = MZ_OK;
+
+    if (mode & MZ_OPEN_MODE_WRITE)
+    {
+#ifdef MZ_ZIP_NO_COMPRESSION
+        return MZ_SUPPORT_ERROR;
+#else
+        /* Context of a previous open is reset and reused */
+        if (zstd->cstream == NULL)
+            zstd->cstream = ZSTD_createCStream();
+        else
+            ZSTD_CCtx_reset(zstd->cstream, ZSTD_reset_session_only);
+        if (zstd->cstream == NULL)
+            return MZ_OPEN_ERROR;
+
+        ZSTD_CCtx_setParameter(zstd->cstream, ZSTD_c_compressionLevel, zstd->level);
+        /* Fails when the library is built without multithreading, compression then stays on this thread */
+        ZSTD_CCtx_setParameter(zstd->cstream, ZSTD_c_nbWorkers, (zstd->threads > 1) ? zstd->threads : 0);
+
+        zstd->out.dst = zstd->buffer;
+        zstd->out.size = sizeof(zstd->buffer);
+        zstd->out.pos = 0;
+#endif
+    }
+    else if (mode & MZ_OPEN_MODE_READ)
+    {
+#ifdef MZ_ZIP_NO_DECOMPRESSION
+        return MZ_SUPPORT_ERROR;
+#else
+        if (zstd->dstream == NULL)
+            zstd->dstream = ZSTD_createDStream();
+        else
+            ZSTD_DCtx_reset(zstd->dstream, ZSTD_reset_session_only);
+        if (zstd->dstream == NULL)
+            return MZ_OPEN_ERROR;
+
+        zstd->in.src = zstd->buffer;
+        zstd->in.size = 0;
+        zstd->in.pos = 0;
+#endif
+    }
+
+    zstd->initialized = 1;
+    zstd->stream_end = 0;
+    zstd->mode = mode;
+    return MZ_OK;
+}
+
+int32_t mz_stream_zstd_is_open(void *stream)
+{
+    mz_stream_zstd *zstd = (mz_stream_zstd *)stream;
+    if (zstd->initialized != 1)
+        return MZ_OPEN_ERROR;
+    return MZ_OK;
+}
+
+int32_t mz_stream_zstd_read(void *stream, void *buf, int32_t size)
+{
+#ifdef MZ_ZIP_NO_DECOMPRESSION
+    MZ_UNUSED(stream);
+    MZ_UNUSED(buf);
+    MZ_UNUSED(size);
+    return MZ_SUPPORT_ERROR;
+#else
+    mz_stream_zstd *zstd = (mz_stream_zstd *)stream;
+    ZSTD_outBuffer out;
+    size_t in_pos_before = 0;
+    size_t out_pos_before = 0;
+    size_t result = 0;
+    int32_t in_bytes = 0;
+    int32_t out_bytes = 0;
+    int32_t bytes_to_read = sizeof(zstd->buffer);
+    int32_t read = 0;
+    uint8_t end_of_input = 0;
+
+
+    if (zstd->stream_end)
+        return 0;
+
+    out.dst = buf;
+    out.size = (size_t)size;
+    out.pos = 0;
+
+    do
+    {
+        if (zstd->in.pos == zstd->in.size)
+        {
+            if (zstd->max_total_in > 0)
+            {
+                if ((int64_t)bytes_to_read > (zstd->max_total_in - zstd->total_in))
+                    bytes_to_read = (int32_t)(zstd->max_total_in - zstd->total_in);
+            }
+
+            read = mz_stream_read(zstd->stream.base, zstd->buffer, bytes_to_read);
+
+            if (read < 0)
+                return read;
+
+            end_of_input = (read == 0);
+
+            zstd->in.src = zstd->buffer;
+            zstd->in.size = (size_t)read;
+            zstd->in.pos = 0;
+        }
+
+        in_pos_before = zstd->in.pos;
+        out_pos_before = out.pos;
+
+        result = ZSTD_decompressStream(zstd->dstream, &out, &zstd->in);
+
+        in_bytes = (int32_t)(zstd->in.pos - in_pos_before);
+        out_bytes = (int32_t)(out.pos - out_pos_before);
+
+        zstd->total_in += in_bytes;
+        zstd->total_out += out_bytes;
+
+        if (ZSTD_isError(result))
+        {
+            zstd->error = MZ_DATA_ERROR;
+            break;
+        }
+        if (result == 0)
+        {
+            zstd->stream_end = 1;
+            break;
+        }
+        /* Input ran out before the end of the frame */
+        if (end_of_input && out_bytes == 0)
+            break;
+    }
+    while (out.pos < out.size);
+
+    if (zstd->error != MZ_OK)
+        return zstd->error;
+
+    return (int32_t)out.pos;
+#endif
+}
+
+#ifndef MZ_ZIP_NO_COMPRESSION
+static int32_t mz_stream_zstd_flush(void *stream)
+{
+    mz_stream_zstd *zstd = (mz_stream_zstd *)stream;
+    int32_t out_len = (int32_t)zstd->out.pos;
+    if (mz_stream_write(zstd->stream.base, zstd->buffer, out_len) != out_len)
+        return MZ_WRITE_ERROR;
+    return MZ_OK;
+}
+
+static int32_t mz_stream_zstd_compress(void *stream, ZSTD_EndDirective end_op)
+{
+    mz_stream_zstd *zstd = (mz_stream_zstd *)stream;
+    size_t out_pos_before = 0;
+    size_t result = 0;
+    int32_t err = MZ_OK;
+
+    do
+    {
+        if (zstd->out.pos == zstd->out.size)
+        {
+            err = mz_stream_zstd_flush(zstd);
+            if (err != MZ_OK)
+                return err;
+
+            zstd->out.pos = 0;
+        }
+
+        out_pos_before = zstd->out.pos;
+
+        result = ZSTD_compressStream2(zstd->cstream, &zstd->out, &zstd->in, end_op);
+
+        zstd->total_out += (int64_t)(zstd->out.pos - out_pos_before);
+
+        if (ZSTD_isError(result))
+        {
+            zstd->error = MZ_DATA_ERROR;
+            return MZ_DATA_ERROR;
+        }
+    }
+    while ((zstd->in.pos < zstd->in.size) || (end_op == ZSTD_e_end && result != 0));
+
+    return MZ_OK;
+}
+#endif
+
+int32_t mz_stream_zstd_write(void *stream, const void *buf, int32_t size)
+{
+    mz_stream_zstd *zstd = (mz_stream_zstd *)stream;
+    int32_t err = size;
+
+#ifdef MZ_ZIP_NO_COMPRESSION
+    MZ_UNUSED(zstd);
+    MZ_UNUSED(buf);
+    err = MZ_SUPPORT_ERROR;
+#else
+    zstd->in.src = buf;
+    zstd->in.size = (size_t)size;
+    zstd->in.pos = 0;
+
+    if (mz_stream_zstd_compress(stream, ZSTD_e_continue) != MZ_OK)
+        return MZ_WRITE_ERROR;
+
+    zstd->total_in += size;
+#endif
+    return err;
+}
+
+int64_t mz_stream_zstd_tell(void *stream)
+{
+    MZ_UNUSED(stream);
+
+    return MZ_TELL_ERROR;
+}
+
+int32_t mz_stream_zstd_seek(void *stream, int64_t offset, int32_t origin)
+{
+    MZ_UNUSED(stream);
+    MZ_UNUSED(offset);
+    MZ_UNUSED(origin);
+
+    return MZ_SEEK_ERROR;
+}
+
+int32_t mz_stream_zstd_close(void *stream)
+{
+    mz_stream_zstd *zstd = (mz_stream_zstd *)stream;
+
+    if (zstd->mode & MZ_OPEN_MODE_WRITE)
+    {
+#ifdef MZ_ZIP_NO_COMPRESSION
+        return MZ_SUPPORT_ERROR;
+#else
+        zstd->in.src = NULL;
+        zstd->in.size = 0;
+        zstd->in.pos = 0;
+
+        if (mz_stream_zstd_compress(stream, ZSTD_e_end) == MZ_OK)
+        {
+            if (mz_stream_zstd_flush(stream) != MZ_OK)
+                zstd->error = MZ_WRITE_ERROR;
+        }
+#endif
+    }
+    else if (zstd->mode & MZ_OPEN_MODE_READ)
+    {
+#ifdef MZ_ZIP_NO_DECOMPRESSION
+        return MZ_SUPPORT_ERROR;
+#endif
+    }
+
+    zstd->initialized = 0;
+
+    if (zstd->error != MZ_OK)
+        return MZ_CLOSE_ERROR;
+    return MZ_OK;
+}
+
+int32_t mz_stream_zstd_error(void *stream)
+{
+    mz_stream_zstd *zstd = (mz_stream_zstd *)stream;
+    return zstd->error;
+}
+
+int32_t mz_stream_zstd_get_prop_int64(void *stream, int32_t prop, int64_t *value)
+{
+    mz_stream_zstd *zstd = (mz_stream_zstd *)stream;
+    switch (prop)
+    {
+    case MZ_STREAM_PROP_TOTAL_IN:
+        *value = zstd->total_in;
+        break;
+    case MZ_STREAM_PROP_TOTAL_IN_MAX:
+        *value = zstd->max_total_in;
+        break;
+    case MZ_STREAM_PROP_TOTAL_OUT:
+        *value = zstd->total_out;
+        break;
+    case MZ_STREAM_PROP_HEADER_SIZE:
+        *value = 0;
+        break;
+    case MZ_STREAM_PROP_COMPRESS_THREADS:
+        *value = zstd->threads;
+        break;
+    default:
+        return MZ_EXIST_ERROR;
+    }
+    return MZ_OK;
+}
+
+int32_t mz_stream_zstd_set_prop_int64(void *stream, int32_t prop, int64_t value)
+{
+    mz_stream_zstd *zstd = (mz_stream_zstd *)stream;
+    switch (prop)
+    {
+    case MZ_STREAM_PROP_COMPRESS_LEVEL:
+        if (value < 0)
+            zstd->level = ZSTD_CLEVEL_DEFAULT;
+        else
+            zstd->level = (int16_t)value;
+        return MZ_OK;
+    case MZ_STREAM_PROP_TOTAL_IN_MAX:
+        zstd->max_total_in = value;
+        return MZ_OK;
+    case MZ_STREAM_PROP_COMPRESS_THREADS:
+        if (value < 0)
+            return MZ_PARAM_ERROR;
+        zstd->threads = (int32_t)value;
+        return MZ_OK;
+    }
+    return MZ_EXIST_ERROR;
+}
+
+void *mz_stream_zstd_create(void **stream)
+{
+    mz_stream_zstd *zstd = NULL;
+
+    zstd = (mz_stream_zstd *)MZ_ALLOC(sizeof(mz_stream_zstd));
+    if (zstd != NULL)
+    {
+        memset(zstd, 0, sizeof(mz_stream_zstd));
+        zstd->stream.vtbl = &mz_stream_zstd_vtbl;
+        zstd->level = ZSTD_CLEVEL_DEFAULT;
+    }
+    if (stream != NULL)
+        *stream = zstd;
+
+    return zstd;
+}
+
+void mz_stream_zstd_delete(void **stream)
+{
+    mz_stream_zstd *zstd = NULL;
+    if (stream == NULL)
+        return;
+    zstd = (mz_stream_zstd *)*stream;
+    if (zstd != NULL)
+    {
+        if (zstd->cstream != NULL)
+            ZSTD_freeCStream(zstd->cstream);
+        if (zstd->dstream != NULL)
+            ZSTD_freeDStream(zstd->dstream);
+        MZ_FREE(zstd);
+    }
+    *stream = NULL;
+}
+
+void *mz_stream_zstd_get_interface(void)
+{
+    return (void *)&mz_stream_zstd_vtbl;
+}
@@ -30,6 +30,7 @@
 #  include "mz_strm_lzma.h"
 #endif
 #include "mz_strm_mem.h"
+#include "mz_strm_paged.h"
 #ifdef HAVE_PKCRYPT
 #  include "mz_strm_pkcrypt.h"
 #endif
@@ -39,6 +40,9 @@
 #ifdef HAVE_ZLIB
 #  include "mz_strm_zlib.h"
 #endif
+#ifdef HAVE_ZSTD
+#  include "mz_strm_zstd.h"
+#endif
 
 #include "mz_zip.h"
 
@@ -64,18 +68,73 @@
 #define MZ_ZIP_MAGIC_ENDLOCHEADER64     (0x07064b50)
 #define MZ_ZIP_MAGIC_DATADESCRIPTOR     (0x08074b50)
 #define MZ_ZIP_MAGIC_DATADESCRIPTORU8   { 0x50, 0x4b, 0x07, 0x08 }
+#define MZ_ZIP_MAGIC_INDEX              (0x58495a4d)
+
+#define MZ_ZIP_INDEX_VERSION            (3)
+#define MZ_ZIP_INDEX_HEADER_SIZE        (96)
+#define MZ_ZIP_INDEX_FLAG_SORTED        (1 << 0)
 
 #define MZ_ZIP_SIZE_LD_ITEM             (30)
 #define MZ_ZIP_SIZE_CD_ITEM             (46)
 #define MZ_ZIP_SIZE_CD_LOCATOR64        (20)
 #define MZ_ZIP_SIZE_MAX_DATA_DESCRIPTOR (24)
 
+#define MZ_ZIP_SIZE_EOCD                (22)
+#define MZ_ZIP_SIZE_EOCD64              (56)
+
+#define MZ_ZIP_CODEC_POOL_SIZE          (4)     /* closed compression streams kept per zip */
+
 #ifndef MZ_ZIP_EOCD_MAX_BACK
 #define MZ_ZIP_EOCD_MAX_BACK            (1 << 20)
 #endif
+#ifndef MZ_ZIP_TAIL_READ_SIZE
+/* Large enough for end of central dir records with the longest comment */
+#define MZ_ZIP_TAIL_READ_SIZE           (UINT16_MAX + MZ_ZIP_SIZE_EOCD + \
+                                         MZ_ZIP_SIZE_CD_LOCATOR64 + MZ_ZIP_SIZE_EOCD64)
+#endif
+#ifndef MZ_ZIP_INDEX_TAIL_SIZE
+/* End of the archive checked against a loaded index, covers the end of central dir
+   records and the last entries of the central dir */
+#define MZ_ZIP_INDEX_TAIL_SIZE          (MZ_ZIP_TAIL_READ_SIZE + 4096)
+#endif
 
 /***************************************************************************/
 
+typedef struct mz_zip_index_slot_s
+{
+    uint32_t hash;                  /* hash of the normalized filename */
+    uint32_t key_pos;               /* offset of the folded filename in the key pool */
+    int64_t  cd_pos;                /* pos of the entry in the central dir, -1 if empty */
+} mz_zip_index_slot;
+
+typedef struct mz_zip_table_s
+{
+    uint64_t count;                 /* number of entries in the table */
+    uint64_t capacity;              /* number of entries allocated for each column */
+    int64_t  *cd_pos;               /* pos of the entry in the central dir */
+    int64_t  *disk_offset;
+    int64_t  *compressed_size;
+    int64_t  *uncompressed_size;
+    time_t   *modified_date;
+    time_t   *accessed_date;
+    time_t   *creation_date;
+    uint32_t *crc;
+    uint32_t *disk_number;
+    uint32_t *external_fa;
+    uint32_t *filename_pos;         /* offset of the filename in the string pool */
+    uint16_t *filename_size;
+    uint16_t *version_madeby;
+    uint16_t *version_needed;
+    uint16_t *flag;
+    uint16_t *compression_method;
+    uint16_t *internal_fa;
+    uint16_t *aes_version;
+    uint8_t  *aes_encryption_mode;
+    char     *pool;                 /* null-terminated filenames */
+    uint32_t pool_size;
+    uint32_t pool_capacity;
+} mz_zip_table;
+
 typedef struct mz_zip_s
 {
     mz_zip_file file_info;
@@ -84,10 +143,15 @@ typedef struct mz_zip_s
     void *stream;                   /* main stream */
     void *cd_stream;                /* pointer to the stream with the cd */
     void *cd_mem_stream;            /* memory stream for central directory */
+    void *cd_paged_stream;          /* paged stream for central directory larger than cd_mem_max */
     void *compress_stream;          /* compression stream */
     void *crypt_stream;             /* encryption stream */
     void *file_info_stream;         /* memory stream for storing file info */
     void *local_file_info_stream;   /* memory stream for storing local file info */
+    void *header_stream;            /* memory stream for assembling the local header */
+
+    void     *codec_pool[MZ_ZIP_CODEC_POOL_SIZE];           /* closed compression streams for reuse */
+    uint16_t codec_pool_method[MZ_ZIP_CODEC_POOL_SIZE];    /* compression method of each pooled stream */
 
     int32_t  open_mode;
     uint8_t  recover;
@@ -100,16 +164,48 @@ typedef struct mz_zip_s
     int64_t  cd_offset;             /* offset of start of central directory */
     int64_t  cd_size;               /* size of the central directory */
     uint32_t cd_signature;          /* signature of central directory */
+    int64_t  cd_mem_max;            /* max size of central directory stored in memory */
 
     uint8_t  entry_scanned;         /* entry header information read ok */
     uint8_t  entry_opened;          /* entry is open for read/write */
     uint8_t  entry_raw;             /* entry opened with raw mode */
+    uint8_t  entry_header_pending;  /* local header is written with the first entry data */
+    uint8_t  entry_crc_stream;      /* entry crc32 is computed by the compression stream */
+    int64_t  entry_read_buffer;     /* compressed bytes decoded without the compression stream */
     uint32_t entry_crc32;           /* entry crc32  */
+    int32_t  compress_threads;      /* threads used to compress each entry */
 
     uint64_t number_entry;
 
     uint16_t version_madeby;
     char     *comment;
+
+    uint8_t  index;                 /* build filename index when reading central dir */
+    mz_zip_index_slot *index_case;  /* filename hash table, case sensitive */
+    mz_zip_index_slot *index_nocase;/* filename hash table, case insensitive */
+    uint32_t index_mask;            /* number of slots in each hash table minus one */
+    uint8_t  *index_keys;           /* folded filenames each stored after its 16-bit length */
+    uint32_t index_keys_size;
+    uint32_t index_keys_capacity;
+    uint8_t  entry_table;           /* build entry table when reading central dir */
+    mz_zip_table table;             /* packed entry info for random access by index */
+    uint8_t  index_loaded;          /* index was loaded instead of built from the central dir */
+    int64_t  index_archive_size;    /* size of the archive the loaded index was saved for */
+    int32_t  index_tail_size;       /* size of the end of the archive checked on open */
+    uint32_t index_tail_crc;        /* crc32 of the end of the archive the loaded index was saved for */
+    int64_t  index_cd_start_pos;    /* cd start pos the cd positions in the loaded index are relative to */
+    uint8_t  prefix_index;          /* build sorted filename index when reading central dir */
+    uint32_t *index_sorted;         /* entry table indexes sorted by filename */
+    uint32_t *query;                /* entry table indexes found by last prefix query */
+    uint64_t query_count;
+    uint64_t query_pos;
+    uint8_t  query_children;        /* last query was for the children of a directory */
+    int32_t  query_dir_len;         /* length of the directory of the last child query */
+    uint8_t  path_check;            /* check normalized paths when reading central dir */
+    uint8_t  *path_flags;           /* conflict flags of each entry in the entry table */
+    uint32_t *path_pos;             /* offset of the normalized path of each entry in the path pool */
+    char     *path_pool;
+    uint32_t path_flags_all;        /* conflict flags found in any entry */
 } mz_zip;
 
 /***************************************************************************/
@@ -142,51 +238,6 @@ static int32_t mz_zip_search_eocd(void *stream, int64_t *central_pos)
     return mz_stream_find_reverse(stream, (const void *)find, sizeof(find), max_back, central_pos);
 }
 
-/* Locate the end of central directory 64 of a zip file */
-static int32_t mz_zip_search_zip64_eocd(void *stream, const int64_t end_central_offset, int64_t *central_pos)
-{
-    int64_t offset = 0;
-    uint32_t value32 = 0;
-    int32_t err = MZ_OK;
-
-
-    *central_pos = 0;
-
-    /* Zip64 end of central directory locator */
-    err = mz_stream_seek(stream, end_central_offset - MZ_ZIP_SIZE_CD_LOCATOR64, MZ_SEEK_SET);
-    /* Read locator signature */
-    if (err == MZ_OK)
-    {
-        err = mz_stream_read_uint32(stream, &value32);
-        if (err == MZ_OK && value32 != MZ_ZIP_MAGIC_ENDLOCHEADER64)
-            err = MZ_FORMAT_ERROR;
-    }
-    /* Number of the disk with the start of the zip64 end of  central directory */
-    if (err == MZ_OK)
-        err = mz_stream_read_uint32(stream, &value32);
-    /* Relative offset of the zip64 end of central directory record8 */
-    if (err == MZ_OK)
-        err = mz_stream_read_uint64(stream, (uint64_t *)&offset);
-    /* Total number of disks */
-    if (err == MZ_OK)
-        err = mz_stream_read_uint32(stream, &value32);
-    /* Goto end of central directory record */
-    if (err == MZ_OK)
-        err = mz_stream_seek(stream, (int64_t)offset, MZ_SEEK_SET);
-    /* The signature */
-    if (err == MZ_OK)
-    {
-        err = mz_stream_read_uint32(stream, &value32);
-        if (value32 != MZ_ZIP_MAGIC_ENDHEADER64)
-            err = MZ_FORMAT_ERROR;
-    }
-
-    if (err == MZ_OK)
-        *central_pos = offset;
-
-    return err;
-}
-
 /* Get info about the current file in the zip file */
 static int32_t mz_zip_entry_read_header(void *stream, uint8_t local, mz_zip_file *file_info, void *file_extra_stream)
 {
@@ -692,8 +743,9 @@ static int32_t mz_zip_entry_write_header(void *stream, uint8_t local, mz_zip_fil
             if ((file_info->flag & MZ_ZIP_FLAG_ENCRYPTED) && (file_info->aes_version))
                 version_needed = 51;
 #endif
-#ifdef HAVE_LZMA
-            if (file_info->compression_method == MZ_COMPRESS_METHOD_LZMA)
+#if defined(HAVE_LZMA) || defined(HAVE_ZSTD)
+            if ((file_info->compression_method == MZ_COMPRESS_METHOD_LZMA) ||
+                (file_info->compression_method == MZ_COMPRESS_METHOD_ZSTD))
                 version_needed = 63;
 #endif
         }
@@ -945,71 +997,191 @@ static int32_t mz_zip_entry_write_descriptor(void *stream, uint8_t zip64, uint32
     return err;
 }
 
+/* Get little-endian value from a buffer */
+static uint64_t mz_zip_buffer_value(const uint8_t *buf, int32_t len)
+{
+    uint64_t value = 0;
+    int32_t n = 0;
+
+    for (n = len - 1; n >= 0; n -= 1)
+        value = (value << 8) | buf[n];
+    return value;
+}
+
+/* Put little-endian value into a buffer */
+static void mz_zip_buffer_put(uint8_t *buf, uint64_t value, int32_t len)
+{
+    int32_t n = 0;
+
+    for (n = 0; n < len; n += 1)
+    {
+        buf[n] = (uint8_t)(value & 0xff);
+        value >>= 8;
+    }
+}
+
+/* Read the last bytes of the stream ending at end_pos into the tail buffer */
+static int32_t mz_zip_read_tail(void *stream, int64_t end_pos, uint8_t *tail, int64_t *tail_pos, int32_t *tail_size)
+{
+    int64_t size = MZ_ZIP_TAIL_READ_SIZE;
+    int32_t err = MZ_OK;
+
+    if (size > end_pos)
+        size = end_pos;
+
+    *tail_pos = end_pos - size;
+    *tail_size = 0;
+
+    err = mz_stream_seek(stream, *tail_pos, MZ_SEEK_SET);
+    if ((err == MZ_OK) && (mz_stream_read(stream, tail, (int32_t)size) != (int32_t)size))
+        err = MZ_READ_ERROR;
+    if (err == MZ_OK)
+        *tail_size = (int32_t)size;
+    return err;
+}
+
+/* Get bytes at a position in the stream, from the tail buffer if it holds them */
+static int32_t mz_zip_read_at(void *stream, const uint8_t *tail, int64_t tail_pos, int32_t tail_size,
+    int64_t pos, uint8_t *buf, int32_t len)
+{
+    int32_t err = MZ_OK;
+
+    if ((pos >= tail_pos) && (pos + len <= tail_pos + tail_size))
+    {
+        memcpy(buf, tail + (pos - tail_pos), len);
+        return MZ_OK;
+    }
+
+    err = mz_stream_seek(stream, pos, MZ_SEEK_SET);
+    if ((err == MZ_OK) && (mz_stream_read(stream, buf, len) != len))
+        err = MZ_END_OF_STREAM;
+    return err;
+}
+
+/* Store the central directory in memory using at most one read */
+static int32_t mz_zip_read_cd_mem(void *handle, const uint8_t *tail, int64_t tail_pos, int32_t tail_size)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    uint8_t *cd_buf = NULL;
+    int32_t err = MZ_OK;
+
+
+    if (mz_stream_mem_is_open(zip->cd_mem_stream) != MZ_OK)
+    {
+        mz_stream_mem_set_grow_size(zip->cd_mem_stream, (int32_t)zip->cd_size);
+        err = mz_stream_mem_open(zip->cd_mem_stream, NULL, MZ_OPEN_MODE_CREATE);
+    }
+    /* Seeking past the end grows the memory stream to fit */
+    if (err == MZ_OK)
+        err = mz_stream_mem_seek(zip->cd_mem_stream, zip->cd_size, MZ_SEEK_SET);
+    if (err == MZ_OK)
+        err = mz_stream_mem_get_buffer(zip->cd_mem_stream, (const void **)&cd_buf);
+    if (err == MZ_OK)
+        err = mz_zip_read_at(zip->stream, tail, tail_pos, tail_size, zip->cd_offset, cd_buf, (int32_t)zip->cd_size);
+    if (err == MZ_OK)
+        mz_stream_mem_set_buffer_limit(zip->cd_mem_stream, (int32_t)zip->cd_size);
+    else
+        mz_stream_mem_seek(zip->cd_mem_stream, 0, MZ_SEEK_SET);
+
+    return err;
+}
+
 static int32_t mz_zip_read_cd(void *handle)
 {
     mz_zip *zip = (mz_zip *)handle;
     uint64_t number_entry_cd64 = 0;
     uint64_t number_entry = 0;
     uint64_t number_entry_cd = 0;
-    int64_t eocd_pos = 0;
+    int64_t file_size = 0;
+    int64_t tail_pos = 0;
+    int64_t eocd_pos = -1;
     int64_t eocd_pos64 = 0;
     int64_t value64i = 0;
-    uint16_t value16 = 0;
-    uint32_t value32 = 0;
-    uint64_t value64 = 0;
+    int32_t tail_size = 0;
+    int32_t eocd_offset = 0;
+    int32_t i = 0;
     uint16_t comment_size = 0;
     int32_t comment_read = 0;
     int32_t err = MZ_OK;
+    uint8_t eocd_magic[4] = MZ_ZIP_MAGIC_ENDHEADERU8;
+    uint8_t record[MZ_ZIP_SIZE_EOCD64];
+    uint8_t *tail = NULL;
+    const uint8_t *eocd = NULL;
 
 
     if (zip == NULL)
         return MZ_PARAM_ERROR;
 
-    /* Read and cache central directory records */
-    err = mz_zip_search_eocd(zip->stream, &eocd_pos);
+    tail = (uint8_t *)MZ_ALLOC(MZ_ZIP_TAIL_READ_SIZE);
+    if (tail == NULL)
+        return MZ_MEM_ERROR;
+
+    /* Read the end of the archive in one go, it holds the end of central dir records */
+    err = mz_stream_seek(zip->stream, 0, MZ_SEEK_END);
     if (err == MZ_OK)
     {
-        /* The signature, already checked */
-        err = mz_stream_read_uint32(zip->stream, &value32);
-        /* Number of this disk */
-        if (err == MZ_OK)
-            err = mz_stream_read_uint16(zip->stream, &value16);
+        file_size = mz_stream_tell(zip->stream);
+        err = mz_zip_read_tail(zip->stream, file_size, tail, &tail_pos, &tail_size);
+    }
+    if (err == MZ_OK)
+    {
+        for (i = tail_size - MZ_ZIP_SIZE_EOCD; i >= 0; i -= 1)
+        {
+            if (memcmp(tail + i, eocd_magic, sizeof(eocd_magic)) == 0)
+            {
+                eocd_pos = tail_pos + i;
+                break;
+            }
+        }
+
+        if (eocd_pos < 0)
+        {
+            /* Search further back in case of data appended after the archive */
+            if (tail_pos == 0)
+                err = MZ_EXIST_ERROR;
+            if (err == MZ_OK)
+                err = mz_zip_search_eocd(zip->stream, &eocd_pos);
+            if ((err == MZ_OK) && (eocd_pos + MZ_ZIP_SIZE_EOCD + UINT16_MAX < file_size))
+                file_size = eocd_pos + MZ_ZIP_SIZE_EOCD + UINT16_MAX;
+            if (err == MZ_OK)
+                err = mz_zip_read_tail(zip->stream, file_size, tail, &tail_pos, &tail_size);
+            if ((err == MZ_OK) && (eocd_pos + MZ_ZIP_SIZE_EOCD > tail_pos + tail_size))
+                err = MZ_FORMAT_ERROR;
+        }
+    }
+
+    if (err == MZ_OK)
+    {
+        eocd_offset = (int32_t)(eocd_pos - tail_pos);
+        eocd = tail + eocd_offset;
+
         /* Number of the disk with the start of the central directory */
-        if (err == MZ_OK)
-            err = mz_stream_read_uint16(zip->stream, &value16);
-        zip->disk_number_with_cd = value16;
+        zip->disk_number_with_cd = (uint32_t)mz_zip_buffer_value(eocd + 6, 2);
         /* Total number of entries in the central dir on this disk */
-        if (err == MZ_OK)
-            err = mz_stream_read_uint16(zip->stream, &value16);
-        zip->number_entry = value16;
+        zip->number_entry = mz_zip_buffer_value(eocd + 8, 2);
         /* Total number of entries in the central dir */
-        if (err == MZ_OK)
-            err = mz_stream_read_uint16(zip->stream, &value16);
-        number_entry_cd = value16;
+        number_entry_cd = mz_zip_buffer_value(eocd + 10, 2);
         if (number_entry_cd != zip->number_entry)
             err = MZ_FORMAT_ERROR;
-        /* Size of the central directory */
-        if (err == MZ_OK)
-            err = mz_stream_read_uint32(zip->stream, &value32);
-        if (err == MZ_OK)
-            zip->cd_size = value32;
-        /* Offset of start of central directory with respect to the starting disk number */
-        if (err == MZ_OK)
-            err = mz_stream_read_uint32(zip->stream, &value32);
         if (err == MZ_OK)
-            zip->cd_offset = value32;
-        /* Zip file global comment length */
-        if (err == MZ_OK)
-            err = mz_stream_read_uint16(zip->stream, &comment_size);
+        {
+            /* Size of the central directory */
+            zip->cd_size = (int64_t)mz_zip_buffer_value(eocd + 12, 4);
+            /* Offset of start of central directory with respect to the starting disk number */
+            zip->cd_offset = (int64_t)mz_zip_buffer_value(eocd + 16, 4);
+            /* Zip file global comment length */
+            comment_size = (uint16_t)mz_zip_buffer_value(eocd + 20, 2);
+        }
         if ((err == MZ_OK) && (comment_size > 0))
         {
             zip->comment = (char *)MZ_ALLOC(comment_size + 1);
             if (zip->comment != NULL)
             {
-                comment_read = mz_stream_read(zip->stream, zip->comment, comment_size);
                 /* Don't fail if incorrect comment length read, not critical */
-                if (comment_read < 0)
-                    comment_read = 0;
+                comment_read = tail_size - (eocd_offset + MZ_ZIP_SIZE_EOCD);
+                if (comment_read > comment_size)
+                    comment_read = comment_size;
+                memcpy(zip->comment, eocd + MZ_ZIP_SIZE_EOCD, comment_read);
                 zip->comment[comment_read] = 0;
             }
         }
@@ -1017,51 +1189,46 @@ static int32_t mz_zip_read_cd(void *handle)
         if ((err == MZ_OK) && ((number_entry_cd == UINT16_MAX) || (zip->cd_offset == UINT32_MAX)))
         {
             /* Format should be Zip64, as the central directory or file size is too large */
-            if (mz_zip_search_zip64_eocd(zip->stream, eocd_pos, &eocd_pos64) == MZ_OK)
+            if (eocd_pos >= MZ_ZIP_SIZE_CD_LOCATOR64)
+            {
+                /* Zip64 end of central directory locator */
+                if (mz_zip_read_at(zip->stream, tail, tail_pos, tail_size, eocd_pos - MZ_ZIP_SIZE_CD_LOCATOR64,
+                    record, MZ_ZIP_SIZE_CD_LOCATOR64) == MZ_OK &&
+                    mz_zip_buffer_value(record, 4) == MZ_ZIP_MAGIC_ENDLOCHEADER64)
+                {
+                    /* Relative offset of the zip64 end of central directory record */
+                    value64i = (int64_t)mz_zip_buffer_value(record + 8, 8);
+                    if ((value64i >= 0) && (mz_zip_read_at(zip->stream, tail, tail_pos, tail_size, value64i,
+                        record, MZ_ZIP_SIZE_EOCD64) == MZ_OK) &&
+                        mz_zip_buffer_value(record, 4) == MZ_ZIP_MAGIC_ENDHEADER64)
+                    {
+                        eocd_pos64 = value64i;
+                    }
+                }
+            }
+
+            if (eocd_pos64 > 0)
             {
                 eocd_pos = eocd_pos64;
 
-                err = mz_stream_seek(zip->stream, eocd_pos, MZ_SEEK_SET);
-                /* The signature, already checked */
-                if (err == MZ_OK)
-                    err = mz_stream_read_uint32(zip->stream, &value32);
-                /* Size of zip64 end of central directory record */
-                if (err == MZ_OK)
-                    err = mz_stream_read_uint64(zip->stream, &value64);
                 /* Version made by */
-                if (err == MZ_OK)
-                    err = mz_stream_read_uint16(zip->stream, &zip->version_madeby);
-                /* Version needed to extract */
-                if (err == MZ_OK)
-                    err = mz_stream_read_uint16(zip->stream, &value16);
-                /* Number of this disk */
-                if (err == MZ_OK)
-                    err = mz_stream_read_uint32(zip->stream, &value32);
+                zip->version_madeby = (uint16_t)mz_zip_buffer_value(record + 12, 2);
                 /* Number of the disk with the start of the central directory */
-                if (err == MZ_OK)
-                    err = mz_stream_read_uint32(zip->stream, &zip->disk_number_with_cd);
+                zip->disk_number_with_cd = (uint32_t)mz_zip_buffer_value(record + 20, 4);
                 /* Total number of entries in the central directory on this disk */
-                if (err == MZ_OK)
-                    err = mz_stream_read_uint64(zip->stream, &number_entry);
+                number_entry = mz_zip_buffer_value(record + 24, 8);
                 /* Total number of entries in the central directory */
-                if (err == MZ_OK)
-                    err = mz_stream_read_uint64(zip->stream, &number_entry_cd64);
+                number_entry_cd64 = mz_zip_buffer_value(record + 32, 8);
                 if (number_entry == UINT32_MAX)
                     zip->number_entry = number_entry_cd64;
                 /* Size of the central directory */
-                if (err == MZ_OK)
-                {
-                    err = mz_stream_read_int64(zip->stream, &zip->cd_size);
-                    if (zip->cd_size < 0)
-                        err = MZ_FORMAT_ERROR;
-                }
+                zip->cd_size = (int64_t)mz_zip_buffer_value(record + 40, 8);
+                if (zip->cd_size < 0)
+                    err = MZ_FORMAT_ERROR;
                 /* Offset of start of central directory with respect to the starting disk number */
-                if (err == MZ_OK)
-                {
-                    err = mz_stream_read_int64(zip->stream, &zip->cd_offset);
-                    if (zip->cd_offset < 0)
-                        err = MZ_FORMAT_ERROR;
-                }
+                zip->cd_offset = (int64_t)mz_zip_buffer_value(record + 48, 8);
+                if (zip->cd_offset < 0)
+                    err = MZ_FORMAT_ERROR;
             }
             else if ((zip->number_entry == UINT16_MAX) || (number_entry_cd != zip->number_entry) ||
                      (zip->cd_size == UINT16_MAX) || (zip->cd_offset == UINT32_MAX))
@@ -1077,19 +1244,21 @@ static int32_t mz_zip_read_cd(void *handle)
             zip->disk_number_with_cd, zip->number_entry, zip->cd_offset, zip->cd_size);
 
         /* Verify central directory signature exists at offset */
-        err = mz_stream_seek(zip->stream, zip->cd_offset, MZ_SEEK_SET);
+        err = mz_zip_read_at(zip->stream, tail, tail_pos, tail_size, zip->cd_offset, record, 4);
         if (err == MZ_OK)
-            err = mz_stream_read_uint32(zip->stream, &zip->cd_signature);
+            zip->cd_signature = (uint32_t)mz_zip_buffer_value(record, 4);
         if ((err == MZ_OK) && (zip->cd_signature != MZ_ZIP_MAGIC_CENTRALHEADER))
         {
             /* If cd exists in large file and no zip-64 support, error for recover */
             if (eocd_pos > UINT32_MAX && eocd_pos64 == 0)
                 err = MZ_FORMAT_ERROR;
             /* If cd not found attempt to seek backward to find it */
+            if ((err == MZ_OK) && (eocd_pos - zip->cd_size < 0))
+                err = MZ_SEEK_ERROR;
             if (err == MZ_OK)
-                err = mz_stream_seek(zip->stream, eocd_pos - zip->cd_size, MZ_SEEK_SET);
+                err = mz_zip_read_at(zip->stream, tail, tail_pos, tail_size, eocd_pos - zip->cd_size, record, 4);
             if (err == MZ_OK)
-                err = mz_stream_read_uint32(zip->stream, &zip->cd_signature);
+                zip->cd_signature = (uint32_t)mz_zip_buffer_value(record, 4);
             if ((err == MZ_OK) && (zip->cd_signature == MZ_ZIP_MAGIC_CENTRALHEADER))
             {
 
@@ -1116,16 +1285,31 @@ static int32_t mz_zip_read_cd(void *handle)
         }
     }
 
+    /* Fetch the whole central directory in at most one more read */
+    if ((err == MZ_OK) && (zip->cd_size > 0) && (zip->cd_size <= INT32_MAX) &&
+        ((zip->cd_mem_max == 0) || (zip->cd_size <= zip->cd_mem_max)))
+    {
+        err = mz_zip_read_cd_mem(handle, tail, tail_pos, tail_size);
+        if (err == MZ_OK)
+            zip->cd_stream = zip->cd_mem_stream;
+    }
+
+    MZ_FREE(tail);
     return err;
 }
 
 static int32_t mz_zip_write_cd(void *handle)
 {
     mz_zip *zip = (mz_zip *)handle;
+    mz_stream_iovec iov[2];
+    void *end_stream = NULL;
     int64_t zip64_eocd_pos_inzip = 0;
     int64_t disk_number = 0;
     int64_t disk_size = 0;
     int32_t comment_size = 0;
+    int32_t iov_count = 0;
+    int32_t total_size = 0;
+    int32_t end_size = 0;
     int32_t err = MZ_OK;
 
 
@@ -1148,7 +1332,21 @@ static int32_t mz_zip_write_cd(void *handle)
     zip->cd_size = (uint32_t)mz_stream_tell(zip->cd_mem_stream);
     mz_stream_seek(zip->cd_mem_stream, 0, MZ_SEEK_SET);
 
-    err = mz_stream_copy(zip->stream, zip->cd_mem_stream, (int32_t)zip->cd_size);
+    /* Central directory and end records are written together in a single write */
+    err = mz_stream_mem_get_buffer(zip->cd_mem_stream, &iov[0].buf);
+    iov[0].size = (int32_t)zip->cd_size;
+    iov_count = 1;
+    total_size = iov[0].size;
+
+    /* Disks are cut wherever they fill up, so when splitting the central directory is
+       written first to know where the end records start */
+    if ((err == MZ_OK) && (disk_size > 0))
+    {
+        if (mz_stream_writev(zip->stream, iov, iov_count) != iov[0].size)
+            err = MZ_WRITE_ERROR;
+        iov_count = 0;
+        total_size = 0;
+    }
 
     mz_zip_print("Zip - Write cd (disk %" PRId32 " entries %" PRId64 " offset %" PRId64 " size %" PRId64 ")\n",
         zip->disk_number_with_cd, zip->number_entry, zip->cd_offset, zip->cd_size);
@@ -1159,91 +1357,96 @@ static int32_t mz_zip_write_cd(void *handle)
         return MZ_FORMAT_ERROR;
     }
 
+    mz_stream_mem_create(&end_stream);
+    mz_stream_mem_open(end_stream, NULL, MZ_OPEN_MODE_CREATE);
+
     /* Write the ZIP64 central directory header */
-    if (zip->cd_offset >= UINT32_MAX || zip->number_entry > UINT16_MAX)
+    if ((err == MZ_OK) && (zip->cd_offset >= UINT32_MAX || zip->number_entry > UINT16_MAX))
     {
-        zip64_eocd_pos_inzip = mz_stream_tell(zip->stream);
+        zip64_eocd_pos_inzip = zip->cd_offset + zip->cd_size;
+        if (disk_size > 0)
+            zip64_eocd_pos_inzip = mz_stream_tell(zip->stream);
 
-        err = mz_stream_write_uint32(zip->stream, MZ_ZIP_MAGIC_ENDHEADER64);
+        err = mz_stream_write_uint32(end_stream, MZ_ZIP_MAGIC_ENDHEADER64);
 
         /* Size of this 'zip64 end of central directory' */
         if (err == MZ_OK)
-            err = mz_stream_write_uint64(zip->stream, (uint64_t)44);
+            err = mz_stream_write_uint64(end_stream, (uint64_t)44);
         /* Version made by */
         if (err == MZ_OK)
-            err = mz_stream_write_uint16(zip->stream, zip->version_madeby);
+            err = mz_stream_write_uint16(end_stream, zip->version_madeby);
         /* Version needed */
         if (err == MZ_OK)
-            err = mz_stream_write_uint16(zip->stream, (uint16_t)45);
+            err = mz_stream_write_uint16(end_stream, (uint16_t)45);
         /* Number of this disk */
         if (err == MZ_OK)
-            err = mz_stream_write_uint32(zip->stream, zip->disk_number_with_cd);
+            err = mz_stream_write_uint32(end_stream, zip->disk_number_with_cd);
         /* Number of the disk with the start of the central directory */
         if (err == MZ_OK)
-            err = mz_stream_write_uint32(zip->stream, zip->disk_number_with_cd);
+            err = mz_stream_write_uint32(end_stream, zip->disk_number_with_cd);
         /* Total number of entries in the central dir on this disk */
         if (err == MZ_OK)
-            err = mz_stream_write_uint64(zip->stream, zip->number_entry);
+            err = mz_stream_write_uint64(end_stream, zip->number_entry);
         /* Total number of entries in the central dir */
         if (err == MZ_OK)
-            err = mz_stream_write_uint64(zip->stream, zip->number_entry);
+            err = mz_stream_write_uint64(end_stream, zip->number_entry);
         /* Size of the central directory */
         if (err == MZ_OK)
-            err = mz_stream_write_int64(zip->stream, zip->cd_size);
+            err = mz_stream_write_int64(end_stream, zip->cd_size);
         /* Offset of start of central directory with respect to the starting disk number */
         if (err == MZ_OK)
-            err = mz_stream_write_int64(zip->stream, zip->cd_offset);
+            err = mz_stream_write_int64(end_stream, zip->cd_offset);
         if (err == MZ_OK)
-            err = mz_stream_write_uint32(zip->stream, MZ_ZIP_MAGIC_ENDLOCHEADER64);
+            err = mz_stream_write_uint32(end_stream, MZ_ZIP_MAGIC_ENDLOCHEADER64);
 
         /* Number of the disk with the start of the central directory */
         if (err == MZ_OK)
-            err = mz_stream_write_uint32(zip->stream, zip->disk_number_with_cd);
+            err = mz_stream_write_uint32(end_stream, zip->disk_number_with_cd);
         /* Relative offset to the end of zip64 central directory */
         if (err == MZ_OK)
-            err = mz_stream_write_int64(zip->stream, zip64_eocd_pos_inzip);
+            err = mz_stream_write_int64(end_stream, zip64_eocd_pos_inzip);
         /* Number of the disk with the start of the central directory */
         if (err == MZ_OK)
-            err = mz_stream_write_uint32(zip->stream, zip->disk_number_with_cd + 1);
+            err = mz_stream_write_uint32(end_stream, zip->disk_number_with_cd + 1);
     }
 
     /* Write the central directory header */
 
     /* Signature */
     if (err == MZ_OK)
-        err = mz_stream_write_uint32(zip->stream, MZ_ZIP_MAGIC_ENDHEADER);
+        err = mz_stream_write_uint32(end_stream, MZ_ZIP_MAGIC_ENDHEADER);
     /* Number of this disk */
     if (err == MZ_OK)
-        err = mz_stream_write_uint16(zip->stream, (uint16_t)zip->disk_number_with_cd);
+        err = mz_stream_write_uint16(end_stream, (uint16_t)zip->disk_number_with_cd);
     /* Number of the disk with the start of the central directory */
     if (err == MZ_OK)
-        err = mz_stream_write_uint16(zip->stream, (uint16_t)zip->disk_number_with_cd);
+        err = mz_stream_write_uint16(end_stream, (uint16_t)zip->disk_number_with_cd);
     /* Total number of entries in the central dir on this disk */
     if (err == MZ_OK)
     {
         if (zip->number_entry >= UINT16_MAX)
-            err = mz_stream_write_uint16(zip->stream, UINT16_MAX);
+            err = mz_stream_write_uint16(end_stream, UINT16_MAX);
         else
-            err = mz_stream_write_uint16(zip->stream, (uint16_t)zip->number_entry);
+            err = mz_stream_write_uint16(end_stream, (uint16_t)zip->number_entry);
     }
     /* Total number of entries in the central dir */
     if (err == MZ_OK)
     {
         if (zip->number_entry >= UINT16_MAX)
-            err = mz_stream_write_uint16(zip->stream, UINT16_MAX);
+            err = mz_stream_write_uint16(end_stream, UINT16_MAX);
         else
-            err = mz_stream_write_uint16(zip->stream, (uint16_t)zip->number_entry);
+            err = mz_stream_write_uint16(end_stream, (uint16_t)zip->number_entry);
     }
     /* Size of the central directory */
     if (err == MZ_OK)
-        err = mz_stream_write_uint32(zip->stream, (uint32_t)zip->cd_size);
+        err = mz_stream_write_uint32(end_stream, (uint32_t)zip->cd_size);
     /* Offset of start of central directory with respect to the starting disk number */
     if (err == MZ_OK)
     {
         if (zip->cd_offset >= UINT32_MAX)
-            err = mz_stream_write_uint32(zip->stream, UINT32_MAX);
+            err = mz_stream_write_uint32(end_stream, UINT32_MAX);
         else
-            err = mz_stream_write_uint32(zip->stream, (uint32_t)zip->cd_offset);
+            err = mz_stream_write_uint32(end_stream, (uint32_t)zip->cd_offset);
     }
 
     /* Write global comment */
@@ -1254,12 +1457,26 @@ static int32_t mz_zip_write_cd(void *handle)
             comment_size = UINT16_MAX;
     }
     if (err == MZ_OK)
-        err = mz_stream_write_uint16(zip->stream, (uint16_t)comment_size);
+        err = mz_stream_write_uint16(end_stream, (uint16_t)comment_size);
     if (err == MZ_OK)
     {
-        if (mz_stream_write(zip->stream, zip->comment, comment_size) != comment_size)
+        if (mz_stream_write(end_stream, zip->comment, comment_size) != comment_size)
             err = MZ_READ_ERROR;
     }
+
+    if (err == MZ_OK)
+    {
+        mz_stream_mem_get_buffer(end_stream, &iov[iov_count].buf);
+        mz_stream_mem_get_buffer_length(end_stream, &end_size);
+        iov[iov_count].size = end_size;
+        iov_count += 1;
+        total_size += end_size;
+
+        if (mz_stream_writev(zip->stream, iov, iov_count) != total_size)
+            err = MZ_WRITE_ERROR;
+    }
+
+    mz_stream_mem_delete(&end_stream);
     return err;
 }
 
@@ -1448,1104 +1665,3534 @@ static int32_t mz_zip_recover_cd(void *handle)
     return MZ_OK;
 }
 
-void *mz_zip_create(void **handle)
+/* Hash a filename so that paths equal under mz_zip_path_compare hash the same */
+static uint32_t mz_zip_index_hash(const char *path, uint8_t ignore_case)
 {
-    mz_zip *zip = NULL;
+    uint32_t hash = 2166136261u;
+    int32_t c = 0;
 
-    zip = (mz_zip *)MZ_ALLOC(sizeof(mz_zip));
-    if (zip != NULL)
-        memset(zip, 0, sizeof(mz_zip));
-    if (handle != NULL)
-        *handle = zip;
+    while (*path != 0)
+    {
+        c = *path;
+        if (c == '\\')
+            c = '/';
+        else if (ignore_case)
+            c = tolower(c);
+        hash ^= (uint8_t)c;
+        hash *= 16777619u;
+        path += 1;
+    }
 
-    return zip;
+    return hash;
 }
 
-void mz_zip_delete(void **handle)
+/* Fold a filename the same way as case insensitive mz_zip_path_compare, returns the key size */
+static uint32_t mz_zip_index_fold(const char *path, uint8_t *key)
 {
-    mz_zip *zip = NULL;
-    if (handle == NULL)
-        return;
-    zip = (mz_zip *)*handle;
-    if (zip != NULL)
+    uint32_t key_size = 0;
+
+    for (key_size = 0; path[key_size] != 0; key_size += 1)
     {
-        MZ_FREE(zip);
+        if (path[key_size] == '\\')
+            key[key_size] = '/';
+        else
+            key[key_size] = (uint8_t)tolower(path[key_size]);
     }
-    *handle = NULL;
+    key[key_size] = 0;
+    return key_size;
 }
 
-int32_t mz_zip_open(void *handle, void *stream, int32_t mode)
+static void mz_zip_table_delete(mz_zip_table *table)
 {
-    mz_zip *zip = (mz_zip *)handle;
-    int32_t err = MZ_OK;
+    void **columns[] = {
+        (void **)&table->cd_pos, (void **)&table->disk_offset, (void **)&table->compressed_size,
+        (void **)&table->uncompressed_size, (void **)&table->modified_date, (void **)&table->accessed_date,
+        (void **)&table->creation_date, (void **)&table->crc, (void **)&table->disk_number,
+        (void **)&table->external_fa, (void **)&table->filename_pos, (void **)&table->filename_size,
+        (void **)&table->version_madeby, (void **)&table->version_needed, (void **)&table->flag,
+        (void **)&table->compression_method, (void **)&table->internal_fa, (void **)&table->aes_version,
+        (void **)&table->aes_encryption_mode, (void **)&table->pool };
+    int32_t i = 0;
+
+    for (i = 0; i < (int32_t)(sizeof(columns) / sizeof(columns[0])); i += 1)
+    {
+        if (*columns[i] != NULL)
+            MZ_FREE(*columns[i]);
+    }
 
+    memset(table, 0, sizeof(mz_zip_table));
+}
 
-    if (zip == NULL)
-        return MZ_PARAM_ERROR;
+static int32_t mz_zip_table_grow(mz_zip_table *table, uint64_t capacity)
+{
+    void **columns[] = {
+        (void **)&table->cd_pos, (void **)&table->disk_offset, (void **)&table->compressed_size,
+        (void **)&table->uncompressed_size, (void **)&table->modified_date, (void **)&table->accessed_date,
+        (void **)&table->creation_date, (void **)&table->crc, (void **)&table->disk_number,
+        (void **)&table->external_fa, (void **)&table->filename_pos, (void **)&table->filename_size,
+        (void **)&table->version_madeby, (void **)&table->version_needed, (void **)&table->flag,
+        (void **)&table->compression_method, (void **)&table->internal_fa, (void **)&table->aes_version,
+        (void **)&table->aes_encryption_mode };
+    size_t sizes[] = {
+        sizeof(int64_t), sizeof(int64_t), sizeof(int64_t),
+        sizeof(int64_t), sizeof(time_t), sizeof(time_t),
+        sizeof(time_t), sizeof(uint32_t), sizeof(uint32_t),
+        sizeof(uint32_t), sizeof(uint32_t), sizeof(uint16_t),
+        sizeof(uint16_t), sizeof(uint16_t), sizeof(uint16_t),
+        sizeof(uint16_t), sizeof(uint16_t), sizeof(uint16_t),
+        sizeof(uint8_t) };
+    void *column = NULL;
+    int32_t i = 0;
+
+    /* Table that can't grow is dropped so it isn't taken as built and callers walk the central dir */
+    if (capacity > UINT32_MAX)
+    {
+        mz_zip_table_delete(table);
+        return MZ_MEM_ERROR;
+    }
 
-    mz_zip_print("Zip - Open\n");
+    for (i = 0; i < (int32_t)(sizeof(columns) / sizeof(columns[0])); i += 1)
+    {
+        column = MZ_ALLOC((size_t)capacity * sizes[i]);
+        if (column == NULL)
+        {
+            mz_zip_table_delete(table);
+            return MZ_MEM_ERROR;
+        }
+        if (*columns[i] != NULL)
+        {
+            memcpy(column, *columns[i], (size_t)table->count * sizes[i]);
+            MZ_FREE(*columns[i]);
+        }
+        *columns[i] = column;
+    }
 
-    zip->stream = stream;
+    table->capacity = capacity;
+    return MZ_OK;
+}
 
-    mz_stream_mem_create(&zip->cd_mem_stream);
+static int32_t mz_zip_table_append(mz_zip_table *table, const mz_zip_file *file_info, int64_t cd_pos)
+{
+    uint64_t capacity = 0;
+    uint64_t i = table->count;
+    char *new_pool = NULL;
+    int32_t err = MZ_OK;
 
-    if (mode & MZ_OPEN_MODE_WRITE)
-    {
-        mz_stream_mem_open(zip->cd_mem_stream, NULL, MZ_OPEN_MODE_CREATE);
-        zip->cd_stream = zip->cd_mem_stream;
-    }
-    else
+    if (table->count == table->capacity)
     {
-        zip->cd_stream = stream;
+        capacity = (table->capacity < 16) ? 16 : table->capacity * 2;
+        err = mz_zip_table_grow(table, capacity);
+        if (err != MZ_OK)
+            return err;
     }
 
-    if ((mode & MZ_OPEN_MODE_READ) || (mode & MZ_OPEN_MODE_APPEND))
+    if ((uint64_t)table->pool_size + file_info->filename_size + 1 > table->pool_capacity)
     {
-        if ((mode & MZ_OPEN_MODE_CREATE) == 0)
-        {
-            err = mz_zip_read_cd(zip);
-            if (err != MZ_OK)
-            {
-                mz_zip_print("Zip - Error detected reading cd (%" PRId32 ")\n", err);
-                if (zip->recover && mz_zip_recover_cd(zip) == MZ_OK)
-                    err = MZ_OK;
-            }
-        }
-
-        if ((err == MZ_OK) && (mode & MZ_OPEN_MODE_APPEND))
+        capacity = (table->pool_capacity < 4096) ? 4096 : (uint64_t)table->pool_capacity * 2;
+        while (capacity < (uint64_t)table->pool_size + file_info->filename_size + 1)
+            capacity *= 2;
+        if (capacity <= UINT32_MAX)
+            new_pool = (char *)MZ_ALLOC((size_t)capacity);
+        if (new_pool == NULL)
         {
-            if (zip->cd_size > 0)
-            {
-                /* Store central directory in memory */
-                err = mz_stream_seek(zip->stream, zip->cd_offset, MZ_SEEK_SET);
-                if (err == MZ_OK)
-                    err = mz_stream_copy(zip->cd_mem_stream, zip->stream, (int32_t)zip->cd_size);
-                if (err == MZ_OK)
-                    err = mz_stream_seek(zip->stream, zip->cd_offset, MZ_SEEK_SET);
-            }
-            else
-            {
-                if (zip->cd_signature == MZ_ZIP_MAGIC_ENDHEADER)
-                {
-                    /* If tiny zip then overwrite end header */
-                    err = mz_stream_seek(zip->stream, zip->cd_offset, MZ_SEEK_SET);
-                }
-                else
-                {
-                    /* If no central directory, append new zip to end of file */
-                    err = mz_stream_seek(zip->stream, 0, MZ_SEEK_END);
-                }
-            }
-
-            if (zip->disk_number_with_cd > 0)
-            {
-                /* Move to last disk to begin appending */
-                mz_stream_set_prop_int64(zip->stream, MZ_STREAM_PROP_DISK_NUMBER, zip->disk_number_with_cd - 1);
-            }
+            mz_zip_table_delete(table);
+            return MZ_MEM_ERROR;
         }
-        else
+        if (table->pool != NULL)
         {
-            zip->cd_start_pos = zip->cd_offset;
+            memcpy(new_pool, table->pool, table->pool_size);
+            MZ_FREE(table->pool);
         }
+        table->pool = new_pool;
+        table->pool_capacity = (uint32_t)capacity;
     }
 
-    if (err != MZ_OK)
-    {
-        mz_zip_close(zip);
-        return err;
-    }
+    table->cd_pos[i] = cd_pos;
+    table->disk_offset[i] = file_info->disk_offset;
+    table->compressed_size[i] = file_info->compressed_size;
+    table->uncompressed_size[i] = file_info->uncompressed_size;
+    table->modified_date[i] = file_info->modified_date;
+    table->accessed_date[i] = file_info->accessed_date;
+    table->creation_date[i] = file_info->creation_date;
+    table->crc[i] = file_info->crc;
+    table->disk_number[i] = file_info->disk_number;
+    table->external_fa[i] = file_info->external_fa;
+    table->filename_pos[i] = table->pool_size;
+    table->filename_size[i] = file_info->filename_size;
+    table->version_madeby[i] = file_info->version_madeby;
+    table->version_needed[i] = file_info->version_needed;
+    table->flag[i] = file_info->flag;
+    table->compression_method[i] = file_info->compression_method;
+    table->internal_fa[i] = file_info->internal_fa;
+    table->aes_version[i] = file_info->aes_version;
+    table->aes_encryption_mode[i] = file_info->aes_encryption_mode;
+
+    memcpy(table->pool + table->pool_size, file_info->filename, file_info->filename_size);
+    table->pool_size += file_info->filename_size;
+    table->pool[table->pool_size] = 0;
+    table->pool_size += 1;
+
+    table->count += 1;
+    return MZ_OK;
+}
 
-    /* Memory streams used to store variable length file info data */
-    mz_stream_mem_create(&zip->file_info_stream);
-    mz_stream_mem_open(zip->file_info_stream, NULL, MZ_OPEN_MODE_CREATE);
+static void mz_zip_index_delete(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
 
-    mz_stream_mem_create(&zip->local_file_info_stream);
-    mz_stream_mem_open(zip->local_file_info_stream, NULL, MZ_OPEN_MODE_CREATE);
+    mz_zip_table_delete(&zip->table);
+
+    if (zip->index_case != NULL)
+        MZ_FREE(zip->index_case);
+    zip->index_case = NULL;
+    if (zip->index_nocase != NULL)
+        MZ_FREE(zip->index_nocase);
+    zip->index_nocase = NULL;
+    zip->index_mask = 0;
+    zip->index_loaded = 0;
+    if (zip->index_keys != NULL)
+        MZ_FREE(zip->index_keys);
+    zip->index_keys = NULL;
+    zip->index_keys_size = 0;
+    zip->index_keys_capacity = 0;
+
+    if (zip->index_sorted != NULL)
+        MZ_FREE(zip->index_sorted);
+    zip->index_sorted = NULL;
+    if (zip->query != NULL)
+        MZ_FREE(zip->query);
+    zip->query = NULL;
+    zip->query_count = 0;
+    zip->query_pos = 0;
+    zip->query_children = 0;
+    zip->query_dir_len = 0;
+
+    if (zip->path_flags != NULL)
+        MZ_FREE(zip->path_flags);
+    zip->path_flags = NULL;
+    if (zip->path_pos != NULL)
+        MZ_FREE(zip->path_pos);
+    zip->path_pos = NULL;
+    if (zip->path_pool != NULL)
+        MZ_FREE(zip->path_pool);
+    zip->path_pool = NULL;
+    zip->path_flags_all = 0;
+}
 
-    zip->open_mode = mode;
+static void mz_zip_index_insert(mz_zip_index_slot *slots, uint32_t mask, const mz_zip_index_slot *entry)
+{
+    uint32_t i = entry->hash & mask;
 
-    return err;
+    /* Linear probing keeps duplicate names in central dir order */
+    while (slots[i].cd_pos >= 0)
+        i = (i + 1) & mask;
+
+    slots[i] = *entry;
 }
 
-int32_t mz_zip_close(void *handle)
+static int32_t mz_zip_index_key_append(void *handle, const char *filename, uint32_t *key_pos)
 {
     mz_zip *zip = (mz_zip *)handle;
-    int32_t err = MZ_OK;
+    uint8_t *new_keys = NULL;
+    uint64_t new_capacity = 0;
+    uint32_t key_size = 0;
+    size_t filename_len = strlen(filename);
 
-    if (zip == NULL)
-        return MZ_PARAM_ERROR;
-
-    mz_zip_print("Zip - Close\n");
+    /* Enough room for the filename, its length and terminator used while folding */
+    if ((uint64_t)zip->index_keys_size + filename_len + 3 > zip->index_keys_capacity)
+    {
+        new_capacity = (uint64_t)zip->index_keys_capacity * 2;
+        if (new_capacity < (uint64_t)zip->index_keys_size + filename_len + 3)
+            new_capacity = (uint64_t)zip->index_keys_size + filename_len + 3;
+        if (new_capacity < 4096)
+            new_capacity = 4096;
+        if (new_capacity > UINT32_MAX)
+            return MZ_MEM_ERROR;
+
+        new_keys = (uint8_t *)MZ_ALLOC((size_t)new_capacity);
+        if (new_keys == NULL)
+            return MZ_MEM_ERROR;
+        if (zip->index_keys != NULL)
+        {
+            memcpy(new_keys, zip->index_keys, zip->index_keys_size);
+            MZ_FREE(zip->index_keys);
+        }
+        zip->index_keys = new_keys;
+        zip->index_keys_capacity = (uint32_t)new_capacity;
+    }
 
-    if (mz_zip_entry_is_open(handle) == MZ_OK)
-        err = mz_zip_entry_close(handle);
+    *key_pos = zip->index_keys_size;
+    key_size = mz_zip_index_fold(filename, zip->index_keys + zip->index_keys_size + 2);
+    if (key_size > UINT16_MAX)
+        key_size = UINT16_MAX;
+    zip->index_keys[zip->index_keys_size] = (uint8_t)(key_size & 0xff);
+    zip->index_keys[zip->index_keys_size + 1] = (uint8_t)(key_size >> 8);
+    zip->index_keys_size += 2 + key_size;
+    return MZ_OK;
+}
 
-    if ((err == MZ_OK) && (zip->open_mode & MZ_OPEN_MODE_WRITE))
-        err = mz_zip_write_cd(handle);
+/* Compare paths ignoring case and slash differences, up to max_len characters if not negative */
+static int32_t mz_zip_index_compare(const char *path1, const char *path2, int32_t max_len)
+{
+    int32_t c1 = 0;
+    int32_t c2 = 0;
+    int32_t i = 0;
 
-    if (zip->cd_mem_stream != NULL)
+    for (i = 0; (max_len < 0) || (i < max_len); i += 1)
     {
-        mz_stream_close(zip->cd_mem_stream);
-        mz_stream_delete(&zip->cd_mem_stream);
+        c1 = (path1[i] == '\\') ? '/' : tolower((uint8_t)path1[i]);
+        c2 = (path2[i] == '\\') ? '/' : tolower((uint8_t)path2[i]);
+        if (c1 != c2)
+            return c1 - c2;
+        if (c1 == 0)
+            break;
     }
 
-    if (zip->file_info_stream != NULL)
-    {
-        mz_stream_mem_close(zip->file_info_stream);
-        mz_stream_mem_delete(&zip->file_info_stream);
-    }
-    if (zip->local_file_info_stream != NULL)
-    {
-        mz_stream_mem_close(zip->local_file_info_stream);
-        mz_stream_mem_delete(&zip->local_file_info_stream);
-    }
+    return 0;
+}
 
-    if (zip->comment)
+/* Stable merge sort of entry table indexes, by filename or otherwise by index */
+static void mz_zip_index_merge_sort(uint32_t *items, uint32_t *temp, uint64_t count, const mz_zip_table *table,
+    uint8_t by_name)
+{
+    uint32_t *src = items;
+    uint32_t *dst = temp;
+    uint32_t *swap = NULL;
+    uint64_t width = 0;
+    uint64_t start = 0;
+    uint64_t mid = 0;
+    uint64_t end = 0;
+    uint64_t left = 0;
+    uint64_t right = 0;
+    uint64_t i = 0;
+    uint8_t take_left = 0;
+
+    for (width = 1; width < count; width *= 2)
     {
-        MZ_FREE(zip->comment);
-        zip->comment = NULL;
-    }
+        for (start = 0; start < count; start += width * 2)
+        {
+            mid = (start + width < count) ? start + width : count;
+            end = (start + width * 2 < count) ? start + width * 2 : count;
 
-    zip->stream = NULL;
-    zip->cd_stream = NULL;
+            for (i = start, left = start, right = mid; i < end; i += 1)
+            {
+                if (right >= end)
+                    take_left = 1;
+                else if (left >= mid)
+                    take_left = 0;
+                else if (by_name)
+                    take_left = (mz_zip_index_compare(table->pool + table->filename_pos[src[left]],
+                        table->pool + table->filename_pos[src[right]], -1) <= 0);
+                else
+                    take_left = (src[left] <= src[right]);
 
-    return err;
-}
+                dst[i] = (take_left) ? src[left++] : src[right++];
+            }
+        }
 
-int32_t mz_zip_get_comment(void *handle, const char **comment)
-{
-    mz_zip *zip = (mz_zip *)handle;
-    if (zip == NULL || comment == NULL)
-        return MZ_PARAM_ERROR;
-    if (zip->comment == NULL)
-        return MZ_EXIST_ERROR;
-    *comment = zip->comment;
-    return MZ_OK;
-}
+        swap = src;
+        src = dst;
+        dst = swap;
+    }
 
-int32_t mz_zip_set_comment(void *handle, const char *comment)
-{
-    mz_zip *zip = (mz_zip *)handle;
-    int32_t comment_size = 0;
-    if (zip == NULL || comment == NULL)
-        return MZ_PARAM_ERROR;
-    if (zip->comment != NULL)
-        MZ_FREE(zip->comment);
-    comment_size = (int32_t)strlen(comment);
-    if (comment_size > UINT16_MAX)
-        return MZ_PARAM_ERROR;
-    zip->comment = (char *)MZ_ALLOC(comment_size+1);
-    if (zip->comment == NULL)
-        return MZ_MEM_ERROR;
-    memset(zip->comment, 0, comment_size+1);
-    strncpy(zip->comment, comment, comment_size);
-    return MZ_OK;
+    if (src != items)
+        memcpy(items, src, (size_t)count * sizeof(uint32_t));
 }
 
-int32_t mz_zip_get_version_madeby(void *handle, uint16_t *version_madeby)
+/* Sort the entry table by filename for prefix queries */
+static int32_t mz_zip_index_sort(void *handle)
 {
     mz_zip *zip = (mz_zip *)handle;
-    if (zip == NULL || version_madeby == NULL)
-        return MZ_PARAM_ERROR;
-    *version_madeby = zip->version_madeby;
-    return MZ_OK;
-}
+    uint32_t *temp = NULL;
+    uint64_t count = zip->table.count;
+    uint64_t i = 0;
 
-int32_t mz_zip_set_version_madeby(void *handle, uint16_t version_madeby)
-{
-    mz_zip *zip = (mz_zip *)handle;
-    if (zip == NULL)
-        return MZ_PARAM_ERROR;
-    zip->version_madeby = version_madeby;
-    return MZ_OK;
-}
 
-int32_t mz_zip_set_recover(void *handle, uint8_t recover)
-{
-    mz_zip *zip = (mz_zip *)handle;
-    if (zip == NULL)
-        return MZ_PARAM_ERROR;
-    zip->recover = recover;
-    return MZ_OK;
-}
+    if (zip->index_sorted != NULL)
+        MZ_FREE(zip->index_sorted);
+    zip->index_sorted = NULL;
 
-int32_t mz_zip_get_stream(void *handle, void **stream)
-{
-    mz_zip *zip = (mz_zip *)handle;
-    if (zip == NULL || stream == NULL)
-        return MZ_PARAM_ERROR;
-    *stream = zip->stream;
-    if (*stream == NULL)
-        return MZ_EXIST_ERROR;
-    return MZ_OK;
-}
+    if (!zip->prefix_index || zip->table.cd_pos == NULL)
+        return MZ_OK;
 
-int32_t mz_zip_set_cd_stream(void *handle, int64_t cd_start_pos, void *cd_stream)
-{
-    mz_zip *zip = (mz_zip *)handle;
-    if (zip == NULL || cd_stream == NULL)
-        return MZ_PARAM_ERROR;
-    zip->cd_offset = 0;
-    zip->cd_stream = cd_stream;
-    zip->cd_start_pos = cd_start_pos;
-    return MZ_OK;
-}
+    zip->index_sorted = (uint32_t *)MZ_ALLOC((size_t)(count + 1) * sizeof(uint32_t));
+    temp = (uint32_t *)MZ_ALLOC((size_t)(count + 1) * sizeof(uint32_t));
+    if (zip->index_sorted == NULL || temp == NULL)
+    {
+        if (zip->index_sorted != NULL)
+            MZ_FREE(zip->index_sorted);
+        zip->index_sorted = NULL;
+        if (temp != NULL)
+            MZ_FREE(temp);
+        return MZ_MEM_ERROR;
+    }
 
-int32_t mz_zip_get_cd_mem_stream(void *handle, void **cd_mem_stream)
-{
-    mz_zip *zip = (mz_zip *)handle;
-    if (zip == NULL || cd_mem_stream == NULL)
-        return MZ_PARAM_ERROR;
-    *cd_mem_stream = zip->cd_mem_stream;
-    if (*cd_mem_stream == NULL)
-        return MZ_EXIST_ERROR;
+    for (i = 0; i < count; i += 1)
+        zip->index_sorted[i] = (uint32_t)i;
+
+    mz_zip_index_merge_sort(zip->index_sorted, temp, count, &zip->table, 1);
+
+    MZ_FREE(temp);
     return MZ_OK;
 }
 
-static int32_t mz_zip_entry_close_int(void *handle)
+/* Find the first sorted position in range whose filename begins with at least (or after) the prefix */
+static uint64_t mz_zip_index_bound(void *handle, uint64_t lo, uint64_t hi, const char *prefix, int32_t prefix_len,
+    uint8_t after)
 {
     mz_zip *zip = (mz_zip *)handle;
+    const char *filename = NULL;
+    uint64_t mid = 0;
+    int32_t cmp = 0;
 
-    if (zip->crypt_stream != NULL)
-        mz_stream_delete(&zip->crypt_stream);
-    zip->crypt_stream = NULL;
-    if (zip->compress_stream != NULL)
-        mz_stream_delete(&zip->compress_stream);
-    zip->compress_stream = NULL;
-
-    zip->entry_opened = 0;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        filename = zip->table.pool + zip->table.filename_pos[zip->index_sorted[mid]];
+        cmp = mz_zip_index_compare(filename, prefix, prefix_len);
+        if ((cmp < 0) || (after && cmp == 0))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
 
-    return MZ_OK;
+    return lo;
 }
 
-static int32_t mz_zip_entry_open_int(void *handle, uint8_t raw, int16_t compress_level, const char *password)
+/* Find entries that begin with a prefix, or only those directly within it, in central dir order */
+static int32_t mz_zip_index_query(void *handle, const char *prefix, uint8_t ignore_case, uint8_t children)
 {
     mz_zip *zip = (mz_zip *)handle;
-    int64_t max_total_in = 0;
-    int64_t header_size = 0;
-    int64_t footer_size = 0;
+    const char *filename = NULL;
+    char *dir = NULL;
+    uint32_t *temp = NULL;
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+    uint64_t i = 0;
+    int32_t prefix_len = 0;
+    int32_t sub_len = 0;
+    int32_t n = 0;
     int32_t err = MZ_OK;
-    uint8_t use_crypt = 0;
 
-    if (zip == NULL)
-        return MZ_PARAM_ERROR;
 
-    switch (zip->file_info.compression_method)
-    {
-    case MZ_COMPRESS_METHOD_STORE:
-    case MZ_COMPRESS_METHOD_DEFLATE:
-#ifdef HAVE_BZIP2
-    case MZ_COMPRESS_METHOD_BZIP2:
-#endif
-#ifdef HAVE_LZMA
-    case MZ_COMPRESS_METHOD_LZMA:
-#endif
-        err = MZ_OK;
-        break;
-    default:
-        return MZ_SUPPORT_ERROR;
-    }
+    if (zip->query != NULL)
+        MZ_FREE(zip->query);
+    zip->query = NULL;
+    zip->query_count = 0;
+    zip->query_pos = 0;
+    zip->query_children = 0;
+    zip->query_dir_len = 0;
 
-#ifndef HAVE_WZAES
-    if (zip->file_info.aes_version)
-        return MZ_SUPPORT_ERROR;
-#endif
+    if (zip->index_sorted == NULL)
+        return MZ_EXIST_ERROR;
 
-    zip->entry_raw = raw;
+    prefix_len = (int32_t)strlen(prefix);
 
-    if ((zip->file_info.flag & MZ_ZIP_FLAG_ENCRYPTED) && (password != NULL))
+    /* Children are found below the directory so the prefix must end with a slash */
+    if (children && (prefix_len > 0) && (prefix[prefix_len - 1] != '/') && (prefix[prefix_len - 1] != '\\'))
     {
-        if (zip->open_mode & MZ_OPEN_MODE_WRITE)
-        {
-            /* Encrypt only when we are not trying to write raw and password is supplied. */
-            if (!zip->entry_raw)
-                use_crypt = 1;
-        }
-        else if (zip->open_mode & MZ_OPEN_MODE_READ)
-        {
-            /* Decrypt only when password is supplied. Don't error when password */
-            /* is not supplied as we may want to read the raw encrypted data. */
-            use_crypt = 1;
-        }
+        dir = (char *)MZ_ALLOC(prefix_len + 2);
+        if (dir == NULL)
+            return MZ_MEM_ERROR;
+        memcpy(dir, prefix, prefix_len);
+        dir[prefix_len] = '/';
+        dir[prefix_len + 1] = 0;
+        prefix = dir;
+        prefix_len += 1;
     }
 
-    if ((err == MZ_OK) && (use_crypt))
+    lo = mz_zip_index_bound(handle, 0, zip->table.count, prefix, prefix_len, 0);
+    hi = mz_zip_index_bound(handle, lo, zip->table.count, prefix, prefix_len, 1);
+
+    zip->query = (uint32_t *)MZ_ALLOC((size_t)(hi - lo + 1) * sizeof(uint32_t));
+    temp = (uint32_t *)MZ_ALLOC((size_t)(hi - lo + 1) * sizeof(uint32_t));
+    if (zip->query == NULL || temp == NULL)
+        err = MZ_MEM_ERROR;
+
+    for (i = lo; (err == MZ_OK) && (i < hi); i += 1)
     {
-#ifdef HAVE_WZAES
-        if (zip->file_info.aes_version)
+        filename = zip->table.pool + zip->table.filename_pos[zip->index_sorted[i]];
+
+        if (!ignore_case)
         {
-            mz_stream_wzaes_create(&zip->crypt_stream);
-            mz_stream_wzaes_set_password(zip->crypt_stream, password);
-            mz_stream_wzaes_set_encryption_mode(zip->crypt_stream, zip->file_info.aes_encryption_mode);
+            for (n = 0; n < prefix_len; n += 1)
+            {
+                if ((filename[n] != prefix[n]) && !((filename[n] == '/' || filename[n] == '\\') &&
+                    (prefix[n] == '/' || prefix[n] == '\\')))
+                    break;
+            }
+            if (n < prefix_len)
+                continue;
         }
-        else
-#endif
-        {
-#ifdef HAVE_PKCRYPT
-            uint8_t verify1 = 0;
-            uint8_t verify2 = 0;
 
-            /* Info-ZIP modification to ZipCrypto format: */
-            /* If bit 3 of the general purpose bit flag is set, it uses high byte of 16-bit File Time. */
+        if (children)
+        {
+            /* Directory entry itself is not one of its children */
+            if (filename[prefix_len] == 0)
+                continue;
 
-            if (zip->file_info.flag & MZ_ZIP_FLAG_DATA_DESCRIPTOR)
+            for (sub_len = prefix_len; filename[sub_len] != 0; sub_len += 1)
             {
-                uint32_t dos_date = 0;
-
-                dos_date = mz_zip_time_t_to_dos_date(zip->file_info.modified_date);
-
-                verify1 = (uint8_t)((dos_date >> 16) & 0xff);
-                verify2 = (uint8_t)((dos_date >> 8) & 0xff);
+                if (filename[sub_len] == '/' || filename[sub_len] == '\\')
+                    break;
             }
-            else
+
+            /* Sub directory is found once, by its own entry which sorts first or by the first
+               entry below it when it has none, and the rest of its subtree is skipped in one go */
+            if (filename[sub_len] != 0)
             {
-                verify1 = (uint8_t)((zip->file_info.crc >> 16) & 0xff);
-                verify2 = (uint8_t)((zip->file_info.crc >> 24) & 0xff);
+                zip->query[zip->query_count] = zip->index_sorted[i];
+                zip->query_count += 1;
+                i = mz_zip_index_bound(handle, i, hi, filename, sub_len + 1, 1) - 1;
+                continue;
             }
-
-            mz_stream_pkcrypt_create(&zip->crypt_stream);
-            mz_stream_pkcrypt_set_password(zip->crypt_stream, password);
-            mz_stream_pkcrypt_set_verify(zip->crypt_stream, verify1, verify2);
-#endif
         }
+
+        zip->query[zip->query_count] = zip->index_sorted[i];
+        zip->query_count += 1;
     }
 
+    zip->query_children = children;
+    zip->query_dir_len = prefix_len;
+
     if (err == MZ_OK)
-    {
-        if (zip->crypt_stream == NULL)
-            mz_stream_raw_create(&zip->crypt_stream);
+        mz_zip_index_merge_sort(zip->query, temp, zip->query_count, &zip->table, 0);
 
-        mz_stream_set_base(zip->crypt_stream, zip->stream);
+    mz_zip_print("Zip - Index - Query (prefix %s range %" PRIu64 ":%" PRIu64 " found %" PRIu64 ")\n",
+        prefix, lo, hi, zip->query_count);
 
-        err = mz_stream_open(zip->crypt_stream, NULL, zip->open_mode);
-    }
+    if (temp != NULL)
+        MZ_FREE(temp);
+    if (dir != NULL)
+        MZ_FREE(dir);
 
-    if (err == MZ_OK)
+    if (err != MZ_OK)
     {
-        if (zip->entry_raw || zip->file_info.compression_method == MZ_COMPRESS_METHOD_STORE)
-            mz_stream_raw_create(&zip->compress_stream);
-#if defined(HAVE_ZLIB) || defined(HAVE_LIBCOMP)
-        else if (zip->file_info.compression_method == MZ_COMPRESS_METHOD_DEFLATE)
-            mz_stream_zlib_create(&zip->compress_stream);
-#endif
-#ifdef HAVE_BZIP2
-        else if (zip->file_info.compression_method == MZ_COMPRESS_METHOD_BZIP2)
-            mz_stream_bzip_create(&zip->compress_stream);
-#endif
-#ifdef HAVE_LZMA
-        else if (zip->file_info.compression_method == MZ_COMPRESS_METHOD_LZMA)
-            mz_stream_lzma_create(&zip->compress_stream);
-#endif
-        else
-            err = MZ_PARAM_ERROR;
+        if (zip->query != NULL)
+            MZ_FREE(zip->query);
+        zip->query = NULL;
+        zip->query_count = 0;
     }
 
-    if (err == MZ_OK)
+    return err;
+}
+
+/* Get the number of hash table slots used for the number of entries */
+static uint64_t mz_zip_index_slot_count(uint64_t entry_count)
+{
+    uint64_t slot_count = 16;
+
+    /* Keep the tables at most half full */
+    while (slot_count < entry_count * 2)
+        slot_count *= 2;
+    return slot_count;
+}
+
+/* Resolve . and .. in a path joined with forward slashes, output must be as long as the path */
+static int32_t mz_zip_path_normalize(const char *path, char *output, uint8_t *flags)
+{
+    const char *component = path;
+    int32_t component_len = 0;
+    int32_t output_len = 0;
+    int32_t depth = 0;
+
+
+    /* Absolute paths and drive letters would be extracted outside of the destination */
+    if ((*path == '/') || (*path == '\\') || (isalpha((uint8_t)path[0]) && (path[1] == ':')))
+        *flags |= MZ_ZIP_PATH_FLAG_TRAVERSAL;
+
+    while (*component != 0)
     {
-        if (zip->open_mode & MZ_OPEN_MODE_WRITE)
+        component_len = (int32_t)strcspn(component, "/\\");
+
+        if ((component_len == 2) && (component[0] == '.') && (component[1] == '.'))
         {
-            mz_stream_set_prop_int64(zip->compress_stream, MZ_STREAM_PROP_COMPRESS_LEVEL, compress_level);
+            if (depth == 0)
+                *flags |= MZ_ZIP_PATH_FLAG_TRAVERSAL;
+            else
+            {
+                /* Remove last component and its slash */
+                while ((output_len > 0) && (output[output_len - 1] != '/'))
+                    output_len -= 1;
+                if (output_len > 0)
+                    output_len -= 1;
+                depth -= 1;
+            }
         }
-        else
+        else if ((component_len > 0) && !((component_len == 1) && (component[0] == '.')) &&
+                 !((component_len == 2) && (component[1] == ':') && (component == path)))
         {
-#ifndef HAVE_LIBCOMP
-            if (zip->entry_raw || zip->file_info.compression_method == MZ_COMPRESS_METHOD_STORE || zip->file_info.flag & MZ_ZIP_FLAG_ENCRYPTED)
-#endif
-            {
-                max_total_in = zip->file_info.compressed_size;
-                mz_stream_set_prop_int64(zip->crypt_stream, MZ_STREAM_PROP_TOTAL_IN_MAX, max_total_in);
+            if (output_len > 0)
+                output[output_len++] = '/';
+            memcpy(output + output_len, component, component_len);
+            output_len += component_len;
+            depth += 1;
+        }
 
-                if (mz_stream_get_prop_int64(zip->crypt_stream, MZ_STREAM_PROP_HEADER_SIZE, &header_size) == MZ_OK)
-                    max_total_in -= header_size;
-                if (mz_stream_get_prop_int64(zip->crypt_stream, MZ_STREAM_PROP_FOOTER_SIZE, &footer_size) == MZ_OK)
-                    max_total_in -= footer_size;
+        component += component_len;
+        if (*component != 0)
+            component += 1;
+    }
 
-                mz_stream_set_prop_int64(zip->compress_stream, MZ_STREAM_PROP_TOTAL_IN_MAX, max_total_in);
-            }
-            if ((zip->file_info.compression_method == MZ_COMPRESS_METHOD_LZMA) && (zip->file_info.flag & MZ_ZIP_FLAG_LZMA_EOS_MARKER) == 0)
-            {
-                mz_stream_set_prop_int64(zip->compress_stream, MZ_STREAM_PROP_TOTAL_IN_MAX, zip->file_info.compressed_size);
-                mz_stream_set_prop_int64(zip->compress_stream, MZ_STREAM_PROP_TOTAL_OUT_MAX, zip->file_info.uncompressed_size);
-            }
-        }
+    output[output_len] = 0;
+    return output_len;
+}
 
-        mz_stream_set_base(zip->compress_stream, zip->crypt_stream);
+static int32_t mz_zip_path_check_build(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    mz_zip_table *table = &zip->table;
+    uint32_t *slots = NULL;
+    const char *path = NULL;
+    const char *other = NULL;
+    uint64_t slot_count = 0;
+    uint64_t i = 0;
+    uint32_t pool_used = 0;
+    uint32_t mask = 0;
+    uint32_t j = 0;
+
+
+    if (zip->path_flags != NULL)
+        MZ_FREE(zip->path_flags);
+    if (zip->path_pos != NULL)
+        MZ_FREE(zip->path_pos);
+    if (zip->path_pool != NULL)
+        MZ_FREE(zip->path_pool);
+    zip->path_flags = NULL;
+    zip->path_pos = NULL;
+    zip->path_pool = NULL;
+    zip->path_flags_all = 0;
+
+    if (!zip->path_check || table->cd_pos == NULL)
+        return MZ_OK;
 
-        err = mz_stream_open(zip->compress_stream, NULL, zip->open_mode);
-    }
+    slot_count = mz_zip_index_slot_count(table->count);
 
-    if (err == MZ_OK)
+    /* Normalized paths are never longer than the filenames in the pool */
+    zip->path_flags = (uint8_t *)MZ_ALLOC((size_t)table->count + 1);
+    zip->path_pos = (uint32_t *)MZ_ALLOC(((size_t)table->count + 1) * sizeof(uint32_t));
+    zip->path_pool = (char *)MZ_ALLOC((size_t)table->pool_size + 1);
+    slots = (uint32_t *)MZ_ALLOC((size_t)slot_count * sizeof(uint32_t));
+    if (zip->path_flags == NULL || zip->path_pos == NULL || zip->path_pool == NULL || slots == NULL)
     {
-        zip->entry_opened = 1;
-        zip->entry_crc32 = 0;
+        if (slots != NULL)
+            MZ_FREE(slots);
+        return MZ_MEM_ERROR;
     }
-    else
+
+    memset(zip->path_flags, 0, (size_t)table->count + 1);
+    memset(slots, 0, (size_t)slot_count * sizeof(uint32_t));
+    mask = (uint32_t)(slot_count - 1);
+
+    for (i = 0; i < table->count; i += 1)
     {
-        mz_zip_entry_close_int(handle);
+        zip->path_pos[i] = pool_used;
+        path = zip->path_pool + pool_used;
+        pool_used += mz_zip_path_normalize(table->pool + table->filename_pos[i],
+            zip->path_pool + pool_used, &zip->path_flags[i]) + 1;
+
+        /* First entry with each case folded path is kept in the table, later ones are flagged */
+        for (j = mz_zip_index_hash(path, 1) & mask; slots[j] != 0; j = (j + 1) & mask)
+        {
+            other = zip->path_pool + zip->path_pos[slots[j] - 1];
+            if (mz_zip_index_compare(other, path, -1) != 0)
+                continue;
+            if (strcmp(other, path) == 0)
+                zip->path_flags[i] |= MZ_ZIP_PATH_FLAG_DUPLICATE;
+            else
+                zip->path_flags[i] |= MZ_ZIP_PATH_FLAG_COLLISION;
+            break;
+        }
+        if (slots[j] == 0)
+            slots[j] = (uint32_t)i + 1;
+
+        zip->path_flags_all |= zip->path_flags[i];
     }
 
-    return err;
-}
+    MZ_FREE(slots);
 
-int32_t mz_zip_entry_is_open(void *handle)
-{
-    mz_zip *zip = (mz_zip *)handle;
-    if (zip == NULL)
-        return MZ_PARAM_ERROR;
-    if (zip->entry_opened == 0)
-        return MZ_EXIST_ERROR;
+    mz_zip_print("Zip - Path check (entries %" PRIu64 " flags %" PRIu32 ")\n",
+        table->count, zip->path_flags_all);
     return MZ_OK;
 }
 
-static int32_t mz_zip_seek_to_local_header(void *handle)
+static int32_t mz_zip_index_build(void *handle)
 {
     mz_zip *zip = (mz_zip *)handle;
+    mz_zip_index_slot *entries = NULL;
+    mz_zip_index_slot *new_entries = NULL;
+    int64_t saved_pos = 0;
+    uint64_t entry_count = 0;
+    uint64_t entry_max = 0;
+    uint64_t slot_count = 0;
+    uint64_t i = 0;
+    uint8_t saved_scanned = 0;
+    int32_t err = MZ_OK;
 
 
-    if (zip->file_info.disk_number == zip->disk_number_with_cd)
-        mz_stream_set_prop_int64(zip->stream, MZ_STREAM_PROP_DISK_NUMBER, -1);
-    else
-        mz_stream_set_prop_int64(zip->stream, MZ_STREAM_PROP_DISK_NUMBER, zip->file_info.disk_number);
+    mz_zip_index_delete(handle);
 
-    mz_zip_print("Zip - Entry - Seek local (disk %" PRId32 " offset %" PRId64 ")\n",
-        zip->file_info.disk_number, zip->file_info.disk_offset);
+    if (!zip->index && !zip->entry_table && !zip->prefix_index && !zip->path_check)
+        return MZ_OK;
 
-    /* Guard against seek overflows */
-    if ((zip->disk_offset_shift > 0) &&
-        (zip->file_info.disk_offset > (INT64_MAX - zip->disk_offset_shift)))
-        return MZ_FORMAT_ERROR;
+    saved_pos = zip->cd_current_pos;
+    saved_scanned = zip->entry_scanned;
 
-    return mz_stream_seek(zip->stream, zip->file_info.disk_offset + zip->disk_offset_shift, MZ_SEEK_SET);
-}
+    /* Don't trust number of entries beyond what could fit in the central dir */
+    entry_max = zip->number_entry;
+    if ((zip->cd_size > 0) && (entry_max > (uint64_t)zip->cd_size / MZ_ZIP_SIZE_CD_ITEM))
+        entry_max = (uint64_t)zip->cd_size / MZ_ZIP_SIZE_CD_ITEM;
+    entry_max += 1;
 
-int32_t mz_zip_entry_read_open(void *handle, uint8_t raw, const char *password)
-{
-    mz_zip *zip = (mz_zip *)handle;
-    int32_t err = MZ_OK;
-    int32_t err_shift = MZ_OK;
+    /* Prefix index sorts the entry table and path check reads it so they need one */
+    if (zip->entry_table || zip->prefix_index || zip->path_check)
+    {
+        err = mz_zip_table_grow(&zip->table, entry_max);
+        if (err != MZ_OK)
+            return err;
+    }
 
-#if defined(MZ_ZIP_NO_ENCRYPTION)
-    if (password != NULL)
-        return MZ_SUPPORT_ERROR;
-#endif
-    if (zip == NULL)
-        return MZ_PARAM_ERROR;
-    if ((zip->open_mode & MZ_OPEN_MODE_READ) == 0)
-        return MZ_PARAM_ERROR;
-    if (zip->entry_scanned == 0)
-        return MZ_PARAM_ERROR;
+    if (zip->index)
+    {
+        /* Each entry uses two records, one for each hash variant */
+        if (entry_max > UINT32_MAX / 4)
+            err = MZ_MEM_ERROR;
+        if (err == MZ_OK)
+            entries = (mz_zip_index_slot *)MZ_ALLOC((size_t)entry_max * 2 * sizeof(mz_zip_index_slot));
+        if (entries == NULL)
+        {
+            mz_zip_index_delete(handle);
+            return MZ_MEM_ERROR;
+        }
+    }
 
-    mz_zip_print("Zip - Entry - Read open (raw %" PRId32 ")\n", raw);
+    /* Walk the central dir once recording the hashes and info of each entry */
+    err = mz_zip_goto_first_entry(handle);
+    while (err == MZ_OK)
+    {
+        if (zip->entry_table || zip->prefix_index || zip->path_check)
+        {
+            err = mz_zip_table_append(&zip->table, &zip->file_info, zip->cd_current_pos);
+            if (err != MZ_OK)
+                break;
+        }
 
-    err = mz_zip_seek_to_local_header(handle);
-    if (err == MZ_OK)
-        err = mz_zip_entry_read_header(zip->stream, 1, &zip->local_file_info, zip->local_file_info_stream);
-	if (err == MZ_FORMAT_ERROR && zip->disk_offset_shift>0) {
-		err = mz_stream_seek(zip->stream, zip->file_info.disk_offset, MZ_SEEK_SET);
-		if (err == MZ_OK)
-			err = mz_zip_entry_read_header(zip->stream, 1, &zip->local_file_info, zip->local_file_info_stream);
-	}
-	if (err != MZ_OK) {
-		printf("Failed to fetch item");
-	}
+        if (entries == NULL)
+        {
+            entry_count += 1;
+            err = mz_zip_goto_next_entry(handle);
+            continue;
+        }
 
-    if (err == MZ_FORMAT_ERROR && zip->disk_offset_shift > 0)
-    {
-        /* Perhaps we didn't compensated correctly for incorrect cd offset */
-        err_shift = mz_stream_seek(zip->stream, zip->file_info.disk_offset, MZ_SEEK_SET);
-        if (err_shift == MZ_OK)
-            err_shift = mz_zip_entry_read_header(zip->stream, 1, &zip->local_file_info, zip->local_file_info_stream);
-        if (err_shift == MZ_OK)
+        if (entry_count == entry_max)
         {
-            zip->disk_offset_shift = 0;
-            err = err_shift;
+            /* Number of entries in end of central dir record was too small */
+            entry_max *= 2;
+            if (entry_max > UINT32_MAX / 4)
+            {
+                err = MZ_MEM_ERROR;
+                break;
+            }
+            new_entries = (mz_zip_index_slot *)MZ_ALLOC((size_t)entry_max * 2 * sizeof(mz_zip_index_slot));
+            if (new_entries == NULL)
+            {
+                err = MZ_MEM_ERROR;
+                break;
+            }
+            memcpy(new_entries, entries, (size_t)entry_count * 2 * sizeof(mz_zip_index_slot));
+            MZ_FREE(entries);
+            entries = new_entries;
         }
-    }
 
-#ifdef MZ_ZIP_NO_DECOMPRESSION
-    if (!raw && zip->file_info.compression_method != MZ_COMPRESS_METHOD_STORE)
-        err = MZ_SUPPORT_ERROR;
-#endif
-    if (err == MZ_OK)
-        err = mz_zip_entry_open_int(handle, raw, 0, password);
+        /* Both records share the folded filename */
+        err = mz_zip_index_key_append(handle, zip->file_info.filename, &entries[entry_count * 2].key_pos);
+        if (err != MZ_OK)
+            break;
 
-    return err;
-}
+        entries[entry_count * 2].hash = mz_zip_index_hash(zip->file_info.filename, 0);
+        entries[entry_count * 2].cd_pos = zip->cd_current_pos;
+        entries[entry_count * 2 + 1].hash = mz_zip_index_hash(zip->file_info.filename, 1);
+        entries[entry_count * 2 + 1].key_pos = entries[entry_count * 2].key_pos;
+        entries[entry_count * 2 + 1].cd_pos = zip->cd_current_pos;
+        entry_count += 1;
 
-int32_t mz_zip_entry_write_open(void *handle, const mz_zip_file *file_info, int16_t compress_level, uint8_t raw, const char *password)
-{
-    mz_zip *zip = (mz_zip *)handle;
-    int64_t filename_pos = -1;
-    int64_t extrafield_pos = 0;
-    int64_t comment_pos = 0;
-    int64_t linkname_pos = 0;
-    int64_t disk_number = 0;
-    uint8_t is_dir = 0;
-    int32_t err = MZ_OK;
+        err = mz_zip_goto_next_entry(handle);
+    }
 
-#if defined(MZ_ZIP_NO_ENCRYPTION)
-    if (password != NULL)
-        return MZ_SUPPORT_ERROR;
-#endif
-    if (zip == NULL || file_info == NULL || file_info->filename == NULL)
-        return MZ_PARAM_ERROR;
+    if (err == MZ_END_OF_LIST)
+        err = MZ_OK;
 
-    if (mz_zip_entry_is_open(handle) == MZ_OK)
+    if ((err == MZ_OK) && (zip->index))
     {
-        err = mz_zip_entry_close(handle);
-        if (err != MZ_OK)
-            return err;
+        slot_count = mz_zip_index_slot_count(entry_count);
+
+        zip->index_case = (mz_zip_index_slot *)MZ_ALLOC((size_t)slot_count * sizeof(mz_zip_index_slot));
+        zip->index_nocase = (mz_zip_index_slot *)MZ_ALLOC((size_t)slot_count * sizeof(mz_zip_index_slot));
+        if (zip->index_case == NULL || zip->index_nocase == NULL)
+            err = MZ_MEM_ERROR;
     }
 
-    memcpy(&zip->file_info, file_info, sizeof(mz_zip_file));
+    if ((err == MZ_OK) && (zip->index))
+    {
+        zip->index_mask = (uint32_t)(slot_count - 1);
 
-    mz_zip_print("Zip - Entry - Write open - %s (level %" PRId16 " raw %" PRId8 ")\n",
-        zip->file_info.filename, compress_level, raw);
+        for (i = 0; i < slot_count; i += 1)
+        {
+            zip->index_case[i].cd_pos = -1;
+            zip->index_nocase[i].cd_pos = -1;
+        }
 
-    mz_stream_seek(zip->file_info_stream, 0, MZ_SEEK_SET);
-    mz_stream_write(zip->file_info_stream, file_info, sizeof(mz_zip_file));
+        for (i = 0; i < entry_count; i += 1)
+        {
+            mz_zip_index_insert(zip->index_case, zip->index_mask, &entries[i * 2]);
+            mz_zip_index_insert(zip->index_nocase, zip->index_mask, &entries[i * 2 + 1]);
+        }
+    }
 
-    /* Copy filename, extrafield, and comment internally */
-    filename_pos = mz_stream_tell(zip->file_info_stream);
-    if (file_info->filename != NULL)
-        mz_stream_write(zip->file_info_stream, file_info->filename, (int32_t)strlen(file_info->filename));
-    mz_stream_write_uint8(zip->file_info_stream, 0);
+    if (entries != NULL)
+        MZ_FREE(entries);
 
-    extrafield_pos = mz_stream_tell(zip->file_info_stream);
-    if (file_info->extrafield != NULL)
-        mz_stream_write(zip->file_info_stream, file_info->extrafield, file_info->extrafield_size);
-    mz_stream_write_uint8(zip->file_info_stream, 0);
+    if (err == MZ_OK)
+        err = mz_zip_index_sort(handle);
+    if (err == MZ_OK)
+        err = mz_zip_path_check_build(handle);
+    if (err != MZ_OK)
+        mz_zip_index_delete(handle);
 
-    comment_pos = mz_stream_tell(zip->file_info_stream);
-    if (file_info->comment != NULL)
-        mz_stream_write(zip->file_info_stream, file_info->comment, file_info->comment_size);
-    mz_stream_write_uint8(zip->file_info_stream, 0);
+    mz_zip_print("Zip - Index - Build (entries %" PRIu64 " slots %" PRIu64 " err %" PRId32 ")\n",
+        entry_count, slot_count, err);
 
-    linkname_pos = mz_stream_tell(zip->file_info_stream);
-    if (file_info->linkname != NULL)
-        mz_stream_write(zip->file_info_stream, file_info->linkname, (int32_t)strlen(file_info->linkname));
-    mz_stream_write_uint8(zip->file_info_stream, 0);
+    /* Restore position in central dir */
+    zip->cd_current_pos = saved_pos;
+    zip->entry_scanned = 0;
+    if (saved_scanned)
+        mz_zip_goto_entry(handle, saved_pos);
 
-    mz_stream_mem_get_buffer_at(zip->file_info_stream, filename_pos, (const void **)&zip->file_info.filename);
-    mz_stream_mem_get_buffer_at(zip->file_info_stream, extrafield_pos, (const void **)&zip->file_info.extrafield);
-    mz_stream_mem_get_buffer_at(zip->file_info_stream, comment_pos, (const void **)&zip->file_info.comment);
-    mz_stream_mem_get_buffer_at(zip->file_info_stream, linkname_pos, (const void **)&zip->file_info.linkname);
+    return err;
+}
 
-    if (zip->file_info.compression_method == MZ_COMPRESS_METHOD_DEFLATE)
+static int32_t mz_zip_index_update(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    uint8_t index_built = (zip->index_case != NULL);
+    uint8_t table_built = (zip->table.cd_pos != NULL);
+    uint8_t sorted_built = (zip->index_sorted != NULL);
+    uint8_t path_built = (zip->path_flags != NULL);
+    int32_t err = MZ_OK;
+
+    /* Indexes are only built for central dirs that won't change */
+    if ((zip->open_mode == 0) || (zip->open_mode & MZ_OPEN_MODE_WRITE))
+        return MZ_OK;
+    if ((zip->index != index_built) ||
+        ((zip->entry_table || zip->prefix_index || zip->path_check) != table_built))
+        return mz_zip_index_build(handle);
+    /* Entry table is already there so only sorting and path checking are needed */
+    if (zip->prefix_index != sorted_built)
+        err = mz_zip_index_sort(handle);
+    if ((err == MZ_OK) && (zip->path_check != path_built))
+        err = mz_zip_path_check_build(handle);
+
+    return err;
+}
+
+static int32_t mz_zip_index_locate(void *handle, const char *filename, uint8_t ignore_case)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    mz_zip_index_slot *slots = NULL;
+    const uint8_t *entry_key = NULL;
+    uint8_t key_buf[256];
+    uint8_t *key = key_buf;
+    size_t key_size = 0;
+    uint32_t hash = 0;
+    uint32_t i = 0;
+    int32_t err = MZ_END_OF_LIST;
+
+
+    key_size = strlen(filename);
+    if (key_size > UINT16_MAX)
+        return MZ_END_OF_LIST;
+    if (key_size >= sizeof(key_buf))
     {
-        if ((compress_level == 8) || (compress_level == 9))
-            zip->file_info.flag |= MZ_ZIP_FLAG_DEFLATE_MAX;
-        if (compress_level == 2)
-            zip->file_info.flag |= MZ_ZIP_FLAG_DEFLATE_FAST;
-        if (compress_level == 1)
-            zip->file_info.flag |= MZ_ZIP_FLAG_DEFLATE_SUPER_FAST;
+        key = (uint8_t *)MZ_ALLOC(key_size + 1);
+        if (key == NULL)
+            return MZ_MEM_ERROR;
     }
-#ifdef HAVE_LZMA
-    else if (zip->file_info.compression_method == MZ_COMPRESS_METHOD_LZMA)
-        zip->file_info.flag |= MZ_ZIP_FLAG_LZMA_EOS_MARKER;
-#endif
 
-    if (mz_zip_attrib_is_dir(zip->file_info.external_fa, zip->file_info.version_madeby) == MZ_OK)
-        is_dir = 1;
+    /* Fold the filename once so each candidate only needs one memcmp */
+    mz_zip_index_fold(filename, key);
 
-    if (!is_dir)
+    slots = (ignore_case) ? zip->index_nocase : zip->index_case;
+    if (ignore_case)
+        hash = mz_zip_index_hash((const char *)key, 0);
+    else
+        hash = mz_zip_index_hash(filename, 0);
+
+    for (i = hash & zip->index_mask; slots[i].cd_pos >= 0; i = (i + 1) & zip->index_mask)
     {
-        zip->file_info.flag |= MZ_ZIP_FLAG_DATA_DESCRIPTOR;
-        if (password != NULL)
-            zip->file_info.flag |= MZ_ZIP_FLAG_ENCRYPTED;
+        if (slots[i].hash != hash)
+            continue;
+
+        /* Equal filenames have equal folded keys even when case is not ignored */
+        entry_key = zip->index_keys + slots[i].key_pos;
+        if ((size_t)(entry_key[0] | (entry_key[1] << 8)) != key_size)
+            continue;
+        if (memcmp(entry_key + 2, key, key_size) != 0)
+            continue;
+
+        err = mz_zip_goto_entry(handle, slots[i].cd_pos);
+        if (err != MZ_OK)
+            break;
+        if (ignore_case || mz_zip_path_compare(zip->file_info.filename, filename, 0) == 0)
+            break;
+        err = MZ_END_OF_LIST;
     }
 
-    mz_stream_get_prop_int64(zip->stream, MZ_STREAM_PROP_DISK_NUMBER, &disk_number);
-    zip->file_info.disk_number = (uint32_t)disk_number;
+    if (key != key_buf)
+        MZ_FREE(key);
+    return err;
+}
 
-    zip->file_info.disk_offset = mz_stream_tell(zip->stream);
-    zip->file_info.crc = 0;
-    zip->file_info.compressed_size = 0;
+/* Crc32 of the last bytes of the archive, used to identify the archive an index was saved for */
+static int32_t mz_zip_index_tail_crc(void *handle, int64_t archive_size, int32_t tail_size, uint32_t *crc)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    uint8_t *tail = NULL;
+    int32_t err = MZ_OK;
 
-#ifdef HAVE_WZAES
-    if (zip->file_info.aes_version && zip->file_info.aes_encryption_mode == 0)
-        zip->file_info.aes_encryption_mode = MZ_AES_ENCRYPTION_MODE_256;
-#endif
+    if ((tail_size <= 0) || (tail_size > archive_size))
+        return MZ_FORMAT_ERROR;
 
-    if ((compress_level == 0) || (is_dir))
-        zip->file_info.compression_method = MZ_COMPRESS_METHOD_STORE;
+    tail = (uint8_t *)MZ_ALLOC(tail_size);
+    if (tail == NULL)
+        return MZ_MEM_ERROR;
 
-#ifdef MZ_ZIP_NO_COMPRESSION
-    if (zip->file_info.compression_method != MZ_COMPRESS_METHOD_STORE)
-        err = MZ_SUPPORT_ERROR;
-#endif
-    if (err == MZ_OK)
-        err = mz_zip_entry_write_header(zip->stream, 1, &zip->file_info);
+    err = mz_stream_seek(zip->stream, archive_size - tail_size, MZ_SEEK_SET);
+    if ((err == MZ_OK) && (mz_stream_read(zip->stream, tail, tail_size) != tail_size))
+        err = MZ_READ_ERROR;
     if (err == MZ_OK)
-        err = mz_zip_entry_open_int(handle, raw, compress_level, password);
+        *crc = mz_crypt_crc32_update(0, tail, tail_size);
 
+    MZ_FREE(tail);
     return err;
 }
 
-int32_t mz_zip_entry_read(void *handle, void *buf, int32_t len)
+/* Check that the loaded index was saved for the archive being opened, the archive modified time,
+   size and the end of the archive are compared so the central dir doesn't need to be read */
+static int32_t mz_zip_index_verify(void *handle)
 {
     mz_zip *zip = (mz_zip *)handle;
-    int32_t read = 0;
+    int64_t archive_size = 0;
+    uint32_t tail_crc = 0;
+    int32_t err = MZ_OK;
 
-    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
-        return MZ_PARAM_ERROR;
+
+    err = mz_stream_seek(zip->stream, 0, MZ_SEEK_END);
+    if (err == MZ_OK)
+    {
+        archive_size = mz_stream_tell(zip->stream);
+        if (archive_size != zip->index_archive_size)
+            err = MZ_EXIST_ERROR;
+    }
+    if (err == MZ_OK)
+        err = mz_zip_index_tail_crc(handle, archive_size, zip->index_tail_size, &tail_crc);
+    if ((err == MZ_OK) && (tail_crc != zip->index_tail_crc))
+        err = MZ_CRC_ERROR;
+    if (err == MZ_OK)
+        zip->cd_signature = MZ_ZIP_MAGIC_CENTRALHEADER;
+
+    mz_zip_print("Zip - Index - Verify (size %" PRId64 " crc 0x%08" PRIx32 " err %" PRId32 ")\n",
+        archive_size, tail_crc, err);
+
+    return err;
+}
+
+/* Move the cd positions of a loaded index to where the central dir is read from */
+static void mz_zip_index_rebase(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int64_t delta = zip->cd_start_pos - zip->index_cd_start_pos;
+    uint64_t i = 0;
+
+    if (delta == 0)
+        return;
+
+    for (i = 0; i < zip->table.count; i += 1)
+        zip->table.cd_pos[i] += delta;
+    for (i = 0; i <= zip->index_mask; i += 1)
+    {
+        if (zip->index_case[i].cd_pos >= 0)
+            zip->index_case[i].cd_pos += delta;
+        if (zip->index_nocase[i].cd_pos >= 0)
+            zip->index_nocase[i].cd_pos += delta;
+    }
+
+    zip->index_cd_start_pos = zip->cd_start_pos;
+}
+
+/* Forget a loaded index and the central dir info that came with it */
+static void mz_zip_index_discard(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
+
+    mz_zip_index_delete(handle);
+
+    if (zip->comment != NULL)
+        MZ_FREE(zip->comment);
+    zip->comment = NULL;
+    zip->cd_stream = zip->stream;
+    zip->disk_offset_shift = 0;
+}
+
+void *mz_zip_create(void **handle)
+{
+    mz_zip *zip = NULL;
+
+    zip = (mz_zip *)MZ_ALLOC(sizeof(mz_zip));
+    if (zip != NULL)
+        memset(zip, 0, sizeof(mz_zip));
+    if (handle != NULL)
+        *handle = zip;
+
+    return zip;
+}
+
+void mz_zip_delete(void **handle)
+{
+    mz_zip *zip = NULL;
+    if (handle == NULL)
+        return;
+    zip = (mz_zip *)*handle;
+    if (zip != NULL)
+    {
+        MZ_FREE(zip);
+    }
+    *handle = NULL;
+}
+
+static void *mz_zip_codec_pool_take(void *handle, uint16_t compression_method)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    void *compress_stream = NULL;
+    int32_t i = 0;
+
+    for (i = 0; i < MZ_ZIP_CODEC_POOL_SIZE; i += 1)
+    {
+        if (zip->codec_pool[i] != NULL && zip->codec_pool_method[i] == compression_method)
+        {
+            compress_stream = zip->codec_pool[i];
+            zip->codec_pool[i] = NULL;
+            break;
+        }
+    }
+    return compress_stream;
+}
+
+static void mz_zip_codec_pool_put(void *handle, uint16_t compression_method, void **compress_stream)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t i = 0;
+
+    for (i = 0; i < MZ_ZIP_CODEC_POOL_SIZE; i += 1)
+    {
+        if (zip->codec_pool[i] == NULL)
+        {
+            zip->codec_pool[i] = *compress_stream;
+            zip->codec_pool_method[i] = compression_method;
+            *compress_stream = NULL;
+            return;
+        }
+    }
+    mz_stream_delete(compress_stream);
+}
+
+static void mz_zip_codec_pool_delete(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t i = 0;
+
+    for (i = 0; i < MZ_ZIP_CODEC_POOL_SIZE; i += 1)
+    {
+        if (zip->codec_pool[i] != NULL)
+            mz_stream_delete(&zip->codec_pool[i]);
+    }
+}
+
+int32_t mz_zip_open(void *handle, void *stream, int32_t mode)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t err = MZ_OK;
+
+
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+
+    mz_zip_print("Zip - Open\n");
+
+    zip->stream = stream;
+
+    mz_stream_mem_create(&zip->cd_mem_stream);
+
+    if (mode & MZ_OPEN_MODE_WRITE)
+    {
+        mz_stream_mem_open(zip->cd_mem_stream, NULL, MZ_OPEN_MODE_CREATE);
+        zip->cd_stream = zip->cd_mem_stream;
+    }
+    else
+    {
+        zip->cd_stream = stream;
+    }
+
+    if ((mode & MZ_OPEN_MODE_READ) || (mode & MZ_OPEN_MODE_APPEND))
+    {
+        if ((mode & MZ_OPEN_MODE_CREATE) == 0)
+        {
+            /* Skip searching for and walking the central dir if a loaded index still matches */
+            if (zip->index_loaded && ((mode & MZ_OPEN_MODE_APPEND) || (mz_zip_index_verify(zip) != MZ_OK)))
+                mz_zip_index_discard(zip);
+
+            if (!zip->index_loaded)
+            {
+                err = mz_zip_read_cd(zip);
+                if (err != MZ_OK)
+                {
+                    mz_zip_print("Zip - Error detected reading cd (%" PRId32 ")\n", err);
+                    if (zip->recover && mz_zip_recover_cd(zip) == MZ_OK)
+                        err = MZ_OK;
+                }
+            }
+        }
+
+        if ((err == MZ_OK) && (mode & MZ_OPEN_MODE_APPEND))
+        {
+            if (zip->cd_size > 0)
+            {
+                /* Store central directory in memory, if not already, and overwrite it */
+                if (zip->cd_stream != zip->cd_mem_stream)
+                    err = mz_zip_read_cd_mem(zip, NULL, 0, 0);
+                if (err == MZ_OK)
+                    err = mz_stream_seek(zip->stream, zip->cd_offset, MZ_SEEK_SET);
+            }
+            else
+            {
+                if (zip->cd_signature == MZ_ZIP_MAGIC_ENDHEADER)
+                {
+                    /* If tiny zip then overwrite end header */
+                    err = mz_stream_seek(zip->stream, zip->cd_offset, MZ_SEEK_SET);
+                }
+                else
+                {
+                    /* If no central directory, append new zip to end of file */
+                    err = mz_stream_seek(zip->stream, 0, MZ_SEEK_END);
+                }
+            }
+
+            if (zip->disk_number_with_cd > 0)
+            {
+                /* Move to last disk to begin appending */
+                mz_stream_set_prop_int64(zip->stream, MZ_STREAM_PROP_DISK_NUMBER, zip->disk_number_with_cd - 1);
+            }
+        }
+        else if (zip->cd_stream == zip->cd_mem_stream)
+        {
+            /* Central directory positions are relative to memory stream */
+            zip->cd_start_pos = 0;
+        }
+        else
+        {
+            zip->cd_start_pos = zip->cd_offset;
+
+            if ((zip->cd_mem_max > 0) && (zip->cd_size > zip->cd_mem_max))
+            {
+                /* Page in central directory on demand to keep memory use within the limit */
+                mz_stream_paged_create(&zip->cd_paged_stream);
+                mz_stream_set_base(zip->cd_paged_stream, zip->stream);
+                mz_stream_paged_set_memory_max(zip->cd_paged_stream, zip->cd_mem_max);
+                err = mz_stream_paged_open(zip->cd_paged_stream, NULL, MZ_OPEN_MODE_READ);
+                if (err == MZ_OK)
+                    zip->cd_stream = zip->cd_paged_stream;
+            }
+        }
+    }
+
+    if (err != MZ_OK)
+    {
+        mz_zip_close(zip);
+        return err;
+    }
+
+    /* Memory streams used to store variable length file info data */
+    mz_stream_mem_create(&zip->file_info_stream);
+    mz_stream_mem_open(zip->file_info_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+    mz_stream_mem_create(&zip->local_file_info_stream);
+    mz_stream_mem_open(zip->local_file_info_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+    mz_stream_mem_create(&zip->header_stream);
+    mz_stream_mem_open(zip->header_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+    zip->open_mode = mode;
+
+    if (zip->index_loaded)
+        mz_zip_index_rebase(zip);
+
+    /* Indexes are optional, if they fail to build lookups fall back to scanning */
+    mz_zip_index_update(zip);
+
+    return err;
+}
+
+int32_t mz_zip_close(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t err = MZ_OK;
+
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+
+    mz_zip_print("Zip - Close\n");
+
+    if (mz_zip_entry_is_open(handle) == MZ_OK)
+        err = mz_zip_entry_close(handle);
+
+    if ((err == MZ_OK) && (zip->open_mode & MZ_OPEN_MODE_WRITE))
+        err = mz_zip_write_cd(handle);
+
+    if (zip->cd_mem_stream != NULL)
+    {
+        mz_stream_close(zip->cd_mem_stream);
+        mz_stream_delete(&zip->cd_mem_stream);
+    }
+
+    /* Paged stream doesn't own the main stream so it isn't closed */
+    if (zip->cd_paged_stream != NULL)
+        mz_stream_paged_delete(&zip->cd_paged_stream);
+
+    if (zip->file_info_stream != NULL)
+    {
+        mz_stream_mem_close(zip->file_info_stream);
+        mz_stream_mem_delete(&zip->file_info_stream);
+    }
+    if (zip->local_file_info_stream != NULL)
+    {
+        mz_stream_mem_close(zip->local_file_info_stream);
+        mz_stream_mem_delete(&zip->local_file_info_stream);
+    }
+    if (zip->header_stream != NULL)
+    {
+        mz_stream_mem_close(zip->header_stream);
+        mz_stream_mem_delete(&zip->header_stream);
+    }
+
+    if (zip->comment)
+    {
+        MZ_FREE(zip->comment);
+        zip->comment = NULL;
+    }
+
+    mz_zip_index_delete(handle);
+    mz_zip_codec_pool_delete(handle);
+
+    zip->stream = NULL;
+    zip->cd_stream = NULL;
+
+    return err;
+}
+
+int32_t mz_zip_get_comment(void *handle, const char **comment)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL || comment == NULL)
+        return MZ_PARAM_ERROR;
+    if (zip->comment == NULL)
+        return MZ_EXIST_ERROR;
+    *comment = zip->comment;
+    return MZ_OK;
+}
+
+int32_t mz_zip_set_comment(void *handle, const char *comment)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t comment_size = 0;
+    if (zip == NULL || comment == NULL)
+        return MZ_PARAM_ERROR;
+    if (zip->comment != NULL)
+        MZ_FREE(zip->comment);
+    comment_size = (int32_t)strlen(comment);
+    if (comment_size > UINT16_MAX)
+        return MZ_PARAM_ERROR;
+    zip->comment = (char *)MZ_ALLOC(comment_size+1);
+    if (zip->comment == NULL)
+        return MZ_MEM_ERROR;
+    memset(zip->comment, 0, comment_size+1);
+    strncpy(zip->comment, comment, comment_size);
+    return MZ_OK;
+}
+
+int32_t mz_zip_get_version_madeby(void *handle, uint16_t *version_madeby)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL || version_madeby == NULL)
+        return MZ_PARAM_ERROR;
+    *version_madeby = zip->version_madeby;
+    return MZ_OK;
+}
+
+int32_t mz_zip_set_version_madeby(void *handle, uint16_t version_madeby)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+    zip->version_madeby = version_madeby;
+    return MZ_OK;
+}
+
+int32_t mz_zip_set_recover(void *handle, uint8_t recover)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+    zip->recover = recover;
+    return MZ_OK;
+}
+
+int32_t mz_zip_set_cd_mem_max(void *handle, int64_t cd_mem_max)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL || cd_mem_max < 0)
+        return MZ_PARAM_ERROR;
+    zip->cd_mem_max = cd_mem_max;
+    return MZ_OK;
+}
+
+int32_t mz_zip_set_index(void *handle, uint8_t index)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+    zip->index = (index != 0);
+    return mz_zip_index_update(handle);
+}
+
+int32_t mz_zip_set_entry_table(void *handle, uint8_t entry_table)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+    zip->entry_table = (entry_table != 0);
+    return mz_zip_index_update(handle);
+}
+
+int32_t mz_zip_set_prefix_index(void *handle, uint8_t prefix_index)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+    zip->prefix_index = (prefix_index != 0);
+    return mz_zip_index_update(handle);
+}
+
+int32_t mz_zip_set_path_check(void *handle, uint8_t path_check)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+    zip->path_check = (path_check != 0);
+    return mz_zip_index_update(handle);
+}
+
+int32_t mz_zip_set_compress_threads(void *handle, int32_t compress_threads)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL || compress_threads < 0)
+        return MZ_PARAM_ERROR;
+    zip->compress_threads = compress_threads;
+    return MZ_OK;
+}
+
+int32_t mz_zip_get_stream(void *handle, void **stream)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL || stream == NULL)
+        return MZ_PARAM_ERROR;
+    *stream = zip->stream;
+    if (*stream == NULL)
+        return MZ_EXIST_ERROR;
+    return MZ_OK;
+}
+
+int32_t mz_zip_set_cd_stream(void *handle, int64_t cd_start_pos, void *cd_stream)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL || cd_stream == NULL)
+        return MZ_PARAM_ERROR;
+    zip->cd_offset = 0;
+    zip->cd_stream = cd_stream;
+    zip->cd_start_pos = cd_start_pos;
+    /* Rebuild indexes if they were built against the previous central dir */
+    if ((zip->index_case != NULL) || (zip->table.cd_pos != NULL))
+        mz_zip_index_build(handle);
+    return MZ_OK;
+}
+
+int32_t mz_zip_get_cd_mem_stream(void *handle, void **cd_mem_stream)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL || cd_mem_stream == NULL)
+        return MZ_PARAM_ERROR;
+    *cd_mem_stream = zip->cd_mem_stream;
+    if (*cd_mem_stream == NULL)
+        return MZ_EXIST_ERROR;
+    return MZ_OK;
+}
+
+static int32_t mz_zip_entry_close_int(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
+
+    if (zip->crypt_stream != NULL)
+        mz_stream_delete(&zip->crypt_stream);
+    zip->crypt_stream = NULL;
+    if (zip->compress_stream != NULL)
+    {
+        /* Closed codec streams keep their context so the next entry only has to reset it */
+        if (!zip->entry_raw && zip->file_info.compression_method != MZ_COMPRESS_METHOD_STORE &&
+            mz_stream_is_open(zip->compress_stream) != MZ_OK)
+            mz_zip_codec_pool_put(handle, zip->file_info.compression_method, &zip->compress_stream);
+        else
+            mz_stream_delete(&zip->compress_stream);
+    }
+    zip->compress_stream = NULL;
+
+    zip->entry_opened = 0;
+
+    return MZ_OK;
+}
+
+static int32_t mz_zip_entry_is_supported(const mz_zip_file *file_info)
+{
+    switch (file_info->compression_method)
+    {
+    case MZ_COMPRESS_METHOD_STORE:
+    case MZ_COMPRESS_METHOD_DEFLATE:
+#ifdef HAVE_BZIP2
+    case MZ_COMPRESS_METHOD_BZIP2:
+#endif
+#ifdef HAVE_LZMA
+    case MZ_COMPRESS_METHOD_LZMA:
+#endif
+#ifdef HAVE_ZSTD
+    case MZ_COMPRESS_METHOD_ZSTD:
+#endif
+        break;
+    default:
+        return MZ_SUPPORT_ERROR;
+    }
+
+#ifndef HAVE_WZAES
+    if (file_info->aes_version)
+        return MZ_SUPPORT_ERROR;
+#endif
+    return MZ_OK;
+}
+
+static uint8_t mz_zip_entry_use_crypt(const mz_zip_file *file_info, int32_t open_mode, uint8_t raw,
+    const char *password)
+{
+    uint8_t use_crypt = 0;
+
+    if ((file_info->flag & MZ_ZIP_FLAG_ENCRYPTED) && (password != NULL))
+    {
+        if (open_mode & MZ_OPEN_MODE_WRITE)
+        {
+            /* Encrypt only when we are not trying to write raw and password is supplied. */
+            if (!raw)
+                use_crypt = 1;
+        }
+        else if (open_mode & MZ_OPEN_MODE_READ)
+        {
+            /* Decrypt only when password is supplied. Don't error when password */
+            /* is not supplied as we may want to read the raw encrypted data. */
+            use_crypt = 1;
+        }
+    }
+    return use_crypt;
+}
+
+static int32_t mz_zip_entry_open_streams(const mz_zip_file *file_info, void *stream, int32_t open_mode,
+    uint8_t raw, int16_t compress_level, int32_t compress_threads, const char *password,
+    void **crypt_stream, void **compress_stream)
+{
+    int64_t max_total_in = 0;
+    int64_t header_size = 0;
+    int64_t footer_size = 0;
+    int32_t err = MZ_OK;
+    uint8_t use_crypt = 0;
+
+    use_crypt = mz_zip_entry_use_crypt(file_info, open_mode, raw, password);
+
+    if ((err == MZ_OK) && (use_crypt))
+    {
+#ifdef HAVE_WZAES
+        if (file_info->aes_version)
+        {
+            mz_stream_wzaes_create(crypt_stream);
+            mz_stream_wzaes_set_password(*crypt_stream, password);
+            mz_stream_wzaes_set_encryption_mode(*crypt_stream, file_info->aes_encryption_mode);
+        }
+        else
+#endif
+        {
+#ifdef HAVE_PKCRYPT
+            uint8_t verify1 = 0;
+            uint8_t verify2 = 0;
+
+            /* Info-ZIP modification to ZipCrypto format: */
+            /* If bit 3 of the general purpose bit flag is set, it uses high byte of 16-bit File Time. */
+
+            if (file_info->flag & MZ_ZIP_FLAG_DATA_DESCRIPTOR)
+            {
+                uint32_t dos_date = 0;
+
+                dos_date = mz_zip_time_t_to_dos_date(file_info->modified_date);
+
+                verify1 = (uint8_t)((dos_date >> 16) & 0xff);
+                verify2 = (uint8_t)((dos_date >> 8) & 0xff);
+            }
+            else
+            {
+                verify1 = (uint8_t)((file_info->crc >> 16) & 0xff);
+                verify2 = (uint8_t)((file_info->crc >> 24) & 0xff);
+            }
+
+            mz_stream_pkcrypt_create(crypt_stream);
+            mz_stream_pkcrypt_set_password(*crypt_stream, password);
+            mz_stream_pkcrypt_set_verify(*crypt_stream, verify1, verify2);
+#endif
+        }
+    }
+
+    if (err == MZ_OK)
+    {
+        if (*crypt_stream == NULL)
+            mz_stream_raw_create(crypt_stream);
+
+        mz_stream_set_base(*crypt_stream, stream);
+
+        err = mz_stream_open(*crypt_stream, NULL, open_mode);
+    }
+
+    if ((err == MZ_OK) && (*compress_stream == NULL))
+    {
+        if (raw || file_info->compression_method == MZ_COMPRESS_METHOD_STORE)
+            mz_stream_raw_create(compress_stream);
+#if defined(HAVE_ZLIB) || defined(HAVE_LIBCOMP)
+        else if (file_info->compression_method == MZ_COMPRESS_METHOD_DEFLATE)
+            mz_stream_zlib_create(compress_stream);
+#endif
+#ifdef HAVE_BZIP2
+        else if (file_info->compression_method == MZ_COMPRESS_METHOD_BZIP2)
+            mz_stream_bzip_create(compress_stream);
+#endif
+#ifdef HAVE_LZMA
+        else if (file_info->compression_method == MZ_COMPRESS_METHOD_LZMA)
+            mz_stream_lzma_create(compress_stream);
+#endif
+#ifdef HAVE_ZSTD
+        else if (file_info->compression_method == MZ_COMPRESS_METHOD_ZSTD)
+            mz_stream_zstd_create(compress_stream);
+#endif
+        else
+            err = MZ_PARAM_ERROR;
+    }
+
+    if (err == MZ_OK)
+    {
+        if (open_mode & MZ_OPEN_MODE_WRITE)
+        {
+            mz_stream_set_prop_int64(*compress_stream, MZ_STREAM_PROP_COMPRESS_LEVEL, compress_level);
+            mz_stream_set_prop_int64(*compress_stream, MZ_STREAM_PROP_COMPRESS_THREADS, compress_threads);
+        }
+        else
+        {
+            /* Limits of a previous entry are cleared when the stream is reused */
+            mz_stream_set_prop_int64(*compress_stream, MZ_STREAM_PROP_TOTAL_IN_MAX, 0);
+            mz_stream_set_prop_int64(*compress_stream, MZ_STREAM_PROP_TOTAL_OUT_MAX, -1);
+#ifndef HAVE_LIBCOMP
+            if (raw || file_info->compression_method == MZ_COMPRESS_METHOD_STORE || file_info->flag & MZ_ZIP_FLAG_ENCRYPTED)
+#endif
+            {
+                max_total_in = file_info->compressed_size;
+                mz_stream_set_prop_int64(*crypt_stream, MZ_STREAM_PROP_TOTAL_IN_MAX, max_total_in);
+
+                if (mz_stream_get_prop_int64(*crypt_stream, MZ_STREAM_PROP_HEADER_SIZE, &header_size) == MZ_OK)
+                    max_total_in -= header_size;
+                if (mz_stream_get_prop_int64(*crypt_stream, MZ_STREAM_PROP_FOOTER_SIZE, &footer_size) == MZ_OK)
+                    max_total_in -= footer_size;
+
+                mz_stream_set_prop_int64(*compress_stream, MZ_STREAM_PROP_TOTAL_IN_MAX, max_total_in);
+            }
+            if ((file_info->compression_method == MZ_COMPRESS_METHOD_LZMA) && (file_info->flag & MZ_ZIP_FLAG_LZMA_EOS_MARKER) == 0)
+            {
+                mz_stream_set_prop_int64(*compress_stream, MZ_STREAM_PROP_TOTAL_IN_MAX, file_info->compressed_size);
+                mz_stream_set_prop_int64(*compress_stream, MZ_STREAM_PROP_TOTAL_OUT_MAX, file_info->uncompressed_size);
+            }
+        }
+
+        mz_stream_set_base(*compress_stream, *crypt_stream);
+
+        err = mz_stream_open(*compress_stream, NULL, open_mode);
+    }
+
+    return err;
+}
+
+static int32_t mz_zip_entry_open_int(void *handle, uint8_t raw, int16_t compress_level, const char *password)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int64_t crc = 0;
+    int32_t err = MZ_OK;
+
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+
+    err = mz_zip_entry_is_supported(&zip->file_info);
+    if (err != MZ_OK)
+        return err;
+
+    zip->entry_raw = raw;
+
+    if (!raw && zip->file_info.compression_method != MZ_COMPRESS_METHOD_STORE)
+        zip->compress_stream = mz_zip_codec_pool_take(handle, zip->file_info.compression_method);
+
+    err = mz_zip_entry_open_streams(&zip->file_info, zip->stream, zip->open_mode, raw, compress_level,
+        zip->compress_threads, password, &zip->crypt_stream, &zip->compress_stream);
+
+    if (err == MZ_OK)
+    {
+        zip->entry_opened = 1;
+        zip->entry_crc32 = 0;
+        zip->entry_crc_stream = 0;
+        zip->entry_read_buffer = 0;
+
+        /* Parallel compression computes the crc of each block along with it */
+        if ((zip->open_mode & MZ_OPEN_MODE_WRITE) && (!raw) &&
+            (mz_stream_get_prop_int64(zip->compress_stream, MZ_STREAM_PROP_CRC, &crc) == MZ_OK))
+            zip->entry_crc_stream = 1;
+    }
+    else
+    {
+        mz_zip_entry_close_int(handle);
+    }
+
+    return err;
+}
+
+int32_t mz_zip_entry_is_open(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+    if (zip->entry_opened == 0)
+        return MZ_EXIST_ERROR;
+    return MZ_OK;
+}
+
+static int32_t mz_zip_seek_to_local_header(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
+
+
+    if (zip->file_info.disk_number == zip->disk_number_with_cd)
+        mz_stream_set_prop_int64(zip->stream, MZ_STREAM_PROP_DISK_NUMBER, -1);
+    else
+        mz_stream_set_prop_int64(zip->stream, MZ_STREAM_PROP_DISK_NUMBER, zip->file_info.disk_number);
+
+    mz_zip_print("Zip - Entry - Seek local (disk %" PRId32 " offset %" PRId64 ")\n",
+        zip->file_info.disk_number, zip->file_info.disk_offset);
+
+    /* Guard against seek overflows */
+    if ((zip->disk_offset_shift > 0) &&
+        (zip->file_info.disk_offset > (INT64_MAX - zip->disk_offset_shift)))
+        return MZ_FORMAT_ERROR;
+
+    return mz_stream_seek(zip->stream, zip->file_info.disk_offset + zip->disk_offset_shift, MZ_SEEK_SET);
+}
+
+int32_t mz_zip_entry_read_open(void *handle, uint8_t raw, const char *password)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t err = MZ_OK;
+    int32_t err_shift = MZ_OK;
+
+#if defined(MZ_ZIP_NO_ENCRYPTION)
+    if (password != NULL)
+        return MZ_SUPPORT_ERROR;
+#endif
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+    if ((zip->open_mode & MZ_OPEN_MODE_READ) == 0)
+        return MZ_PARAM_ERROR;
+    if (zip->entry_scanned == 0)
+        return MZ_PARAM_ERROR;
+
+    mz_zip_print("Zip - Entry - Read open (raw %" PRId32 ")\n", raw);
+
+    err = mz_zip_seek_to_local_header(handle);
+    if (err == MZ_OK)
+        err = mz_zip_entry_read_header(zip->stream, 1, &zip->local_file_info, zip->local_file_info_stream);
+	if (err == MZ_FORMAT_ERROR && zip->disk_offset_shift>0) {
+		err = mz_stream_seek(zip->stream, zip->file_info.disk_offset, MZ_SEEK_SET);
+		if (err == MZ_OK)
+			err = mz_zip_entry_read_header(zip->stream, 1, &zip->local_file_info, zip->local_file_info_stream);
+	}
+	if (err != MZ_OK) {
+		printf("Failed to fetch item");
+	}
+
+    if (err == MZ_FORMAT_ERROR && zip->disk_offset_shift > 0)
+    {
+        /* Perhaps we didn't compensated correctly for incorrect cd offset */
+        err_shift = mz_stream_seek(zip->stream, zip->file_info.disk_offset, MZ_SEEK_SET);
+        if (err_shift == MZ_OK)
+            err_shift = mz_zip_entry_read_header(zip->stream, 1, &zip->local_file_info, zip->local_file_info_stream);
+        if (err_shift == MZ_OK)
+        {
+            zip->disk_offset_shift = 0;
+            err = err_shift;
+        }
+    }
+
+#ifdef MZ_ZIP_NO_DECOMPRESSION
+    if (!raw && zip->file_info.compression_method != MZ_COMPRESS_METHOD_STORE)
+        err = MZ_SUPPORT_ERROR;
+#endif
+    if (err == MZ_OK)
+        err = mz_zip_entry_open_int(handle, raw, 0, password);
+
+    return err;
+}
+
+int32_t mz_zip_entry_write_open(void *handle, const mz_zip_file *file_info, int16_t compress_level, uint8_t raw, const char *password)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int64_t filename_pos = -1;
+    int64_t extrafield_pos = 0;
+    int64_t comment_pos = 0;
+    int64_t linkname_pos = 0;
+    int64_t disk_number = 0;
+    const void *header = NULL;
+    int32_t header_size = 0;
+    uint8_t is_dir = 0;
+    int32_t err = MZ_OK;
+
+#if defined(MZ_ZIP_NO_ENCRYPTION)
+    if (password != NULL)
+        return MZ_SUPPORT_ERROR;
+#endif
+    if (zip == NULL || file_info == NULL || file_info->filename == NULL)
+        return MZ_PARAM_ERROR;
+
+    if (mz_zip_entry_is_open(handle) == MZ_OK)
+    {
+        err = mz_zip_entry_close(handle);
+        if (err != MZ_OK)
+            return err;
+    }
+
+    memcpy(&zip->file_info, file_info, sizeof(mz_zip_file));
+
+    mz_zip_print("Zip - Entry - Write open - %s (level %" PRId16 " raw %" PRId8 ")\n",
+        zip->file_info.filename, compress_level, raw);
+
+    mz_stream_seek(zip->file_info_stream, 0, MZ_SEEK_SET);
+    mz_stream_write(zip->file_info_stream, file_info, sizeof(mz_zip_file));
+
+    /* Copy filename, extrafield, and comment internally */
+    filename_pos = mz_stream_tell(zip->file_info_stream);
+    if (file_info->filename != NULL)
+        mz_stream_write(zip->file_info_stream, file_info->filename, (int32_t)strlen(file_info->filename));
+    mz_stream_write_uint8(zip->file_info_stream, 0);
+
+    extrafield_pos = mz_stream_tell(zip->file_info_stream);
+    if (file_info->extrafield != NULL)
+        mz_stream_write(zip->file_info_stream, file_info->extrafield, file_info->extrafield_size);
+    mz_stream_write_uint8(zip->file_info_stream, 0);
+
+    comment_pos = mz_stream_tell(zip->file_info_stream);
+    if (file_info->comment != NULL)
+        mz_stream_write(zip->file_info_stream, file_info->comment, file_info->comment_size);
+    mz_stream_write_uint8(zip->file_info_stream, 0);
+
+    linkname_pos = mz_stream_tell(zip->file_info_stream);
+    if (file_info->linkname != NULL)
+        mz_stream_write(zip->file_info_stream, file_info->linkname, (int32_t)strlen(file_info->linkname));
+    mz_stream_write_uint8(zip->file_info_stream, 0);
+
+    mz_stream_mem_get_buffer_at(zip->file_info_stream, filename_pos, (const void **)&zip->file_info.filename);
+    mz_stream_mem_get_buffer_at(zip->file_info_stream, extrafield_pos, (const void **)&zip->file_info.extrafield);
+    mz_stream_mem_get_buffer_at(zip->file_info_stream, comment_pos, (const void **)&zip->file_info.comment);
+    mz_stream_mem_get_buffer_at(zip->file_info_stream, linkname_pos, (const void **)&zip->file_info.linkname);
+
+    if (zip->file_info.compression_method == MZ_COMPRESS_METHOD_DEFLATE)
+    {
+        if ((compress_level == 8) || (compress_level == 9))
+            zip->file_info.flag |= MZ_ZIP_FLAG_DEFLATE_MAX;
+        if (compress_level == 2)
+            zip->file_info.flag |= MZ_ZIP_FLAG_DEFLATE_FAST;
+        if (compress_level == 1)
+            zip->file_info.flag |= MZ_ZIP_FLAG_DEFLATE_SUPER_FAST;
+    }
+#ifdef HAVE_LZMA
+    else if (zip->file_info.compression_method == MZ_COMPRESS_METHOD_LZMA)
+        zip->file_info.flag |= MZ_ZIP_FLAG_LZMA_EOS_MARKER;
+#endif
+
+    if (mz_zip_attrib_is_dir(zip->file_info.external_fa, zip->file_info.version_madeby) == MZ_OK)
+        is_dir = 1;
+
+    if (!is_dir)
+    {
+        zip->file_info.flag |= MZ_ZIP_FLAG_DATA_DESCRIPTOR;
+        if (password != NULL)
+            zip->file_info.flag |= MZ_ZIP_FLAG_ENCRYPTED;
+    }
+
+    mz_stream_get_prop_int64(zip->stream, MZ_STREAM_PROP_DISK_NUMBER, &disk_number);
+    zip->file_info.disk_number = (uint32_t)disk_number;
+
+    zip->file_info.disk_offset = mz_stream_tell(zip->stream);
+    zip->file_info.crc = 0;
+    zip->file_info.compressed_size = 0;
+
+#ifdef HAVE_WZAES
+    if (zip->file_info.aes_version && zip->file_info.aes_encryption_mode == 0)
+        zip->file_info.aes_encryption_mode = MZ_AES_ENCRYPTION_MODE_256;
+#endif
+
+    if ((compress_level == 0) || (is_dir))
+        zip->file_info.compression_method = MZ_COMPRESS_METHOD_STORE;
+
+#ifdef MZ_ZIP_NO_COMPRESSION
+    if (zip->file_info.compression_method != MZ_COMPRESS_METHOD_STORE)
+        err = MZ_SUPPORT_ERROR;
+#endif
+    /* Local header is assembled in memory, unless encrypting it is held back and written
+       together with the first data of the entry */
+    if (err == MZ_OK)
+    {
+        mz_stream_mem_seek(zip->header_stream, 0, MZ_SEEK_SET);
+        mz_stream_mem_set_buffer_limit(zip->header_stream, 0);
+        err = mz_zip_entry_write_header(zip->header_stream, 1, &zip->file_info);
+    }
+    if (err == MZ_OK)
+    {
+        mz_stream_mem_get_buffer(zip->header_stream, &header);
+        mz_stream_mem_get_buffer_length(zip->header_stream, &header_size);
+
+        zip->entry_header_pending = !mz_zip_entry_use_crypt(&zip->file_info, zip->open_mode, raw, password);
+        if (!zip->entry_header_pending && mz_stream_write(zip->stream, header, header_size) != header_size)
+            err = MZ_WRITE_ERROR;
+    }
+    /* Prefix is attached before the compressor opens since some write their own header */
+    if ((err == MZ_OK) && (zip->entry_header_pending))
+    {
+        mz_stream_raw_create(&zip->crypt_stream);
+        mz_stream_raw_set_prefix(zip->crypt_stream, header, header_size);
+    }
+    if (err == MZ_OK)
+        err = mz_zip_entry_open_int(handle, raw, compress_level, password);
+    if ((err != MZ_OK) && (zip->crypt_stream != NULL))
+        mz_stream_delete(&zip->crypt_stream);
+
+    return err;
+}
+
+int32_t mz_zip_entry_read(void *handle, void *buf, int32_t len)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t read = 0;
+
+    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+        return MZ_PARAM_ERROR;
     if (UINT_MAX == UINT16_MAX && len > UINT16_MAX) /* zlib limitation */
         return MZ_PARAM_ERROR;
-    if (len == 0)
+    if (len == 0)
+        return MZ_PARAM_ERROR;
+
+    if (zip->file_info.compressed_size == 0)
+        return 0;
+
+    /* Read entire entry even if uncompressed_size = 0, otherwise */
+    /* aes encryption validation will fail if compressed_size > 0 */
+    read = mz_stream_read(zip->compress_stream, buf, len);
+    if (read > 0)
+        zip->entry_crc32 = mz_crypt_crc32_update(zip->entry_crc32, buf, read);
+
+    mz_zip_print("Zip - Entry - Read - %" PRId32 " (max %" PRId32 ")\n", read, len);
+
+    return read;
+}
+
+int32_t mz_zip_entry_read_buffer(void *handle, void *buf, int32_t len)
+{
+#if defined(HAVE_ZLIB) && !defined(MZ_ZIP_NO_DECOMPRESSION)
+    mz_zip *zip = (mz_zip *)handle;
+    const void *source = NULL;
+    uint8_t *source_buf = NULL;
+    int64_t total_in = 0;
+    int32_t source_size = 0;
+    int32_t read = 0;
+    int32_t err = MZ_OK;
+
+    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+        return MZ_PARAM_ERROR;
+    if (zip->entry_raw || (zip->file_info.flag & MZ_ZIP_FLAG_ENCRYPTED))
+        return MZ_SUPPORT_ERROR;
+    if (zip->file_info.compression_method != MZ_COMPRESS_METHOD_DEFLATE)
+        return MZ_SUPPORT_ERROR;
+    if (zip->file_info.compressed_size <= 0 || zip->file_info.compressed_size > INT32_MAX)
+        return MZ_SUPPORT_ERROR;
+    if (zip->file_info.uncompressed_size != len)
+        return MZ_SUPPORT_ERROR;
+
+    /* Entry must not have been partially read through the compression stream */
+    mz_stream_get_prop_int64(zip->crypt_stream, MZ_STREAM_PROP_TOTAL_IN, &total_in);
+    if (total_in != 0)
+        return MZ_SUPPORT_ERROR;
+
+    source_size = (int32_t)zip->file_info.compressed_size;
+
+    /* Decode straight from the zip stream's buffer when it can lend all of the entry */
+    read = mz_stream_read_ptr(zip->crypt_stream, &source, source_size);
+    if (read != source_size)
+    {
+        source_buf = (uint8_t *)MZ_ALLOC(source_size);
+        if (source_buf == NULL)
+            return MZ_MEM_ERROR;
+        if (mz_stream_read(zip->crypt_stream, source_buf, source_size) != source_size)
+            err = MZ_READ_ERROR;
+        source = source_buf;
+    }
+
+    if (err == MZ_OK)
+    {
+        read = mz_stream_zlib_inflate_buffer(zip->compress_stream, source, source_size, buf, len);
+        if (read != len)
+            err = (read < 0) ? read : MZ_DATA_ERROR;
+    }
+    if (err == MZ_OK && source_buf == NULL)
+        err = mz_stream_release(zip->crypt_stream, source_size);
+
+    if (source_buf != NULL)
+        MZ_FREE(source_buf);
+    if (err != MZ_OK)
+        return err;
+
+    zip->entry_read_buffer = source_size;
+    zip->entry_crc32 = mz_crypt_crc32_update(zip->entry_crc32, buf, len);
+
+    mz_zip_print("Zip - Entry - Read Buffer - %" PRId32 " (compressed %" PRId32 ")\n", len, source_size);
+
+    return len;
+#else
+    MZ_UNUSED(handle);
+    MZ_UNUSED(buf);
+    MZ_UNUSED(len);
+    return MZ_SUPPORT_ERROR;
+#endif
+}
+
+int32_t mz_zip_entry_write(void *handle, const void *buf, int32_t len)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t written = 0;
+
+    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+        return MZ_PARAM_ERROR;
+    written = mz_stream_write(zip->compress_stream, buf, len);
+    if (written > 0 && !zip->entry_crc_stream)
+        zip->entry_crc32 = mz_crypt_crc32_update(zip->entry_crc32, buf, written);
+
+    mz_zip_print("Zip - Entry - Write - %" PRId32 " (max %" PRId32 ")\n", written, len);
+
+    return written;
+}
+
+int32_t mz_zip_entry_read_copy(void *handle, void *stream, int32_t len)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    uint8_t buf[16384];
+    int64_t position = 0;
+    int32_t bytes_to_read = 0;
+    int32_t total_read = 0;
+    int32_t copied = 0;
+    int32_t read = 0;
+
+    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+        return MZ_PARAM_ERROR;
+    if (zip->open_mode & MZ_OPEN_MODE_WRITE)
+        return MZ_PARAM_ERROR;
+    if (len <= 0)
+        return MZ_PARAM_ERROR;
+
+    /* Only data that is stored as is can be copied without decoding it */
+    if (!zip->entry_raw)
+    {
+        if (zip->file_info.compression_method != MZ_COMPRESS_METHOD_STORE)
+            return MZ_SUPPORT_ERROR;
+        if (zip->file_info.flag & MZ_ZIP_FLAG_ENCRYPTED)
+            return MZ_SUPPORT_ERROR;
+    }
+
+    if (zip->file_info.compressed_size == 0)
+        return 0;
+
+    if (!zip->entry_raw)
+    {
+        /* Copied bytes are read back from the zip stream to keep the crc check, so the copy
+           is only done when they can be read back without moving the stream position */
+        position = mz_stream_tell(zip->stream);
+        if (position < 0)
+            return MZ_SUPPORT_ERROR;
+        if (mz_stream_read_at(zip->stream, position, buf, 0) < 0)
+            return MZ_SUPPORT_ERROR;
+    }
+
+    copied = mz_stream_copy_from(stream, zip->compress_stream, len);
+    if (copied <= 0 || zip->entry_raw)
+        return copied;
+
+    while (total_read < copied)
+    {
+        bytes_to_read = copied - total_read;
+        if (bytes_to_read > (int32_t)sizeof(buf))
+            bytes_to_read = (int32_t)sizeof(buf);
+
+        read = mz_stream_read_at(zip->stream, position + total_read, buf, bytes_to_read);
+        if (read <= 0)
+            return MZ_READ_ERROR;
+
+        zip->entry_crc32 = mz_crypt_crc32_update(zip->entry_crc32, buf, read);
+        total_read += read;
+    }
+
+    mz_zip_print("Zip - Entry - Read copy - %" PRId32 " (max %" PRId32 ")\n", copied, len);
+
+    return copied;
+}
+
+int32_t mz_zip_entry_copy(void *handle, void *source_handle, int32_t len)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t copied = 0;
+
+    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+        return MZ_PARAM_ERROR;
+    if ((zip->open_mode & MZ_OPEN_MODE_WRITE) == 0)
+        return MZ_PARAM_ERROR;
+
+    /* Target crc is only passed in when closing an entry written raw */
+    if (!zip->entry_raw)
+        return MZ_SUPPORT_ERROR;
+
+    copied = mz_zip_entry_read_copy(source_handle, zip->compress_stream, len);
+
+    mz_zip_print("Zip - Entry - Copy - %" PRId32 " (max %" PRId32 ")\n", copied, len);
+
+    return copied;
+}
+
+int32_t mz_zip_entry_read_close(void *handle, uint32_t *crc32, int64_t *compressed_size,
+    int64_t *uncompressed_size)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int64_t total_in = 0;
+    int32_t err = MZ_OK;
+    uint8_t zip64 = 0;
+
+    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+        return MZ_PARAM_ERROR;
+
+    mz_stream_close(zip->compress_stream);
+
+    mz_zip_print("Zip - Entry - Read Close\n");
+
+    if (crc32 != NULL)
+        *crc32 = zip->file_info.crc;
+    if (compressed_size != NULL)
+        *compressed_size = zip->file_info.compressed_size;
+    if (uncompressed_size != NULL)
+        *uncompressed_size = zip->file_info.uncompressed_size;
+
+    mz_stream_get_prop_int64(zip->compress_stream, MZ_STREAM_PROP_TOTAL_IN, &total_in);
+    total_in += zip->entry_read_buffer;
+
+    if ((zip->file_info.flag & MZ_ZIP_FLAG_DATA_DESCRIPTOR) &&
+        ((zip->file_info.flag & MZ_ZIP_FLAG_MASK_LOCAL_INFO) == 0) &&
+        (crc32 != NULL || compressed_size != NULL || uncompressed_size != NULL))
+    {
+        /* Check to see if data descriptor is zip64 bit format or not */
+        if (mz_zip_extrafield_contains(zip->local_file_info.extrafield,
+            zip->local_file_info.extrafield_size, MZ_ZIP_EXTENSION_ZIP64, NULL) == MZ_OK)
+            zip64 = 1;
+
+        err = mz_zip_seek_to_local_header(handle);
+
+        /* Seek to end of compressed stream since we might have over-read during compression */
+        if (err == MZ_OK)
+            err = mz_stream_seek(zip->stream, MZ_ZIP_SIZE_LD_ITEM +
+                (int64_t)zip->local_file_info.filename_size +
+                (int64_t)zip->local_file_info.extrafield_size +
+                total_in, MZ_SEEK_CUR);
+
+        /* Read data descriptor */
+        if (err == MZ_OK)
+            err = mz_zip_entry_read_descriptor(zip->stream, zip64,
+                crc32, compressed_size, uncompressed_size);
+    }
+
+    /* If entire entry was not read verification will fail */
+    if ((err == MZ_OK) && (total_in > 0) && (!zip->entry_raw))
+    {
+#ifdef HAVE_WZAES
+        /* AES zip version AE-1 will expect a valid crc as well */
+        if (zip->file_info.aes_version <= 0x0001)
+#endif
+        {
+            if (zip->entry_crc32 != zip->file_info.crc)
+            {
+                mz_zip_print("Zip - Entry - Crc failed (actual 0x%08" PRIx32 " expected 0x%08" PRIx32 ")\n",
+                    zip->entry_crc32, zip->file_info.crc);
+
+                err = MZ_CRC_ERROR;
+            }
+        }
+    }
+
+    mz_zip_entry_close_int(handle);
+
+    return err;
+}
+
+/***************************************************************************/
+
+typedef struct mz_zip_entry_stream_s {
+    mz_stream   stream;
+    void        *view_stream;       /* positional view of the zip stream */
+    void        *crypt_stream;
+    void        *compress_stream;
+    uint8_t     opened;
+    uint8_t     raw;
+    uint16_t    aes_version;
+    uint32_t    crc32;
+    uint32_t    expected_crc32;
+    int64_t     compressed_size;
+} mz_zip_entry_stream;
+
+/***************************************************************************/
+
+static int32_t mz_zip_entry_stream_is_open(void *stream)
+{
+    mz_zip_entry_stream *entry = (mz_zip_entry_stream *)stream;
+    if (!entry->opened)
+        return MZ_OPEN_ERROR;
+    return MZ_OK;
+}
+
+static int32_t mz_zip_entry_stream_read(void *stream, void *buf, int32_t size)
+{
+    mz_zip_entry_stream *entry = (mz_zip_entry_stream *)stream;
+    int32_t read = 0;
+
+    if (entry->compressed_size == 0)
+        return 0;
+
+    read = mz_stream_read(entry->compress_stream, buf, size);
+    if (read > 0)
+        entry->crc32 = mz_crypt_crc32_update(entry->crc32, buf, read);
+    return read;
+}
+
+static int32_t mz_zip_entry_stream_write(void *stream, const void *buf, int32_t size)
+{
+    MZ_UNUSED(stream);
+    MZ_UNUSED(buf);
+    MZ_UNUSED(size);
+    return MZ_SUPPORT_ERROR;
+}
+
+static int64_t mz_zip_entry_stream_tell(void *stream)
+{
+    mz_zip_entry_stream *entry = (mz_zip_entry_stream *)stream;
+    int64_t total_out = 0;
+    if (mz_stream_get_prop_int64(entry->compress_stream, MZ_STREAM_PROP_TOTAL_OUT, &total_out) != MZ_OK)
+        return MZ_TELL_ERROR;
+    return total_out;
+}
+
+static int32_t mz_zip_entry_stream_seek(void *stream, int64_t offset, int32_t origin)
+{
+    MZ_UNUSED(stream);
+    MZ_UNUSED(offset);
+    MZ_UNUSED(origin);
+    return MZ_SUPPORT_ERROR;
+}
+
+static int32_t mz_zip_entry_stream_close(void *stream)
+{
+    mz_zip_entry_stream *entry = (mz_zip_entry_stream *)stream;
+    int64_t total_in = 0;
+    int32_t err = MZ_OK;
+
+    if (!entry->opened)
+        return MZ_OK;
+
+    mz_stream_close(entry->compress_stream);
+    mz_stream_get_prop_int64(entry->compress_stream, MZ_STREAM_PROP_TOTAL_IN, &total_in);
+    entry->opened = 0;
+
+    /* If entire entry was not read verification will fail */
+    if ((total_in > 0) && (!entry->raw))
+    {
+#ifdef HAVE_WZAES
+        /* AES zip version AE-1 will expect a valid crc as well */
+        if (entry->aes_version <= 0x0001)
+#endif
+        {
+            if (entry->crc32 != entry->expected_crc32)
+                err = MZ_CRC_ERROR;
+        }
+    }
+
+    return err;
+}
+
+static int32_t mz_zip_entry_stream_error(void *stream)
+{
+    mz_zip_entry_stream *entry = (mz_zip_entry_stream *)stream;
+    return mz_stream_error(entry->compress_stream);
+}
+
+static void *mz_zip_entry_stream_create(void **stream);
+static void mz_zip_entry_stream_delete(void **stream);
+
+static mz_stream_vtbl mz_zip_entry_stream_vtbl = {
+    NULL,
+    mz_zip_entry_stream_is_open,
+    mz_zip_entry_stream_read,
+    mz_zip_entry_stream_write,
+    mz_zip_entry_stream_tell,
+    mz_zip_entry_stream_seek,
+    mz_zip_entry_stream_close,
+    mz_zip_entry_stream_error,
+    mz_zip_entry_stream_create,
+    mz_zip_entry_stream_delete,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+static void *mz_zip_entry_stream_create(void **stream)
+{
+    mz_zip_entry_stream *entry = NULL;
+
+    entry = (mz_zip_entry_stream *)MZ_ALLOC(sizeof(mz_zip_entry_stream));
+    if (entry != NULL)
+    {
+        memset(entry, 0, sizeof(mz_zip_entry_stream));
+        entry->stream.vtbl = &mz_zip_entry_stream_vtbl;
+    }
+    if (stream != NULL)
+        *stream = entry;
+
+    return entry;
+}
+
+static void mz_zip_entry_stream_delete(void **stream)
+{
+    mz_zip_entry_stream *entry = NULL;
+    if (stream == NULL)
+        return;
+    entry = (mz_zip_entry_stream *)*stream;
+    if (entry != NULL)
+    {
+        if (entry->compress_stream != NULL)
+            mz_stream_delete(&entry->compress_stream);
+        if (entry->crypt_stream != NULL)
+            mz_stream_delete(&entry->crypt_stream);
+        if (entry->view_stream != NULL)
+            mz_stream_view_delete(&entry->view_stream);
+        MZ_FREE(entry);
+    }
+    *stream = NULL;
+}
+
+int32_t mz_zip_entry_read_stream_open(void *handle, const mz_zip_file *file_info, uint8_t raw,
+    const char *password, void **stream)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    mz_zip_entry_stream *entry = NULL;
+    mz_zip_file local_file_info;
+    void *local_file_info_stream = NULL;
+    int64_t disk_offset = 0;
+    int32_t err = MZ_OK;
+
+#if defined(MZ_ZIP_NO_ENCRYPTION)
+    if (password != NULL)
+        return MZ_SUPPORT_ERROR;
+#endif
+    if (zip == NULL || file_info == NULL || stream == NULL)
+        return MZ_PARAM_ERROR;
+    *stream = NULL;
+    if ((zip->open_mode & MZ_OPEN_MODE_READ) == 0)
+        return MZ_PARAM_ERROR;
+
+    /* Entries on other disks can't be read without switching the disk of the shared stream */
+    if (file_info->disk_number != zip->disk_number_with_cd)
+        return MZ_SUPPORT_ERROR;
+
+    err = mz_zip_entry_is_supported(file_info);
+#ifdef MZ_ZIP_NO_DECOMPRESSION
+    if (!raw && file_info->compression_method != MZ_COMPRESS_METHOD_STORE)
+        err = MZ_SUPPORT_ERROR;
+#endif
+    if (err != MZ_OK)
+        return err;
+
+    /* Guard against seek overflows */
+    disk_offset = file_info->disk_offset;
+    if ((zip->disk_offset_shift > 0) && (disk_offset > (INT64_MAX - zip->disk_offset_shift)))
+        return MZ_FORMAT_ERROR;
+
+    mz_zip_print("Zip - Entry - Read stream open (raw %" PRId32 " offset %" PRId64 ")\n", raw, disk_offset);
+
+    entry = (mz_zip_entry_stream *)mz_zip_entry_stream_create(NULL);
+    if (entry == NULL)
+        return MZ_MEM_ERROR;
+
+    /* Each entry stream reads the shared zip stream at its own position */
+    mz_stream_view_create(&entry->view_stream);
+    mz_stream_set_base(entry->view_stream, zip->stream);
+    err = mz_stream_view_open(entry->view_stream, NULL, MZ_OPEN_MODE_READ);
+
+    mz_stream_mem_create(&local_file_info_stream);
+    mz_stream_mem_open(local_file_info_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+    if (err == MZ_OK)
+        err = mz_stream_view_seek(entry->view_stream, disk_offset + zip->disk_offset_shift, MZ_SEEK_SET);
+    if (err == MZ_OK)
+        err = mz_zip_entry_read_header(entry->view_stream, 1, &local_file_info, local_file_info_stream);
+    if (err == MZ_FORMAT_ERROR && zip->disk_offset_shift > 0)
+    {
+        /* Perhaps we didn't compensated correctly for incorrect cd offset */
+        err = mz_stream_view_seek(entry->view_stream, disk_offset, MZ_SEEK_SET);
+        if (err == MZ_OK)
+            err = mz_zip_entry_read_header(entry->view_stream, 1, &local_file_info, local_file_info_stream);
+    }
+
+    mz_stream_mem_delete(&local_file_info_stream);
+
+    if (err == MZ_OK)
+    {
+        err = mz_zip_entry_open_streams(file_info, entry->view_stream, MZ_OPEN_MODE_READ, raw, 0, 0,
+            password, &entry->crypt_stream, &entry->compress_stream);
+    }
+
+    if (err == MZ_OK)
+    {
+        entry->opened = 1;
+        entry->raw = raw;
+        entry->aes_version = file_info->aes_version;
+        entry->expected_crc32 = file_info->crc;
+        entry->compressed_size = file_info->compressed_size;
+        *stream = entry;
+    }
+    else
+    {
+        mz_zip_entry_stream_delete((void **)&entry);
+    }
+
+    return err;
+}
+
+int32_t mz_zip_entry_write_close(void *handle, uint32_t crc32, int64_t compressed_size,
+    int64_t uncompressed_size)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    mz_stream_iovec iov[2];
+    uint8_t descriptor[MZ_ZIP_SIZE_MAX_DATA_DESCRIPTOR];
+    void *descriptor_stream = NULL;
+    int64_t header_size = 0;
+    int64_t crc = 0;
+    int32_t iov_count = 0;
+    int32_t total_size = 0;
+    int32_t err = MZ_OK;
+    uint8_t zip64 = 0;
+
+    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+        return MZ_PARAM_ERROR;
+
+    mz_stream_close(zip->compress_stream);
+
+    if (zip->entry_crc_stream &&
+        mz_stream_get_prop_int64(zip->compress_stream, MZ_STREAM_PROP_CRC, &crc) == MZ_OK)
+        zip->entry_crc32 = (uint32_t)crc;
+    if (!zip->entry_raw)
+        crc32 = zip->entry_crc32;
+
+    mz_zip_print("Zip - Entry - Write Close (crc 0x%08" PRIx32 " cs %" PRId64 " ucs %" PRId64 ")\n",
+        crc32, compressed_size, uncompressed_size);
+
+    /* If sizes are not set, then read them from the compression stream */
+    if (compressed_size < 0)
+        mz_stream_get_prop_int64(zip->compress_stream, MZ_STREAM_PROP_TOTAL_OUT, &compressed_size);
+    if (uncompressed_size < 0)
+        mz_stream_get_prop_int64(zip->compress_stream, MZ_STREAM_PROP_TOTAL_IN, &uncompressed_size);
+
+    if (zip->file_info.flag & MZ_ZIP_FLAG_ENCRYPTED)
+    {
+        mz_stream_set_base(zip->crypt_stream, zip->stream);
+        err = mz_stream_close(zip->crypt_stream);
+
+        mz_stream_get_prop_int64(zip->crypt_stream, MZ_STREAM_PROP_TOTAL_OUT, &compressed_size);
+    }
+
+    /* Local header still held back when no data was written goes out with the descriptor */
+    if ((err == MZ_OK) && (zip->entry_header_pending) &&
+        (mz_stream_get_prop_int64(zip->crypt_stream, MZ_STREAM_PROP_HEADER_SIZE, &header_size) == MZ_OK) &&
+        (header_size > 0))
+    {
+        mz_stream_mem_get_buffer(zip->header_stream, &iov[iov_count].buf);
+        iov[iov_count].size = (int32_t)header_size;
+        total_size += iov[iov_count].size;
+        iov_count += 1;
+        mz_stream_raw_set_prefix(zip->crypt_stream, NULL, 0);
+    }
+
+    if ((err == MZ_OK) && (zip->file_info.flag & MZ_ZIP_FLAG_DATA_DESCRIPTOR))
+    {
+        /* Determine if we need to write data descriptor in zip64 format,
+           if local extrafield was saved with zip64 extrafield */
+        if (zip->file_info.zip64 == MZ_ZIP64_AUTO)
+        {
+            if (zip->file_info.uncompressed_size >= UINT32_MAX)
+                zip64 = 1;
+            if (zip->file_info.compressed_size >= UINT32_MAX)
+                zip64 = 1;
+            if (zip->file_info.disk_offset >= UINT32_MAX)
+                zip64 = 1;
+            else if (zip->file_info.uncompressed_size == 0)
+                zip64 = 1;
+        }
+        else if (zip->file_info.zip64 == MZ_ZIP64_FORCE)
+        {
+            zip64 = 1;
+        }
+
+        mz_stream_mem_create(&descriptor_stream);
+        mz_stream_mem_set_buffer(descriptor_stream, descriptor, sizeof(descriptor));
+
+        if (zip->file_info.flag & MZ_ZIP_FLAG_MASK_LOCAL_INFO)
+            err = mz_zip_entry_write_descriptor(descriptor_stream,
+                zip64, 0, compressed_size, 0);
+        else
+            err = mz_zip_entry_write_descriptor(descriptor_stream,
+                zip64, crc32, compressed_size, uncompressed_size);
+
+        iov[iov_count].buf = descriptor;
+        iov[iov_count].size = (int32_t)mz_stream_mem_tell(descriptor_stream);
+        total_size += iov[iov_count].size;
+        iov_count += 1;
+
+        mz_stream_mem_delete(&descriptor_stream);
+    }
+
+    if ((err == MZ_OK) && (iov_count > 0))
+    {
+        if (mz_stream_writev(zip->stream, iov, iov_count) != total_size)
+            err = MZ_WRITE_ERROR;
+    }
+
+    /* Write file info to central directory */
+
+    mz_zip_print("Zip - Entry - Write cd (ucs %" PRId64 " cs %" PRId64 " crc 0x%08" PRIx32 ")\n",
+        uncompressed_size, compressed_size, crc32);
+
+    zip->file_info.crc = crc32;
+    zip->file_info.compressed_size = compressed_size;
+    zip->file_info.uncompressed_size = uncompressed_size;
+
+    if (err == MZ_OK)
+        err = mz_zip_entry_write_header(zip->cd_mem_stream, 0, &zip->file_info);
+
+    zip->number_entry += 1;
+
+    mz_zip_entry_close_int(handle);
+
+    return err;
+}
+
+int32_t mz_zip_entry_is_dir(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t filename_length = 0;
+
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+    if (zip->entry_scanned == 0)
         return MZ_PARAM_ERROR;
+    if (mz_zip_attrib_is_dir(zip->file_info.external_fa, zip->file_info.version_madeby) == MZ_OK)
+        return MZ_OK;
 
-    if (zip->file_info.compressed_size == 0)
-        return 0;
+    filename_length = (int32_t)strlen(zip->file_info.filename);
+    if (filename_length > 0)
+    {
+        if ((zip->file_info.filename[filename_length - 1] == '/') ||
+            (zip->file_info.filename[filename_length - 1] == '\\'))
+            return MZ_OK;
+    }
+    return MZ_EXIST_ERROR;
+}
 
-    /* Read entire entry even if uncompressed_size = 0, otherwise */
-    /* aes encryption validation will fail if compressed_size > 0 */
-    read = mz_stream_read(zip->compress_stream, buf, len);
-    if (read > 0)
-        zip->entry_crc32 = mz_crypt_crc32_update(zip->entry_crc32, buf, read);
+int32_t mz_zip_entry_is_symlink(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
 
-    mz_zip_print("Zip - Entry - Read - %" PRId32 " (max %" PRId32 ")\n", read, len);
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+    if (zip->entry_scanned == 0)
+        return MZ_PARAM_ERROR;
+    if (mz_zip_attrib_is_symlink(zip->file_info.external_fa, zip->file_info.version_madeby) != MZ_OK)
+        return MZ_EXIST_ERROR;
+    if (zip->file_info.linkname == NULL || *zip->file_info.linkname == 0)
+        return MZ_EXIST_ERROR;
 
-    return read;
+    return MZ_OK;
 }
 
-int32_t mz_zip_entry_write(void *handle, const void *buf, int32_t len)
+int32_t mz_zip_entry_get_info(void *handle, mz_zip_file **file_info)
+{
+    mz_zip *zip = (mz_zip *)handle;
+
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+
+    if ((zip->open_mode & MZ_OPEN_MODE_WRITE) == 0)
+    {
+        if (!zip->entry_scanned)
+            return MZ_PARAM_ERROR;
+    }
+
+    *file_info = &zip->file_info;
+    return MZ_OK;
+}
+
+int32_t mz_zip_entry_get_local_info(void *handle, mz_zip_file **local_file_info)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+        return MZ_PARAM_ERROR;
+    *local_file_info = &zip->local_file_info;
+    return MZ_OK;
+}
+
+int32_t mz_zip_entry_set_extrafield(void *handle, const uint8_t *extrafield, uint16_t extrafield_size)
+{
+    mz_zip *zip = (mz_zip *)handle;
+
+    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+        return MZ_PARAM_ERROR;
+
+    zip->file_info.extrafield = extrafield;
+    zip->file_info.extrafield_size = extrafield_size;
+    return MZ_OK;
+}
+
+int32_t mz_zip_entry_close(void *handle)
+{
+    return mz_zip_entry_close_raw(handle, UINT64_MAX, 0);
+}
+
+int32_t mz_zip_entry_close_raw(void *handle, int64_t uncompressed_size, uint32_t crc32)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t err = MZ_OK;
+
+    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+        return MZ_PARAM_ERROR;
+
+    if (zip->open_mode & MZ_OPEN_MODE_WRITE)
+        err = mz_zip_entry_write_close(handle, crc32, UINT64_MAX, uncompressed_size);
+    else
+        err = mz_zip_entry_read_close(handle, NULL, NULL, NULL);
+
+    return err;
+}
+
+static int32_t mz_zip_goto_next_entry_int(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t err = MZ_OK;
+
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+
+    zip->entry_scanned = 0;
+
+    mz_stream_set_prop_int64(zip->cd_stream, MZ_STREAM_PROP_DISK_NUMBER, -1);
+
+    err = mz_stream_seek(zip->cd_stream, zip->cd_current_pos, MZ_SEEK_SET);
+    if (err == MZ_OK)
+        err = mz_zip_entry_read_header(zip->cd_stream, 0, &zip->file_info, zip->file_info_stream);
+    if (err == MZ_OK)
+        zip->entry_scanned = 1;
+    return err;
+}
+
+int32_t mz_zip_set_number_entry(void *handle, uint64_t number_entry)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+    zip->number_entry = number_entry;
+    return MZ_OK;
+}
+
+int32_t mz_zip_get_number_entry(void *handle, uint64_t *number_entry)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL || number_entry == NULL)
+        return MZ_PARAM_ERROR;
+    *number_entry = zip->number_entry;
+    return MZ_OK;
+}
+
+int32_t mz_zip_set_disk_number_with_cd(void *handle, uint32_t disk_number_with_cd)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+    zip->disk_number_with_cd = disk_number_with_cd;
+    return MZ_OK;
+}
+
+int32_t mz_zip_get_disk_number_with_cd(void *handle, uint32_t *disk_number_with_cd)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL || disk_number_with_cd == NULL)
+        return MZ_PARAM_ERROR;
+    *disk_number_with_cd = zip->disk_number_with_cd;
+    return MZ_OK;
+}
+
+int64_t mz_zip_get_entry(void *handle)
 {
     mz_zip *zip = (mz_zip *)handle;
-    int32_t written = 0;
 
-    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+    if (zip == NULL)
         return MZ_PARAM_ERROR;
-    written = mz_stream_write(zip->compress_stream, buf, len);
-    if (written > 0)
-        zip->entry_crc32 = mz_crypt_crc32_update(zip->entry_crc32, buf, written);
-
-    mz_zip_print("Zip - Entry - Write - %" PRId32 " (max %" PRId32 ")\n", written, len);
 
-    return written;
+    return zip->cd_current_pos;
 }
 
-int32_t mz_zip_entry_read_close(void *handle, uint32_t *crc32, int64_t *compressed_size,
-    int64_t *uncompressed_size)
+int32_t mz_zip_goto_entry(void *handle, int64_t cd_pos)
 {
     mz_zip *zip = (mz_zip *)handle;
-    int64_t total_in = 0;
-    int32_t err = MZ_OK;
-    uint8_t zip64 = 0;
 
-    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+    if (zip == NULL)
         return MZ_PARAM_ERROR;
 
-    mz_stream_close(zip->compress_stream);
-
-    mz_zip_print("Zip - Entry - Read Close\n");
+    if (cd_pos < zip->cd_start_pos || cd_pos > zip->cd_start_pos + zip->cd_size)
+        return MZ_PARAM_ERROR;
 
-    if (crc32 != NULL)
-        *crc32 = zip->file_info.crc;
-    if (compressed_size != NULL)
-        *compressed_size = zip->file_info.compressed_size;
-    if (uncompressed_size != NULL)
-        *uncompressed_size = zip->file_info.uncompressed_size;
+    zip->cd_current_pos = cd_pos;
 
-    mz_stream_get_prop_int64(zip->compress_stream, MZ_STREAM_PROP_TOTAL_IN, &total_in);
+    return mz_zip_goto_next_entry_int(handle);
+}
 
-    if ((zip->file_info.flag & MZ_ZIP_FLAG_DATA_DESCRIPTOR) &&
-        ((zip->file_info.flag & MZ_ZIP_FLAG_MASK_LOCAL_INFO) == 0) &&
-        (crc32 != NULL || compressed_size != NULL || uncompressed_size != NULL))
-    {
-        /* Check to see if data descriptor is zip64 bit format or not */
-        if (mz_zip_extrafield_contains(zip->local_file_info.extrafield,
-            zip->local_file_info.extrafield_size, MZ_ZIP_EXTENSION_ZIP64, NULL) == MZ_OK)
-            zip64 = 1;
+int32_t mz_zip_goto_first_entry(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
 
-        err = mz_zip_seek_to_local_header(handle);
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
 
-        /* Seek to end of compressed stream since we might have over-read during compression */
-        if (err == MZ_OK)
-            err = mz_stream_seek(zip->stream, MZ_ZIP_SIZE_LD_ITEM +
-                (int64_t)zip->local_file_info.filename_size +
-                (int64_t)zip->local_file_info.extrafield_size +
-                total_in, MZ_SEEK_CUR);
+    zip->cd_current_pos = zip->cd_start_pos;
 
-        /* Read data descriptor */
-        if (err == MZ_OK)
-            err = mz_zip_entry_read_descriptor(zip->stream, zip64,
-                crc32, compressed_size, uncompressed_size);
-    }
+    return mz_zip_goto_next_entry_int(handle);
+}
 
-    /* If entire entry was not read verification will fail */
-    if ((err == MZ_OK) && (total_in > 0) && (!zip->entry_raw))
-    {
-#ifdef HAVE_WZAES
-        /* AES zip version AE-1 will expect a valid crc as well */
-        if (zip->file_info.aes_version <= 0x0001)
-#endif
-        {
-            if (zip->entry_crc32 != zip->file_info.crc)
-            {
-                mz_zip_print("Zip - Entry - Crc failed (actual 0x%08" PRIx32 " expected 0x%08" PRIx32 ")\n",
-                    zip->entry_crc32, zip->file_info.crc);
+int32_t mz_zip_goto_next_entry(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
 
-                err = MZ_CRC_ERROR;
-            }
-        }
-    }
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
 
-    mz_zip_entry_close_int(handle);
+    zip->cd_current_pos += (int64_t)MZ_ZIP_SIZE_CD_ITEM + zip->file_info.filename_size +
+        zip->file_info.extrafield_size + zip->file_info.comment_size;
 
-    return err;
+    return mz_zip_goto_next_entry_int(handle);
 }
 
-int32_t mz_zip_entry_write_close(void *handle, uint32_t crc32, int64_t compressed_size,
-    int64_t uncompressed_size)
+int32_t mz_zip_locate_entry(void *handle, const char *filename, uint8_t ignore_case)
 {
     mz_zip *zip = (mz_zip *)handle;
     int32_t err = MZ_OK;
-    uint8_t zip64 = 0;
+    int32_t result = 0;
 
-    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+    if (zip == NULL || filename == NULL)
         return MZ_PARAM_ERROR;
 
-    mz_stream_close(zip->compress_stream);
-
-    if (!zip->entry_raw)
-        crc32 = zip->entry_crc32;
-
-    mz_zip_print("Zip - Entry - Write Close (crc 0x%08" PRIx32 " cs %" PRId64 " ucs %" PRId64 ")\n",
-        crc32, compressed_size, uncompressed_size);
+    /* If we are already on the current entry, no need to search */
+    if ((zip->entry_scanned) && (zip->file_info.filename != NULL))
+    {
+        result = mz_zip_path_compare(zip->file_info.filename, filename, ignore_case);
+        if (result == 0)
+            return MZ_OK;
+    }
 
-    /* If sizes are not set, then read them from the compression stream */
-    if (compressed_size < 0)
-        mz_stream_get_prop_int64(zip->compress_stream, MZ_STREAM_PROP_TOTAL_OUT, &compressed_size);
-    if (uncompressed_size < 0)
-        mz_stream_get_prop_int64(zip->compress_stream, MZ_STREAM_PROP_TOTAL_IN, &uncompressed_size);
+    /* Probe filename index if it has been built */
+    if (zip->index_case != NULL)
+        return mz_zip_index_locate(handle, filename, ignore_case);
 
-    if (zip->file_info.flag & MZ_ZIP_FLAG_ENCRYPTED)
+    /* Search all entries starting at the first */
+    err = mz_zip_goto_first_entry(handle);
+    while (err == MZ_OK)
     {
-        mz_stream_set_base(zip->crypt_stream, zip->stream);
-        err = mz_stream_close(zip->crypt_stream);
+        result = mz_zip_path_compare(zip->file_info.filename, filename, ignore_case);
+        if (result == 0)
+            return MZ_OK;
 
-        mz_stream_get_prop_int64(zip->crypt_stream, MZ_STREAM_PROP_TOTAL_OUT, &compressed_size);
+        err = mz_zip_goto_next_entry(handle);
     }
 
-    if ((err == MZ_OK) && (zip->file_info.flag & MZ_ZIP_FLAG_DATA_DESCRIPTOR))
-    {
-        /* Determine if we need to write data descriptor in zip64 format,
-           if local extrafield was saved with zip64 extrafield */
-        if (zip->file_info.zip64 == MZ_ZIP64_AUTO)
-        {
-            if (zip->file_info.uncompressed_size >= UINT32_MAX)
-                zip64 = 1;
-            if (zip->file_info.compressed_size >= UINT32_MAX)
-                zip64 = 1;
-            if (zip->file_info.disk_offset >= UINT32_MAX)
-                zip64 = 1;
-            else if (zip->file_info.uncompressed_size == 0)
-                zip64 = 1;
-        }
-        else if (zip->file_info.zip64 == MZ_ZIP64_FORCE)
-        {
-            zip64 = 1;
-        }
+    return err;
+}
 
-        if (zip->file_info.flag & MZ_ZIP_FLAG_MASK_LOCAL_INFO)
-            err = mz_zip_entry_write_descriptor(zip->stream,
-                zip64, 0, compressed_size, 0);
-        else
-            err = mz_zip_entry_write_descriptor(zip->stream,
-                zip64, crc32, compressed_size, uncompressed_size);
-    }
+int32_t mz_zip_locate_first_entry(void *handle, void *userdata, mz_zip_locate_entry_cb cb)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t err = MZ_OK;
+    int32_t result = 0;
 
-    /* Write file info to central directory */
+    /* Search first entry looking for match */
+    err = mz_zip_goto_first_entry(handle);
+    if (err != MZ_OK)
+        return err;
 
-    mz_zip_print("Zip - Entry - Write cd (ucs %" PRId64 " cs %" PRId64 " crc 0x%08" PRIx32 ")\n",
-        uncompressed_size, compressed_size, crc32);
+    result = cb(handle, userdata, &zip->file_info);
+    if (result == 0)
+        return MZ_OK;
 
-    zip->file_info.crc = crc32;
-    zip->file_info.compressed_size = compressed_size;
-    zip->file_info.uncompressed_size = uncompressed_size;
+    return mz_zip_locate_next_entry(handle, userdata, cb);
+}
 
-    if (err == MZ_OK)
-        err = mz_zip_entry_write_header(zip->cd_mem_stream, 0, &zip->file_info);
+int32_t mz_zip_locate_next_entry(void *handle, void *userdata, mz_zip_locate_entry_cb cb)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t err = MZ_OK;
+    int32_t result = 0;
 
-    zip->number_entry += 1;
+    /* Search next entries looking for match */
+    err = mz_zip_goto_next_entry(handle);
+    while (err == MZ_OK)
+    {
+        result = cb(handle, userdata, &zip->file_info);
+        if (result == 0)
+            return MZ_OK;
 
-    mz_zip_entry_close_int(handle);
+        err = mz_zip_goto_next_entry(handle);
+    }
 
     return err;
 }
 
-int32_t mz_zip_entry_is_dir(void *handle)
+int32_t mz_zip_entry_count(void *handle, uint64_t *count)
 {
     mz_zip *zip = (mz_zip *)handle;
-    int32_t filename_length = 0;
+    if (zip == NULL || count == NULL)
+        return MZ_PARAM_ERROR;
+    if (zip->table.cd_pos != NULL)
+        *count = zip->table.count;
+    else
+        *count = zip->number_entry;
+    return MZ_OK;
+}
+
+int32_t mz_zip_goto_entry_index(void *handle, uint64_t index)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    int32_t err = MZ_OK;
 
     if (zip == NULL)
         return MZ_PARAM_ERROR;
-    if (zip->entry_scanned == 0)
-        return MZ_PARAM_ERROR;
-    if (mz_zip_attrib_is_dir(zip->file_info.external_fa, zip->file_info.version_madeby) == MZ_OK)
-        return MZ_OK;
 
-    filename_length = (int32_t)strlen(zip->file_info.filename);
-    if (filename_length > 0)
+    if (zip->table.cd_pos != NULL)
     {
-        if ((zip->file_info.filename[filename_length - 1] == '/') ||
-            (zip->file_info.filename[filename_length - 1] == '\\'))
-            return MZ_OK;
+        if (index >= zip->table.count)
+            return MZ_END_OF_LIST;
+        return mz_zip_goto_entry(handle, zip->table.cd_pos[index]);
     }
-    return MZ_EXIST_ERROR;
+
+    /* Without entry table we must walk the central dir */
+    err = mz_zip_goto_first_entry(handle);
+    while ((err == MZ_OK) && (index > 0))
+    {
+        err = mz_zip_goto_next_entry(handle);
+        index -= 1;
+    }
+
+    return err;
 }
 
-int32_t mz_zip_entry_is_symlink(void *handle)
+int32_t mz_zip_entry_get_index(void *handle, uint64_t *index)
 {
     mz_zip *zip = (mz_zip *)handle;
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+    uint64_t mid = 0;
 
-    if (zip == NULL)
+    if (zip == NULL || index == NULL)
         return MZ_PARAM_ERROR;
-    if (zip->entry_scanned == 0)
-        return MZ_PARAM_ERROR;
-    if (mz_zip_attrib_is_symlink(zip->file_info.external_fa, zip->file_info.version_madeby) != MZ_OK)
+    if (zip->table.cd_pos == NULL)
         return MZ_EXIST_ERROR;
-    if (zip->file_info.linkname == NULL || *zip->file_info.linkname == 0)
+    if (!zip->entry_scanned)
+        return MZ_PARAM_ERROR;
+
+    /* Entry table is in central dir order so it can be searched by position */
+    hi = zip->table.count;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (zip->table.cd_pos[mid] < zip->cd_current_pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if ((lo >= zip->table.count) || (zip->table.cd_pos[lo] != zip->cd_current_pos))
         return MZ_EXIST_ERROR;
 
+    *index = lo;
     return MZ_OK;
 }
 
-int32_t mz_zip_entry_get_info(void *handle, mz_zip_file **file_info)
+int32_t mz_zip_get_entry_info_at(void *handle, uint64_t index, mz_zip_file *file_info)
 {
     mz_zip *zip = (mz_zip *)handle;
+    mz_zip_table *table = NULL;
 
-    if (zip == NULL)
+    if (zip == NULL || file_info == NULL)
         return MZ_PARAM_ERROR;
+    table = &zip->table;
+    if (table->cd_pos == NULL)
+        return MZ_EXIST_ERROR;
+    if (index >= table->count)
+        return MZ_END_OF_LIST;
 
-    if ((zip->open_mode & MZ_OPEN_MODE_WRITE) == 0)
-    {
-        if (!zip->entry_scanned)
-            return MZ_PARAM_ERROR;
-    }
+    memset(file_info, 0, sizeof(mz_zip_file));
+
+    file_info->version_madeby = table->version_madeby[index];
+    file_info->version_needed = table->version_needed[index];
+    file_info->flag = table->flag[index];
+    file_info->compression_method = table->compression_method[index];
+    file_info->modified_date = table->modified_date[index];
+    file_info->accessed_date = table->accessed_date[index];
+    file_info->creation_date = table->creation_date[index];
+    file_info->crc = table->crc[index];
+    file_info->compressed_size = table->compressed_size[index];
+    file_info->uncompressed_size = table->uncompressed_size[index];
+    file_info->filename_size = table->filename_size[index];
+    file_info->disk_number = table->disk_number[index];
+    file_info->disk_offset = table->disk_offset[index];
+    file_info->internal_fa = table->internal_fa[index];
+    file_info->external_fa = table->external_fa[index];
+    file_info->aes_version = table->aes_version[index];
+    file_info->aes_encryption_mode = table->aes_encryption_mode[index];
+
+    /* Variable length data other than the filename is not kept in the table */
+    file_info->filename = table->pool + table->filename_pos[index];
+    file_info->comment = "";
+    file_info->linkname = "";
 
-    *file_info = &zip->file_info;
     return MZ_OK;
 }
 
-int32_t mz_zip_entry_get_local_info(void *handle, mz_zip_file **local_file_info)
+int32_t mz_zip_get_local_header_offset(void *handle, const mz_zip_file *file_info, int64_t *offset)
 {
     mz_zip *zip = (mz_zip *)handle;
-    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+    if (zip == NULL || file_info == NULL || offset == NULL)
         return MZ_PARAM_ERROR;
-    *local_file_info = &zip->local_file_info;
+    /* Guard against seek overflows */
+    if ((zip->disk_offset_shift > 0) && (file_info->disk_offset > (INT64_MAX - zip->disk_offset_shift)))
+        return MZ_FORMAT_ERROR;
+    *offset = file_info->disk_offset + zip->disk_offset_shift;
     return MZ_OK;
 }
 
-int32_t mz_zip_entry_set_extrafield(void *handle, const uint8_t *extrafield, uint16_t extrafield_size)
+int32_t mz_zip_get_entries_info(void *handle, uint64_t first, int32_t count, mz_zip_file_lite *entries)
 {
     mz_zip *zip = (mz_zip *)handle;
+    mz_zip_table *table = NULL;
+    mz_zip_file_lite *entry = NULL;
+    uint64_t index = 0;
+    int32_t i = 0;
 
-    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+    if (zip == NULL || entries == NULL || count < 0)
         return MZ_PARAM_ERROR;
+    table = &zip->table;
+    if (table->cd_pos == NULL)
+        return MZ_EXIST_ERROR;
+    if (first >= table->count)
+        return MZ_END_OF_LIST;
 
-    zip->file_info.extrafield = extrafield;
-    zip->file_info.extrafield_size = extrafield_size;
+    if ((uint64_t)count > table->count - first)
+        count = (int32_t)(table->count - first);
+
+    for (i = 0, index = first; i < count; i += 1, index += 1)
+    {
+        entry = &entries[i];
+
+        entry->version_madeby = table->version_madeby[index];
+        entry->flag = table->flag[index];
+        entry->compression_method = table->compression_method[index];
+        entry->filename_size = table->filename_size[index];
+        entry->crc = table->crc[index];
+        entry->external_fa = table->external_fa[index];
+        entry->compressed_size = table->compressed_size[index];
+        entry->uncompressed_size = table->uncompressed_size[index];
+        entry->modified_date = table->modified_date[index];
+        entry->accessed_date = table->accessed_date[index];
+        entry->creation_date = table->creation_date[index];
+        entry->disk_offset = table->disk_offset[index];
+        entry->disk_number = table->disk_number[index];
+        entry->internal_fa = table->internal_fa[index];
+        entry->aes_version = table->aes_version[index];
+        entry->filename = table->pool + table->filename_pos[index];
+    }
+
+    return count;
+}
+
+int32_t mz_zip_get_path_flags(void *handle, uint32_t *flags)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL || flags == NULL)
+        return MZ_PARAM_ERROR;
+    if (zip->path_flags == NULL)
+        return MZ_EXIST_ERROR;
+    *flags = zip->path_flags_all;
     return MZ_OK;
 }
 
-int32_t mz_zip_entry_close(void *handle)
+int32_t mz_zip_get_entry_path_at(void *handle, uint64_t index, const char **path, uint32_t *flags)
 {
-    return mz_zip_entry_close_raw(handle, UINT64_MAX, 0);
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+    if (zip->path_flags == NULL)
+        return MZ_EXIST_ERROR;
+    if (index >= zip->table.count)
+        return MZ_END_OF_LIST;
+    if (path != NULL)
+        *path = zip->path_pool + zip->path_pos[index];
+    if (flags != NULL)
+        *flags = zip->path_flags[index];
+    return MZ_OK;
 }
 
-int32_t mz_zip_entry_close_raw(void *handle, int64_t uncompressed_size, uint32_t crc32)
+int32_t mz_zip_entry_get_path_flags(void *handle, uint32_t *flags)
 {
     mz_zip *zip = (mz_zip *)handle;
+    uint64_t index = 0;
     int32_t err = MZ_OK;
 
-    if (zip == NULL || mz_zip_entry_is_open(handle) != MZ_OK)
+    if (zip == NULL || flags == NULL)
         return MZ_PARAM_ERROR;
+    if (zip->path_flags == NULL)
+        return MZ_EXIST_ERROR;
 
-    if (zip->open_mode & MZ_OPEN_MODE_WRITE)
-        err = mz_zip_entry_write_close(handle, crc32, UINT64_MAX, uncompressed_size);
-    else
-        err = mz_zip_entry_read_close(handle, NULL, NULL, NULL);
-
+    err = mz_zip_entry_get_index(handle, &index);
+    if (err == MZ_OK)
+        *flags = zip->path_flags[index];
     return err;
 }
 
-static int32_t mz_zip_goto_next_entry_int(void *handle)
+int32_t mz_zip_locate_first_prefix(void *handle, const char *prefix, uint8_t ignore_case)
 {
     mz_zip *zip = (mz_zip *)handle;
     int32_t err = MZ_OK;
 
-    if (zip == NULL)
+    if (zip == NULL || prefix == NULL)
         return MZ_PARAM_ERROR;
 
-    zip->entry_scanned = 0;
-
-    mz_stream_set_prop_int64(zip->cd_stream, MZ_STREAM_PROP_DISK_NUMBER, -1);
-
-    err = mz_stream_seek(zip->cd_stream, zip->cd_current_pos, MZ_SEEK_SET);
+    err = mz_zip_index_query(handle, prefix, ignore_case, 0);
     if (err == MZ_OK)
-        err = mz_zip_entry_read_header(zip->cd_stream, 0, &zip->file_info, zip->file_info_stream);
-    if (err == MZ_OK)
-        zip->entry_scanned = 1;
+        err = mz_zip_locate_next_prefix(handle);
     return err;
 }
 
-int32_t mz_zip_set_number_entry(void *handle, uint64_t number_entry)
+int32_t mz_zip_locate_first_child(void *handle, const char *dir, uint8_t ignore_case)
 {
     mz_zip *zip = (mz_zip *)handle;
-    if (zip == NULL)
-        return MZ_PARAM_ERROR;
-    zip->number_entry = number_entry;
-    return MZ_OK;
-}
+    int32_t err = MZ_OK;
 
-int32_t mz_zip_get_number_entry(void *handle, uint64_t *number_entry)
-{
-    mz_zip *zip = (mz_zip *)handle;
-    if (zip == NULL || number_entry == NULL)
+    if (zip == NULL || dir == NULL)
         return MZ_PARAM_ERROR;
-    *number_entry = zip->number_entry;
-    return MZ_OK;
+
+    err = mz_zip_index_query(handle, dir, ignore_case, 1);
+    if (err == MZ_OK)
+        err = mz_zip_locate_next_prefix(handle);
+    return err;
 }
 
-int32_t mz_zip_set_disk_number_with_cd(void *handle, uint32_t disk_number_with_cd)
+int32_t mz_zip_locate_next_prefix(void *handle)
 {
     mz_zip *zip = (mz_zip *)handle;
+    int32_t err = MZ_OK;
+
     if (zip == NULL)
         return MZ_PARAM_ERROR;
-    zip->disk_number_with_cd = disk_number_with_cd;
-    return MZ_OK;
+    if (zip->query_pos >= zip->query_count)
+        return MZ_END_OF_LIST;
+
+    err = mz_zip_goto_entry(handle, zip->table.cd_pos[zip->query[zip->query_pos]]);
+    zip->query_pos += 1;
+    return err;
 }
 
-int32_t mz_zip_get_disk_number_with_cd(void *handle, uint32_t *disk_number_with_cd)
+int32_t mz_zip_get_child_name(void *handle, const char **name, int32_t *name_size)
 {
     mz_zip *zip = (mz_zip *)handle;
-    if (zip == NULL || disk_number_with_cd == NULL)
+    const char *filename = NULL;
+    int32_t size = 0;
+
+    if (zip == NULL || name == NULL || name_size == NULL)
         return MZ_PARAM_ERROR;
-    *disk_number_with_cd = zip->disk_number_with_cd;
+    if (!zip->query_children || zip->query_pos == 0)
+        return MZ_EXIST_ERROR;
+
+    /* Child name ends after the first slash below the directory */
+    filename = zip->table.pool + zip->table.filename_pos[zip->query[zip->query_pos - 1]];
+    for (size = zip->query_dir_len; filename[size] != 0; size += 1)
+    {
+        if (filename[size] == '/' || filename[size] == '\\')
+        {
+            size += 1;
+            break;
+        }
+    }
+
+    *name = filename;
+    *name_size = size;
     return MZ_OK;
 }
 
-int64_t mz_zip_get_entry(void *handle)
+/***************************************************************************/
+
+/* Index files start with a fixed size header followed by blocks, each padded to 8 bytes:
+   the archive comment, one block for each entry table column in central dir order, the
+   filename pool, the folded key pool, the hash, key pos and cd pos of each slot of the case
+   sensitive and then the case insensitive hash table, and the entry order sorted by filename
+   when the prefix index was built. All values are little-endian and columns hold fixed size
+   values so each block is aligned and is read with a single read. */
+
+static int32_t mz_zip_index_block_write(void *stream, const void *buf, int64_t size)
 {
-    mz_zip *zip = (mz_zip *)handle;
+    uint8_t pad[8];
+    int32_t pad_size = (int32_t)((8 - (size & 7)) & 7);
 
-    if (zip == NULL)
+    if ((size < 0) || (size > INT32_MAX))
         return MZ_PARAM_ERROR;
 
-    return zip->cd_current_pos;
+    memset(pad, 0, sizeof(pad));
+    if ((size > 0) && (mz_stream_write(stream, buf, (int32_t)size) != (int32_t)size))
+        return MZ_WRITE_ERROR;
+    if ((pad_size > 0) && (mz_stream_write(stream, pad, pad_size) != pad_size))
+        return MZ_WRITE_ERROR;
+    return MZ_OK;
 }
 
-int32_t mz_zip_goto_entry(void *handle, int64_t cd_pos)
+static int32_t mz_zip_index_block_read(void *stream, void *buf, int64_t size)
 {
-    mz_zip *zip = (mz_zip *)handle;
+    uint8_t pad[8];
+    int32_t pad_size = (int32_t)((8 - (size & 7)) & 7);
 
-    if (zip == NULL)
-        return MZ_PARAM_ERROR;
+    if ((size < 0) || (size > INT32_MAX))
+        return MZ_FORMAT_ERROR;
 
-    if (cd_pos < zip->cd_start_pos || cd_pos > zip->cd_start_pos + zip->cd_size)
-        return MZ_PARAM_ERROR;
+    if ((size > 0) && (mz_stream_read(stream, buf, (int32_t)size) != (int32_t)size))
+        return MZ_READ_ERROR;
+    if ((pad_size > 0) && (mz_stream_read(stream, pad, pad_size) != pad_size))
+        return MZ_READ_ERROR;
+    return MZ_OK;
+}
 
-    zip->cd_current_pos = cd_pos;
+/* Columns with 64-bit values, including time_t of any size, are stored first */
+#define MZ_ZIP_INDEX_COLUMNS_64         (7)
 
-    return mz_zip_goto_next_entry_int(handle);
+static int32_t mz_zip_index_columns(mz_zip_table *table, void **columns, size_t *sizes)
+{
+    void *table_columns[] = {
+        table->cd_pos, table->disk_offset, table->compressed_size,
+        table->uncompressed_size, table->modified_date, table->accessed_date,
+        table->creation_date, table->crc, table->disk_number,
+        table->external_fa, table->filename_pos, table->filename_size,
+        table->version_madeby, table->version_needed, table->flag,
+        table->compression_method, table->internal_fa, table->aes_version,
+        table->aes_encryption_mode };
+    size_t table_sizes[] = {
+        sizeof(int64_t), sizeof(int64_t), sizeof(int64_t),
+        sizeof(int64_t), sizeof(time_t), sizeof(time_t),
+        sizeof(time_t), sizeof(uint32_t), sizeof(uint32_t),
+        sizeof(uint32_t), sizeof(uint32_t), sizeof(uint16_t),
+        sizeof(uint16_t), sizeof(uint16_t), sizeof(uint16_t),
+        sizeof(uint16_t), sizeof(uint16_t), sizeof(uint16_t),
+        sizeof(uint8_t) };
+    int32_t count = (int32_t)(sizeof(table_columns) / sizeof(table_columns[0]));
+
+    memcpy(columns, table_columns, sizeof(table_columns));
+    memcpy(sizes, table_sizes, sizeof(table_sizes));
+    return count;
 }
 
-int32_t mz_zip_goto_first_entry(void *handle)
+static void mz_zip_index_column_encode(uint8_t *buf, const void *column, size_t size, int32_t width, uint64_t count)
 {
-    mz_zip *zip = (mz_zip *)handle;
+    uint64_t value = 0;
+    uint64_t i = 0;
 
-    if (zip == NULL)
-        return MZ_PARAM_ERROR;
+    for (i = 0; i < count; i += 1)
+    {
+        if (size == 1)
+            value = ((const uint8_t *)column)[i];
+        else if (size == 2)
+            value = ((const uint16_t *)column)[i];
+        else if (size == 4 && width == 8)
+            value = (uint64_t)(int64_t)((const int32_t *)column)[i];
+        else if (size == 4)
+            value = ((const uint32_t *)column)[i];
+        else
+            value = ((const uint64_t *)column)[i];
+        mz_zip_buffer_put(buf + i * width, value, width);
+    }
+}
 
-    zip->cd_current_pos = zip->cd_start_pos;
+static void mz_zip_index_column_decode(const uint8_t *buf, void *column, size_t size, int32_t width, uint64_t count)
+{
+    uint64_t value = 0;
+    uint64_t i = 0;
 
-    return mz_zip_goto_next_entry_int(handle);
+    for (i = 0; i < count; i += 1)
+    {
+        value = mz_zip_buffer_value(buf + i * width, width);
+        if (size == 1)
+            ((uint8_t *)column)[i] = (uint8_t)value;
+        else if (size == 2)
+            ((uint16_t *)column)[i] = (uint16_t)value;
+        else if (size == 4 && width == 8)
+            ((int32_t *)column)[i] = (int32_t)(int64_t)value;
+        else if (size == 4)
+            ((uint32_t *)column)[i] = (uint32_t)value;
+        else
+            ((uint64_t *)column)[i] = value;
+    }
 }
 
-int32_t mz_zip_goto_next_entry(void *handle)
+int32_t mz_zip_index_load(void *handle, void *stream, int64_t archive_time)
 {
     mz_zip *zip = (mz_zip *)handle;
+    mz_zip_table *table = &zip->table;
+    mz_zip_index_slot *slots = NULL;
+    void *columns[32];
+    size_t sizes[32];
+    uint8_t header[MZ_ZIP_INDEX_HEADER_SIZE];
+    uint8_t *buf = NULL;
+    uint64_t number_entry = 0;
+    uint64_t used_count = 0;
+    uint64_t i = 0;
+    int64_t cd_offset = 0;
+    int64_t cd_size = 0;
+    int64_t cd_start_pos = 0;
+    int64_t disk_offset_shift = 0;
+    uint32_t disk_number_with_cd = 0;
+    uint32_t entry_count = 0;
+    uint32_t slot_count = 0;
+    uint32_t pool_size = 0;
+    uint32_t keys_size = 0;
+    uint32_t key_size = 0;
+    uint16_t version_madeby = 0;
+    uint16_t comment_size = 0;
+    uint16_t flags = 0;
+    int32_t column_count = 0;
+    int32_t table_index = 0;
+    int32_t width = 0;
+    int32_t err = MZ_OK;
 
-    if (zip == NULL)
+
+    if (zip == NULL || stream == NULL)
+        return MZ_PARAM_ERROR;
+    /* Index must be loaded before the zip file is opened */
+    if (zip->stream != NULL)
         return MZ_PARAM_ERROR;
 
-    zip->cd_current_pos += (int64_t)MZ_ZIP_SIZE_CD_ITEM + zip->file_info.filename_size +
-        zip->file_info.extrafield_size + zip->file_info.comment_size;
+    mz_zip_index_delete(handle);
 
-    return mz_zip_goto_next_entry_int(handle);
-}
+    if (mz_stream_read(stream, header, sizeof(header)) != (int32_t)sizeof(header))
+        err = MZ_READ_ERROR;
+    if ((err == MZ_OK) && (mz_zip_buffer_value(header, 4) != MZ_ZIP_MAGIC_INDEX))
+        err = MZ_FORMAT_ERROR;
+    if ((err == MZ_OK) && (mz_zip_buffer_value(header + 4, 2) != MZ_ZIP_INDEX_VERSION))
+        err = MZ_VERSION_ERROR;
+    /* Archive modified time, size and end of the archive identify the archive */
+    if ((err == MZ_OK) && ((int64_t)mz_zip_buffer_value(header + 8, 8) != archive_time))
+        err = MZ_EXIST_ERROR;
+    if (err == MZ_OK)
+    {
+        flags = (uint16_t)mz_zip_buffer_value(header + 6, 2);
+        zip->index_archive_size = (int64_t)mz_zip_buffer_value(header + 16, 8);
+        zip->index_tail_size = (int32_t)mz_zip_buffer_value(header + 24, 4);
+        zip->index_tail_crc = (uint32_t)mz_zip_buffer_value(header + 28, 4);
+        /* Central dir location as read from the end of central dir records */
+        disk_number_with_cd = (uint32_t)mz_zip_buffer_value(header + 32, 4);
+        comment_size = (uint16_t)mz_zip_buffer_value(header + 36, 2);
+        version_madeby = (uint16_t)mz_zip_buffer_value(header + 38, 2);
+        cd_offset = (int64_t)mz_zip_buffer_value(header + 40, 8);
+        cd_size = (int64_t)mz_zip_buffer_value(header + 48, 8);
+        cd_start_pos = (int64_t)mz_zip_buffer_value(header + 56, 8);
+        disk_offset_shift = (int64_t)mz_zip_buffer_value(header + 64, 8);
+        number_entry = mz_zip_buffer_value(header + 72, 8);
+        entry_count = (uint32_t)mz_zip_buffer_value(header + 80, 4);
+        slot_count = (uint32_t)mz_zip_buffer_value(header + 84, 4);
+        pool_size = (uint32_t)mz_zip_buffer_value(header + 88, 4);
+        keys_size = (uint32_t)mz_zip_buffer_value(header + 92, 4);
+    }
 
-int32_t mz_zip_locate_entry(void *handle, const char *filename, uint8_t ignore_case)
-{
-    mz_zip *zip = (mz_zip *)handle;
-    int32_t err = MZ_OK;
-    int32_t result = 0;
+    /* Don't trust any value that doesn't fit the central dir */
+    if ((err == MZ_OK) && ((disk_number_with_cd != 0) || (cd_offset < 0) || (cd_size <= 0) ||
+        (cd_size > INT32_MAX) || (zip->index_archive_size < 0) ||
+        (cd_offset > zip->index_archive_size - cd_size) || ((cd_start_pos != 0) && (cd_start_pos != cd_offset)) ||
+        (zip->index_tail_size <= 0) || (zip->index_tail_size > MZ_ZIP_INDEX_TAIL_SIZE) ||
+        (zip->index_tail_size > zip->index_archive_size)))
+        err = MZ_FORMAT_ERROR;
+    if ((err == MZ_OK) && ((entry_count > (uint64_t)cd_size / MZ_ZIP_SIZE_CD_ITEM) ||
+        (pool_size < entry_count) || ((uint64_t)pool_size > (uint64_t)cd_size + entry_count) ||
+        ((uint64_t)keys_size > (uint64_t)pool_size + entry_count) ||
+        (slot_count != mz_zip_index_slot_count(entry_count))))
+        err = MZ_FORMAT_ERROR;
 
-    if (zip == NULL || filename == NULL)
-        return MZ_PARAM_ERROR;
+    if ((err == MZ_OK) && (comment_size > 0))
+    {
+        zip->comment = (char *)MZ_ALLOC(comment_size + 1);
+        if (zip->comment == NULL)
+            err = MZ_MEM_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_index_block_read(stream, zip->comment, comment_size);
+        if (err == MZ_OK)
+            zip->comment[comment_size] = 0;
+    }
 
-    /* If we are already on the current entry, no need to search */
-    if ((zip->entry_scanned) && (zip->file_info.filename != NULL))
+    /* Scratch buffer is large enough for the largest block of fixed size values */
+    if (err == MZ_OK)
     {
-        result = mz_zip_path_compare(zip->file_info.filename, filename, ignore_case);
-        if (result == 0)
-            return MZ_OK;
+        buf = (uint8_t *)MZ_ALLOC((size_t)slot_count * sizeof(int64_t));
+        if (buf == NULL)
+            err = MZ_MEM_ERROR;
     }
 
-    /* Search all entries starting at the first */
-    err = mz_zip_goto_first_entry(handle);
-    while (err == MZ_OK)
+    if (err == MZ_OK)
+        err = mz_zip_table_grow(table, (uint64_t)entry_count + 1);
+    if (err == MZ_OK)
+        column_count = mz_zip_index_columns(table, columns, sizes);
+    for (i = 0; (err == MZ_OK) && (i < (uint64_t)column_count); i += 1)
     {
-        result = mz_zip_path_compare(zip->file_info.filename, filename, ignore_case);
-        if (result == 0)
-            return MZ_OK;
+        width = (i < MZ_ZIP_INDEX_COLUMNS_64) ? 8 : (int32_t)sizes[i];
+        err = mz_zip_index_block_read(stream, buf, (int64_t)entry_count * width);
+        if (err == MZ_OK)
+            mz_zip_index_column_decode(buf, columns[i], sizes[i], width, entry_count);
+    }
+    if (err == MZ_OK)
+        table->count = entry_count;
+    for (i = 0; (err == MZ_OK) && (i < entry_count); i += 1)
+    {
+        if ((table->cd_pos[i] < cd_start_pos) || (table->cd_pos[i] > cd_start_pos + cd_size - MZ_ZIP_SIZE_CD_ITEM) ||
+            ((uint64_t)table->filename_pos[i] + table->filename_size[i] >= pool_size))
+            err = MZ_FORMAT_ERROR;
+    }
 
-        err = mz_zip_goto_next_entry(handle);
+    if (err == MZ_OK)
+    {
+        table->pool = (char *)MZ_ALLOC(pool_size + 1);
+        if (table->pool == NULL)
+            err = MZ_MEM_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_index_block_read(stream, table->pool, pool_size);
+        table->pool_size = pool_size;
+        table->pool_capacity = pool_size + 1;
+    }
+    for (i = 0; (err == MZ_OK) && (i < entry_count); i += 1)
+    {
+        if (table->pool[table->filename_pos[i] + table->filename_size[i]] != 0)
+            err = MZ_FORMAT_ERROR;
+    }
+
+    if (err == MZ_OK)
+    {
+        zip->index_keys = (uint8_t *)MZ_ALLOC(keys_size + 1);
+        if (zip->index_keys == NULL)
+            err = MZ_MEM_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_index_block_read(stream, zip->index_keys, keys_size);
+        zip->index_keys_size = keys_size;
+        zip->index_keys_capacity = keys_size + 1;
+    }
+
+    if (err == MZ_OK)
+    {
+        zip->index_case = (mz_zip_index_slot *)MZ_ALLOC((size_t)slot_count * sizeof(mz_zip_index_slot));
+        zip->index_nocase = (mz_zip_index_slot *)MZ_ALLOC((size_t)slot_count * sizeof(mz_zip_index_slot));
+        if (zip->index_case == NULL || zip->index_nocase == NULL)
+            err = MZ_MEM_ERROR;
+    }
+    for (table_index = 0; (err == MZ_OK) && (table_index < 2); table_index += 1)
+    {
+        slots = (table_index == 0) ? zip->index_case : zip->index_nocase;
+        used_count = 0;
+
+        err = mz_zip_index_block_read(stream, buf, (int64_t)slot_count * 4);
+        for (i = 0; (err == MZ_OK) && (i < slot_count); i += 1)
+            slots[i].hash = (uint32_t)mz_zip_buffer_value(buf + i * 4, 4);
+        if (err == MZ_OK)
+            err = mz_zip_index_block_read(stream, buf, (int64_t)slot_count * 4);
+        for (i = 0; (err == MZ_OK) && (i < slot_count); i += 1)
+            slots[i].key_pos = (uint32_t)mz_zip_buffer_value(buf + i * 4, 4);
+        if (err == MZ_OK)
+            err = mz_zip_index_block_read(stream, buf, (int64_t)slot_count * 8);
+        for (i = 0; (err == MZ_OK) && (i < slot_count); i += 1)
+            slots[i].cd_pos = (int64_t)mz_zip_buffer_value(buf + i * 8, 8);
+
+        for (i = 0; (err == MZ_OK) && (i < slot_count); i += 1)
+        {
+            if (slots[i].cd_pos >= 0)
+            {
+                used_count += 1;
+                if ((slots[i].cd_pos < cd_start_pos) || (slots[i].cd_pos > cd_start_pos + cd_size - MZ_ZIP_SIZE_CD_ITEM))
+                    err = MZ_FORMAT_ERROR;
+                /* Folded filename must be entirely within the key pool */
+                if ((uint64_t)slots[i].key_pos + 2 > keys_size)
+                    err = MZ_FORMAT_ERROR;
+                if (err == MZ_OK)
+                {
+                    key_size = zip->index_keys[slots[i].key_pos] | (zip->index_keys[slots[i].key_pos + 1] << 8);
+                    if ((uint64_t)slots[i].key_pos + 2 + key_size > keys_size)
+                        err = MZ_FORMAT_ERROR;
+                }
+            }
+            else if (slots[i].cd_pos != -1)
+                err = MZ_FORMAT_ERROR;
+        }
+
+        /* Lookups stop at empty slots so there must be some */
+        if ((err == MZ_OK) && (used_count > entry_count))
+            err = MZ_FORMAT_ERROR;
+    }
+
+    /* Filename order saved with the prefix index saves sorting again */
+    if ((err == MZ_OK) && (flags & MZ_ZIP_INDEX_FLAG_SORTED))
+    {
+        zip->index_sorted = (uint32_t *)MZ_ALLOC(((size_t)entry_count + 1) * sizeof(uint32_t));
+        if (zip->index_sorted == NULL)
+            err = MZ_MEM_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_index_block_read(stream, buf, (int64_t)entry_count * 4);
+        for (i = 0; (err == MZ_OK) && (i < entry_count); i += 1)
+        {
+            zip->index_sorted[i] = (uint32_t)mz_zip_buffer_value(buf + i * 4, 4);
+            if (zip->index_sorted[i] >= entry_count)
+                err = MZ_FORMAT_ERROR;
+        }
+    }
+
+    if (buf != NULL)
+        MZ_FREE(buf);
+
+    if (err == MZ_OK)
+    {
+        zip->index_mask = slot_count - 1;
+        zip->index_loaded = 1;
+        zip->index_cd_start_pos = cd_start_pos;
+        zip->index = 1;
+        zip->entry_table = 1;
+        if (zip->index_sorted != NULL)
+            zip->prefix_index = 1;
+
+        zip->disk_number_with_cd = disk_number_with_cd;
+        zip->disk_offset_shift = disk_offset_shift;
+        zip->cd_offset = cd_offset;
+        zip->cd_size = cd_size;
+        zip->number_entry = number_entry;
+        zip->version_madeby = version_madeby;
+    }
+    else
+    {
+        mz_zip_index_delete(handle);
+        if (zip->comment != NULL)
+            MZ_FREE(zip->comment);
+        zip->comment = NULL;
     }
 
+    mz_zip_print("Zip - Index - Load (entries %" PRIu32 " slots %" PRIu32 " err %" PRId32 ")\n",
+        entry_count, slot_count, err);
+
     return err;
 }
 
-int32_t mz_zip_locate_first_entry(void *handle, void *userdata, mz_zip_locate_entry_cb cb)
+int32_t mz_zip_index_save(void *handle, void *stream, int64_t archive_time)
 {
     mz_zip *zip = (mz_zip *)handle;
+    mz_zip_table *table = &zip->table;
+    mz_zip_index_slot *slots = NULL;
+    void *columns[32];
+    size_t sizes[32];
+    uint8_t header[MZ_ZIP_INDEX_HEADER_SIZE];
+    uint8_t *buf = NULL;
+    uint64_t slot_count = 0;
+    uint64_t i = 0;
+    int64_t archive_size = 0;
+    int32_t tail_size = 0;
+    uint32_t tail_crc = 0;
+    uint16_t comment_size = 0;
+    int32_t column_count = 0;
+    int32_t table_index = 0;
+    int32_t width = 0;
     int32_t err = MZ_OK;
-    int32_t result = 0;
 
-    /* Search first entry looking for match */
-    err = mz_zip_goto_first_entry(handle);
+
+    if (zip == NULL || stream == NULL)
+        return MZ_PARAM_ERROR;
+    if ((zip->open_mode == 0) || (zip->open_mode & MZ_OPEN_MODE_WRITE))
+        return MZ_PARAM_ERROR;
+    /* Index can only be used later for single disk archives with a central dir */
+    if ((zip->disk_number_with_cd != 0) || (zip->cd_size <= 0))
+        return MZ_SUPPORT_ERROR;
+
+    zip->index = 1;
+    zip->entry_table = 1;
+
+    err = mz_zip_index_update(handle);
+    if ((err == MZ_OK) && (zip->index_case == NULL || table->cd_pos == NULL))
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = mz_stream_seek(zip->stream, 0, MZ_SEEK_END);
+    if (err == MZ_OK)
+    {
+        archive_size = mz_stream_tell(zip->stream);
+        tail_size = MZ_ZIP_INDEX_TAIL_SIZE;
+        if (tail_size > archive_size)
+            tail_size = (int32_t)archive_size;
+        err = mz_zip_index_tail_crc(handle, archive_size, tail_size, &tail_crc);
+    }
     if (err != MZ_OK)
         return err;
 
-    result = cb(handle, userdata, &zip->file_info);
-    if (result == 0)
-        return MZ_OK;
+    slot_count = (uint64_t)zip->index_mask + 1;
+    if (zip->comment != NULL)
+        comment_size = (uint16_t)strlen(zip->comment);
+
+    memset(header, 0, sizeof(header));
+    mz_zip_buffer_put(header, MZ_ZIP_MAGIC_INDEX, 4);
+    mz_zip_buffer_put(header + 4, MZ_ZIP_INDEX_VERSION, 2);
+    mz_zip_buffer_put(header + 6, (zip->index_sorted != NULL) ? MZ_ZIP_INDEX_FLAG_SORTED : 0, 2);
+    mz_zip_buffer_put(header + 8, (uint64_t)archive_time, 8);
+    mz_zip_buffer_put(header + 16, (uint64_t)archive_size, 8);
+    mz_zip_buffer_put(header + 24, (uint64_t)tail_size, 4);
+    mz_zip_buffer_put(header + 28, tail_crc, 4);
+    mz_zip_buffer_put(header + 32, zip->disk_number_with_cd, 4);
+    mz_zip_buffer_put(header + 36, comment_size, 2);
+    mz_zip_buffer_put(header + 38, zip->version_madeby, 2);
+    mz_zip_buffer_put(header + 40, (uint64_t)zip->cd_offset, 8);
+    mz_zip_buffer_put(header + 48, (uint64_t)zip->cd_size, 8);
+    mz_zip_buffer_put(header + 56, (uint64_t)zip->cd_start_pos, 8);
+    mz_zip_buffer_put(header + 64, (uint64_t)zip->disk_offset_shift, 8);
+    mz_zip_buffer_put(header + 72, zip->number_entry, 8);
+    mz_zip_buffer_put(header + 80, table->count, 4);
+    mz_zip_buffer_put(header + 84, slot_count, 4);
+    mz_zip_buffer_put(header + 88, table->pool_size, 4);
+    mz_zip_buffer_put(header + 92, zip->index_keys_size, 4);
+
+    err = mz_zip_index_block_write(stream, header, sizeof(header));
+    if (err == MZ_OK)
+        err = mz_zip_index_block_write(stream, zip->comment, comment_size);
 
-    return mz_zip_locate_next_entry(handle, userdata, cb);
-}
+    if (err == MZ_OK)
+    {
+        buf = (uint8_t *)MZ_ALLOC((size_t)slot_count * sizeof(int64_t));
+        if (buf == NULL)
+            err = MZ_MEM_ERROR;
+    }
 
-int32_t mz_zip_locate_next_entry(void *handle, void *userdata, mz_zip_locate_entry_cb cb)
-{
-    mz_zip *zip = (mz_zip *)handle;
-    int32_t err = MZ_OK;
-    int32_t result = 0;
+    column_count = mz_zip_index_columns(table, columns, sizes);
+    for (i = 0; (err == MZ_OK) && (i < (uint64_t)column_count); i += 1)
+    {
+        width = (i < MZ_ZIP_INDEX_COLUMNS_64) ? 8 : (int32_t)sizes[i];
+        mz_zip_index_column_encode(buf, columns[i], sizes[i], width, table->count);
+        err = mz_zip_index_block_write(stream, buf, (int64_t)table->count * width);
+    }
 
-    /* Search next entries looking for match */
-    err = mz_zip_goto_next_entry(handle);
-    while (err == MZ_OK)
+    if (err == MZ_OK)
+        err = mz_zip_index_block_write(stream, table->pool, table->pool_size);
+    if (err == MZ_OK)
+        err = mz_zip_index_block_write(stream, zip->index_keys, zip->index_keys_size);
+
+    /* Hash tables are stored as is so they don't need to be rebuilt */
+    for (table_index = 0; (err == MZ_OK) && (table_index < 2); table_index += 1)
     {
-        result = cb(handle, userdata, &zip->file_info);
-        if (result == 0)
-            return MZ_OK;
+        slots = (table_index == 0) ? zip->index_case : zip->index_nocase;
 
-        err = mz_zip_goto_next_entry(handle);
+        for (i = 0; i < slot_count; i += 1)
+            mz_zip_buffer_put(buf + i * 4, slots[i].hash, 4);
+        err = mz_zip_index_block_write(stream, buf, (int64_t)slot_count * 4);
+        for (i = 0; i < slot_count; i += 1)
+            mz_zip_buffer_put(buf + i * 4, slots[i].key_pos, 4);
+        if (err == MZ_OK)
+            err = mz_zip_index_block_write(stream, buf, (int64_t)slot_count * 4);
+        for (i = 0; i < slot_count; i += 1)
+            mz_zip_buffer_put(buf + i * 8, (uint64_t)slots[i].cd_pos, 8);
+        if (err == MZ_OK)
+            err = mz_zip_index_block_write(stream, buf, (int64_t)slot_count * 8);
+    }
+
+    if ((err == MZ_OK) && (zip->index_sorted != NULL))
+    {
+        for (i = 0; i < table->count; i += 1)
+            mz_zip_buffer_put(buf + i * 4, zip->index_sorted[i], 4);
+        err = mz_zip_index_block_write(stream, buf, (int64_t)table->count * 4);
     }
 
+    if (buf != NULL)
+        MZ_FREE(buf);
+
+    mz_zip_print("Zip - Index - Save (entries %" PRIu64 " slots %" PRIu64 " err %" PRId32 ")\n",
+        table->count, slot_count, err);
+
     return err;
 }
 
+int32_t mz_zip_index_is_loaded(void *handle)
+{
+    mz_zip *zip = (mz_zip *)handle;
+    if (zip == NULL)
+        return MZ_PARAM_ERROR;
+    if (!zip->index_loaded)
+        return MZ_EXIST_ERROR;
+    return MZ_OK;
+}
+
 /***************************************************************************/
 
 int32_t mz_zip_attrib_is_dir(uint32_t attrib, uint16_t version_madeby)
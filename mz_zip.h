@@ -54,6 +54,27 @@ typedef struct mz_zip_file_s
 
 } mz_zip_file, mz_zip_entry;
 
+typedef struct mz_zip_file_lite_s
+{
+    uint16_t version_madeby;            /* version made by */
+    uint16_t flag;                      /* general purpose bit flag */
+    uint16_t compression_method;        /* compression method */
+    uint16_t filename_size;             /* filename length */
+    uint32_t crc;                       /* crc-32 */
+    uint32_t external_fa;               /* external file attributes */
+    int64_t  compressed_size;           /* compressed size */
+    int64_t  uncompressed_size;         /* uncompressed size */
+    time_t   modified_date;             /* last modified date in unix time */
+    time_t   accessed_date;             /* last accessed date in unix time */
+    time_t   creation_date;             /* creation date in unix time */
+    int64_t  disk_offset;               /* relative offset of local header */
+    uint32_t disk_number;               /* disk number start */
+    uint16_t internal_fa;               /* internal file attributes */
+    uint16_t aes_version;               /* winzip aes extension if not 0 */
+
+    const char *filename;               /* filename utf8 null-terminated string */
+} mz_zip_file_lite;
+
 /***************************************************************************/
 
 typedef int32_t (*mz_zip_locate_entry_cb)(void *handle, void *userdata, mz_zip_file *file_info);
@@ -87,6 +108,24 @@ int32_t mz_zip_set_version_madeby(void *handle, uint16_t version_madeby);
 int32_t mz_zip_set_recover(void *handle, uint8_t recover);
 /* Set the ability to recover the central dir by reading local file headers */
 
+int32_t mz_zip_set_cd_mem_max(void *handle, int64_t cd_mem_max);
+/* Sets the max size of central dir to store in memory, larger ones are paged in as needed, 0 for no limit */
+
+int32_t mz_zip_set_index(void *handle, uint8_t index);
+/* Sets whether to build a filename index when reading the central dir for faster locating */
+
+int32_t mz_zip_set_entry_table(void *handle, uint8_t entry_table);
+/* Sets whether to build a packed table of entry info when reading the central dir */
+
+int32_t mz_zip_set_prefix_index(void *handle, uint8_t prefix_index);
+/* Sets whether to build a sorted filename index when reading the central dir for prefix queries */
+
+int32_t mz_zip_set_path_check(void *handle, uint8_t path_check);
+/* Sets whether to normalize entry paths and flag duplicates, case collisions and traversal when reading the central dir */
+
+int32_t mz_zip_set_compress_threads(void *handle, int32_t compress_threads);
+/* Sets the number of threads used to compress each entry, only deflate supports more than one */
+
 int32_t mz_zip_get_stream(void *handle, void **stream);
 /* Get a pointer to the stream used to open */
 
@@ -107,10 +146,25 @@ int32_t mz_zip_entry_read_open(void *handle, uint8_t raw, const char *password);
 int32_t mz_zip_entry_read(void *handle, void *buf, int32_t len);
 /* Read bytes from the current file in the zip file */
 
+int32_t mz_zip_entry_read_buffer(void *handle, void *buf, int32_t len);
+/* Decode the whole current file in one call into a buffer of its uncompressed size, the compressed
+   data is held in memory at once, returns MZ_SUPPORT_ERROR when the file has to be read instead */
+
+int32_t mz_zip_entry_read_copy(void *handle, void *stream, int32_t len);
+/* Copy bytes of the current file in the zip file to a stream without passing them through memory
+   when both streams are files that support it, only for entries opened raw or stored unencrypted,
+   returns MZ_SUPPORT_ERROR when the bytes have to be read instead */
+
 int32_t mz_zip_entry_read_close(void *handle, uint32_t *crc32, int64_t *compressed_size,
     int64_t *uncompressed_size);
 /* Close the current file for reading and get data descriptor values */
 
+int32_t mz_zip_entry_read_stream_open(void *handle, const mz_zip_file *file_info, uint8_t raw,
+    const char *password, void **stream);
+/* Open a stream for reading the file with its own position in the zip stream, several entry streams
+   can be read by different threads when the zip stream supports positional reads, closing the stream
+   verifies the crc and it is freed with mz_stream_delete */
+
 int32_t mz_zip_entry_write_open(void *handle, const mz_zip_file *file_info,
     int16_t compress_level, uint8_t raw, const char *password);
 /* Open for writing the current file in the zip file */
@@ -118,6 +172,11 @@ int32_t mz_zip_entry_write_open(void *handle, const mz_zip_file *file_info,
 int32_t mz_zip_entry_write(void *handle, const void *buf, int32_t len);
 /* Write bytes from the current file in the zip file */
 
+int32_t mz_zip_entry_copy(void *handle, void *source_handle, int32_t len);
+/* Copy bytes of the current file in the source zip file opened for reading into the current file
+   opened raw for writing, the crc and sizes of the source file are kept so the copied bytes are
+   not read back, returns MZ_SUPPORT_ERROR when the bytes have to be read and written */
+
 int32_t mz_zip_entry_write_close(void *handle, uint32_t crc32, int64_t compressed_size,
     int64_t uncompressed_size);
 /* Close the current file for writing and set data descriptor values */
@@ -178,6 +237,64 @@ int32_t mz_zip_locate_first_entry(void *handle, void *userdata, mz_zip_locate_en
 int32_t mz_zip_locate_next_entry(void *handle, void *userdata, mz_zip_locate_entry_cb cb);
 /* LOcate the next matching entry based on a match callback */
 
+int32_t mz_zip_entry_count(void *handle, uint64_t *count);
+/* Get the number of entries in the entry table or central dir if the table is not built */
+
+int32_t mz_zip_goto_entry_index(void *handle, uint64_t index);
+/* Go to the entry at the specified index in the central dir */
+
+int32_t mz_zip_entry_get_index(void *handle, uint64_t *index);
+/* Get the index of the current entry in the entry table, requires the entry table */
+
+int32_t mz_zip_get_entry_info_at(void *handle, uint64_t index, mz_zip_file *file_info);
+/* Get info about the entry at the specified index from the entry table without moving to it,
+   extra field and comment are not available */
+
+int32_t mz_zip_get_local_header_offset(void *handle, const mz_zip_file *file_info, int64_t *offset);
+/* Get the position of the local header of an entry in its disk, corrected for data
+   prepended to the zip the same way entries are opened */
+
+int32_t mz_zip_get_entries_info(void *handle, uint64_t first, int32_t count, mz_zip_file_lite *entries);
+/* Fills an array with info about count entries starting at the specified index from the entry table,
+   returns the number of entries filled or MZ_END_OF_LIST if first is past the last entry */
+
+int32_t mz_zip_get_path_flags(void *handle, uint32_t *flags);
+/* Get the path flags found in any entry, requires path check */
+
+int32_t mz_zip_get_entry_path_at(void *handle, uint64_t index, const char **path, uint32_t *flags);
+/* Get the normalized path and path flags of the entry at the specified index, requires path check */
+
+int32_t mz_zip_entry_get_path_flags(void *handle, uint32_t *flags);
+/* Get the path flags of the current entry, requires path check */
+
+int32_t mz_zip_locate_first_prefix(void *handle, const char *prefix, uint8_t ignore_case);
+/* Locate the first entry whose name begins with the prefix, requires the prefix index */
+
+int32_t mz_zip_locate_first_child(void *handle, const char *dir, uint8_t ignore_case);
+/* Locate the first child directly within the directory, requires the prefix index, each sub directory
+   is a single child even when it has no entry of its own */
+
+int32_t mz_zip_locate_next_prefix(void *handle);
+/* Locate the next entry found by the last prefix or child query or MZ_END_OF_LIST if none left */
+
+int32_t mz_zip_get_child_name(void *handle, const char **name, int32_t *name_size);
+/* Get the path of the child last located by a child query, sub directories end with a slash and
+   when the name is shorter than the current entry's filename the directory has no entry of its own
+   and the current entry is one below it */
+
+/***************************************************************************/
+
+int32_t mz_zip_index_load(void *handle, void *stream, int64_t archive_time);
+/* Loads a saved index to use instead of reading the central dir, must be called before opening,
+   the index is used if the archive time, size and last bytes of the archive still match */
+
+int32_t mz_zip_index_save(void *handle, void *stream, int64_t archive_time);
+/* Saves the filename index, entry table and prefix index order of the zip file opened for reading,
+   columns are stored aligned and are read back into memory rather than mapped */
+
+int32_t mz_zip_index_is_loaded(void *handle);
+/* Checks to see if the zip file was opened using a loaded index */
+
 /***************************************************************************/
 
 int32_t  mz_zip_attrib_is_dir(uint32_t attributes, uint16_t version_madeby);
@@ -15,9 +15,21 @@
 #include "mz_strm.h"
 #include "mz_strm_buf.h"
 #include "mz_strm_mem.h"
+#ifdef HAVE_MMAP
+#include "mz_strm_mmap.h"
+#endif
 #include "mz_strm_os.h"
+#ifdef HAVE_PTHREAD
+#include "mz_strm_readahead.h"
+#endif
 #include "mz_strm_split.h"
+#ifdef HAVE_URING
+#include "mz_strm_uring.h"
+#endif
 #include "mz_strm_wzaes.h"
+#ifdef HAVE_ZLIB
+#include "mz_strm_zlib.h"
+#endif
 #include "mz_zip.h"
 
 #include "mz_zip_rw.h"
@@ -25,6 +37,12 @@
 /***************************************************************************/
 
 #define MZ_DEFAULT_PROGRESS_INTERVAL    (1000u)
+#define MZ_PREFETCH_HEADER_SIZE         (30 + 1024)     /* local header with room for extra fields */
+#define MZ_KERNEL_COPY_SIZE             (8 * 1024 * 1024) /* max bytes per copy between files */
+#define MZ_PREALLOCATE_MAX_RATIO        (1032)          /* max expansion of a deflated entry */
+#ifndef MZ_ONESHOT_MAX_SIZE
+#define MZ_ONESHOT_MAX_SIZE             (1024 * 1024)   /* max buffer size coded in one call */
+#endif
 
 #define MZ_ZIP_CD_FILENAME              ("__cdcd__")
 
@@ -42,6 +60,9 @@ typedef struct mz_zip_reader_s {
     mz_zip_file *file_info;
     const char  *pattern;
     uint8_t     pattern_ignore_case;
+    uint8_t     pattern_indexed;
+    void        *pattern_wc;
+    void        *pattern_glob;
     const char  *password;
     void        *overwrite_userdata;
     mz_zip_reader_overwrite_cb
@@ -63,6 +84,17 @@ typedef struct mz_zip_reader_s {
     uint8_t     cd_verified;
     uint8_t     cd_zipped;
     uint8_t     entry_verified;
+    const char  *index_path;
+    int64_t     archive_time;
+    int64_t     cd_mem_max;
+    uint8_t     path_check;
+    uint8_t     mmap;
+    int32_t     prefetch;
+    uint8_t     file_uring;     /* file stream can be asked to prefetch */
+    int32_t     readahead;
+    void        *readahead_stream;
+    uint8_t     sequential;
+    uint8_t     preallocate;
 } mz_zip_reader;
 
 /***************************************************************************/
@@ -77,6 +109,58 @@ int32_t mz_zip_reader_is_open(void *handle)
     return MZ_OK;
 }
 
+static int32_t mz_zip_reader_index_load(void *handle)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+    void *file_stream = NULL;
+    void *buffered_stream = NULL;
+    int32_t err = MZ_OK;
+
+
+    mz_stream_os_create(&file_stream);
+    mz_stream_buffered_create(&buffered_stream);
+    mz_stream_set_base(buffered_stream, file_stream);
+
+    err = mz_stream_open(buffered_stream, reader->index_path, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK)
+    {
+        err = mz_zip_index_load(reader->zip_handle, buffered_stream, reader->archive_time);
+        mz_stream_close(buffered_stream);
+    }
+
+    mz_stream_buffered_delete(&buffered_stream);
+    mz_stream_os_delete(&file_stream);
+    return err;
+}
+
+static int32_t mz_zip_reader_index_save(void *handle)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+    void *file_stream = NULL;
+    void *buffered_stream = NULL;
+    int32_t err = MZ_OK;
+
+
+    mz_stream_os_create(&file_stream);
+    mz_stream_buffered_create(&buffered_stream);
+    mz_stream_set_base(buffered_stream, file_stream);
+
+    err = mz_stream_open(buffered_stream, reader->index_path, MZ_OPEN_MODE_WRITE | MZ_OPEN_MODE_CREATE);
+    if (err == MZ_OK)
+    {
+        err = mz_zip_index_save(reader->zip_handle, buffered_stream, reader->archive_time);
+        if (mz_stream_close(buffered_stream) != MZ_OK && err == MZ_OK)
+            err = MZ_CLOSE_ERROR;
+        /* Don't leave behind a partial index */
+        if (err != MZ_OK)
+            mz_os_unlink(reader->index_path);
+    }
+
+    mz_stream_buffered_delete(&buffered_stream);
+    mz_stream_os_delete(&file_stream);
+    return err;
+}
+
 int32_t mz_zip_reader_open(void *handle, void *stream)
 {
     mz_zip_reader *reader = (mz_zip_reader *)handle;
@@ -87,6 +171,15 @@ int32_t mz_zip_reader_open(void *handle, void *stream)
 
     mz_zip_create(&reader->zip_handle);
     mz_zip_set_recover(reader->zip_handle, 1);
+    mz_zip_set_cd_mem_max(reader->zip_handle, reader->cd_mem_max);
+    mz_zip_set_path_check(reader->zip_handle, reader->path_check != 0);
+    /* Entry table gives the offsets of the entries that follow the one being read */
+    if (reader->prefetch > 0)
+        mz_zip_set_entry_table(reader->zip_handle, 1);
+
+    /* Index file is optional, if it is missing or out of date the central dir is read */
+    if (reader->index_path != NULL)
+        mz_zip_reader_index_load(reader);
 
     err = mz_zip_open(reader->zip_handle, stream, MZ_OPEN_MODE_READ);
 
@@ -97,23 +190,73 @@ int32_t mz_zip_reader_open(void *handle, void *stream)
     }
 
     mz_zip_reader_unzip_cd(reader);
+
+    if ((reader->index_path != NULL) && (mz_zip_index_is_loaded(reader->zip_handle) != MZ_OK))
+        mz_zip_reader_index_save(reader);
     return MZ_OK;
 }
 
 int32_t mz_zip_reader_open_file(void *handle, const char *path)
 {
     mz_zip_reader *reader = (mz_zip_reader *)handle;
+    time_t modified_date = 0;
     int32_t err = MZ_OK;
 
 
     mz_zip_reader_close(handle);
 
-    mz_stream_os_create(&reader->file_stream);
-    mz_stream_buffered_create(&reader->buffered_stream);
+    /* Index file is only valid for the archive as last modified */
+    if ((reader->index_path != NULL) && (mz_os_get_file_date(path, &modified_date, NULL, NULL) == MZ_OK))
+        reader->archive_time = (int64_t)modified_date;
+
     mz_stream_split_create(&reader->split_stream);
 
-    mz_stream_set_base(reader->buffered_stream, reader->file_stream);
-    mz_stream_set_base(reader->split_stream, reader->buffered_stream);
+#ifdef HAVE_MMAP
+    if (reader->mmap)
+    {
+        /* Mapped reads are served from the page cache so no buffering is needed */
+        mz_stream_mmap_create(&reader->file_stream);
+        mz_stream_mmap_set_advice(reader->file_stream, MZ_STREAM_MMAP_ADVICE_SEQUENTIAL);
+        mz_stream_set_base(reader->split_stream, reader->file_stream);
+    }
+    else
+#endif
+#ifdef HAVE_PTHREAD
+    if (reader->readahead > 0)
+    {
+        /* Blocks read ahead on the helper thread already buffer the file */
+        mz_stream_os_create(&reader->file_stream);
+        if (reader->sequential)
+            mz_stream_os_set_advice(reader->file_stream, MZ_STREAM_OS_ADVICE_SEQUENTIAL | MZ_STREAM_OS_ADVICE_NOREUSE);
+        mz_stream_readahead_create(&reader->readahead_stream);
+        mz_stream_readahead_set_size(reader->readahead_stream, reader->readahead, MZ_STREAM_READAHEAD_BLOCK_SIZE);
+
+        mz_stream_set_base(reader->readahead_stream, reader->file_stream);
+        mz_stream_set_base(reader->split_stream, reader->readahead_stream);
+    }
+    else
+#endif
+#ifdef HAVE_URING
+    if (reader->prefetch > 0)
+    {
+        /* Ring keeps its own read ahead buffers so no buffering is needed */
+        mz_stream_uring_create(&reader->file_stream);
+        mz_stream_set_base(reader->split_stream, reader->file_stream);
+        reader->file_uring = 1;
+    }
+    else
+#endif
+    {
+        mz_stream_os_create(&reader->file_stream);
+        if (reader->sequential)
+            mz_stream_os_set_advice(reader->file_stream, MZ_STREAM_OS_ADVICE_SEQUENTIAL | MZ_STREAM_OS_ADVICE_NOREUSE);
+        mz_stream_buffered_create(&reader->buffered_stream);
+        /* Entries are mostly read start to end so let the read buffer grow */
+        mz_stream_set_prop_int64(reader->buffered_stream, MZ_STREAM_PROP_BUFFER_ADAPTIVE, 1);
+
+        mz_stream_set_base(reader->buffered_stream, reader->file_stream);
+        mz_stream_set_base(reader->split_stream, reader->buffered_stream);
+    }
 
     err = mz_stream_open(reader->split_stream, path, MZ_OPEN_MODE_READ);
     if (err == MZ_OK)
@@ -221,8 +364,12 @@ int32_t mz_zip_reader_close(void *handle)
     if (reader->buffered_stream != NULL)
         mz_stream_buffered_delete(&reader->buffered_stream);
 
+    if (reader->readahead_stream != NULL)
+        mz_stream_delete(&reader->readahead_stream);
+
     if (reader->file_stream != NULL)
-        mz_stream_os_delete(&reader->file_stream);
+        mz_stream_delete(&reader->file_stream);
+    reader->file_uring = 0;
 
     if (reader->mem_stream != NULL)
     {
@@ -230,6 +377,7 @@ int32_t mz_zip_reader_close(void *handle)
         mz_stream_mem_delete(&reader->mem_stream);
     }
 
+    reader->archive_time = 0;
     return err;
 }
 
@@ -242,7 +390,9 @@ int32_t mz_zip_reader_unzip_cd(void *handle)
     void *cd_mem_stream = NULL;
     void *new_cd_stream = NULL;
     void *file_extra_stream = NULL;
+    const void *cd_buf = NULL;
     uint64_t number_entry = 0;
+    int32_t cd_size = 0;
     int32_t err = MZ_OK;
 
 
@@ -272,14 +422,34 @@ int32_t mz_zip_reader_unzip_cd(void *handle)
     if (err != MZ_OK)
         return err;
 
-    mz_zip_get_cd_mem_stream(reader->zip_handle, &cd_mem_stream);
-    if (mz_stream_mem_is_open(cd_mem_stream) != MZ_OK)
-        mz_stream_mem_open(cd_mem_stream, NULL, MZ_OPEN_MODE_CREATE);
-
-    err = mz_stream_seek(cd_mem_stream, 0, MZ_SEEK_SET);
+    /* Central dir is decoded on its own since the active one may still be in the memory stream */
+    mz_stream_mem_create(&new_cd_stream);
+    mz_stream_mem_set_grow_size(new_cd_stream, (int32_t)cd_info->uncompressed_size);
+    err = mz_stream_mem_open(new_cd_stream, NULL, MZ_OPEN_MODE_CREATE);
     if (err == MZ_OK)
-        err = mz_stream_copy_stream(cd_mem_stream, NULL, handle, mz_zip_reader_entry_read,
+        err = mz_stream_copy_stream(new_cd_stream, NULL, handle, mz_zip_reader_entry_read,
             (int32_t)cd_info->uncompressed_size);
+    if (err == MZ_OK)
+    {
+        cd_size = (int32_t)mz_stream_mem_tell(new_cd_stream);
+        err = mz_stream_mem_get_buffer(new_cd_stream, &cd_buf);
+    }
+
+    /* Replace the contents of the memory stream, dropping any bytes past the decoded central dir */
+    if (err == MZ_OK)
+    {
+        mz_zip_get_cd_mem_stream(reader->zip_handle, &cd_mem_stream);
+        if (mz_stream_mem_is_open(cd_mem_stream) != MZ_OK)
+            mz_stream_mem_open(cd_mem_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+        err = mz_stream_mem_seek(cd_mem_stream, 0, MZ_SEEK_SET);
+    }
+    if (err == MZ_OK)
+    {
+        mz_stream_mem_set_buffer_limit(cd_mem_stream, 0);
+        if (mz_stream_mem_write(cd_mem_stream, cd_buf, cd_size) != cd_size)
+            err = MZ_WRITE_ERROR;
+    }
 
     if (err == MZ_OK)
     {
@@ -299,15 +469,90 @@ int32_t mz_zip_reader_unzip_cd(void *handle)
 
 /***************************************************************************/
 
+static int32_t mz_zip_reader_pattern_compile(void *handle)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+    int32_t flags = MZ_PATH_GLOB_WC;
+
+    if (reader->pattern_wc != NULL || reader->pattern == NULL)
+        return MZ_OK;
+    if (mz_path_glob_create(&reader->pattern_wc) == NULL)
+        return MZ_MEM_ERROR;
+
+    /* Pattern set with mz_zip_reader_set_pattern keeps the mz_path_compare_wc syntax */
+    if (reader->pattern_ignore_case)
+        flags |= MZ_PATH_GLOB_IGNORE_CASE;
+    return mz_path_glob_add(reader->pattern_wc, reader->pattern, flags);
+}
+
 static int32_t mz_zip_reader_locate_entry_cb(void *handle, void *userdata, mz_zip_file *file_info)
 {
     mz_zip_reader *reader = (mz_zip_reader *)userdata;
-    int32_t result = 0;
+    int32_t result = MZ_OK;
     MZ_UNUSED(handle);
-    result = mz_path_compare_wc(file_info->filename, reader->pattern, reader->pattern_ignore_case);
+    /* Entries must match both the pattern and the added patterns */
+    if (reader->pattern_wc != NULL)
+        result = mz_path_glob_match(reader->pattern_wc, file_info->filename);
+    if (result == MZ_OK && reader->pattern_glob != NULL)
+        result = mz_path_glob_match(reader->pattern_glob, file_info->filename);
     return result;
 }
 
+static int32_t mz_zip_reader_locate_pattern(void *handle, int32_t err)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+    mz_zip_file *file_info = NULL;
+
+    /* Step through entries found by prefix query until one matches the whole pattern */
+    while (err == MZ_OK)
+    {
+        err = mz_zip_entry_get_info(reader->zip_handle, &file_info);
+        if (err != MZ_OK)
+            break;
+        if (mz_zip_reader_locate_entry_cb(reader->zip_handle, reader, file_info) == MZ_OK)
+            break;
+        err = mz_zip_locate_next_prefix(reader->zip_handle);
+    }
+
+    return err;
+}
+
+static int32_t mz_zip_reader_locate_first_pattern(void *handle)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+    const char *prefix = "";
+    const char *glob_prefix = NULL;
+    uint8_t ignore_case = 0;
+    uint8_t glob_ignore_case = 0;
+    int32_t err = MZ_OK;
+
+    err = mz_zip_reader_pattern_compile(handle);
+    if (err == MZ_OK && reader->pattern_wc != NULL)
+        err = mz_path_glob_get_prefix(reader->pattern_wc, &prefix, &ignore_case);
+    if (err == MZ_OK && reader->pattern_glob != NULL)
+    {
+        /* Matching entries begin with both prefixes so the longer one is used */
+        err = mz_path_glob_get_prefix(reader->pattern_glob, &glob_prefix, &glob_ignore_case);
+        if (err == MZ_OK && strlen(glob_prefix) > strlen(prefix))
+        {
+            prefix = glob_prefix;
+            ignore_case = glob_ignore_case;
+        }
+    }
+    if (err != MZ_OK)
+        return err;
+
+    /* Only entries beginning with the literal prefix of the patterns can match */
+    err = mz_zip_locate_first_prefix(reader->zip_handle, prefix, ignore_case);
+
+    /* Scan all entries if the prefix index has not been built */
+    reader->pattern_indexed = (err != MZ_EXIST_ERROR);
+    if (!reader->pattern_indexed)
+        return mz_zip_locate_first_entry(reader->zip_handle, reader, mz_zip_reader_locate_entry_cb);
+
+    return mz_zip_reader_locate_pattern(handle, err);
+}
+
 int32_t mz_zip_reader_goto_first_entry(void *handle)
 {
     mz_zip_reader *reader = (mz_zip_reader *)handle;
@@ -319,10 +564,10 @@ int32_t mz_zip_reader_goto_first_entry(void *handle)
     if (mz_zip_entry_is_open(reader->zip_handle) == MZ_OK)
         mz_zip_reader_entry_close(handle);
 
-    if (reader->pattern == NULL)
+    if (reader->pattern == NULL && reader->pattern_glob == NULL)
         err = mz_zip_goto_first_entry(reader->zip_handle);
     else
-        err = mz_zip_locate_first_entry(reader->zip_handle, reader, mz_zip_reader_locate_entry_cb);
+        err = mz_zip_reader_locate_first_pattern(handle);
 
     reader->file_info = NULL;
     if (err == MZ_OK)
@@ -342,10 +587,16 @@ int32_t mz_zip_reader_goto_next_entry(void *handle)
     if (mz_zip_entry_is_open(reader->zip_handle) == MZ_OK)
         mz_zip_reader_entry_close(handle);
 
-    if (reader->pattern == NULL)
+    if (reader->pattern == NULL && reader->pattern_glob == NULL)
         err = mz_zip_goto_next_entry(reader->zip_handle);
+    else if (reader->pattern_indexed)
+        err = mz_zip_reader_locate_pattern(handle, mz_zip_locate_next_prefix(reader->zip_handle));
     else
-        err = mz_zip_locate_next_entry(reader->zip_handle, reader, mz_zip_reader_locate_entry_cb);
+    {
+        err = mz_zip_reader_pattern_compile(handle);
+        if (err == MZ_OK)
+            err = mz_zip_locate_next_entry(reader->zip_handle, reader, mz_zip_reader_locate_entry_cb);
+    }
 
     reader->file_info = NULL;
     if (err == MZ_OK)
@@ -362,6 +613,9 @@ int32_t mz_zip_reader_locate_entry(void *handle, const char *filename, uint8_t i
     if (mz_zip_entry_is_open(reader->zip_handle) == MZ_OK)
         mz_zip_reader_entry_close(handle);
 
+    /* Build filename index on first lookup so later lookups don't scan */
+    mz_zip_set_index(reader->zip_handle, 1);
+
     err = mz_zip_locate_entry(reader->zip_handle, filename, ignore_case);
 
     reader->file_info = NULL;
@@ -373,6 +627,41 @@ int32_t mz_zip_reader_locate_entry(void *handle, const char *filename, uint8_t i
 
 /***************************************************************************/
 
+static void mz_zip_reader_entry_prefetch(void *handle)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+#ifdef HAVE_URING
+    mz_zip_file file_info;
+    uint64_t index = 0;
+    int64_t offset = 0;
+    int64_t size = 0;
+    int32_t i = 0;
+
+    if (!reader->file_uring || reader->prefetch <= 0)
+        return;
+    if (mz_zip_entry_get_index(reader->zip_handle, &index) != MZ_OK)
+        return;
+
+    /* Start reading the local headers and data of the next entries while
+       the current one is being decompressed */
+    for (i = 1; i <= reader->prefetch; i += 1)
+    {
+        if (mz_zip_get_entry_info_at(reader->zip_handle, index + i, &file_info) != MZ_OK)
+            break;
+        /* Offsets on other disks are relative to files that aren't open */
+        if (file_info.disk_number != reader->file_info->disk_number)
+            break;
+        if (mz_zip_get_local_header_offset(reader->zip_handle, &file_info, &offset) != MZ_OK)
+            break;
+
+        size = MZ_PREFETCH_HEADER_SIZE + file_info.filename_size + file_info.compressed_size;
+        mz_stream_uring_prefetch(reader->file_stream, offset, size);
+    }
+#else
+    MZ_UNUSED(reader);
+#endif
+}
+
 int32_t mz_zip_reader_entry_open(void *handle)
 {
     mz_zip_reader *reader = (mz_zip_reader *)handle;
@@ -405,6 +694,8 @@ int32_t mz_zip_reader_entry_open(void *handle)
     }
 
     err = mz_zip_entry_read_open(reader->zip_handle, reader->raw, password);
+    if (err == MZ_OK)
+        mz_zip_reader_entry_prefetch(handle);
 #ifndef MZ_ZIP_NO_ENCRYPTION
     if (err != MZ_OK)
         return err;
@@ -643,6 +934,7 @@ int32_t mz_zip_reader_entry_save_process(void *handle, void *stream, mz_stream_w
     int32_t err = MZ_OK;
     int32_t read = 0;
     int32_t written = 0;
+    uint8_t copy = (write_cb == mz_stream_write);
 
 
     if (mz_zip_reader_is_open(reader) != MZ_OK)
@@ -659,6 +951,29 @@ int32_t mz_zip_reader_entry_save_process(void *handle, void *stream, mz_stream_w
     if (err != MZ_OK)
         return err;
 
+    /* Stored entries written to a file can be copied between the files by the system,
+       entries with a hash to verify are read once instead of being read back for it */
+#ifndef MZ_ZIP_NO_ENCRYPTION
+    if (reader->hash != NULL)
+        copy = 0;
+#endif
+    if (copy)
+    {
+        written = mz_zip_entry_read_copy(reader->zip_handle, stream, MZ_KERNEL_COPY_SIZE);
+        if (written > 0)
+            return written;
+        if (written == 0)
+        {
+            err = mz_zip_reader_entry_close(handle);
+            if (err != MZ_OK)
+                return err;
+
+            return MZ_END_OF_STREAM;
+        }
+        if (written != MZ_SUPPORT_ERROR)
+            return written;
+    }
+
     /* Unzip entry in zip file */
     read = mz_zip_reader_entry_read(handle, reader->buffer, sizeof(reader->buffer));
 
@@ -737,6 +1052,7 @@ int32_t mz_zip_reader_entry_save_file(void *handle, const char *path)
     mz_zip_reader *reader = (mz_zip_reader *)handle;
     void *stream = NULL;
     uint32_t target_attrib = 0;
+    int64_t reserve = 0;
     int32_t err_attrib = 0;
     int32_t err = MZ_OK;
     int32_t err_cb = MZ_OK;
@@ -805,6 +1121,16 @@ int32_t mz_zip_reader_entry_save_file(void *handle, const char *path)
     mz_stream_os_create(&stream);
     err = mz_stream_os_open(stream, pathwfs, MZ_OPEN_MODE_CREATE);
 
+    /* Reserve the whole file up front to keep it from being fragmented, but no more
+       than the compressed data can expand to since the size is not trusted */
+    if ((err == MZ_OK) && (reader->preallocate))
+    {
+        reserve = reader->file_info->uncompressed_size;
+        if (reserve / MZ_PREALLOCATE_MAX_RATIO > reader->file_info->compressed_size)
+            reserve = reader->file_info->compressed_size * MZ_PREALLOCATE_MAX_RATIO;
+        mz_stream_os_preallocate(stream, reserve);
+    }
+
     if (err == MZ_OK)
         err = mz_zip_reader_entry_save(handle, stream, mz_stream_write);
 
@@ -831,6 +1157,40 @@ int32_t mz_zip_reader_entry_save_file(void *handle, const char *path)
     return err;
 }
 
+static int32_t mz_zip_reader_entry_save_buffer_oneshot(void *handle, void *buf, int32_t len)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+    int32_t err = MZ_OK;
+    int32_t read = 0;
+
+    if (mz_zip_entry_is_open(reader->zip_handle) != MZ_OK)
+        err = mz_zip_reader_entry_open(handle);
+    if (err != MZ_OK)
+        return err;
+
+    if (reader->progress_cb != NULL)
+        reader->progress_cb(handle, reader->progress_userdata, reader->file_info, 0);
+
+    read = mz_zip_entry_read_buffer(reader->zip_handle, buf, len);
+    if (read == MZ_SUPPORT_ERROR)
+        return read;
+    if (read != len)
+    {
+        mz_zip_reader_entry_close(handle);
+        return (read < 0) ? read : MZ_DATA_ERROR;
+    }
+
+#ifndef MZ_ZIP_NO_ENCRYPTION
+    if (reader->hash != NULL)
+        mz_crypt_sha_update(reader->hash, buf, len);
+#endif
+
+    if (reader->progress_cb != NULL)
+        reader->progress_cb(handle, reader->progress_userdata, reader->file_info, len);
+
+    return mz_zip_reader_entry_close(handle);
+}
+
 int32_t mz_zip_reader_entry_save_buffer(void *handle, void *buf, int32_t len)
 {
     mz_zip_reader *reader = (mz_zip_reader *)handle;
@@ -846,6 +1206,16 @@ int32_t mz_zip_reader_entry_save_buffer(void *handle, void *buf, int32_t len)
     if (len != (int32_t)reader->file_info->uncompressed_size)
         return MZ_PARAM_ERROR;
 
+    /* Small deflated entries are decoded straight into the buffer in one call */
+    if (len > 0 && len <= MZ_ONESHOT_MAX_SIZE &&
+        reader->file_info->compressed_size <= MZ_ONESHOT_MAX_SIZE)
+    {
+        err = mz_zip_reader_entry_save_buffer_oneshot(handle, buf, len);
+        if (err != MZ_SUPPORT_ERROR)
+            return err;
+        err = MZ_OK;
+    }
+
     /* Create a memory stream backed by our buffer and save to it */
     mz_stream_mem_create(&mem_stream);
     mz_stream_mem_set_buffer(mem_stream, buf, len);
@@ -879,11 +1249,22 @@ int32_t mz_zip_reader_save_all(void *handle, const char *destination_dir)
 {
     mz_zip_reader *reader = (mz_zip_reader *)handle;
     int32_t err = MZ_OK;
+    uint32_t path_flags = 0;
     uint8_t *utf8_string = NULL;
     char path[512];
     char utf8_name[256];
     char resolved_name[256];
 
+    /* Conflicting paths were found when the central dir was read */
+    if (reader->path_check == MZ_ZIP_PATH_CHECK_REJECT)
+    {
+        err = mz_zip_get_path_flags(reader->zip_handle, &path_flags);
+        if (err != MZ_OK)
+            return err;
+        if (path_flags != 0)
+            return MZ_FORMAT_ERROR;
+    }
+
     err = mz_zip_reader_goto_first_entry(handle);
 
     if (err == MZ_END_OF_LIST)
@@ -891,6 +1272,19 @@ int32_t mz_zip_reader_save_all(void *handle, const char *destination_dir)
 
     while (err == MZ_OK)
     {
+        /* Skip entries that are duplicates, collide or would be extracted outside of destination */
+        if (reader->path_check == MZ_ZIP_PATH_CHECK_SKIP)
+        {
+            err = mz_zip_entry_get_path_flags(reader->zip_handle, &path_flags);
+            if (err != MZ_OK)
+                break;
+            if (path_flags != 0)
+            {
+                err = mz_zip_reader_goto_next_entry(handle);
+                continue;
+            }
+        }
+
         /* Construct output path */
         path[0] = 0;
 
@@ -937,6 +1331,68 @@ void mz_zip_reader_set_pattern(void *handle, const char *pattern, uint8_t ignore
     mz_zip_reader *reader = (mz_zip_reader *)handle;
     reader->pattern = pattern;
     reader->pattern_ignore_case = ignore_case;
+    /* Compiled again on next use, patterns added with mz_zip_reader_add_pattern are kept */
+    mz_path_glob_delete(&reader->pattern_wc);
+}
+
+int32_t mz_zip_reader_add_pattern(void *handle, const char *pattern, int32_t flags)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+
+    if (reader == NULL || pattern == NULL)
+        return MZ_PARAM_ERROR;
+
+    if (reader->pattern_glob == NULL && mz_path_glob_create(&reader->pattern_glob) == NULL)
+        return MZ_MEM_ERROR;
+    return mz_path_glob_add(reader->pattern_glob, pattern, flags);
+}
+
+void mz_zip_reader_set_path_check(void *handle, uint8_t path_check)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+    reader->path_check = path_check;
+}
+
+void mz_zip_reader_set_mmap(void *handle, uint8_t mmap)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+    reader->mmap = mmap;
+}
+
+void mz_zip_reader_set_prefetch(void *handle, int32_t prefetch)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+    reader->prefetch = prefetch;
+}
+
+void mz_zip_reader_set_readahead(void *handle, int32_t readahead)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+    reader->readahead = readahead;
+}
+
+void mz_zip_reader_set_sequential(void *handle, uint8_t sequential)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+    reader->sequential = sequential;
+}
+
+void mz_zip_reader_set_preallocate(void *handle, uint8_t preallocate)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+    reader->preallocate = preallocate;
+}
+
+void mz_zip_reader_set_index_path(void *handle, const char *index_path)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+    reader->index_path = index_path;
+}
+
+void mz_zip_reader_set_cd_mem_max(void *handle, int64_t cd_mem_max)
+{
+    mz_zip_reader *reader = (mz_zip_reader *)handle;
+    reader->cd_mem_max = cd_mem_max;
 }
 
 void mz_zip_reader_set_password(void *handle, const char *password)
@@ -1062,6 +1518,8 @@ void mz_zip_reader_delete(void **handle)
     if (reader != NULL)
     {
         mz_zip_reader_close(reader);
+        mz_path_glob_delete(&reader->pattern_wc);
+        mz_path_glob_delete(&reader->pattern_glob);
         MZ_FREE(reader);
     }
     *handle = NULL;
@@ -1077,6 +1535,7 @@ typedef struct mz_zip_writer_s {
     void        *sha256;
     void        *mem_stream;
     void        *file_extra_stream;
+    void        *oneshot_stream;    /* deflate stream whose coder is reused by buffers coded in one call */
     mz_zip_file file_info;
     void        *overwrite_userdata;
     mz_zip_writer_overwrite_cb
@@ -1098,11 +1557,14 @@ typedef struct mz_zip_writer_s {
     const char  *cert_pwd;
     uint16_t    compress_method;
     int16_t     compress_level;
+    int32_t     compress_threads;
     uint8_t     follow_links;
     uint8_t     store_links;
     uint8_t     zip_cd;
     uint8_t     aes;
     uint8_t     raw;
+    int32_t     write_behind;
+    uint8_t     direct;
     uint8_t     buffer[UINT16_MAX];
 } mz_zip_writer;
 
@@ -1132,6 +1594,8 @@ static int32_t mz_zip_writer_open_int(void *handle, void *stream, int32_t mode)
         return err;
     }
 
+    mz_zip_set_compress_threads(writer->zip_handle, writer->compress_threads);
+
     return MZ_OK;
 }
 
@@ -1144,6 +1608,7 @@ int32_t mz_zip_writer_open_file(void *handle, const char *path, int64_t disk_siz
 {
     mz_zip_writer *writer = (mz_zip_writer *)handle;
     int32_t mode = MZ_OPEN_MODE_READWRITE;
+    int32_t stream_mode = 0;
     int32_t err = MZ_OK;
     int32_t err_cb = 0;
     char directory[320];
@@ -1183,6 +1648,7 @@ int32_t mz_zip_writer_open_file(void *handle, const char *path, int64_t disk_siz
     }
 
     mz_stream_os_create(&writer->file_stream);
+    mz_stream_os_set_write_behind(writer->file_stream, writer->write_behind);
     mz_stream_buffered_create(&writer->buffered_stream);
     mz_stream_split_create(&writer->split_stream);
 
@@ -1191,7 +1657,12 @@ int32_t mz_zip_writer_open_file(void *handle, const char *path, int64_t disk_siz
 
     mz_stream_split_set_prop_int64(writer->split_stream, MZ_STREAM_PROP_DISK_SIZE, disk_size);
 
-    err = mz_stream_open(writer->split_stream, path, mode);
+    /* Buffered stream keeps writes to the file aligned for direct I/O */
+    stream_mode = mode;
+    if (writer->direct)
+        stream_mode |= MZ_OPEN_MODE_DIRECT;
+
+    err = mz_stream_open(writer->split_stream, path, stream_mode);
     if (err == MZ_OK)
         err = mz_zip_writer_open_int(handle, writer->split_stream, mode);
 
@@ -1622,6 +2093,81 @@ int32_t mz_zip_writer_add_info(void *handle, void *stream, mz_stream_read_cb rea
     return err;
 }
 
+static int32_t mz_zip_writer_add_buffer_oneshot(void *handle, void *buf, int32_t len, mz_zip_file *file_info)
+{
+#if defined(HAVE_ZLIB) && !defined(MZ_ZIP_NO_COMPRESSION)
+    mz_zip_writer *writer = (mz_zip_writer *)handle;
+    mz_zip_file oneshot_info;
+    uint8_t *target = NULL;
+    int32_t target_size = 0;
+    int32_t written = 0;
+    int32_t err = MZ_OK;
+
+    if (writer->raw || writer->compress_level == 0)
+        return MZ_SUPPORT_ERROR;
+    if (file_info->compression_method != MZ_COMPRESS_METHOD_DEFLATE)
+        return MZ_SUPPORT_ERROR;
+    if ((file_info->flag & MZ_ZIP_FLAG_ENCRYPTED) || writer->password != NULL)
+        return MZ_SUPPORT_ERROR;
+    if (mz_zip_attrib_is_dir(file_info->external_fa, file_info->version_madeby) == MZ_OK)
+        return MZ_SUPPORT_ERROR;
+
+    if (writer->oneshot_stream == NULL)
+        mz_stream_zlib_create(&writer->oneshot_stream);
+    if (writer->oneshot_stream == NULL)
+        return MZ_MEM_ERROR;
+    mz_stream_set_prop_int64(writer->oneshot_stream, MZ_STREAM_PROP_COMPRESS_LEVEL, writer->compress_level);
+
+    target_size = mz_stream_zlib_deflate_bound(writer->oneshot_stream, len);
+    if (target_size < 0)
+        return MZ_SUPPORT_ERROR;
+    target = (uint8_t *)MZ_ALLOC(target_size);
+    if (target == NULL)
+        return MZ_MEM_ERROR;
+
+    written = mz_stream_zlib_deflate_buffer(writer->oneshot_stream, buf, len, target, target_size);
+    if (written < 0)
+    {
+        MZ_FREE(target);
+        return MZ_SUPPORT_ERROR;
+    }
+
+    /* Compressed data is added as a raw entry with the sizes and crc already known */
+    memcpy(&oneshot_info, file_info, sizeof(oneshot_info));
+    oneshot_info.crc = mz_crypt_crc32_update(0, buf, len);
+    oneshot_info.compressed_size = written;
+    oneshot_info.uncompressed_size = len;
+
+    writer->raw = 1;
+    err = mz_zip_writer_entry_open(handle, &oneshot_info);
+    if (err == MZ_OK)
+    {
+        if (writer->progress_cb != NULL)
+            writer->progress_cb(handle, writer->progress_userdata, &writer->file_info, 0);
+#ifndef MZ_ZIP_NO_ENCRYPTION
+        if (writer->sha256 != NULL)
+            mz_crypt_sha_update(writer->sha256, buf, len);
+#endif
+        if (mz_zip_entry_write(writer->zip_handle, target, written) != written)
+            err = MZ_WRITE_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_writer_entry_close(handle);
+        if (err == MZ_OK && writer->progress_cb != NULL)
+            writer->progress_cb(handle, writer->progress_userdata, &writer->file_info, len);
+    }
+    writer->raw = 0;
+
+    MZ_FREE(target);
+    return err;
+#else
+    MZ_UNUSED(handle);
+    MZ_UNUSED(buf);
+    MZ_UNUSED(len);
+    MZ_UNUSED(file_info);
+    return MZ_SUPPORT_ERROR;
+#endif
+}
+
 int32_t mz_zip_writer_add_buffer(void *handle, void *buf, int32_t len, mz_zip_file *file_info)
 {
     void *mem_stream = NULL;
@@ -1632,6 +2178,15 @@ int32_t mz_zip_writer_add_buffer(void *handle, void *buf, int32_t len, mz_zip_fi
     if (buf == NULL)
         return MZ_PARAM_ERROR;
 
+    /* Small buffers are deflated in one call instead of through the compression stream */
+    if (file_info != NULL && len > 0 && len <= MZ_ONESHOT_MAX_SIZE)
+    {
+        err = mz_zip_writer_add_buffer_oneshot(handle, buf, len, file_info);
+        if (err != MZ_SUPPORT_ERROR)
+            return err;
+        err = MZ_OK;
+    }
+
     /* Create a memory stream backed by our buffer and add from it */
     mz_stream_mem_create(&mem_stream);
     mz_stream_mem_set_buffer(mem_stream, buf, len);
@@ -1744,6 +2299,7 @@ int32_t mz_zip_writer_add_path(void *handle, const char *path, const char *root_
     const char *filename = NULL;
     const char *filenameinzip = path;
     char *wildcard_ptr = NULL;
+    void *wildcard_glob = NULL;
     char full_path[1024];
     char path_dir[1024];
 
@@ -1798,10 +2354,26 @@ int32_t mz_zip_writer_add_path(void *handle, const char *path, const char *root_
         }
     }
 
+    /* Compile wildcard once for all entries in the directory */
+    if (wildcard_ptr != NULL)
+    {
+        if (mz_path_glob_create(&wildcard_glob) == NULL)
+            return MZ_MEM_ERROR;
+        err = mz_path_glob_add(wildcard_glob, wildcard_ptr, MZ_PATH_GLOB_WC | MZ_PATH_GLOB_IGNORE_CASE);
+        if (err != MZ_OK)
+        {
+            mz_path_glob_delete(&wildcard_glob);
+            return err;
+        }
+    }
+
     dir = mz_os_open_dir(path);
 
     if (dir == NULL)
+    {
+        mz_path_glob_delete(&wildcard_glob);
         return MZ_EXIST_ERROR;
+    }
 
     while ((entry = mz_os_read_dir(dir)) != NULL)
     {
@@ -1815,18 +2387,66 @@ int32_t mz_zip_writer_add_path(void *handle, const char *path, const char *root_
         if (!recursive && mz_os_is_dir(full_path) == MZ_OK)
             continue;
 
-        if ((wildcard_ptr != NULL) && (mz_path_compare_wc(entry->d_name, wildcard_ptr, 1) != MZ_OK))
+        if ((wildcard_glob != NULL) && (mz_path_glob_match(wildcard_glob, entry->d_name) != MZ_OK))
             continue;
 
         err = mz_zip_writer_add_path(handle, full_path, root_path, include_path, recursive);
         if (err != MZ_OK)
-            return err;
+            break;
     }
 
     mz_os_close_dir(dir);
+    mz_path_glob_delete(&wildcard_glob);
+    if (entry != NULL)
+        return err;
     return MZ_OK;
 }
 
+static int32_t mz_zip_writer_copy_entry(void *handle, void *reader_zip_handle)
+{
+    mz_zip_writer *writer = (mz_zip_writer *)handle;
+    uint64_t current_time = 0;
+    uint64_t update_time = 0;
+    int64_t current_pos = 0;
+    int64_t update_pos = 0;
+    int32_t copied = 0;
+    int32_t err = MZ_OK;
+
+    while (err == MZ_OK)
+    {
+        copied = mz_zip_entry_copy(writer->zip_handle, reader_zip_handle, MZ_KERNEL_COPY_SIZE);
+        if (copied == 0)
+            break;
+        if (copied < 0)
+        {
+            /* Only an entry with nothing copied yet can still be read and written instead */
+            err = copied;
+            if ((err == MZ_SUPPORT_ERROR) && (current_pos > 0))
+                err = MZ_WRITE_ERROR;
+            break;
+        }
+
+        current_pos += copied;
+
+        /* Update progress if enough time have passed */
+        current_time = mz_os_ms_time();
+        if ((current_time - update_time) > writer->progress_cb_interval_ms)
+        {
+            if (writer->progress_cb != NULL)
+                writer->progress_cb(handle, writer->progress_userdata, &writer->file_info, current_pos);
+
+            update_pos = current_pos;
+            update_time = current_time;
+        }
+    }
+
+    /* Update the progress at the end */
+    if (writer->progress_cb != NULL && update_pos != current_pos)
+        writer->progress_cb(handle, writer->progress_userdata, &writer->file_info, current_pos);
+
+    return err;
+}
+
 int32_t mz_zip_writer_copy_from_reader(void *handle, void *reader)
 {
     mz_zip_writer *writer = (mz_zip_writer *)handle;
@@ -1864,10 +2484,19 @@ int32_t mz_zip_writer_copy_from_reader(void *handle, void *reader)
 
         err = mz_zip_writer_entry_open(writer, file_info);
 
+#ifndef MZ_ZIP_NO_ENCRYPTION
+        /* Copied entry keeps the hash extra field of the source entry, no hash is calculated */
+        if (writer->sha256 != NULL)
+            mz_crypt_sha_delete(&writer->sha256);
+#endif
+
         if ((err == MZ_OK) &&
             (mz_zip_attrib_is_dir(writer->file_info.external_fa, writer->file_info.version_madeby) != MZ_OK))
         {
-            err = mz_zip_writer_add(writer, reader_zip_handle, mz_zip_entry_read);
+            /* Data that can't be copied between the files by the system is read and written */
+            err = mz_zip_writer_copy_entry(writer, reader_zip_handle);
+            if (err == MZ_SUPPORT_ERROR)
+                err = mz_zip_writer_add(writer, reader_zip_handle, mz_zip_entry_read);
         }
 
         if ((err == MZ_OK) && (file_info->flag & MZ_ZIP_FLAG_DATA_DESCRIPTOR))
@@ -1936,6 +2565,14 @@ void mz_zip_writer_set_compress_level(void *handle, int16_t compress_level)
     writer->compress_level = compress_level;
 }
 
+void mz_zip_writer_set_compress_threads(void *handle, int32_t compress_threads)
+{
+    mz_zip_writer *writer = (mz_zip_writer *)handle;
+    writer->compress_threads = compress_threads;
+    if (writer->zip_handle != NULL)
+        mz_zip_set_compress_threads(writer->zip_handle, compress_threads);
+}
+
 void mz_zip_writer_set_follow_links(void *handle, uint8_t follow_links)
 {
     mz_zip_writer *writer = (mz_zip_writer *)handle;
@@ -1954,6 +2591,18 @@ void mz_zip_writer_set_zip_cd(void *handle, uint8_t zip_cd)
     writer->zip_cd = zip_cd;
 }
 
+void mz_zip_writer_set_write_behind(void *handle, int32_t write_behind)
+{
+    mz_zip_writer *writer = (mz_zip_writer *)handle;
+    writer->write_behind = write_behind;
+}
+
+void mz_zip_writer_set_direct(void *handle, uint8_t direct)
+{
+    mz_zip_writer *writer = (mz_zip_writer *)handle;
+    writer->direct = direct;
+}
+
 int32_t mz_zip_writer_set_certificate(void *handle, const char *cert_path, const char *cert_pwd)
 {
     mz_zip_writer *writer = (mz_zip_writer *)handle;
@@ -2067,6 +2716,8 @@ void *mz_zip_writer_create(void **handle)
         writer->compress_method = MZ_COMPRESS_METHOD_BZIP2;
 #elif defined(HAVE_LZMA)
         writer->compress_method = MZ_COMPRESS_METHOD_LZMA;
+#elif defined(HAVE_ZSTD)
+        writer->compress_method = MZ_COMPRESS_METHOD_ZSTD;
 #else
         writer->compress_method = MZ_COMPRESS_METHOD_STORE;
 #endif
@@ -2089,6 +2740,11 @@ void mz_zip_writer_delete(void **handle)
     {
         mz_zip_writer_close(writer);
 
+#ifdef HAVE_ZLIB
+        if (writer->oneshot_stream != NULL)
+            mz_stream_zlib_delete(&writer->oneshot_stream);
+#endif
+
         if (writer->cert_data != NULL)
             MZ_FREE(writer->cert_data);
 
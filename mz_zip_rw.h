@@ -109,7 +109,40 @@ int32_t mz_zip_reader_save_all(void *handle, const char *destination_dir);
 /***************************************************************************/
 
 void    mz_zip_reader_set_pattern(void *handle, const char *pattern, uint8_t ignore_case);
-/* Sets the match pattern for entries in the zip file, if null all entries are matched */
+/* Sets the match pattern for entries in the zip file, if null all entries are matched,
+   entries must also match the patterns added with mz_zip_reader_add_pattern */
+
+int32_t mz_zip_reader_add_pattern(void *handle, const char *pattern, int32_t flags);
+/* Adds an include or exclude glob pattern for entries in the zip file, see mz_path_glob_add,
+   added patterns are kept when the pattern is set again */
+
+void    mz_zip_reader_set_path_check(void *handle, uint8_t path_check);
+/* Sets whether saving all entries rejects the zip file or skips entries with duplicate, colliding or
+   traversing paths, requires opening after */
+
+void    mz_zip_reader_set_mmap(void *handle, uint8_t mmap);
+/* Sets whether opening a zip file maps it into memory instead of reading it, ignored if unsupported */
+
+void    mz_zip_reader_set_readahead(void *handle, int32_t readahead);
+/* Sets the number of bytes to read ahead of the file position on a helper thread, ignored if
+   unsupported, requires opening after */
+
+void    mz_zip_reader_set_prefetch(void *handle, int32_t prefetch);
+/* Sets the number of entries following the open entry to read ahead asynchronously, requires io_uring
+   and opening after */
+
+void    mz_zip_reader_set_sequential(void *handle, uint8_t sequential);
+/* Sets whether the zip file is read start to end, data read is dropped from the page cache,
+   requires opening after */
+
+void    mz_zip_reader_set_preallocate(void *handle, uint8_t preallocate);
+/* Sets whether space for saved files is reserved before writing them, ignored if unsupported */
+
+void    mz_zip_reader_set_index_path(void *handle, const char *index_path);
+/* Sets the path of an index file used to open the zip file faster, it is saved if missing or out of date */
+
+void    mz_zip_reader_set_cd_mem_max(void *handle, int64_t cd_mem_max);
+/* Sets the max size of central dir to store in memory, larger ones are paged in as needed */
 
 void    mz_zip_reader_set_password(void *handle, const char *password);
 /* Sets the password required for extraction */
@@ -247,6 +280,9 @@ void    mz_zip_writer_set_compress_method(void *handle, uint16_t compress_method
 void    mz_zip_writer_set_compress_level(void *handle, int16_t compress_level);
 /* Sets the compression level when adding files in zip */
 
+void    mz_zip_writer_set_compress_threads(void *handle, int32_t compress_threads);
+/* Sets the number of threads used to deflate each file added in zip */
+
 void    mz_zip_writer_set_follow_links(void *handle, uint8_t follow_links);
 /* Follow symbolic links when traversing directories and files to add */
 
@@ -256,6 +292,14 @@ void    mz_zip_writer_set_store_links(void *handle, uint8_t store_links);
 void    mz_zip_writer_set_zip_cd(void *handle, uint8_t zip_cd);
 /* Sets additional flags to be set when adding files in zip */
 
+void    mz_zip_writer_set_write_behind(void *handle, int32_t write_behind);
+/* Sets the number of bytes written to the zip file after which they are written out and dropped from
+   the page cache, ignored if unsupported, requires opening after */
+
+void    mz_zip_writer_set_direct(void *handle, uint8_t direct);
+/* Writes the zip file with direct I/O bypassing the page cache, ignored if unsupported,
+   requires opening after */
+
 int32_t mz_zip_writer_set_certificate(void *handle, const char *cert_path, const char *cert_pwd);
 /* Sets the certificate and timestamp url to use for signing when adding files in zip */
 
@@ -0,0 +1,3220 @@
+/* test.c - Test bed area
+   Version 2.9.1, November 15, 2019
+   part of the MiniZip project
+
+   Copyright (C) 2018-2019 Nathan Moinvaziri
+     https://github.com/nmoinvaz/minizip
+
+   This program is distributed under the terms of the same license as zlib.
+   See the accompanying LICENSE file for the full text of the license.
+*/
+
+#include "mz.h"
+#include "mz_crypt.h"
+#include "mz_os.h"
+#include "mz_strm.h"
+#include "mz_strm_buf.h"
+#ifdef HAVE_BZIP2
+#include "mz_strm_bzip.h"
+#endif
+#ifdef HAVE_PKCRYPT
+#include "mz_strm_pkcrypt.h"
+#endif
+#include "mz_strm_mem.h"
+#ifdef HAVE_MMAP
+#include "mz_strm_mmap.h"
+#endif
+#include "mz_strm_os.h"
+#ifdef HAVE_PTHREAD
+#include "mz_strm_readahead.h"
+#endif
+#ifdef HAVE_URING
+#include "mz_strm_uring.h"
+#endif
+#ifdef HAVE_WZAES
+#include "mz_strm_wzaes.h"
+#endif
+#ifdef HAVE_ZLIB
+#include "mz_strm_zlib.h"
+#endif
+#ifdef HAVE_ZSTD
+#include "mz_strm_zstd.h"
+#endif
+#include "mz_zip.h"
+#include "mz_zip_rw.h"
+
+#include <stdio.h> /* printf, snprintf */
+#ifdef HAVE_FALLOCATE
+#  include <sys/stat.h> /* stat */
+#endif
+#ifdef HAVE_PTHREAD
+#  include <pthread.h>
+#endif
+
+#if defined(_MSC_VER) && (_MSC_VER < 1900)
+#  define snprintf _snprintf
+#endif
+
+/***************************************************************************/
+
+int32_t test_path_resolve_int(char *path, char *expected_path)
+{
+    char output[256];
+    int32_t ok = 0;
+
+    memset(output, 'z', sizeof(output));
+    mz_path_resolve(path, output, sizeof(output));
+    ok = (strcmp(output, expected_path) == 0);
+    printf("path resolve - %s -> %s = %s (%" PRId32 ")\n", path, expected_path, output, ok);
+    return !ok;
+}
+
+int32_t test_path_resolve(void)
+{
+    int32_t err = MZ_OK;
+
+    err |= test_path_resolve_int("c:\\test\\.", "c:\\test\\");
+    err |= test_path_resolve_int("c:\\test\\.\\", "c:\\test\\");
+    err |= test_path_resolve_int("c:\\test\\.\\.", "c:\\test\\");
+    err |= test_path_resolve_int("c:\\test\\..", "c:\\");
+    err |= test_path_resolve_int("c:\\test\\..\\", "c:\\");
+    err |= test_path_resolve_int("c:\\test\\.\\..", "c:\\");
+    err |= test_path_resolve_int("c:\\test\\.\\\\..", "c:\\");
+    err |= test_path_resolve_int(".", ".");
+    err |= test_path_resolve_int(".\\", "");
+    err |= test_path_resolve_int("..", "");
+    err |= test_path_resolve_int("..\\", "");
+    err |= test_path_resolve_int(".\\test\\123", "test\\123");
+    err |= test_path_resolve_int(".\\..\\test\\123", "test\\123");
+    err |= test_path_resolve_int("..\\..\\test\\123", "test\\123");
+    err |= test_path_resolve_int("test\\.abc.txt", "test\\.abc.txt");
+    err |= test_path_resolve_int("c:\\test\\123\\.\\abc.txt", "c:\\test\\123\\abc.txt");
+    err |= test_path_resolve_int("c:\\test\\123\\..\\abc.txt", "c:\\test\\abc.txt");
+    err |= test_path_resolve_int("c:\\test\\123\\..\\..\\abc.txt", "c:\\abc.txt");
+    err |= test_path_resolve_int("c:\\test\\123\\..\\..\\..\\abc.txt", "abc.txt");
+    err |= test_path_resolve_int("c:\\test\\123\\..\\.\\..\\abc.txt", "c:\\abc.txt");
+
+    return err;
+}
+
+int32_t test_path_glob_int(const char *pattern, int32_t flags, const char *path, int32_t expected)
+{
+    void *glob = NULL;
+    int32_t ok = 0;
+    int32_t result = 0;
+
+    mz_path_glob_create(&glob);
+    mz_path_glob_add(glob, pattern, flags);
+    result = (mz_path_glob_match(glob, path) == MZ_OK);
+    mz_path_glob_delete(&glob);
+
+    ok = (result == expected);
+    /* Compatible mode must agree with the uncompiled wildcard compare */
+    if (flags & MZ_PATH_GLOB_WC)
+        ok &= ((mz_path_compare_wc(path, pattern, (flags & MZ_PATH_GLOB_IGNORE_CASE) != 0) == MZ_OK) == expected);
+    printf("path glob - %s ~ %s = %" PRId32 " (%" PRId32 ")\n", path, pattern, result, ok);
+    return !ok;
+}
+
+int32_t test_path_glob(void)
+{
+    void *glob = NULL;
+    const char *prefix = NULL;
+    int32_t err = MZ_OK;
+
+    err |= test_path_glob_int("*.txt", MZ_PATH_GLOB_WC, "dir/a.txt", 1);
+    err |= test_path_glob_int("*.TXT", MZ_PATH_GLOB_WC | MZ_PATH_GLOB_IGNORE_CASE, "dir\\a.txt", 1);
+    err |= test_path_glob_int("dir/*.png", MZ_PATH_GLOB_WC, "dir/", 1);
+    err |= test_path_glob_int("a*b*c", MZ_PATH_GLOB_WC, "axbxx", 0);
+    err |= test_path_glob_int("a?c", MZ_PATH_GLOB_WC, "abc", 0);
+    err |= test_path_glob_int("*.txt", 0, "dir/a.txt", 0);
+    err |= test_path_glob_int("**.txt", 0, "dir/a.txt", 1);
+    err |= test_path_glob_int("dir/**/*.c", 0, "dir/sub/deep/mz_os.c", 1);
+    err |= test_path_glob_int("dir/*/*.c", 0, "dir/sub/deep/mz_os.c", 0);
+    err |= test_path_glob_int("dir/**/*.c", 0, "dir/a.c", 1);
+    err |= test_path_glob_int("**/*.c", 0, "a.c", 1);
+    err |= test_path_glob_int("a/**/b", 0, "a/b", 1);
+    err |= test_path_glob_int("a/**/b", 0, "a/xb", 0);
+    err |= test_path_glob_int("a**/b", 0, "ab", 0);
+    err |= test_path_glob_int("file?.[ch]", 0, "file1.h", 1);
+    err |= test_path_glob_int("file?.[!ch]", 0, "file1.h", 0);
+    err |= test_path_glob_int("[A-C]*", MZ_PATH_GLOB_IGNORE_CASE, "bin", 1);
+    err |= test_path_glob_int("[a-c]*", 0, "Bin", 0);
+    err |= test_path_glob_int("a[", 0, "a[", 1);
+
+    /* Exclude patterns win over include patterns sharing the literal prefix */
+    mz_path_glob_create(&glob);
+    mz_path_glob_add(glob, "src/**.c", 0);
+    mz_path_glob_add(glob, "src/**.h", 0);
+    mz_path_glob_add(glob, "**/test/**", MZ_PATH_GLOB_EXCLUDE);
+    if (mz_path_glob_match(glob, "src/mz_os.c") != MZ_OK)
+        err |= 1;
+    if (mz_path_glob_match(glob, "src/test/test.c") == MZ_OK)
+        err |= 1;
+    if (mz_path_glob_match(glob, "lib/mz_os.h") == MZ_OK)
+        err |= 1;
+    mz_path_glob_get_prefix(glob, &prefix, NULL);
+    if (strcmp(prefix, "src/") != 0)
+        err |= 1;
+    mz_path_glob_delete(&glob);
+
+    return err;
+}
+
+int32_t test_utf8(void)
+{
+    const char *test_string = "Heiz�lr�cksto�abd�mpfung";
+    uint8_t *utf8_string = mz_os_utf8_string_create(test_string, MZ_ENCODING_CODEPAGE_950);
+    if (utf8_string == NULL)
+        return MZ_BUF_ERROR;
+#if defined(_WINDOWS)
+    wchar_t *unicode_string = mz_os_unicode_string_create((const char *)utf8_string, MZ_ENCODING_UTF8);
+    if (unicode_string == NULL)
+        return MZ_BUF_ERROR;
+    mz_os_unicode_string_delete(&unicode_string);
+#endif
+    mz_os_utf8_string_delete(&utf8_string);
+    return MZ_OK;
+}
+
+int32_t test_encrypt(char *method, mz_stream_create_cb crypt_create, char *password)
+{
+    char buf[UINT16_MAX];
+    int32_t read = 0;
+    int32_t written = 0;
+    int64_t total_written = 0;
+    void *out_stream = NULL;
+    void *in_stream = NULL;
+    void *crypt_out_stream = NULL;
+    char encrypt_path[120];
+    char decrypt_path[120];
+
+    snprintf(encrypt_path, sizeof(encrypt_path), "LICENSE.encrypt.%s", method);
+    snprintf(decrypt_path, sizeof(decrypt_path), "LICENSE.decrypt.%s", method);
+
+    mz_stream_os_create(&in_stream);
+
+    if (mz_stream_os_open(in_stream, "LICENSE", MZ_OPEN_MODE_READ) == MZ_OK)
+    {
+        read = mz_stream_os_read(in_stream, buf, UINT16_MAX);
+        mz_stream_os_close(in_stream);
+    }
+
+    mz_stream_os_delete(&in_stream);
+    mz_stream_os_create(&out_stream);
+
+    if (mz_stream_os_open(out_stream, encrypt_path, MZ_OPEN_MODE_CREATE | MZ_OPEN_MODE_WRITE) == MZ_OK)
+    {
+        crypt_create(&crypt_out_stream);
+
+        mz_stream_set_base(crypt_out_stream, out_stream);
+
+        if (mz_stream_open(crypt_out_stream, password, MZ_OPEN_MODE_WRITE) == MZ_OK)
+        {
+            written = mz_stream_write(crypt_out_stream, buf, read);
+            mz_stream_close(crypt_out_stream);
+            mz_stream_get_prop_int64(crypt_out_stream, MZ_STREAM_PROP_TOTAL_OUT, &total_written);
+        }
+
+        mz_stream_delete(&crypt_out_stream);
+
+        mz_stream_os_close(out_stream);
+
+        printf("%s encrypted %" PRId32 "\n", encrypt_path, written);
+    }
+
+    mz_stream_os_delete(&out_stream);
+    mz_stream_os_create(&in_stream);
+
+    if (mz_stream_os_open(in_stream, encrypt_path, MZ_OPEN_MODE_READ) == MZ_OK)
+    {
+        crypt_create(&crypt_out_stream);
+
+        mz_stream_set_base(crypt_out_stream, in_stream);
+        mz_stream_set_prop_int64(crypt_out_stream, MZ_STREAM_PROP_TOTAL_IN_MAX, total_written);
+
+        if (mz_stream_open(crypt_out_stream, password, MZ_OPEN_MODE_READ) == MZ_OK)
+        {
+            read = mz_stream_read(crypt_out_stream, buf, read);
+            mz_stream_close(crypt_out_stream);
+        }
+
+        mz_stream_delete(&crypt_out_stream);
+
+        mz_stream_os_close(in_stream);
+
+        printf("%s decrypted %" PRId32 "\n", decrypt_path, read);
+    }
+
+    mz_stream_os_delete(&in_stream);
+    mz_stream_os_create(&out_stream);
+
+    if (mz_stream_os_open(out_stream, decrypt_path, MZ_OPEN_MODE_CREATE | MZ_OPEN_MODE_WRITE) == MZ_OK)
+    {
+        mz_stream_os_write(out_stream, buf, read);
+        mz_stream_os_close(out_stream);
+    }
+
+    mz_stream_os_delete(&out_stream);
+    return 0;
+}
+
+int32_t test_compress(char *method, mz_stream_create_cb create_compress)
+{
+    uint8_t buf[UINT16_MAX];
+    int32_t read = 0;
+    int64_t total_in = 0;
+    int64_t total_out = 0;
+    void *in_stream = NULL;
+    void *out_stream = NULL;
+    void *deflate_stream = NULL;
+    void *inflate_stream = NULL;
+    uint32_t crc32 = 0;
+    char filename[120];
+
+    printf("Testing compress %s\n", method);
+
+    mz_stream_os_create(&in_stream);
+
+    if (mz_stream_os_open(in_stream, "LICENSE", MZ_OPEN_MODE_READ) == MZ_OK)
+    {
+        read = mz_stream_os_read(in_stream, buf, UINT16_MAX);
+        if (read > 0)
+            crc32 = mz_crypt_crc32_update(crc32, (const uint8_t *)buf, read);
+
+        mz_stream_os_close(in_stream);
+    }
+
+    mz_stream_os_delete(&in_stream);
+
+    if (read < 0)
+    {
+        printf("Failed to read LICENSE\n");
+        return MZ_OPEN_ERROR;
+    }
+
+    printf("LICENSE crc 0x%08x\n", crc32);
+
+    mz_stream_os_create(&out_stream);
+
+    snprintf(filename, sizeof(filename), "LICENSE.deflate.%s", method);
+    if (mz_stream_os_open(out_stream, filename, MZ_OPEN_MODE_CREATE | MZ_OPEN_MODE_WRITE) == MZ_OK)
+    {
+        create_compress(&deflate_stream);
+        mz_stream_set_base(deflate_stream, out_stream);
+
+        mz_stream_open(deflate_stream, NULL, MZ_OPEN_MODE_WRITE);
+        mz_stream_write(deflate_stream, buf, read);
+        mz_stream_close(deflate_stream);
+
+        mz_stream_get_prop_int64(deflate_stream, MZ_STREAM_PROP_TOTAL_IN, &total_in);
+        mz_stream_get_prop_int64(deflate_stream, MZ_STREAM_PROP_TOTAL_OUT, &total_out);
+
+        mz_stream_delete(&deflate_stream);
+
+        printf("%s compressed from %u to %u\n", filename, (uint32_t)total_in, (uint32_t)total_out);
+
+        mz_stream_os_close(out_stream);
+    }
+
+    mz_stream_os_delete(&out_stream);
+    mz_stream_os_create(&in_stream);
+
+    if (mz_stream_os_open(in_stream, filename, MZ_OPEN_MODE_READ) == MZ_OK)
+    {
+        create_compress(&inflate_stream);
+        mz_stream_set_base(inflate_stream, in_stream);
+
+        mz_stream_open(inflate_stream, NULL, MZ_OPEN_MODE_READ);
+        read = mz_stream_read(inflate_stream, buf, UINT16_MAX);
+        mz_stream_close(inflate_stream);
+
+        mz_stream_get_prop_int64(inflate_stream, MZ_STREAM_PROP_TOTAL_IN, &total_in);
+        mz_stream_get_prop_int64(inflate_stream, MZ_STREAM_PROP_TOTAL_OUT, &total_out);
+
+        mz_stream_delete(&inflate_stream);
+
+        mz_stream_os_close(in_stream);
+
+        printf("%s uncompressed from %u to %u\n", filename, (uint32_t)total_in, (uint32_t)total_out);
+    }
+
+    mz_stream_os_delete(&in_stream);
+    mz_stream_os_create(&out_stream);
+
+    crc32 = 0;
+
+    snprintf(filename, sizeof(filename), "LICENSE.inflate.%s", method);
+    if (mz_stream_os_open(out_stream, filename, MZ_OPEN_MODE_CREATE | MZ_OPEN_MODE_WRITE) == MZ_OK)
+    {
+        crc32 = mz_crypt_crc32_update(crc32, (const uint8_t *)buf, read);
+
+        mz_stream_os_close(out_stream);
+
+        printf("%s crc 0x%08x\n", filename, crc32);
+    }
+
+    mz_stream_os_delete(&out_stream);
+
+    return MZ_OK;
+}
+
+/***************************************************************************/
+
+#ifdef HAVE_BZIP2
+int test_stream_bzip(void)
+{
+    return test_compress("bzip", mz_stream_bzip_create);
+}
+#endif
+#ifdef HAVE_PKCRYPT
+int test_stream_pkcrypt(void)
+{
+    return test_encrypt("pkcrypt", mz_stream_pkcrypt_create, "hello");
+}
+#endif
+#ifdef HAVE_WZAES
+int test_stream_wzaes(void)
+{
+    int32_t iteration_count = 1000;
+    int32_t err = MZ_OK;
+    int32_t i = 0;
+    uint8_t key[MZ_HASH_SHA1_SIZE];
+    const char *password = "passwordpasswordpasswordpassword";
+    const char *salt = "8F3472E4EA57F56E36F30246DC22C173";
+
+
+    printf("Pbkdf2 password - %s\n", password);
+    printf("Pbkdf2 salt - %s\n", salt);
+
+    err = mz_crypt_pbkdf2((uint8_t *)password, (int32_t)strlen(password),
+        (uint8_t *)salt, (int32_t)strlen(salt), iteration_count, key, sizeof(key));
+
+    if (err == MZ_OK)
+    {
+        printf("Pbkdf2 key hex\n");
+        for (i = 0; i < (int32_t)sizeof(key); i += 1)
+            printf("%02x", key[i]);
+        printf("\n");
+    }
+    else
+    {
+        printf("Pbkdf2 failed - %" PRId32 "", err);
+        return MZ_CRYPT_ERROR;
+    }
+
+    return test_encrypt("aes", mz_stream_wzaes_create, "hello");
+}
+#endif
+#ifdef HAVE_ZLIB
+int32_t test_stream_zlib(void)
+{
+    return test_compress("zlib", mz_stream_zlib_create);
+}
+
+int32_t test_stream_zlib_mem(void)
+{
+    mz_zip_file file_info;
+    void *read_mem_stream = NULL;
+    void *write_mem_stream = NULL;
+    void *os_stream = NULL;
+    void *zip_handle = NULL;
+    int32_t written = 0;
+    int32_t read = 0;
+    int32_t text_size = 0;
+    int32_t buffer_size = 0;
+    int32_t err = MZ_OK;
+    const uint8_t *buffer_ptr = NULL;
+    char *password = NULL;
+    char *text_name = "test";
+    char *text_ptr = "test string";
+    char temp[120];
+
+
+    memset(&file_info, 0, sizeof(file_info));
+
+    text_size = (int32_t)strlen(text_ptr);
+
+    /* Write zip to memory stream */
+    mz_stream_mem_create(&write_mem_stream);
+    mz_stream_mem_set_grow_size(write_mem_stream, 128 * 1024);
+    mz_stream_open(write_mem_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+    mz_zip_create(&zip_handle);
+    err = mz_zip_open(zip_handle, write_mem_stream, MZ_OPEN_MODE_WRITE);
+
+    if (err == MZ_OK)
+    {
+        file_info.version_madeby = MZ_VERSION_MADEBY;
+        file_info.compression_method = MZ_COMPRESS_METHOD_DEFLATE;
+        file_info.filename = text_name;
+        file_info.uncompressed_size = text_size;
+#ifdef HAVE_WZAES
+        file_info.aes_version = MZ_AES_VERSION;
+        password = "1234";
+#endif
+
+        err = mz_zip_entry_write_open(zip_handle, &file_info, MZ_COMPRESS_LEVEL_DEFAULT, 0, password);
+        if (err == MZ_OK)
+        {
+            written = mz_zip_entry_write(zip_handle, text_ptr, text_size);
+            if (written < MZ_OK)
+                err = written;
+            mz_zip_entry_close(zip_handle);
+        }
+
+        mz_zip_close(zip_handle);
+    }
+    else
+    {
+        err = MZ_INTERNAL_ERROR;
+    }
+
+    mz_zip_delete(&zip_handle);
+
+    mz_stream_mem_get_buffer(write_mem_stream, (const void **)&buffer_ptr);
+    mz_stream_mem_seek(write_mem_stream, 0, MZ_SEEK_END);
+    buffer_size = (int32_t)mz_stream_mem_tell(write_mem_stream);
+
+    if (err == MZ_OK)
+    {
+        /* Create a zip file on disk for inspection */
+        mz_stream_os_create(&os_stream);
+        mz_stream_os_open(os_stream, "mytest.zip", MZ_OPEN_MODE_WRITE | MZ_OPEN_MODE_CREATE);
+        mz_stream_os_write(os_stream, buffer_ptr, buffer_size);
+        mz_stream_os_close(os_stream);
+        mz_stream_os_delete(&os_stream);
+    }
+
+    if (err == MZ_OK)
+    {
+        /* Read from a memory stream */
+        mz_stream_mem_create(&read_mem_stream);
+        mz_stream_mem_set_buffer(read_mem_stream, (void *)buffer_ptr, buffer_size);
+        mz_stream_open(read_mem_stream, NULL, MZ_OPEN_MODE_READ);
+
+        mz_zip_create(&zip_handle);
+        err = mz_zip_open(zip_handle, read_mem_stream, MZ_OPEN_MODE_READ);
+
+        if (err == MZ_OK)
+        {
+            err = mz_zip_goto_first_entry(zip_handle);
+            if (err == MZ_OK)
+                err = mz_zip_entry_read_open(zip_handle, 0, password);
+            if (err == MZ_OK)
+                read = mz_zip_entry_read(zip_handle, temp, sizeof(temp));
+
+            MZ_UNUSED(read);
+
+            mz_zip_entry_close(zip_handle);
+            mz_zip_close(zip_handle);
+        }
+
+        mz_zip_delete(&zip_handle);
+
+        mz_stream_mem_close(&read_mem_stream);
+        mz_stream_mem_delete(&read_mem_stream);
+        read_mem_stream = NULL;
+    }
+
+    mz_stream_mem_close(write_mem_stream);
+    mz_stream_mem_delete(&write_mem_stream);
+    write_mem_stream = NULL;
+
+    return err;
+}
+
+int32_t test_stream_zlib_threads(void)
+{
+    mz_zip_file file_info;
+    void *mem_stream = NULL;
+    void *zip_handle = NULL;
+    void *zlib_stream = NULL;
+    uint8_t *data = NULL;
+    uint8_t *buf = NULL;
+    int32_t data_size = 1000 * 1000 + 3;
+    int32_t sizes[] = { 1000 * 1000 + 3, 500, 128 * 1024 };
+    int64_t crc = 0;
+    int32_t chunk = 0;
+    int32_t total = 0;
+    int32_t read = 0;
+    int32_t i = 0;
+    int32_t n = 0;
+    int32_t err = MZ_OK;
+
+    printf("Zlib stream threads.. ");
+
+    data = (uint8_t *)MZ_ALLOC(data_size);
+    buf = (uint8_t *)MZ_ALLOC(data_size);
+    if (data == NULL || buf == NULL)
+        err = MZ_MEM_ERROR;
+    for (i = 0; err == MZ_OK && i < data_size; i += 1)
+        data[i] = (uint8_t)(((i / 100) % 3 == 0) ? (i * 7) % 253 : "zip it "[i % 7]);
+
+    mz_stream_mem_create(&mem_stream);
+    mz_stream_mem_set_grow_size(mem_stream, 128 * 1024);
+    mz_stream_open(mem_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+    /* Entries larger and smaller than a block are written in odd sized chunks */
+    mz_zip_create(&zip_handle);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, mem_stream, MZ_OPEN_MODE_WRITE);
+    if (err == MZ_OK)
+        err = mz_zip_set_compress_threads(zip_handle, 4);
+    for (n = 0; (err == MZ_OK) && (n < 3); n += 1)
+    {
+        memset(&file_info, 0, sizeof(file_info));
+        file_info.version_madeby = MZ_VERSION_MADEBY;
+        file_info.compression_method = MZ_COMPRESS_METHOD_DEFLATE;
+        file_info.filename = (n == 0) ? "large" : (n == 1) ? "small" : "block";
+
+        err = mz_zip_entry_write_open(zip_handle, &file_info, MZ_COMPRESS_LEVEL_DEFAULT, 0, NULL);
+        for (total = 0; (err == MZ_OK) && (total < sizes[n]); total += chunk)
+        {
+            chunk = (sizes[n] - total < 10007) ? sizes[n] - total : 10007;
+            if (mz_zip_entry_write(zip_handle, data + total, chunk) != chunk)
+                err = MZ_WRITE_ERROR;
+        }
+        if (err == MZ_OK)
+            err = mz_zip_entry_close(zip_handle);
+    }
+    mz_zip_close(zip_handle);
+
+    /* Blocks inflate as one stream and the combined crc matches */
+    mz_stream_mem_seek(mem_stream, 0, MZ_SEEK_SET);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, mem_stream, MZ_OPEN_MODE_READ);
+    for (n = 0; (err == MZ_OK) && (n < 3); n += 1)
+    {
+        err = (n == 0) ? mz_zip_goto_first_entry(zip_handle) : mz_zip_goto_next_entry(zip_handle);
+        if (err == MZ_OK)
+            err = mz_zip_entry_read_open(zip_handle, 0, NULL);
+        for (total = 0; (err == MZ_OK) && (total < data_size); total += read)
+        {
+            read = mz_zip_entry_read(zip_handle, buf + total, data_size - total);
+            if (read < 0)
+                err = read;
+            if (read <= 0)
+                break;
+        }
+        if (err == MZ_OK && (total != sizes[n] || memcmp(buf, data, total) != 0))
+            err = MZ_INTERNAL_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_entry_close(zip_handle);
+    }
+    mz_zip_close(zip_handle);
+    mz_zip_delete(&zip_handle);
+
+    /* Closing twice writes nothing more and the crc of the blocks stays until reopened */
+    mz_stream_mem_seek(mem_stream, 0, MZ_SEEK_SET);
+    mz_stream_mem_set_buffer_limit(mem_stream, 0);
+    mz_stream_zlib_create(&zlib_stream);
+    mz_stream_set_base(zlib_stream, mem_stream);
+    mz_stream_set_prop_int64(zlib_stream, MZ_STREAM_PROP_COMPRESS_THREADS, 4);
+    if (err == MZ_OK)
+        err = mz_stream_open(zlib_stream, NULL, MZ_OPEN_MODE_WRITE);
+    if (err == MZ_OK && mz_stream_write(zlib_stream, data, data_size) != data_size)
+        err = MZ_WRITE_ERROR;
+    if (err == MZ_OK)
+        err = mz_stream_close(zlib_stream);
+    total = (int32_t)mz_stream_mem_tell(mem_stream);
+    if (err == MZ_OK)
+        err = mz_stream_zlib_close(zlib_stream);
+    if (err == MZ_OK && mz_stream_mem_tell(mem_stream) != total)
+        err = MZ_WRITE_ERROR;
+#ifdef HAVE_PTHREAD
+    if (err == MZ_OK && (mz_stream_get_prop_int64(zlib_stream, MZ_STREAM_PROP_CRC, &crc) != MZ_OK ||
+        (uint32_t)crc != mz_crypt_crc32_update(0, data, data_size)))
+        err = MZ_CRC_ERROR;
+#endif
+    mz_stream_mem_seek(mem_stream, 0, MZ_SEEK_SET);
+    if (err == MZ_OK)
+        err = mz_stream_open(zlib_stream, NULL, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK && mz_stream_get_prop_int64(zlib_stream, MZ_STREAM_PROP_CRC, &crc) == MZ_OK)
+        err = MZ_CRC_ERROR;
+    mz_stream_close(zlib_stream);
+    mz_stream_zlib_delete(&zlib_stream);
+    mz_stream_mem_delete(&mem_stream);
+
+#ifdef HAVE_PTHREAD
+    /* A base that fails every block keeps failing writes and close instead of waiting on them */
+    mz_stream_mem_create(&mem_stream);
+    mz_stream_mem_set_buffer(mem_stream, buf, 16);
+    mz_stream_open(mem_stream, NULL, MZ_OPEN_MODE_READWRITE);
+    mz_stream_zlib_create(&zlib_stream);
+    mz_stream_set_base(zlib_stream, mem_stream);
+    mz_stream_set_prop_int64(zlib_stream, MZ_STREAM_PROP_COMPRESS_THREADS, 4);
+    if (err == MZ_OK)
+        err = mz_stream_open(zlib_stream, NULL, MZ_OPEN_MODE_WRITE);
+    for (n = 0, i = 0; (err == MZ_OK) && (i < 8); i += 1)
+    {
+        if (mz_stream_write(zlib_stream, data, data_size) != data_size)
+            n += 1;
+        else if (n > 0)
+            break;
+    }
+    if (err == MZ_OK && (i != 8 || n == 0))
+        err = MZ_WRITE_ERROR;
+    if (err == MZ_OK && mz_stream_zlib_close(zlib_stream) == MZ_OK)
+        err = MZ_CLOSE_ERROR;
+    mz_stream_zlib_delete(&zlib_stream);
+    mz_stream_mem_close(mem_stream);
+    mz_stream_mem_delete(&mem_stream);
+#endif
+
+    MZ_FREE(data);
+    MZ_FREE(buf);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+#endif
+#ifdef HAVE_ZSTD
+int32_t test_stream_zstd(void)
+{
+    return test_compress("zstd", mz_stream_zstd_create);
+}
+#endif
+
+/***************************************************************************/
+
+int32_t test_stream_find_run(char *name, int32_t count, const uint8_t *find, int32_t find_size, mz_stream_find_cb find_cb)
+{
+    void *mem_stream = NULL;
+    int32_t i = 0;
+    int32_t x = 0;
+    int32_t err = MZ_OK;
+    int64_t last_pos = 0;
+    int64_t position = 0;
+
+    MZ_UNUSED(name);
+
+    if (find == NULL || find_size == 0 || find_cb == NULL)
+        return MZ_PARAM_ERROR;
+
+    for (i = 0; i < count; i += 1)
+    {
+#if 1
+        mz_stream_mem_create(&mem_stream);
+        mz_stream_mem_open(mem_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+        for (x = 0; x < find_size; x += 1)
+            mz_stream_write_uint8(mem_stream, find[x]);
+        for (x = 0; x < i; x += 1)
+            mz_stream_write_uint8(mem_stream, 0);
+
+        if (find_cb == mz_stream_find)
+            mz_stream_seek(mem_stream, 0, MZ_SEEK_SET);
+
+        err = find_cb(mem_stream, (const void *)find, find_size, (int64_t)i + find_size, &position);
+        last_pos = mz_stream_tell(mem_stream);
+        mz_stream_mem_delete(&mem_stream);
+
+#ifdef TEST_VERBOSE
+        printf("Find postzero - %s (len %" PRId32 " pos %" PRId64 " ok %" PRId32 ")\n",
+            name, find_size, position, (position == 0));
+#endif
+
+        if (position != 0 || last_pos != position)
+            break;
+#endif
+        mz_stream_mem_create(&mem_stream);
+        mz_stream_mem_open(mem_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+        for (x = 0; x < i; x += 1)
+            mz_stream_write_uint8(mem_stream, 0);
+        for (x = 0; x < find_size; x += 1)
+            mz_stream_write_uint8(mem_stream, find[x]);
+
+        if (find_cb == mz_stream_find)
+            mz_stream_seek(mem_stream, 0, MZ_SEEK_SET);
+
+        err = find_cb(mem_stream, (const void *)find, find_size, (int64_t)i + find_size, &position);
+        last_pos = mz_stream_tell(mem_stream);
+        mz_stream_mem_delete(&mem_stream);
+
+#ifdef TEST_VERBOSE
+        printf("Find prezero - %s (len %" PRId32 " pos %" PRId64 " ok %" PRId32 ")\n",
+            name, find_size, position, (position == i));
+#endif
+
+        if (position != i || last_pos != position)
+            break;
+
+        mz_stream_mem_create(&mem_stream);
+        mz_stream_mem_open(mem_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+        for (x = 0; x < i; x += 1)
+            mz_stream_write_uint8(mem_stream, 0);
+        for (x = 0; x < find_size; x += 1)
+            mz_stream_write_uint8(mem_stream, find[x]);
+        for (x = 0; x < i; x += 1)
+            mz_stream_write_uint8(mem_stream, 0);
+
+        if (find_cb == mz_stream_find)
+            mz_stream_seek(mem_stream, 0, MZ_SEEK_SET);
+
+        err = find_cb(mem_stream, (const void *)find, find_size, (int64_t)i + find_size + i, &position);
+        last_pos = mz_stream_tell(mem_stream);
+        mz_stream_mem_delete(&mem_stream);
+
+#ifdef TEST_VERBOSE
+        printf("Find equalzero - %s (len %" PRId32 " pos %" PRId64 " ok %" PRId32 ")\n",
+            name, find_size, position, (position == i));
+#endif
+
+        if (position != i || last_pos != position)
+            break;
+
+        mz_stream_mem_create(&mem_stream);
+        mz_stream_mem_open(mem_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+        for (x = 0; x < i; x += 1)
+            mz_stream_write_uint8(mem_stream, 0);
+        for (x = 0; x < find_size; x += 1)
+            mz_stream_write_uint8(mem_stream, find[x]);
+        for (x = 0; x < i; x += 1)
+            mz_stream_write_uint8(mem_stream, 0);
+        mz_stream_write_uint8(mem_stream, 0);
+
+        if (find_cb == mz_stream_find)
+            mz_stream_seek(mem_stream, 0, MZ_SEEK_SET);
+
+        err = find_cb(mem_stream, (const void *)find, find_size, (int64_t)i + find_size + i + 1, &position);
+        last_pos = mz_stream_tell(mem_stream);
+        mz_stream_mem_delete(&mem_stream);
+
+#ifdef TEST_VERBOSE
+        printf("Find unequalzero - %s (len %" PRId32 " pos %" PRId64 " ok %" PRId32 ")\n",
+            name, find_size, position, (position == i));
+#endif
+
+        if (position != i || last_pos != position)
+            break;
+    }
+
+    return err;
+}
+
+int32_t test_stream_find(void)
+{
+    int32_t c = 1;
+    int32_t err = MZ_OK;
+    char *find = "0123456789";
+
+    printf("Find stream.. ");
+    for (c = 1; c < (int32_t)strlen(find); c += 1)
+    {
+        err = test_stream_find_run("forward", 2096, (uint8_t *)find, c, mz_stream_find);
+        if (err != MZ_OK)
+            return err;
+    }
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+int32_t test_stream_find_reverse(void)
+{
+    int32_t c = 1;
+    int32_t err = MZ_OK;
+    char *find = "0123456789";
+
+    printf("Find reverse stream.. ");
+    for (c = 1; c < (int32_t)strlen(find); c += 1)
+    {
+        err = test_stream_find_run("backward", 2096, (uint8_t *)find, c, mz_stream_find_reverse);
+        if (err != MZ_OK)
+            return err;
+    }
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+int32_t test_stream_buffered(void)
+{
+    void *mem_stream = NULL;
+    void *buffered_stream = NULL;
+    const void *mem_buf = NULL;
+    uint8_t data[256 * 1024];
+    uint8_t buf[1000];
+    int64_t size = 0;
+    int32_t read = 0;
+    int32_t count = 0;
+    int32_t i = 0;
+    int32_t err = MZ_OK;
+
+    printf("Buffered stream.. ");
+
+    for (i = 0; i < (int32_t)sizeof(data); i += 1)
+        data[i] = (uint8_t)(i % 251);
+
+    mz_stream_mem_create(&mem_stream);
+    mz_stream_mem_set_buffer(mem_stream, data, sizeof(data));
+    mz_stream_mem_open(mem_stream, NULL, MZ_OPEN_MODE_READ);
+
+    mz_stream_buffered_create(&buffered_stream);
+    mz_stream_set_base(buffered_stream, mem_stream);
+    err = mz_stream_set_prop_int64(buffered_stream, MZ_STREAM_PROP_READ_BUFFER_SIZE, 4096);
+    if (err == MZ_OK)
+        err = mz_stream_set_prop_int64(buffered_stream, MZ_STREAM_PROP_BUFFER_ADAPTIVE, 1);
+
+    /* Sequential reads grow the read buffer */
+    while (err == MZ_OK && read < (int32_t)sizeof(data))
+    {
+        count = mz_stream_read(buffered_stream, buf, sizeof(buf));
+        if (count <= 0 || memcmp(buf, data + read, count) != 0)
+            err = MZ_READ_ERROR;
+        read += count;
+    }
+    if (err == MZ_OK)
+        err = mz_stream_get_prop_int64(buffered_stream, MZ_STREAM_PROP_READ_BUFFER_SIZE, &size);
+    if (err == MZ_OK && size <= 4096)
+        err = MZ_INTERNAL_ERROR;
+
+    /* Random reads shrink it back */
+    if (err == MZ_OK)
+        err = mz_stream_seek(buffered_stream, 1000, MZ_SEEK_SET);
+    if (err == MZ_OK && mz_stream_read(buffered_stream, buf, 10) != 10)
+        err = MZ_READ_ERROR;
+    if (err == MZ_OK && memcmp(buf, data + 1000, 10) != 0)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = mz_stream_seek(buffered_stream, 200000, MZ_SEEK_SET);
+    if (err == MZ_OK && mz_stream_read(buffered_stream, buf, 10) != 10)
+        err = MZ_READ_ERROR;
+    if (err == MZ_OK && memcmp(buf, data + 200000, 10) != 0)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = mz_stream_get_prop_int64(buffered_stream, MZ_STREAM_PROP_READ_BUFFER_SIZE, &size);
+    if (err == MZ_OK && size != 4096)
+        err = MZ_INTERNAL_ERROR;
+
+    mz_stream_buffered_delete(&buffered_stream);
+    mz_stream_mem_delete(&mem_stream);
+
+    /* Small write buffer is flushed many times */
+    mz_stream_mem_create(&mem_stream);
+    mz_stream_mem_open(mem_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+    mz_stream_buffered_create(&buffered_stream);
+    mz_stream_set_base(buffered_stream, mem_stream);
+    if (err == MZ_OK)
+        err = mz_stream_set_prop_int64(buffered_stream, MZ_STREAM_PROP_WRITE_BUFFER_SIZE, 100);
+    for (i = 0; err == MZ_OK && i < 10000; i += 7)
+    {
+        count = (10000 - i < 7) ? 10000 - i : 7;
+        if (mz_stream_write(buffered_stream, data + i, count) != count)
+            err = MZ_WRITE_ERROR;
+    }
+    if (err == MZ_OK)
+        err = mz_stream_close(buffered_stream);
+    if (err == MZ_OK)
+    {
+        mz_stream_mem_get_buffer(mem_stream, &mem_buf);
+        mz_stream_mem_seek(mem_stream, 0, MZ_SEEK_END);
+        if (mz_stream_mem_tell(mem_stream) != 10000 || memcmp(mem_buf, data, 10000) != 0)
+            err = MZ_INTERNAL_ERROR;
+    }
+
+    mz_stream_buffered_delete(&buffered_stream);
+    mz_stream_mem_delete(&mem_stream);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+/***************************************************************************/
+
+int32_t test_stream_os_hints(void)
+{
+    const char *path = "os_hints.bin";
+#ifdef HAVE_FALLOCATE
+    struct stat file_stat;
+#endif
+    void *file_stream = NULL;
+    uint8_t *data = NULL;
+    uint8_t *buf = NULL;
+    int32_t data_size = 9 * 1024 * 1024;
+    int32_t chunk_size = 64 * 1024;
+    int32_t total = 0;
+    int32_t read = 0;
+    int32_t i = 0;
+    int32_t err = MZ_OK;
+
+    printf("Os stream hints.. ");
+
+    data = (uint8_t *)MZ_ALLOC(data_size);
+    buf = (uint8_t *)MZ_ALLOC(chunk_size);
+    if (data == NULL || buf == NULL)
+        err = MZ_MEM_ERROR;
+    for (i = 0; err == MZ_OK && i < data_size; i += 1)
+        data[i] = (uint8_t)((i * 11) % 239);
+
+    /* Written data is flushed out in windows while writing */
+    mz_stream_os_create(&file_stream);
+    mz_stream_os_set_write_behind(file_stream, 1024 * 1024);
+    if (err == MZ_OK)
+        err = mz_stream_os_open(file_stream, path, MZ_OPEN_MODE_CREATE | MZ_OPEN_MODE_WRITE);
+    for (total = 0; err == MZ_OK && total < data_size; total += chunk_size)
+    {
+        if (mz_stream_os_write(file_stream, data + total, chunk_size) != chunk_size)
+            err = MZ_WRITE_ERROR;
+    }
+    mz_stream_os_close(file_stream);
+
+    /* Data read is dropped from the cache without changing what is read */
+    mz_stream_os_set_write_behind(file_stream, 0);
+    mz_stream_os_set_advice(file_stream, MZ_STREAM_OS_ADVICE_SEQUENTIAL | MZ_STREAM_OS_ADVICE_NOREUSE);
+    if (err == MZ_OK)
+        err = mz_stream_os_open(file_stream, path, MZ_OPEN_MODE_READ);
+    for (total = 0; err == MZ_OK && total < data_size; total += read)
+    {
+        read = mz_stream_os_read(file_stream, buf, chunk_size);
+        if (read != chunk_size || memcmp(buf, data + total, read) != 0)
+            err = MZ_READ_ERROR;
+    }
+    mz_stream_os_close(file_stream);
+
+    /* Space preallocated and not written is not part of the file and is given back */
+    mz_stream_os_set_advice(file_stream, MZ_STREAM_OS_ADVICE_NORMAL);
+    if (err == MZ_OK)
+        err = mz_stream_os_open(file_stream, path, MZ_OPEN_MODE_CREATE | MZ_OPEN_MODE_WRITE);
+    if (err == MZ_OK)
+    {
+        read = mz_stream_os_preallocate(file_stream, data_size);
+        if (read != MZ_OK && read != MZ_SUPPORT_ERROR)
+            err = read;
+    }
+    if (err == MZ_OK && mz_stream_os_write(file_stream, data, 100) != 100)
+        err = MZ_WRITE_ERROR;
+    mz_stream_os_close(file_stream);
+#ifdef HAVE_FALLOCATE
+    if (err == MZ_OK && stat(path, &file_stat) == 0 && file_stat.st_blocks * 512 >= 1024 * 1024)
+        err = MZ_WRITE_ERROR;
+#endif
+    if (err == MZ_OK)
+        err = mz_stream_os_open(file_stream, path, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK)
+        err = mz_stream_os_seek(file_stream, 0, MZ_SEEK_END);
+    if (err == MZ_OK && mz_stream_os_tell(file_stream) != 100)
+        err = MZ_SEEK_ERROR;
+    mz_stream_os_close(file_stream);
+    mz_stream_os_delete(&file_stream);
+
+    MZ_FREE(data);
+    MZ_FREE(buf);
+    mz_os_unlink(path);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+#if !defined(MZ_ZIP_NO_COMPRESSION) && !defined(MZ_ZIP_NO_DECOMPRESSION)
+int32_t test_stream_writev(void)
+{
+    const char *path = "writev.bin";
+    mz_stream_iovec iov[3];
+    void *file_stream = NULL;
+    void *buffered_stream = NULL;
+    void *raw_stream = NULL;
+    uint8_t data[64 * 1024];
+    uint8_t buf[sizeof(data)];
+    int32_t size = 0;
+    int32_t i = 0;
+    int32_t err = MZ_OK;
+
+    printf("Stream writev.. ");
+
+    for (i = 0; i < (int32_t)sizeof(data); i += 1)
+        data[i] = (uint8_t)((i * 7) % 253);
+
+    iov[0].buf = data + 10;
+    iov[0].size = 20;
+    iov[1].buf = data + 30;
+    iov[1].size = 40000;
+    iov[2].buf = data + 40030;
+    iov[2].size = 5;
+
+    mz_stream_os_create(&file_stream);
+    mz_stream_buffered_create(&buffered_stream);
+    mz_stream_raw_create(&raw_stream);
+    mz_stream_set_base(buffered_stream, file_stream);
+    mz_stream_set_base(raw_stream, buffered_stream);
+
+    /* Prefix is emitted in front of the vector but not counted as written */
+    err = mz_stream_open(buffered_stream, path, MZ_OPEN_MODE_CREATE | MZ_OPEN_MODE_WRITE);
+    if (err == MZ_OK)
+    {
+        mz_stream_raw_set_prefix(raw_stream, data, 10);
+        if (mz_stream_tell(raw_stream) != 10)
+            err = MZ_TELL_ERROR;
+    }
+    if (err == MZ_OK && mz_stream_writev(raw_stream, iov, 3) != 40025)
+        err = MZ_WRITE_ERROR;
+    if (err == MZ_OK && mz_stream_tell(raw_stream) != 40035)
+        err = MZ_TELL_ERROR;
+
+    /* Buffered data is kept in order with a following vector */
+    if (err == MZ_OK && mz_stream_write(raw_stream, data + 40035, 100) != 100)
+        err = MZ_WRITE_ERROR;
+    iov[0].buf = data + 40135;
+    iov[0].size = (int32_t)sizeof(data) - 40135;
+    if (err == MZ_OK && mz_stream_writev(raw_stream, iov, 1) != iov[0].size)
+        err = MZ_WRITE_ERROR;
+    mz_stream_close(buffered_stream);
+
+    if (err == MZ_OK)
+        err = mz_stream_os_open(file_stream, path, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK)
+    {
+        size = mz_stream_os_read(file_stream, buf, sizeof(buf));
+        if (size != (int32_t)sizeof(data) || memcmp(buf, data, size) != 0)
+            err = MZ_READ_ERROR;
+        if (mz_stream_os_read(file_stream, buf, 1) != 0)
+            err = MZ_READ_ERROR;
+    }
+    mz_stream_os_close(file_stream);
+
+    mz_stream_raw_delete(&raw_stream);
+    mz_stream_buffered_delete(&buffered_stream);
+    mz_stream_os_delete(&file_stream);
+    mz_os_unlink(path);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+int32_t test_zip_create_mem(void *mem_stream, const char **names, int32_t name_count)
+{
+    mz_zip_file file_info;
+    void *zip_handle = NULL;
+    int32_t i = 0;
+    int32_t err = MZ_OK;
+
+
+    mz_stream_mem_set_grow_size(mem_stream, 128 * 1024);
+    mz_stream_open(mem_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+    mz_zip_create(&zip_handle);
+    err = mz_zip_open(zip_handle, mem_stream, MZ_OPEN_MODE_WRITE);
+
+    for (i = 0; (err == MZ_OK) && (i < name_count); i += 1)
+    {
+        memset(&file_info, 0, sizeof(file_info));
+        file_info.version_madeby = MZ_VERSION_MADEBY;
+        file_info.compression_method = MZ_COMPRESS_METHOD_STORE;
+        file_info.filename = names[i];
+        file_info.uncompressed_size = (int64_t)strlen(names[i]);
+
+        err = mz_zip_entry_write_open(zip_handle, &file_info, MZ_COMPRESS_LEVEL_DEFAULT, 0, NULL);
+        if (err == MZ_OK)
+        {
+            if (mz_zip_entry_write(zip_handle, names[i], (int32_t)strlen(names[i])) < 0)
+                err = MZ_WRITE_ERROR;
+            mz_zip_entry_close(zip_handle);
+        }
+    }
+
+    mz_zip_close(zip_handle);
+    mz_zip_delete(&zip_handle);
+
+    mz_stream_mem_seek(mem_stream, 0, MZ_SEEK_SET);
+    return err;
+}
+
+int32_t test_zip_locate_run(void *zip_handle, const char *filename, uint8_t ignore_case, const char *expected)
+{
+    mz_zip_file *file_info = NULL;
+    int32_t err = MZ_OK;
+
+    err = mz_zip_locate_entry(zip_handle, filename, ignore_case);
+    if (expected == NULL)
+        return (err == MZ_END_OF_LIST) ? MZ_OK : MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = mz_zip_entry_get_info(zip_handle, &file_info);
+    if (err == MZ_OK && strcmp(file_info->filename, expected) != 0)
+        err = MZ_INTERNAL_ERROR;
+    return err;
+}
+
+int32_t test_zip_locate(void)
+{
+    const char *names[] = { "readme.txt", "assets/Image.PNG", "assets\\sound.wav", "dup.txt", "Dup.txt", NULL };
+    char long_name[300];
+    char long_name_upper[300];
+    void *mem_stream = NULL;
+    void *zip_handle = NULL;
+    int32_t err = MZ_OK;
+    int32_t i = 0;
+
+    printf("Zip locate.. ");
+
+    /* Name longer than the stack buffer used to fold filenames */
+    for (i = 0; i < (int32_t)sizeof(long_name) - 1; i += 1)
+    {
+        long_name[i] = (char)('a' + (i % 26));
+        long_name_upper[i] = (char)('A' + (i % 26));
+    }
+    long_name[i] = 0;
+    long_name_upper[i] = 0;
+    names[5] = long_name;
+
+    mz_stream_mem_create(&mem_stream);
+    err = test_zip_create_mem(mem_stream, names, sizeof(names) / sizeof(names[0]));
+
+    mz_zip_create(&zip_handle);
+    mz_zip_set_index(zip_handle, 1);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, mem_stream, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK)
+    {
+        err |= test_zip_locate_run(zip_handle, "readme.txt", 0, "readme.txt");
+        err |= test_zip_locate_run(zip_handle, "assets/Image.PNG", 0, "assets/Image.PNG");
+        err |= test_zip_locate_run(zip_handle, "assets/image.png", 0, NULL);
+        err |= test_zip_locate_run(zip_handle, "ASSETS/image.png", 1, "assets/Image.PNG");
+        err |= test_zip_locate_run(zip_handle, "assets/sound.wav", 0, "assets\\sound.wav");
+        err |= test_zip_locate_run(zip_handle, "DUP.TXT", 1, "dup.txt");
+        err |= test_zip_locate_run(zip_handle, "Dup.txt", 0, "Dup.txt");
+        err |= test_zip_locate_run(zip_handle, "missing.txt", 1, NULL);
+        err |= test_zip_locate_run(zip_handle, "ASSETS\\SOUND.WAV", 1, "assets\\sound.wav");
+        err |= test_zip_locate_run(zip_handle, long_name_upper, 1, long_name);
+        err |= test_zip_locate_run(zip_handle, long_name_upper, 0, NULL);
+        mz_zip_close(zip_handle);
+    }
+    mz_zip_delete(&zip_handle);
+
+    mz_stream_mem_close(mem_stream);
+    mz_stream_mem_delete(&mem_stream);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+int32_t test_zip_entry_table(void)
+{
+    const char *names[] = { "first.txt", "dir/second.txt", "dir/sub/third.txt" };
+    mz_zip_file file_info;
+    mz_zip_file *current_info = NULL;
+    mz_zip_file_lite entries[8];
+    void *mem_stream = NULL;
+    void *zip_handle = NULL;
+    uint64_t count = 0;
+    uint64_t i = 0;
+    int32_t err = MZ_OK;
+
+    printf("Zip entry table.. ");
+
+    mz_stream_mem_create(&mem_stream);
+    err = test_zip_create_mem(mem_stream, names, sizeof(names) / sizeof(names[0]));
+
+    mz_zip_create(&zip_handle);
+    mz_zip_set_entry_table(zip_handle, 1);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, mem_stream, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK)
+        err = mz_zip_entry_count(zip_handle, &count);
+    if (err == MZ_OK && count != sizeof(names) / sizeof(names[0]))
+        err = MZ_INTERNAL_ERROR;
+
+    /* Visit entries in reverse to check random access */
+    for (i = count; (err == MZ_OK) && (i > 0); i -= 1)
+    {
+        err = mz_zip_get_entry_info_at(zip_handle, i - 1, &file_info);
+        if (err == MZ_OK && strcmp(file_info.filename, names[i - 1]) != 0)
+            err = MZ_INTERNAL_ERROR;
+        if (err == MZ_OK && file_info.uncompressed_size != (int64_t)strlen(names[i - 1]))
+            err = MZ_INTERNAL_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_goto_entry_index(zip_handle, i - 1);
+        if (err == MZ_OK)
+            err = mz_zip_entry_get_info(zip_handle, &current_info);
+        if (err == MZ_OK && current_info->crc != file_info.crc)
+            err = MZ_INTERNAL_ERROR;
+    }
+
+    if (err == MZ_OK && mz_zip_get_entry_info_at(zip_handle, count, &file_info) != MZ_END_OF_LIST)
+        err = MZ_INTERNAL_ERROR;
+
+    /* Batch request past the end is truncated to the remaining entries */
+    if (err == MZ_OK && mz_zip_get_entries_info(zip_handle, 1, 8, entries) != (int32_t)count - 1)
+        err = MZ_INTERNAL_ERROR;
+    for (i = 1; (err == MZ_OK) && (i < count); i += 1)
+    {
+        if (strcmp(entries[i - 1].filename, names[i]) != 0)
+            err = MZ_INTERNAL_ERROR;
+        if (entries[i - 1].uncompressed_size != (int64_t)strlen(names[i]))
+            err = MZ_INTERNAL_ERROR;
+    }
+    if (err == MZ_OK && mz_zip_get_entries_info(zip_handle, count, 8, entries) != MZ_END_OF_LIST)
+        err = MZ_INTERNAL_ERROR;
+
+    mz_zip_close(zip_handle);
+    mz_zip_delete(&zip_handle);
+
+    mz_stream_mem_close(mem_stream);
+    mz_stream_mem_delete(&mem_stream);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+int32_t test_zip_path_check(void)
+{
+    const char *names[] = { "a.txt", "dir/../a.txt", "A.TXT", "../evil.txt", "./ok/./b.txt", "/etc/passwd" };
+    const char *expected_paths[] = { "a.txt", "a.txt", "A.TXT", "evil.txt", "ok/b.txt", "etc/passwd" };
+    const uint32_t expected_flags[] = { 0, MZ_ZIP_PATH_FLAG_DUPLICATE, MZ_ZIP_PATH_FLAG_COLLISION,
+        MZ_ZIP_PATH_FLAG_TRAVERSAL, 0, MZ_ZIP_PATH_FLAG_TRAVERSAL };
+    const char *path = NULL;
+    void *mem_stream = NULL;
+    void *zip_handle = NULL;
+    uint32_t flags = 0;
+    uint64_t i = 0;
+    int32_t err = MZ_OK;
+
+    printf("Zip path check.. ");
+
+    mz_stream_mem_create(&mem_stream);
+    err = test_zip_create_mem(mem_stream, names, sizeof(names) / sizeof(names[0]));
+
+    mz_zip_create(&zip_handle);
+    mz_zip_set_path_check(zip_handle, 1);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, mem_stream, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK)
+        err = mz_zip_get_path_flags(zip_handle, &flags);
+    if (err == MZ_OK && flags != (MZ_ZIP_PATH_FLAG_DUPLICATE | MZ_ZIP_PATH_FLAG_COLLISION | MZ_ZIP_PATH_FLAG_TRAVERSAL))
+        err = MZ_INTERNAL_ERROR;
+
+    for (i = 0; (err == MZ_OK) && (i < sizeof(names) / sizeof(names[0])); i += 1)
+    {
+        err = mz_zip_get_entry_path_at(zip_handle, i, &path, &flags);
+        if (err == MZ_OK && (strcmp(path, expected_paths[i]) != 0 || flags != expected_flags[i]))
+            err = MZ_INTERNAL_ERROR;
+        /* Flags of the current entry come from the same table */
+        if (err == MZ_OK)
+            err = mz_zip_goto_entry_index(zip_handle, i);
+        if (err == MZ_OK)
+            err = mz_zip_entry_get_path_flags(zip_handle, &flags);
+        if (err == MZ_OK && flags != expected_flags[i])
+            err = MZ_INTERNAL_ERROR;
+    }
+
+    mz_zip_close(zip_handle);
+    mz_zip_delete(&zip_handle);
+
+    mz_stream_mem_close(mem_stream);
+    mz_stream_mem_delete(&mem_stream);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+int32_t test_zip_cd_paged(void)
+{
+    char names_buf[100][32];
+    const char *names[100];
+    mz_zip_file *file_info = NULL;
+    void *mem_stream = NULL;
+    void *zip_handle = NULL;
+    int32_t name_count = (int32_t)(sizeof(names) / sizeof(names[0]));
+    int32_t i = 0;
+    int32_t err = MZ_OK;
+
+    printf("Zip paged central dir.. ");
+
+    for (i = 0; i < name_count; i += 1)
+    {
+        snprintf(names_buf[i], sizeof(names_buf[i]), "dir/file%03" PRId32 ".txt", i);
+        names[i] = names_buf[i];
+    }
+
+    mz_stream_mem_create(&mem_stream);
+    err = test_zip_create_mem(mem_stream, names, name_count);
+
+    /* Central dir is much larger than the memory limit */
+    mz_zip_create(&zip_handle);
+    mz_zip_set_cd_mem_max(zip_handle, 1024);
+    mz_zip_set_index(zip_handle, 1);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, mem_stream, MZ_OPEN_MODE_READ);
+
+    if (err == MZ_OK)
+        err = mz_zip_goto_first_entry(zip_handle);
+    for (i = 0; (err == MZ_OK) && (i < name_count); i += 1)
+    {
+        err = mz_zip_entry_get_info(zip_handle, &file_info);
+        if (err == MZ_OK && strcmp(file_info->filename, names[i]) != 0)
+            err = MZ_INTERNAL_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_goto_next_entry(zip_handle);
+        if (err == MZ_END_OF_LIST && i == name_count - 1)
+            err = MZ_OK;
+    }
+
+    /* Jump around the central dir in reverse to cause page evictions */
+    for (i = name_count - 1; (err == MZ_OK) && (i >= 0); i -= 3)
+    {
+        err = mz_zip_locate_entry(zip_handle, names[i], 0);
+        if (err == MZ_OK)
+            err = mz_zip_entry_get_info(zip_handle, &file_info);
+        if (err == MZ_OK && file_info->uncompressed_size != (int64_t)strlen(names[i]))
+            err = MZ_INTERNAL_ERROR;
+    }
+
+    mz_zip_close(zip_handle);
+    mz_zip_delete(&zip_handle);
+
+    mz_stream_mem_close(mem_stream);
+    mz_stream_mem_delete(&mem_stream);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+static uint64_t test_zip_get_value(const uint8_t *buf, int32_t len)
+{
+    uint64_t value = 0;
+    int32_t i = 0;
+    for (i = len - 1; i >= 0; i -= 1)
+        value = (value << 8) | buf[i];
+    return value;
+}
+
+static void test_zip_put_value(uint8_t *buf, uint64_t value, int32_t len)
+{
+    int32_t i = 0;
+    for (i = 0; i < len; i += 1)
+        buf[i] = (uint8_t)(value >> (i * 8));
+}
+
+int32_t test_zip_open_tail_run(const char *name, const uint8_t *buf, int32_t size, const char **names,
+    int32_t name_count, const char *comment)
+{
+    mz_zip_file *file_info = NULL;
+    void *mem_stream = NULL;
+    void *zip_handle = NULL;
+    const char *zip_comment = NULL;
+    char read_buf[256];
+    int32_t read = 0;
+    int32_t i = 0;
+    int32_t err = MZ_OK;
+
+    mz_stream_mem_create(&mem_stream);
+    mz_stream_mem_set_buffer(mem_stream, (void *)buf, size);
+    mz_stream_mem_open(mem_stream, NULL, MZ_OPEN_MODE_READ);
+
+    mz_zip_create(&zip_handle);
+    err = mz_zip_open(zip_handle, mem_stream, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK && comment != NULL && (mz_zip_get_comment(zip_handle, &zip_comment) != MZ_OK ||
+        strcmp(zip_comment, comment) != 0))
+        err = MZ_INTERNAL_ERROR;
+
+    /* Every entry is listed and its data is found where the central dir says */
+    if (err == MZ_OK)
+        err = mz_zip_goto_first_entry(zip_handle);
+    for (i = 0; (err == MZ_OK) && (i < name_count); i += 1)
+    {
+        err = mz_zip_entry_get_info(zip_handle, &file_info);
+        if (err == MZ_OK && strcmp(file_info->filename, names[i]) != 0)
+            err = MZ_INTERNAL_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_entry_read_open(zip_handle, 0, NULL);
+        if (err == MZ_OK)
+        {
+            read = mz_zip_entry_read(zip_handle, read_buf, sizeof(read_buf));
+            if (read != (int32_t)strlen(names[i]) || memcmp(read_buf, names[i], read) != 0)
+                err = MZ_READ_ERROR;
+            if (mz_zip_entry_close(zip_handle) != MZ_OK && err == MZ_OK)
+                err = MZ_CRC_ERROR;
+        }
+        if (err == MZ_OK)
+            err = mz_zip_goto_next_entry(zip_handle);
+        if (err == MZ_END_OF_LIST && i == name_count - 1)
+            err = MZ_OK;
+    }
+
+    mz_zip_close(zip_handle);
+    mz_zip_delete(&zip_handle);
+
+    mz_stream_mem_close(mem_stream);
+    mz_stream_mem_delete(&mem_stream);
+
+    if (err != MZ_OK)
+        printf("%s failed (%" PRId32 ") ", name, err);
+    return err;
+}
+
+int32_t test_zip_open_tail(void)
+{
+    const char *names[] = { "first.txt", "dir/second.txt", "dir/sub/third.txt" };
+    const char *long_names[600];
+    char *long_names_buf = NULL;
+    char *comment = NULL;
+    void *mem_stream = NULL;
+    const uint8_t *src = NULL;
+    uint8_t *buf = NULL;
+    int32_t name_count = (int32_t)(sizeof(names) / sizeof(names[0]));
+    int32_t long_name_count = (int32_t)(sizeof(long_names) / sizeof(long_names[0]));
+    int32_t comment_size = 60000;
+    int32_t junk_size = 8192;
+    int32_t prepend_size = 1000;
+    int32_t src_size = 0;
+    int32_t eocd_pos = 0;
+    int32_t pos = 0;
+    int32_t i = 0;
+    uint32_t cd_size = 0;
+    uint32_t cd_offset = 0;
+    int32_t err = MZ_OK;
+
+    printf("Zip open tail.. ");
+
+    mz_stream_mem_create(&mem_stream);
+    err = test_zip_create_mem(mem_stream, names, name_count);
+    mz_stream_mem_seek(mem_stream, 0, MZ_SEEK_END);
+    src_size = (int32_t)mz_stream_mem_tell(mem_stream);
+    mz_stream_mem_get_buffer(mem_stream, (const void **)&src);
+
+    /* Archive has no comment so the end of central dir record is last */
+    eocd_pos = src_size - 22;
+    cd_size = (uint32_t)test_zip_get_value(src + eocd_pos + 12, 4);
+    cd_offset = (uint32_t)test_zip_get_value(src + eocd_pos + 16, 4);
+
+    buf = (uint8_t *)MZ_ALLOC(src_size + comment_size + junk_size + prepend_size + 56 + 20);
+    comment = (char *)MZ_ALLOC(comment_size + 1);
+    if (buf == NULL || comment == NULL)
+        err = MZ_MEM_ERROR;
+
+    /* Zip64 end of central dir record and locator ahead of the end of central dir record */
+    if (err == MZ_OK)
+    {
+        memcpy(buf, src, eocd_pos);
+        pos = eocd_pos;
+        memset(buf + pos, 0, 56);
+        test_zip_put_value(buf + pos, 0x06064b50, 4);
+        test_zip_put_value(buf + pos + 4, 44, 8);
+        test_zip_put_value(buf + pos + 12, MZ_VERSION_MADEBY, 2);
+        test_zip_put_value(buf + pos + 14, 45, 2);
+        test_zip_put_value(buf + pos + 24, name_count, 8);
+        test_zip_put_value(buf + pos + 32, name_count, 8);
+        test_zip_put_value(buf + pos + 40, cd_size, 8);
+        test_zip_put_value(buf + pos + 48, cd_offset, 8);
+        pos += 56;
+        test_zip_put_value(buf + pos, 0x07064b50, 4);
+        test_zip_put_value(buf + pos + 4, 0, 4);
+        test_zip_put_value(buf + pos + 8, eocd_pos, 8);
+        test_zip_put_value(buf + pos + 16, 1, 4);
+        pos += 20;
+        memcpy(buf + pos, src + eocd_pos, 22);
+        test_zip_put_value(buf + pos + 8, UINT16_MAX, 2);
+        test_zip_put_value(buf + pos + 10, UINT16_MAX, 2);
+        test_zip_put_value(buf + pos + 16, UINT32_MAX, 4);
+        err = test_zip_open_tail_run("zip64", buf, pos + 22, names, name_count, NULL);
+    }
+
+    /* Long comment and data appended after it leave the record out of the first tail read */
+    if (err == MZ_OK)
+    {
+        memset(comment, 'c', comment_size);
+        comment[comment_size] = 0;
+        memcpy(buf, src, src_size);
+        test_zip_put_value(buf + eocd_pos + 20, comment_size, 2);
+        memcpy(buf + src_size, comment, comment_size);
+        memset(buf + src_size + comment_size, 0, junk_size);
+        err = test_zip_open_tail_run("comment", buf, src_size + comment_size + junk_size, names, name_count,
+            comment);
+    }
+
+    /* Data prepended to the archive shifts every offset */
+    if (err == MZ_OK)
+    {
+        memset(buf, 'p', prepend_size);
+        memcpy(buf + prepend_size, src, src_size);
+        err = test_zip_open_tail_run("prepend", buf, prepend_size + src_size, names, name_count, NULL);
+    }
+
+    mz_stream_mem_close(mem_stream);
+    mz_stream_mem_delete(&mem_stream);
+
+    /* Central dir larger than the tail read is fetched with one more read */
+    long_names_buf = (char *)MZ_ALLOC(long_name_count * 192);
+    if (long_names_buf == NULL && err == MZ_OK)
+        err = MZ_MEM_ERROR;
+    for (i = 0; (err == MZ_OK) && (i < long_name_count); i += 1)
+    {
+        snprintf(long_names_buf + i * 192, 192, "dir%03" PRId32 "/%0160" PRId32 ".txt", i, i);
+        long_names[i] = long_names_buf + i * 192;
+    }
+    mz_stream_mem_create(&mem_stream);
+    if (err == MZ_OK)
+        err = test_zip_create_mem(mem_stream, long_names, long_name_count);
+    mz_stream_mem_seek(mem_stream, 0, MZ_SEEK_END);
+    src_size = (int32_t)mz_stream_mem_tell(mem_stream);
+    mz_stream_mem_get_buffer(mem_stream, (const void **)&src);
+    if (err == MZ_OK && test_zip_get_value(src + src_size - 22 + 12, 4) <= UINT16_MAX + 22 + 20 + 56)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = test_zip_open_tail_run("large", src, src_size, long_names, long_name_count, NULL);
+    mz_stream_mem_close(mem_stream);
+    mz_stream_mem_delete(&mem_stream);
+
+    if (long_names_buf != NULL)
+        MZ_FREE(long_names_buf);
+    if (comment != NULL)
+        MZ_FREE(comment);
+    if (buf != NULL)
+        MZ_FREE(buf);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+int32_t test_zip_prefix_count(void *zip_handle, int32_t err, const char *first, int32_t *count)
+{
+    mz_zip_file *file_info = NULL;
+
+    *count = 0;
+    while (err == MZ_OK)
+    {
+        err = mz_zip_entry_get_info(zip_handle, &file_info);
+        if (err == MZ_OK && *count == 0 && strcmp(file_info->filename, first) != 0)
+            err = MZ_INTERNAL_ERROR;
+        if (err == MZ_OK)
+        {
+            *count += 1;
+            err = mz_zip_locate_next_prefix(zip_handle);
+        }
+    }
+    if (err == MZ_END_OF_LIST)
+        err = MZ_OK;
+    return err;
+}
+
+int32_t test_zip_prefix(void)
+{
+    const char *names[] = { "assets/", "assets/textures/", "assets/textures/a.png", "assets/Readme.txt",
+        "assets/textures/sub/c.png", "config/app.ini", "assetsx.txt", "Assets/upper.txt", "assets/textures/b.png" };
+    void *mem_stream = NULL;
+    void *reader = NULL;
+    void *zip_handle = NULL;
+    int32_t count = 0;
+    int32_t err = MZ_OK;
+
+    printf("Zip prefix index.. ");
+
+    mz_stream_mem_create(&mem_stream);
+    err = test_zip_create_mem(mem_stream, names, sizeof(names) / sizeof(names[0]));
+
+    mz_zip_reader_create(&reader);
+    if (err == MZ_OK)
+        err = mz_zip_reader_open(reader, mem_stream);
+    if (err == MZ_OK)
+        err = mz_zip_reader_get_zip_handle(reader, &zip_handle);
+    if (err == MZ_OK)
+        err = mz_zip_set_prefix_index(zip_handle, 1);
+
+    /* Entries are found in central dir order */
+    if (err == MZ_OK)
+        err = test_zip_prefix_count(zip_handle, mz_zip_locate_first_prefix(zip_handle, "assets/textures/", 0),
+            "assets/textures/", &count);
+    if (err == MZ_OK && count != 4)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = test_zip_prefix_count(zip_handle, mz_zip_locate_first_prefix(zip_handle, "ASSETS\\", 1),
+            "assets/", &count);
+    if (err == MZ_OK && count != 7)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = test_zip_prefix_count(zip_handle, mz_zip_locate_first_child(zip_handle, "assets", 0),
+            "assets/textures/", &count);
+    if (err == MZ_OK && count != 2)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK && mz_zip_locate_first_prefix(zip_handle, "missing/", 0) != MZ_END_OF_LIST)
+        err = MZ_INTERNAL_ERROR;
+
+    /* Reader uses the prefix index for the literal start of the pattern, added patterns
+       still apply after the pattern is set */
+    if (err == MZ_OK)
+        err = mz_zip_reader_add_pattern(reader, "**/b.png", MZ_PATH_GLOB_EXCLUDE);
+    mz_zip_reader_set_pattern(reader, "assets/textures/*.png", 0);
+    count = 0;
+    if (err == MZ_OK)
+        err = mz_zip_reader_goto_first_entry(reader);
+    while (err == MZ_OK)
+    {
+        count += 1;
+        err = mz_zip_reader_goto_next_entry(reader);
+    }
+    if (err == MZ_END_OF_LIST)
+        err = (count == 3) ? MZ_OK : MZ_INTERNAL_ERROR;
+
+    mz_zip_reader_close(reader);
+    mz_zip_reader_delete(&reader);
+
+    mz_stream_mem_close(mem_stream);
+    mz_stream_mem_delete(&mem_stream);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+int32_t test_zip_prefix_children(void)
+{
+    const char *names[] = { "a/b/c.txt", "a/b/d.txt", "a/e.txt", "a/f/g/h.txt", "top.txt" };
+    const char *children[] = { "a/b/", "a/e.txt", "a/f/" };
+    mz_zip_file *file_info = NULL;
+    void *mem_stream = NULL;
+    void *zip_handle = NULL;
+    const char *name = NULL;
+    int32_t name_size = 0;
+    int32_t count = 0;
+    int32_t err = MZ_OK;
+
+    printf("Zip prefix children.. ");
+
+    mz_stream_mem_create(&mem_stream);
+    err = test_zip_create_mem(mem_stream, names, sizeof(names) / sizeof(names[0]));
+
+    mz_zip_create(&zip_handle);
+    mz_zip_set_prefix_index(zip_handle, 1);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, mem_stream, MZ_OPEN_MODE_READ);
+
+    /* Sub directories without entries of their own are each found once */
+    if (err == MZ_OK)
+        err = mz_zip_locate_first_child(zip_handle, "a", 0);
+    while (err == MZ_OK)
+    {
+        if (count >= 3)
+            err = MZ_INTERNAL_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_get_child_name(zip_handle, &name, &name_size);
+        if (err == MZ_OK)
+            err = mz_zip_entry_get_info(zip_handle, &file_info);
+        if (err == MZ_OK && ((name_size != (int32_t)strlen(children[count])) ||
+            (strncmp(name, children[count], name_size) != 0) || (strcmp(file_info->filename, name) != 0)))
+            err = MZ_INTERNAL_ERROR;
+        /* Current entry is within the directory when it has no entry */
+        if (err == MZ_OK && (name[name_size - 1] == '/') != (file_info->filename_size > name_size))
+            err = MZ_INTERNAL_ERROR;
+        if (err == MZ_OK)
+        {
+            count += 1;
+            err = mz_zip_locate_next_prefix(zip_handle);
+        }
+    }
+    if (err == MZ_END_OF_LIST)
+        err = (count == 3) ? MZ_OK : MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = test_zip_prefix_count(zip_handle, mz_zip_locate_first_child(zip_handle, "", 0), "a/b/c.txt", &count);
+    if (err == MZ_OK && count != 2)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK && mz_zip_locate_first_prefix(zip_handle, "a/", 0) == MZ_OK &&
+        mz_zip_get_child_name(zip_handle, &name, &name_size) != MZ_EXIST_ERROR)
+        err = MZ_INTERNAL_ERROR;
+
+    mz_zip_close(zip_handle);
+    mz_zip_delete(&zip_handle);
+
+    mz_stream_mem_close(mem_stream);
+    mz_stream_mem_delete(&mem_stream);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+int32_t test_zip_index_file_open(void *mem_stream, void *index_stream, int64_t archive_time, int64_t cd_mem_max,
+    uint8_t *loaded)
+{
+    mz_zip_file file_info;
+    mz_zip_file *file_info_ptr = NULL;
+    void *zip_handle = NULL;
+    int32_t err = MZ_OK;
+
+    *loaded = 0;
+
+    mz_zip_create(&zip_handle);
+    mz_zip_set_entry_table(zip_handle, 1);
+    mz_zip_set_cd_mem_max(zip_handle, cd_mem_max);
+    mz_stream_mem_seek(index_stream, 0, MZ_SEEK_SET);
+    mz_zip_index_load(zip_handle, index_stream, archive_time);
+
+    err = mz_zip_open(zip_handle, mem_stream, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK && mz_zip_index_is_loaded(zip_handle) == MZ_OK)
+        *loaded = 1;
+    if (err == MZ_OK)
+        err = mz_zip_locate_entry(zip_handle, "DIR/SECOND.TXT", 1);
+    if (err == MZ_OK)
+        err = mz_zip_get_entry_info_at(zip_handle, 2, &file_info);
+    if (err == MZ_OK && strcmp(file_info.filename, "dir/sub/third.txt") != 0)
+        err = MZ_INTERNAL_ERROR;
+    /* Filename order is saved along with the prefix index */
+    if (err == MZ_OK && *loaded)
+        err = mz_zip_locate_first_child(zip_handle, "dir/sub", 0);
+    if (err == MZ_OK && *loaded)
+        err = mz_zip_entry_get_info(zip_handle, &file_info_ptr);
+    if (err == MZ_OK && *loaded && strcmp(file_info_ptr->filename, "dir/sub/third.txt") != 0)
+        err = MZ_INTERNAL_ERROR;
+
+    mz_zip_close(zip_handle);
+    mz_zip_delete(&zip_handle);
+    return err;
+}
+
+int32_t test_zip_index_file(void)
+{
+    const char *names[] = { "first.txt", "dir/second.txt", "dir/sub/third.txt" };
+    const char *other_names[] = { "other.txt", "dir/second.txt", "dir/sub/third.txt" };
+    void *mem_stream = NULL;
+    void *other_mem_stream = NULL;
+    void *index_stream = NULL;
+    void *zip_handle = NULL;
+    uint8_t loaded = 0;
+    int32_t err = MZ_OK;
+
+    printf("Zip index file.. ");
+
+    mz_stream_mem_create(&mem_stream);
+    mz_stream_mem_create(&other_mem_stream);
+    mz_stream_mem_create(&index_stream);
+    mz_stream_mem_open(index_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+    err = test_zip_create_mem(mem_stream, names, sizeof(names) / sizeof(names[0]));
+    if (err == MZ_OK)
+        err = test_zip_create_mem(other_mem_stream, other_names, sizeof(other_names) / sizeof(other_names[0]));
+
+    mz_zip_create(&zip_handle);
+    mz_zip_set_prefix_index(zip_handle, 1);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, mem_stream, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK)
+        err = mz_zip_index_save(zip_handle, index_stream, 1234);
+    mz_zip_close(zip_handle);
+    mz_zip_delete(&zip_handle);
+
+    /* Index is used only for the same archive with the same time */
+    if (err == MZ_OK)
+        err = test_zip_index_file_open(mem_stream, index_stream, 1234, 0, &loaded);
+    if (err == MZ_OK && !loaded)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = test_zip_index_file_open(mem_stream, index_stream, 5678, 0, &loaded);
+    if (err == MZ_OK && loaded)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = test_zip_index_file_open(other_mem_stream, index_stream, 1234, 0, &loaded);
+    if (err == MZ_OK && loaded)
+        err = MZ_INTERNAL_ERROR;
+    /* Central dir that is paged in is not read to use the index */
+    if (err == MZ_OK)
+        err = test_zip_index_file_open(mem_stream, index_stream, 1234, 64, &loaded);
+    if (err == MZ_OK && !loaded)
+        err = MZ_INTERNAL_ERROR;
+
+    mz_stream_mem_close(index_stream);
+    mz_stream_mem_delete(&index_stream);
+    mz_stream_mem_close(other_mem_stream);
+    mz_stream_mem_delete(&other_mem_stream);
+    mz_stream_mem_close(mem_stream);
+    mz_stream_mem_delete(&mem_stream);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+int32_t test_zip_entry_read_stream(void)
+{
+    const char *path = "entry_stream.zip";
+    mz_zip_file file_info;
+    void *file_stream = NULL;
+    void *zip_handle = NULL;
+    void *entry_streams[2] = { NULL, NULL };
+    uint8_t data[2][4096];
+    uint8_t buf[512];
+    int32_t offsets[2] = { 0, 0 };
+    int32_t read = 0;
+    int32_t i = 0;
+    int32_t n = 0;
+    int32_t err = MZ_OK;
+
+    printf("Zip entry read stream.. ");
+
+    for (i = 0; i < (int32_t)sizeof(data[0]); i += 1)
+    {
+        data[0][i] = (uint8_t)('a' + (i % 26));
+        data[1][i] = (uint8_t)('0' + ((i / 7) % 10));
+    }
+
+    mz_stream_os_create(&file_stream);
+    mz_zip_create(&zip_handle);
+
+    err = mz_stream_os_open(file_stream, path, MZ_OPEN_MODE_CREATE | MZ_OPEN_MODE_WRITE);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, file_stream, MZ_OPEN_MODE_WRITE);
+    for (n = 0; (err == MZ_OK) && (n < 2); n += 1)
+    {
+        memset(&file_info, 0, sizeof(file_info));
+        file_info.version_madeby = MZ_VERSION_MADEBY;
+#ifdef HAVE_ZLIB
+        file_info.compression_method = MZ_COMPRESS_METHOD_DEFLATE;
+#else
+        file_info.compression_method = MZ_COMPRESS_METHOD_STORE;
+#endif
+        file_info.filename = (n == 0) ? "letters.txt" : "digits.txt";
+        file_info.uncompressed_size = sizeof(data[n]);
+
+        err = mz_zip_entry_write_open(zip_handle, &file_info, MZ_COMPRESS_LEVEL_DEFAULT, 0, NULL);
+        if (err == MZ_OK && mz_zip_entry_write(zip_handle, data[n], sizeof(data[n])) != sizeof(data[n]))
+            err = MZ_WRITE_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_entry_close(zip_handle);
+    }
+    mz_zip_close(zip_handle);
+    mz_stream_os_close(file_stream);
+
+    /* Both entries are read at once through one shared zip handle and file */
+    if (err == MZ_OK)
+        err = mz_stream_os_open(file_stream, path, MZ_OPEN_MODE_READ);
+    mz_zip_set_entry_table(zip_handle, 1);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, file_stream, MZ_OPEN_MODE_READ);
+    for (n = 0; (err == MZ_OK) && (n < 2); n += 1)
+    {
+        err = mz_zip_get_entry_info_at(zip_handle, n, &file_info);
+        if (err == MZ_OK)
+            err = mz_zip_entry_read_stream_open(zip_handle, &file_info, 0, NULL, &entry_streams[n]);
+    }
+    while (err == MZ_OK && (offsets[0] < (int32_t)sizeof(data[0]) || offsets[1] < (int32_t)sizeof(data[1])))
+    {
+        for (n = 0; (err == MZ_OK) && (n < 2); n += 1)
+        {
+            read = mz_stream_read(entry_streams[n], buf, sizeof(buf));
+            if (read < 0 || offsets[n] + read > (int32_t)sizeof(data[n]))
+                err = MZ_READ_ERROR;
+            else if (memcmp(buf, data[n] + offsets[n], read) != 0)
+                err = MZ_INTERNAL_ERROR;
+            else
+                offsets[n] += read;
+        }
+    }
+    for (n = 0; n < 2; n += 1)
+    {
+        if (entry_streams[n] == NULL)
+            continue;
+        if (err == MZ_OK)
+            err = mz_stream_close(entry_streams[n]);
+        mz_stream_delete(&entry_streams[n]);
+    }
+
+    mz_zip_close(zip_handle);
+    mz_zip_delete(&zip_handle);
+    mz_stream_os_close(file_stream);
+    mz_stream_os_delete(&file_stream);
+    mz_os_unlink(path);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+#ifdef HAVE_PTHREAD
+typedef struct test_entry_thread_s {
+    void        *stream;
+    uint32_t    crc;
+    int64_t     size;
+    int32_t     err;
+} test_entry_thread;
+
+static void *test_zip_entry_read_thread(void *arg)
+{
+    test_entry_thread *entry = (test_entry_thread *)arg;
+    uint8_t buf[1000];
+    int32_t read = 0;
+
+    do
+    {
+        read = mz_stream_read(entry->stream, buf, sizeof(buf));
+        if (read > 0)
+        {
+            entry->crc = mz_crypt_crc32_update(entry->crc, buf, read);
+            entry->size += read;
+        }
+    } while (read > 0);
+
+    entry->err = (read < 0) ? read : mz_stream_close(entry->stream);
+    return NULL;
+}
+
+int32_t test_zip_entry_read_threads(void)
+{
+    const char *path = "entry_threads.zip";
+    mz_zip_file file_info;
+    test_entry_thread entries[4];
+    pthread_t threads[4];
+    char name[32];
+    void *file_stream = NULL;
+    void *zip_handle = NULL;
+    uint8_t *data = NULL;
+    uint32_t crcs[4];
+    int32_t data_size = 200 * 1024;
+    int32_t started = 0;
+    int32_t i = 0;
+    int32_t n = 0;
+    int32_t err = MZ_OK;
+
+    printf("Zip entry read threads.. ");
+
+    memset(entries, 0, sizeof(entries));
+    data = (uint8_t *)MZ_ALLOC(data_size);
+    if (data == NULL)
+        return MZ_MEM_ERROR;
+
+    mz_stream_os_create(&file_stream);
+    mz_zip_create(&zip_handle);
+
+    err = mz_stream_os_open(file_stream, path, MZ_OPEN_MODE_CREATE | MZ_OPEN_MODE_WRITE);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, file_stream, MZ_OPEN_MODE_WRITE);
+    for (n = 0; (err == MZ_OK) && (n < 4); n += 1)
+    {
+        for (i = 0; i < data_size; i += 1)
+            data[i] = (uint8_t)('a' + ((i / (n + 1)) % 26) + ((i * n) % 5));
+        crcs[n] = mz_crypt_crc32_update(0, data, data_size);
+
+        snprintf(name, sizeof(name), "entry%d.txt", (int)n);
+        memset(&file_info, 0, sizeof(file_info));
+        file_info.version_madeby = MZ_VERSION_MADEBY;
+        file_info.compression_method = (n % 2) ? MZ_COMPRESS_METHOD_STORE : MZ_COMPRESS_METHOD_DEFLATE;
+        file_info.filename = name;
+        file_info.uncompressed_size = data_size;
+
+        err = mz_zip_entry_write_open(zip_handle, &file_info, MZ_COMPRESS_LEVEL_DEFAULT, 0, NULL);
+        if (err == MZ_OK && mz_zip_entry_write(zip_handle, data, data_size) != data_size)
+            err = MZ_WRITE_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_entry_close(zip_handle);
+    }
+    mz_zip_close(zip_handle);
+    mz_stream_os_close(file_stream);
+
+    /* Each entry is read on its own thread through the same zip handle and file */
+    if (err == MZ_OK)
+        err = mz_stream_os_open(file_stream, path, MZ_OPEN_MODE_READ);
+    mz_zip_set_entry_table(zip_handle, 1);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, file_stream, MZ_OPEN_MODE_READ);
+    for (n = 0; (err == MZ_OK) && (n < 4); n += 1)
+    {
+        err = mz_zip_get_entry_info_at(zip_handle, n, &file_info);
+        if (err == MZ_OK)
+            err = mz_zip_entry_read_stream_open(zip_handle, &file_info, 0, NULL, &entries[n].stream);
+    }
+    for (started = 0; (err == MZ_OK) && (started < 4); started += 1)
+    {
+        if (pthread_create(&threads[started], NULL, test_zip_entry_read_thread, &entries[started]) != 0)
+            err = MZ_INTERNAL_ERROR;
+    }
+    for (n = 0; n < started; n += 1)
+    {
+        pthread_join(threads[n], NULL);
+        if (err == MZ_OK)
+            err = entries[n].err;
+        if (err == MZ_OK && (entries[n].size != data_size || entries[n].crc != crcs[n]))
+            err = MZ_CRC_ERROR;
+    }
+    for (n = 0; n < 4; n += 1)
+    {
+        if (entries[n].stream != NULL)
+            mz_stream_delete(&entries[n].stream);
+    }
+
+    mz_zip_close(zip_handle);
+    mz_zip_delete(&zip_handle);
+    mz_stream_os_close(file_stream);
+    mz_stream_os_delete(&file_stream);
+    mz_os_unlink(path);
+    MZ_FREE(data);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+#endif
+
+int32_t test_zip_entry_copy(void)
+{
+    const char *names[] = { "stored.bin", "deflated.bin" };
+    const char *path = "entry_copy.zip";
+    const char *copy_path = "entry_copy_raw.zip";
+    const char *out_path = "entry_copy.bin";
+    mz_zip_file file_info;
+    void *zip_stream = NULL;
+    void *file_stream = NULL;
+    void *zip_handle = NULL;
+    void *reader = NULL;
+    void *writer = NULL;
+    uint8_t *data = NULL;
+    uint8_t *buf = NULL;
+    int32_t data_size = 300 * 1024;
+    int32_t copied = 0;
+    int32_t total = 0;
+    int32_t i = 0;
+    int32_t n = 0;
+    int32_t err = MZ_OK;
+
+    printf("Zip entry copy.. ");
+
+    data = (uint8_t *)MZ_ALLOC(data_size);
+    buf = (uint8_t *)MZ_ALLOC(data_size);
+    if (data == NULL || buf == NULL)
+        err = MZ_MEM_ERROR;
+    for (i = 0; err == MZ_OK && i < data_size; i += 1)
+        data[i] = (uint8_t)((i * 7) % 251);
+
+    mz_zip_writer_create(&writer);
+    if (err == MZ_OK)
+        err = mz_zip_writer_open_file(writer, path, 0, 0);
+    for (n = 0; (err == MZ_OK) && (n < 2); n += 1)
+    {
+        memset(&file_info, 0, sizeof(file_info));
+        file_info.version_madeby = MZ_VERSION_MADEBY;
+        file_info.compression_method = MZ_COMPRESS_METHOD_STORE;
+#ifdef HAVE_ZLIB
+        if (n == 1)
+            file_info.compression_method = MZ_COMPRESS_METHOD_DEFLATE;
+#endif
+        file_info.filename = names[n];
+        err = mz_zip_writer_add_buffer(writer, data, data_size, &file_info);
+    }
+    mz_zip_writer_close(writer);
+    mz_zip_writer_delete(&writer);
+
+    /* Stored entry is copied from the zip file into another file with its crc still checked */
+    mz_stream_os_create(&zip_stream);
+    mz_stream_os_create(&file_stream);
+    mz_zip_create(&zip_handle);
+    if (err == MZ_OK)
+        err = mz_stream_os_open(zip_stream, path, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, zip_stream, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK)
+        err = mz_zip_locate_entry(zip_handle, names[0], 0);
+    if (err == MZ_OK)
+        err = mz_zip_entry_read_open(zip_handle, 0, NULL);
+    if (err == MZ_OK)
+        err = mz_stream_os_open(file_stream, out_path, MZ_OPEN_MODE_CREATE | MZ_OPEN_MODE_WRITE);
+    while (err == MZ_OK)
+    {
+        copied = mz_zip_entry_read_copy(zip_handle, file_stream, 100 * 1024);
+        if (copied <= 0)
+            break;
+        total += copied;
+    }
+    mz_stream_os_close(file_stream);
+#if defined(HAVE_COPY_FILE_RANGE) || defined(HAVE_SENDFILE)
+    if (err == MZ_OK && (copied != 0 || total != data_size))
+        err = MZ_WRITE_ERROR;
+#endif
+    if (err == MZ_OK && copied == 0)
+    {
+        err = mz_zip_entry_close(zip_handle);
+        if (err == MZ_OK)
+            err = mz_stream_os_open(file_stream, out_path, MZ_OPEN_MODE_READ);
+        if (err == MZ_OK && mz_stream_os_read(file_stream, buf, data_size) != data_size)
+            err = MZ_READ_ERROR;
+        if (err == MZ_OK && memcmp(buf, data, data_size) != 0)
+            err = MZ_INTERNAL_ERROR;
+        mz_stream_os_close(file_stream);
+    }
+    mz_zip_close(zip_handle);
+    mz_zip_delete(&zip_handle);
+    mz_stream_os_close(zip_stream);
+    mz_stream_os_delete(&zip_stream);
+    mz_stream_os_delete(&file_stream);
+
+    /* Reader extracts the stored entry the same way and checks the entry hash */
+    mz_zip_reader_create(&reader);
+    if (err == MZ_OK)
+        err = mz_zip_reader_open_file(reader, path);
+    if (err == MZ_OK)
+        err = mz_zip_reader_locate_entry(reader, names[0], 0);
+    if (err == MZ_OK)
+        err = mz_zip_reader_entry_save_file(reader, out_path);
+
+    /* Both entries are copied raw into a new zip file */
+    mz_zip_writer_create(&writer);
+    if (err == MZ_OK)
+        err = mz_zip_writer_open_file(writer, copy_path, 0, 0);
+    if (err == MZ_OK)
+        err = mz_zip_reader_goto_first_entry(reader);
+    while (err == MZ_OK)
+    {
+        err = mz_zip_writer_copy_from_reader(writer, reader);
+        if (err == MZ_OK)
+            err = mz_zip_reader_goto_next_entry(reader);
+    }
+    if (err == MZ_END_OF_LIST)
+        err = MZ_OK;
+    mz_zip_writer_close(writer);
+    mz_zip_writer_delete(&writer);
+    mz_zip_reader_close(reader);
+
+    if (err == MZ_OK)
+        err = mz_zip_reader_open_file(reader, copy_path);
+    for (n = 0; (err == MZ_OK) && (n < 2); n += 1)
+    {
+        memset(buf, 0, data_size);
+        err = mz_zip_reader_locate_entry(reader, names[n], 0);
+        if (err == MZ_OK)
+            err = mz_zip_reader_entry_save_buffer(reader, buf, data_size);
+        if (err == MZ_OK && memcmp(buf, data, data_size) != 0)
+            err = MZ_INTERNAL_ERROR;
+    }
+    mz_zip_reader_close(reader);
+    mz_zip_reader_delete(&reader);
+
+    MZ_FREE(data);
+    MZ_FREE(buf);
+    mz_os_unlink(path);
+    mz_os_unlink(copy_path);
+    mz_os_unlink(out_path);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+int32_t test_zip_writer_direct(void)
+{
+    const char *names[] = { "a.bin", "b.bin", "c.bin", "d.bin", "e.bin" };
+    int32_t sizes[] = { 1000, 70001, 300 * 1024 + 7, 13, 200000 };
+    const char *path = "writer_direct.zip";
+    mz_zip_file file_info;
+    void *reader = NULL;
+    void *writer = NULL;
+    void *file_stream = NULL;
+    uint8_t *data = NULL;
+    uint8_t *buf = NULL;
+    int64_t align = 0;
+    int32_t data_size = 300 * 1024 + 7;
+    int32_t i = 0;
+    int32_t n = 0;
+    int32_t err = MZ_OK;
+
+    printf("Zip writer direct.. ");
+
+    data = (uint8_t *)MZ_ALLOC(data_size);
+    buf = (uint8_t *)MZ_ALLOC(data_size);
+    if (data == NULL || buf == NULL)
+        err = MZ_MEM_ERROR;
+    for (i = 0; err == MZ_OK && i < data_size; i += 1)
+        data[i] = (uint8_t)((i * 13) % 241);
+
+    /* Odd sized entries end up at unaligned offsets, the last one is appended */
+    mz_zip_writer_create(&writer);
+    mz_zip_writer_set_direct(writer, 1);
+    for (n = 0; (err == MZ_OK) && (n < 5); n += 1)
+    {
+        if (n == 0 || n == 4)
+        {
+            mz_zip_writer_close(writer);
+            err = mz_zip_writer_open_file(writer, path, 0, (n == 4));
+            if (err != MZ_OK)
+                break;
+        }
+        memset(&file_info, 0, sizeof(file_info));
+        file_info.version_madeby = MZ_VERSION_MADEBY;
+        file_info.compression_method = MZ_COMPRESS_METHOD_STORE;
+#ifdef HAVE_ZLIB
+        if (n == 2)
+            file_info.compression_method = MZ_COMPRESS_METHOD_DEFLATE;
+#endif
+        file_info.filename = names[n];
+        err = mz_zip_writer_add_buffer(writer, data, sizes[n], &file_info);
+    }
+    mz_zip_writer_close(writer);
+    mz_zip_writer_delete(&writer);
+
+    /* Tail of the file written without direct I/O must be intact */
+    mz_zip_reader_create(&reader);
+    if (err == MZ_OK)
+        err = mz_zip_reader_open_file(reader, path);
+    for (n = 0; (err == MZ_OK) && (n < 5); n += 1)
+    {
+        memset(buf, 0, data_size);
+        err = mz_zip_reader_locate_entry(reader, names[n], 0);
+        if (err == MZ_OK && mz_zip_reader_entry_save_buffer_length(reader) != sizes[n])
+            err = MZ_FORMAT_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_reader_entry_save_buffer(reader, buf, sizes[n]);
+        if (err == MZ_OK && memcmp(buf, data, sizes[n]) != 0)
+            err = MZ_INTERNAL_ERROR;
+    }
+    mz_zip_reader_close(reader);
+    mz_zip_reader_delete(&reader);
+
+    /* Alignment asked of the filesystem is a power of two */
+    mz_stream_os_create(&file_stream);
+    if (err == MZ_OK && mz_stream_os_open(file_stream, path, MZ_OPEN_MODE_READ | MZ_OPEN_MODE_DIRECT) == MZ_OK)
+    {
+        if (mz_stream_os_get_prop_int64(file_stream, MZ_STREAM_PROP_WRITE_ALIGNMENT, &align) == MZ_OK &&
+            (align <= 0 || (align & (align - 1)) != 0))
+            err = MZ_INTERNAL_ERROR;
+        mz_stream_os_close(file_stream);
+    }
+    mz_stream_os_delete(&file_stream);
+
+    MZ_FREE(data);
+    MZ_FREE(buf);
+    mz_os_unlink(path);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+#ifdef HAVE_ZLIB
+int32_t test_zip_codec_reuse(void)
+{
+    uint16_t methods[] = {
+        MZ_COMPRESS_METHOD_DEFLATE, MZ_COMPRESS_METHOD_DEFLATE, MZ_COMPRESS_METHOD_STORE,
+#ifdef HAVE_BZIP2
+        MZ_COMPRESS_METHOD_BZIP2, MZ_COMPRESS_METHOD_BZIP2,
+#endif
+#ifdef HAVE_LZMA
+        MZ_COMPRESS_METHOD_LZMA, MZ_COMPRESS_METHOD_LZMA,
+#endif
+        MZ_COMPRESS_METHOD_DEFLATE, MZ_COMPRESS_METHOD_DEFLATE };
+    int16_t levels[] = { 6, 1, 6, 9, 6, 6, 6, 6, 1 };
+    int32_t count = (int32_t)(sizeof(methods) / sizeof(methods[0]));
+    mz_zip_file file_info;
+    mz_zip_file *read_info = NULL;
+    void *mem_stream = NULL;
+    void *zip_handle = NULL;
+    uint8_t *data = NULL;
+    uint8_t *buf = NULL;
+    uint32_t seed = 7;
+    int32_t data_size = 100000;
+    int32_t size = 0;
+    int32_t read = 0;
+    int32_t total = 0;
+    int32_t i = 0;
+    int32_t n = 0;
+    int32_t err = MZ_OK;
+    char name[32];
+
+    printf("Zip codec reuse.. ");
+
+    data = (uint8_t *)MZ_ALLOC(data_size);
+    buf = (uint8_t *)MZ_ALLOC(data_size);
+    if (data == NULL || buf == NULL)
+        err = MZ_MEM_ERROR;
+    for (i = 0; err == MZ_OK && i < data_size; i += 1)
+    {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (i & 0x100) ? (uint8_t)(seed >> 16) : (uint8_t)('a' + (i % 11));
+    }
+
+    /* Entries of the same method reuse the codec of the previous one, some with another level */
+    mz_stream_mem_create(&mem_stream);
+    mz_stream_mem_set_grow_size(mem_stream, 128 * 1024);
+    mz_stream_open(mem_stream, NULL, MZ_OPEN_MODE_CREATE);
+
+    mz_zip_create(&zip_handle);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, mem_stream, MZ_OPEN_MODE_WRITE);
+    for (n = 0; (err == MZ_OK) && (n < count); n += 1)
+    {
+        snprintf(name, sizeof(name), "entry%" PRId32 ".bin", n);
+        size = data_size - n * 997;
+
+        memset(&file_info, 0, sizeof(file_info));
+        file_info.version_madeby = MZ_VERSION_MADEBY;
+        file_info.compression_method = methods[n];
+        file_info.filename = name;
+
+        err = mz_zip_entry_write_open(zip_handle, &file_info, levels[n], 0, NULL);
+        if (err == MZ_OK && mz_zip_entry_write(zip_handle, data + n, size) != size)
+            err = MZ_WRITE_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_entry_close(zip_handle);
+    }
+    mz_zip_close(zip_handle);
+
+    /* Every entry must decode with its crc checked by a reused codec */
+    mz_stream_mem_seek(mem_stream, 0, MZ_SEEK_SET);
+    if (err == MZ_OK)
+        err = mz_zip_open(zip_handle, mem_stream, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK)
+        err = mz_zip_goto_first_entry(zip_handle);
+    for (n = 0; (err == MZ_OK) && (n < count); n += 1)
+    {
+        size = data_size - n * 997;
+
+        err = mz_zip_entry_get_info(zip_handle, &read_info);
+        if (err == MZ_OK && read_info->compression_method != methods[n])
+            err = MZ_FORMAT_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_entry_read_open(zip_handle, 0, NULL);
+        for (total = 0; err == MZ_OK && total < data_size; total += read)
+        {
+            read = mz_zip_entry_read(zip_handle, buf + total, data_size - total);
+            if (read < 0)
+                err = read;
+            if (read <= 0)
+                break;
+        }
+        if (err == MZ_OK && (total != size || memcmp(buf, data + n, size) != 0))
+            err = MZ_DATA_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_entry_close(zip_handle);
+        if (err == MZ_OK && n + 1 < count)
+            err = mz_zip_goto_next_entry(zip_handle);
+    }
+    mz_zip_close(zip_handle);
+    mz_zip_delete(&zip_handle);
+    mz_stream_mem_delete(&mem_stream);
+
+    MZ_FREE(data);
+    MZ_FREE(buf);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+
+int32_t test_zip_buffer_oneshot(void)
+{
+    const char *names[] = { "text.txt", "noise.bin", "empty.txt", "large.txt" };
+    int32_t sizes[] = { 40000, 5000, 0, 2 * 1024 * 1024 + 3 };
+    const char *path = "buffer_oneshot.zip";
+    mz_zip_file file_info;
+    void *reader = NULL;
+    void *writer = NULL;
+    uint8_t *data = NULL;
+    uint8_t *text = NULL;
+    uint8_t *buf = NULL;
+    uint8_t *source = NULL;
+    uint32_t seed = 1;
+    int32_t data_size = 5000 + 2 * 1024 * 1024 + 3;
+    int32_t read = 0;
+    int32_t i = 0;
+    int32_t n = 0;
+    int32_t err = MZ_OK;
+
+    printf("Zip buffer oneshot.. ");
+
+    /* Incompressible bytes up front followed by text */
+    data = (uint8_t *)MZ_ALLOC(data_size);
+    buf = (uint8_t *)MZ_ALLOC(data_size);
+    if (data == NULL || buf == NULL)
+        err = MZ_MEM_ERROR;
+    for (i = 0; err == MZ_OK && i < data_size; i += 1)
+    {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (i < sizes[1]) ? (uint8_t)(seed >> 16) : (uint8_t)('a' + (i % 7) + ((i / 1000) % 3));
+    }
+    text = data + sizes[1];
+
+    /* Small entries are deflated in one call, the large one goes through the compression stream */
+    mz_zip_writer_create(&writer);
+    if (err == MZ_OK)
+        err = mz_zip_writer_open_file(writer, path, 0, 0);
+    for (n = 0; (err == MZ_OK) && (n < 4); n += 1)
+    {
+        memset(&file_info, 0, sizeof(file_info));
+        file_info.version_madeby = MZ_VERSION_MADEBY;
+        file_info.compression_method = MZ_COMPRESS_METHOD_DEFLATE;
+        file_info.filename = names[n];
+        source = (n == 1) ? data : text;
+        err = mz_zip_writer_add_buffer(writer, source, sizes[n], &file_info);
+    }
+    mz_zip_writer_close(writer);
+    mz_zip_writer_delete(&writer);
+
+    /* Small entries are decoded in one call and checked against the crc */
+    mz_zip_reader_create(&reader);
+    if (err == MZ_OK)
+        err = mz_zip_reader_open_file(reader, path);
+    for (n = 0; (err == MZ_OK) && (n < 4); n += 1)
+    {
+        memset(buf, 0, data_size);
+        source = (n == 1) ? data : text;
+        err = mz_zip_reader_locate_entry(reader, names[n], 0);
+        if (err == MZ_OK && mz_zip_reader_entry_save_buffer_length(reader) != sizes[n])
+            err = MZ_FORMAT_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_reader_entry_save_buffer(reader, buf, sizes[n]);
+        if (err == MZ_OK && memcmp(buf, source, sizes[n]) != 0)
+            err = MZ_INTERNAL_ERROR;
+    }
+
+    /* Entry deflated in one call must also read back through the compression stream */
+    if (err == MZ_OK)
+        err = mz_zip_reader_locate_entry(reader, names[0], 0);
+    if (err == MZ_OK)
+        err = mz_zip_reader_entry_open(reader);
+    for (i = 0; (err == MZ_OK) && (i < sizes[0]); i += read)
+    {
+        read = mz_zip_reader_entry_read(reader, buf + i, 4096);
+        if (read <= 0)
+            err = MZ_READ_ERROR;
+    }
+    if (err == MZ_OK && memcmp(buf, text, sizes[0]) != 0)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = mz_zip_reader_entry_close(reader);
+    mz_zip_reader_close(reader);
+    mz_zip_reader_delete(&reader);
+
+    MZ_FREE(data);
+    MZ_FREE(buf);
+    mz_os_unlink(path);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+#endif
+
+#ifdef HAVE_MMAP
+int32_t test_stream_mmap(void)
+{
+    const char *names[] = { "first.txt", "dir/second.txt" };
+    const char *path = "mmap.zip";
+    const void *mem_buf = NULL;
+    const void *map_buf = NULL;
+    void *mem_stream = NULL;
+    void *file_stream = NULL;
+    void *mmap_stream = NULL;
+    void *reader = NULL;
+    int64_t mem_size = 0;
+    int64_t map_size = 0;
+    uint8_t buf[16];
+    int32_t err = MZ_OK;
+
+    printf("Mmap stream.. ");
+
+    mz_stream_mem_create(&mem_stream);
+    err = test_zip_create_mem(mem_stream, names, sizeof(names) / sizeof(names[0]));
+    if (err == MZ_OK)
+    {
+        mz_stream_mem_get_buffer(mem_stream, &mem_buf);
+        mz_stream_mem_seek(mem_stream, 0, MZ_SEEK_END);
+        mem_size = mz_stream_mem_tell(mem_stream);
+
+        mz_stream_os_create(&file_stream);
+        err = mz_stream_os_open(file_stream, path, MZ_OPEN_MODE_CREATE | MZ_OPEN_MODE_WRITE);
+        if (err == MZ_OK && mz_stream_os_write(file_stream, mem_buf, (int32_t)mem_size) != (int32_t)mem_size)
+            err = MZ_WRITE_ERROR;
+        mz_stream_os_close(file_stream);
+        mz_stream_os_delete(&file_stream);
+    }
+
+    /* Mapping is read only and hands out pointers to the file contents */
+    mz_stream_mmap_create(&mmap_stream);
+    if (err == MZ_OK && mz_stream_mmap_open(mmap_stream, path, MZ_OPEN_MODE_WRITE) != MZ_SUPPORT_ERROR)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = mz_stream_mmap_open(mmap_stream, path, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK)
+    {
+        mz_stream_mmap_get_buffer_length(mmap_stream, &map_size);
+        if (map_size != mem_size)
+            err = MZ_INTERNAL_ERROR;
+    }
+    if (err == MZ_OK)
+        err = mz_stream_mmap_seek(mmap_stream, -(int64_t)sizeof(buf), MZ_SEEK_END);
+    if (err == MZ_OK && mz_stream_mmap_read(mmap_stream, buf, sizeof(buf) * 2) != sizeof(buf))
+        err = MZ_READ_ERROR;
+    if (err == MZ_OK && memcmp(buf, (const uint8_t *)mem_buf + mem_size - sizeof(buf), sizeof(buf)) != 0)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK && mz_stream_mmap_get_buffer_at(mmap_stream, map_size, &map_buf) != MZ_SEEK_ERROR)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = mz_stream_mmap_get_buffer_at(mmap_stream, 4, &map_buf);
+    if (err == MZ_OK && memcmp(map_buf, (const uint8_t *)mem_buf + 4, (size_t)mem_size - 4) != 0)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = mz_stream_seek(mmap_stream, 0, MZ_SEEK_SET);
+    if (err == MZ_OK && mz_stream_read_ptr(mmap_stream, &map_buf, 4) != 4)
+        err = MZ_READ_ERROR;
+    if (err == MZ_OK && memcmp(map_buf, mem_buf, 4) != 0)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = mz_stream_release(mmap_stream, 4);
+    if (err == MZ_OK && mz_stream_tell(mmap_stream) != 4)
+        err = MZ_TELL_ERROR;
+    mz_stream_mmap_close(mmap_stream);
+    mz_stream_mmap_delete(&mmap_stream);
+
+    /* Reader opens the zip file through the mapping */
+    mz_zip_reader_create(&reader);
+    mz_zip_reader_set_mmap(reader, 1);
+    if (err == MZ_OK)
+        err = mz_zip_reader_open_file(reader, path);
+    if (err == MZ_OK)
+        err = mz_zip_reader_locate_entry(reader, "dir/second.txt", 0);
+    if (err == MZ_OK)
+        err = mz_zip_reader_entry_open(reader);
+    if (err == MZ_OK && mz_zip_reader_entry_read(reader, buf, sizeof(buf)) != (int32_t)strlen("dir/second.txt"))
+        err = MZ_READ_ERROR;
+    if (err == MZ_OK && memcmp(buf, "dir/second.txt", strlen("dir/second.txt")) != 0)
+        err = MZ_INTERNAL_ERROR;
+    mz_zip_reader_close(reader);
+    mz_zip_reader_delete(&reader);
+
+    mz_stream_mem_close(mem_stream);
+    mz_stream_mem_delete(&mem_stream);
+    mz_os_unlink(path);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+#endif
+
+#ifdef HAVE_URING
+int32_t test_stream_uring(void)
+{
+    const char *names[] = { "first.txt", "dir/second.txt", "dir/third.txt", "fourth.txt" };
+    const char *path = "uring.bin";
+    const char *zip_path = "uring.zip";
+    const void *mem_buf = NULL;
+    void *mem_stream = NULL;
+    void *uring_stream = NULL;
+    void *reader = NULL;
+    void *zip_handle = NULL;
+    mz_zip_file *file_info = NULL;
+    uint8_t data[3 * 4096 + 100];
+    uint8_t buf[4096];
+    int64_t mem_size = 0;
+    int64_t offset = 0;
+    int32_t written = 0;
+    int32_t read = 0;
+    int32_t count = 0;
+    int32_t i = 0;
+    int32_t err = MZ_OK;
+
+    printf("Uring stream.. ");
+
+    for (i = 0; i < (int32_t)sizeof(data); i += 1)
+        data[i] = (uint8_t)(i * 7);
+
+    /* Small buffers so writes and reads span several requests in flight */
+    mz_stream_uring_create(&uring_stream);
+    mz_stream_uring_set_queue_depth(uring_stream, 4);
+    mz_stream_uring_set_buffer_size(uring_stream, 4096);
+    err = mz_stream_uring_open(uring_stream, path, MZ_OPEN_MODE_CREATE | MZ_OPEN_MODE_WRITE);
+    while (err == MZ_OK && written < (int32_t)sizeof(data))
+    {
+        count = (int32_t)sizeof(data) - written;
+        if (count > 1000)
+            count = 1000;
+        if (mz_stream_uring_write(uring_stream, data + written, count) != count)
+            err = MZ_WRITE_ERROR;
+        written += count;
+    }
+    /* Reading back data that may still be in flight */
+    if (err == MZ_OK)
+        err = mz_stream_uring_seek(uring_stream, 5000, MZ_SEEK_SET);
+    if (err == MZ_OK && mz_stream_uring_read(uring_stream, buf, 3000) != 3000)
+        err = MZ_READ_ERROR;
+    if (err == MZ_OK && memcmp(buf, data + 5000, 3000) != 0)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK && mz_stream_uring_complete(uring_stream, 1) != 0)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = mz_stream_uring_close(uring_stream);
+
+    if (err == MZ_OK)
+        err = mz_stream_uring_open(uring_stream, path, MZ_OPEN_MODE_READ);
+    if (err == MZ_OK)
+        err = mz_stream_uring_prefetch(uring_stream, 4096, sizeof(data));
+    while (err == MZ_OK && read < (int32_t)sizeof(data))
+    {
+        count = mz_stream_uring_read(uring_stream, buf, 777);
+        if (count <= 0 || memcmp(buf, data + read, count) != 0)
+            err = MZ_READ_ERROR;
+        read += count;
+    }
+    if (err == MZ_OK && mz_stream_uring_read(uring_stream, buf, sizeof(buf)) != 0)
+        err = MZ_READ_ERROR;
+    if (err == MZ_OK && mz_stream_uring_read_at(uring_stream, 10000, buf, 50) != 50)
+        err = MZ_READ_ERROR;
+    if (err == MZ_OK && memcmp(buf, data + 10000, 50) != 0)
+        err = MZ_INTERNAL_ERROR;
+    mz_stream_uring_close(uring_stream);
+    mz_stream_uring_delete(&uring_stream);
+    mz_os_unlink(path);
+
+    /* Reader prefetches the entries following the one being read, the zip has
+       data prepended so the offsets in the cd need to be shifted */
+    mz_stream_mem_create(&mem_stream);
+    if (err == MZ_OK)
+        err = test_zip_create_mem(mem_stream, names, sizeof(names) / sizeof(names[0]));
+    if (err == MZ_OK)
+    {
+        mz_stream_mem_get_buffer(mem_stream, &mem_buf);
+        mz_stream_mem_seek(mem_stream, 0, MZ_SEEK_END);
+        mem_size = mz_stream_mem_tell(mem_stream);
+
+        mz_stream_uring_create(&uring_stream);
+        err = mz_stream_uring_open(uring_stream, zip_path, MZ_OPEN_MODE_CREATE | MZ_OPEN_MODE_WRITE);
+        if (err == MZ_OK && mz_stream_uring_write(uring_stream, data, 5000) != 5000)
+            err = MZ_WRITE_ERROR;
+        if (err == MZ_OK && mz_stream_uring_write(uring_stream, mem_buf, (int32_t)mem_size) != (int32_t)mem_size)
+            err = MZ_WRITE_ERROR;
+        if (mz_stream_uring_close(uring_stream) != MZ_OK && err == MZ_OK)
+            err = MZ_CLOSE_ERROR;
+        mz_stream_uring_delete(&uring_stream);
+    }
+
+    mz_zip_reader_create(&reader);
+    mz_zip_reader_set_prefetch(reader, 2);
+    if (err == MZ_OK)
+        err = mz_zip_reader_open_file(reader, zip_path);
+    if (err == MZ_OK)
+        err = mz_zip_reader_goto_first_entry(reader);
+    if (err == MZ_OK)
+        err = mz_zip_reader_get_zip_handle(reader, &zip_handle);
+    if (err == MZ_OK)
+        err = mz_zip_reader_entry_get_info(reader, &file_info);
+    if (err == MZ_OK)
+        err = mz_zip_get_local_header_offset(zip_handle, file_info, &offset);
+    if (err == MZ_OK && offset != file_info->disk_offset + 5000)
+        err = MZ_INTERNAL_ERROR;
+    for (i = 0; err == MZ_OK && i < (int32_t)(sizeof(names) / sizeof(names[0])); i += 1)
+    {
+        err = mz_zip_reader_entry_open(reader);
+        if (err == MZ_OK && mz_zip_reader_entry_read(reader, buf, sizeof(buf)) != (int32_t)strlen(names[i]))
+            err = MZ_READ_ERROR;
+        if (err == MZ_OK && memcmp(buf, names[i], strlen(names[i])) != 0)
+            err = MZ_INTERNAL_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_reader_entry_close(reader);
+        if (err == MZ_OK)
+            err = mz_zip_reader_goto_next_entry(reader);
+    }
+    if (err == MZ_END_OF_LIST)
+        err = MZ_OK;
+    mz_zip_reader_close(reader);
+    mz_zip_reader_delete(&reader);
+
+    mz_stream_mem_close(mem_stream);
+    mz_stream_mem_delete(&mem_stream);
+    mz_os_unlink(zip_path);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+#endif
+
+#ifdef HAVE_PTHREAD
+int32_t test_stream_readahead(void)
+{
+    const char *names[] = { "first.txt", "dir/second.txt", "dir/third.txt" };
+    const char *path = "readahead.zip";
+    const void *mem_buf = NULL;
+    const void *ptr = NULL;
+    void *mem_stream = NULL;
+    void *file_stream = NULL;
+    void *readahead_stream = NULL;
+    void *reader = NULL;
+    uint8_t *data = NULL;
+    uint8_t buf[5000];
+    int64_t mem_size = 0;
+    int32_t data_size = 1024 * 1024;
+    int32_t read = 0;
+    int32_t count = 0;
+    int32_t i = 0;
+    int32_t err = MZ_OK;
+
+    printf("Readahead stream.. ");
+
+    data = (uint8_t *)MZ_ALLOC(data_size);
+    if (data == NULL)
+        return MZ_MEM_ERROR;
+    for (i = 0; i < data_size; i += 1)
+        data[i] = (uint8_t)((i * 13) % 241);
+
+    mz_stream_mem_create(&mem_stream);
+    mz_stream_mem_set_buffer(mem_stream, data, data_size);
+
+    /* Small blocks so the ring wraps many times */
+    mz_stream_readahead_create(&readahead_stream);
+    mz_stream_readahead_set_size(readahead_stream, 64 * 1024, 16 * 1024);
+    mz_stream_set_base(readahead_stream, mem_stream);
+    err = mz_stream_open(readahead_stream, NULL, MZ_OPEN_MODE_READ);
+    while (err == MZ_OK && read < data_size)
+    {
+        count = mz_stream_read(readahead_stream, buf, sizeof(buf));
+        if (count <= 0 || memcmp(buf, data + read, count) != 0)
+            err = MZ_READ_ERROR;
+        read += count;
+    }
+    if (err == MZ_OK && mz_stream_read(readahead_stream, buf, sizeof(buf)) != 0)
+        err = MZ_READ_ERROR;
+
+    /* Seeking backward redirects the thread, seeking forward skips blocks */
+    if (err == MZ_OK)
+        err = mz_stream_seek(readahead_stream, 100, MZ_SEEK_SET);
+    if (err == MZ_OK && mz_stream_read(readahead_stream, buf, 10) != 10)
+        err = MZ_READ_ERROR;
+    if (err == MZ_OK && memcmp(buf, data + 100, 10) != 0)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = mz_stream_seek(readahead_stream, 40000, MZ_SEEK_CUR);
+    if (err == MZ_OK && mz_stream_tell(readahead_stream) != 40110)
+        err = MZ_TELL_ERROR;
+    if (err == MZ_OK && mz_stream_read_ptr(readahead_stream, &ptr, 10) <= 0)
+        err = MZ_READ_ERROR;
+    if (err == MZ_OK && memcmp(ptr, data + 40110, 1) != 0)
+        err = MZ_INTERNAL_ERROR;
+    if (err == MZ_OK)
+        err = mz_stream_release(readahead_stream, 1);
+    if (err == MZ_OK)
+        err = mz_stream_seek(readahead_stream, -10, MZ_SEEK_END);
+    if (err == MZ_OK && mz_stream_read(readahead_stream, buf, sizeof(buf)) != 10)
+        err = MZ_READ_ERROR;
+    if (err == MZ_OK && memcmp(buf, data + data_size - 10, 10) != 0)
+        err = MZ_INTERNAL_ERROR;
+
+    mz_stream_close(readahead_stream);
+    mz_stream_readahead_delete(&readahead_stream);
+    mz_stream_mem_delete(&mem_stream);
+    MZ_FREE(data);
+
+    /* Reader reads the zip file through the helper thread */
+    mz_stream_mem_create(&mem_stream);
+    if (err == MZ_OK)
+        err = test_zip_create_mem(mem_stream, names, sizeof(names) / sizeof(names[0]));
+    if (err == MZ_OK)
+    {
+        mz_stream_mem_get_buffer(mem_stream, &mem_buf);
+        mz_stream_mem_seek(mem_stream, 0, MZ_SEEK_END);
+        mem_size = mz_stream_mem_tell(mem_stream);
+
+        mz_stream_os_create(&file_stream);
+        err = mz_stream_os_open(file_stream, path, MZ_OPEN_MODE_CREATE | MZ_OPEN_MODE_WRITE);
+        if (err == MZ_OK && mz_stream_os_write(file_stream, mem_buf, (int32_t)mem_size) != (int32_t)mem_size)
+            err = MZ_WRITE_ERROR;
+        mz_stream_os_close(file_stream);
+        mz_stream_os_delete(&file_stream);
+    }
+
+    mz_zip_reader_create(&reader);
+    mz_zip_reader_set_readahead(reader, 1024 * 1024);
+    if (err == MZ_OK)
+        err = mz_zip_reader_open_file(reader, path);
+    if (err == MZ_OK)
+        err = mz_zip_reader_goto_first_entry(reader);
+    for (i = 0; err == MZ_OK && i < (int32_t)(sizeof(names) / sizeof(names[0])); i += 1)
+    {
+        err = mz_zip_reader_entry_open(reader);
+        if (err == MZ_OK && mz_zip_reader_entry_read(reader, buf, sizeof(buf)) != (int32_t)strlen(names[i]))
+            err = MZ_READ_ERROR;
+        if (err == MZ_OK && memcmp(buf, names[i], strlen(names[i])) != 0)
+            err = MZ_INTERNAL_ERROR;
+        if (err == MZ_OK)
+            err = mz_zip_reader_entry_close(reader);
+        if (err == MZ_OK)
+            err = mz_zip_reader_goto_next_entry(reader);
+    }
+    if (err == MZ_END_OF_LIST)
+        err = MZ_OK;
+    mz_zip_reader_close(reader);
+    mz_zip_reader_delete(&reader);
+
+    mz_stream_mem_close(mem_stream);
+    mz_stream_mem_delete(&mem_stream);
+    mz_os_unlink(path);
+
+    if (err != MZ_OK)
+        return err;
+
+    printf("OK\n");
+    return MZ_OK;
+}
+#endif
+#endif
+
+/***************************************************************************/
+
+int32_t convert_buffer_to_hex_string(uint8_t *buf, int32_t buf_size, char *hex_string, int32_t max_hex_string)
+{
+    int32_t p = 0;
+    int32_t i = 0;
+
+    if (max_hex_string > 0)
+        hex_string[0] = 0;
+    for (i = 0, p = 0; i < (int32_t)buf_size && p < max_hex_string; i += 1, p += 2)
+        snprintf(hex_string + p, max_hex_string - p, "%02x", buf[i]);
+    if (p < max_hex_string)
+        hex_string[p] = 0;
+    return MZ_OK;
+}
+
+static uint32_t test_crypt_crc32_bitwise(uint32_t value, const uint8_t *buf, int32_t size)
+{
+    int32_t i = 0;
+    int32_t b = 0;
+
+    value = ~value;
+    for (i = 0; i < size; i += 1)
+    {
+        value ^= buf[i];
+        for (b = 0; b < 8; b += 1)
+            value = (value >> 1) ^ (0xedb88320 & (0 - (value & 1)));
+    }
+    return ~value;
+}
+
+int32_t test_crypt_crc32(void)
+{
+    static const int32_t sizes[] = { 0, 1, 7, 15, 16, 63, 64, 65, 127, 128, 255, 1000, 4093, 4096 };
+    uint8_t *buf = NULL;
+    uint32_t seed = 0x12345678;
+    uint32_t expected = 0;
+    uint32_t crc1 = 0;
+    uint32_t crc2 = 0;
+    int32_t buf_size = 8192;
+    int32_t err = MZ_OK;
+    int32_t offset = 0;
+    int32_t split = 0;
+    int32_t i = 0;
+
+    expected = mz_crypt_crc32_update(0, (const uint8_t *)"123456789", 9);
+    printf("Crc32 check computed - %08x\n", expected);
+    printf("Crc32 check expected - cbf43926\n");
+    if (expected != 0xcbf43926)
+        return MZ_CRC_ERROR;
+
+    buf = (uint8_t *)MZ_ALLOC(buf_size);
+    if (buf == NULL)
+        return MZ_MEM_ERROR;
+    for (i = 0; i < buf_size; i += 1)
+    {
+        seed = seed * 1103515245 + 12345;
+        buf[i] = (uint8_t)(seed >> 16);
+    }
+
+    /* Vary the alignment and length so every kernel path and its tail are exercised */
+    for (offset = 0; offset < 16 && err == MZ_OK; offset += 3)
+    {
+        for (i = 0; i < (int32_t)(sizeof(sizes) / sizeof(sizes[0])) && err == MZ_OK; i += 1)
+        {
+            expected = test_crypt_crc32_bitwise(0, buf + offset, sizes[i]);
+            if (mz_crypt_crc32_update(0, buf + offset, sizes[i]) != expected)
+                err = MZ_CRC_ERROR;
+
+            for (split = 0; split <= sizes[i] && err == MZ_OK; split += 1 + sizes[i] / 5)
+            {
+                crc1 = mz_crypt_crc32_update(0, buf + offset, split);
+                crc2 = mz_crypt_crc32_update(0, buf + offset + split, sizes[i] - split);
+                if (mz_crypt_crc32_update(crc1, buf + offset + split, sizes[i] - split) != expected)
+                    err = MZ_CRC_ERROR;
+                else if (mz_crypt_crc32_combine(crc1, crc2, sizes[i] - split) != expected)
+                    err = MZ_CRC_ERROR;
+            }
+        }
+    }
+
+    MZ_FREE(buf);
+
+    if (err == MZ_OK)
+        printf("Crc32.. OK\n");
+    else
+        printf("Crc32 mismatch (%" PRId32 ")\n", err);
+    return err;
+}
+
+#ifndef MZ_ZIP_NO_ENCRYPTION
+int32_t test_crypt_sha(void)
+{
+    void *sha1 = NULL;
+    void *sha256 = NULL;
+    char *test = "the quick and lazy fox did his thang";
+    char computed_hash[320];
+    uint8_t hash[MZ_HASH_SHA1_SIZE];
+    uint8_t hash256[MZ_HASH_SHA256_SIZE];
+
+    printf("Sha hash input - %s\n", test);
+
+    memset(hash, 0, sizeof(hash));
+
+    mz_crypt_sha_create(&sha1);
+    mz_crypt_sha_set_algorithm(sha1, MZ_HASH_SHA1);
+    mz_crypt_sha_begin(sha1);
+    mz_crypt_sha_update(sha1, test, (int32_t)strlen(test));
+    mz_crypt_sha_end(sha1, hash, sizeof(hash));
+    mz_crypt_sha_delete(&sha1);
+
+    convert_buffer_to_hex_string(hash, sizeof(hash), computed_hash, sizeof(computed_hash));
+
+    printf("Sha1 hash computed - %s\n", computed_hash);
+    printf("Sha1 hash expected - 3efb8392b6cd8e14bd76bd08081521dc73df418c\n");
+
+    if (strcmp(computed_hash, "3efb8392b6cd8e14bd76bd08081521dc73df418c") != 0)
+        return MZ_HASH_ERROR;
+
+    memset(hash256, 0, sizeof(hash256));
+
+    mz_crypt_sha_create(&sha256);
+    mz_crypt_sha_set_algorithm(sha256, MZ_HASH_SHA256);
+    mz_crypt_sha_begin(sha256);
+    mz_crypt_sha_update(sha256, test, (int32_t)strlen(test));
+    mz_crypt_sha_end(sha256, hash256, sizeof(hash256));
+    mz_crypt_sha_delete(&sha256);
+
+    convert_buffer_to_hex_string(hash256, sizeof(hash256), computed_hash, sizeof(computed_hash));
+
+    printf("Sha256 hash computed - %s\n", computed_hash);
+    printf("Sha256 hash expected - 7a31ea0848525f7ebfeec9ee532bcc5d6d26772427e097b86cf440a56546541c\n");
+
+    if (strcmp(computed_hash, "7a31ea0848525f7ebfeec9ee532bcc5d6d26772427e097b86cf440a56546541c") != 0)
+        return MZ_HASH_ERROR;
+
+    printf("Sha.. OK\n");
+    return MZ_OK;
+}
+
+int test_crypt_aes(void)
+{
+    void *aes = NULL;
+    char *key = "awesomekeythisis";
+    char *test = "youknowitsogrowi";
+    char computed_hash[320];
+    int32_t key_length = 0;
+    int32_t test_length = 0;
+    uint8_t buf[120];
+    uint8_t hash[MZ_HASH_SHA256_SIZE];
+
+    printf("Aes key - %s\n", key);
+    printf("Aes input - %s\n", test);
+
+    memset(hash, 0, sizeof(hash));
+
+    key_length = (int32_t)strlen(key);
+    test_length = (int32_t)strlen(test);
+
+    strncpy((char *)buf, test, sizeof(buf));
+
+    printf("Aes input hex\n");
+    convert_buffer_to_hex_string(buf, test_length, computed_hash, sizeof(computed_hash));
+    printf("%s\n", computed_hash);
+
+    mz_crypt_aes_create(&aes);
+    mz_crypt_aes_set_mode(aes, MZ_AES_ENCRYPTION_MODE_256);
+    mz_crypt_aes_set_encrypt_key(aes, key, key_length);
+    mz_crypt_aes_encrypt(aes, buf, test_length);
+    mz_crypt_aes_delete(&aes);
+
+    printf("Aes encrypted\n");
+    convert_buffer_to_hex_string(buf, test_length, computed_hash, sizeof(computed_hash));
+    printf("%s\n", computed_hash);
+
+    mz_crypt_aes_create(&aes);
+    mz_crypt_aes_set_mode(aes, MZ_AES_ENCRYPTION_MODE_256);
+    mz_crypt_aes_set_decrypt_key(aes, key, key_length);
+    mz_crypt_aes_decrypt(aes, buf, test_length);
+    mz_crypt_aes_delete(&aes);
+
+    printf("Aes decrypted\n");
+    convert_buffer_to_hex_string(buf, test_length, computed_hash, sizeof(computed_hash));
+    printf("%s\n", computed_hash);
+
+    if (strcmp((char *)buf, test) != 0)
+        return MZ_CRYPT_ERROR;
+
+    printf("Aes.. OK\n");
+    return MZ_OK;
+}
+
+int32_t test_crypt_hmac(void)
+{
+    void *hmac;
+    char *key = "hm123";
+    char *test = "12345678";
+    char computed_hash[320];
+    int32_t key_length = 0;
+    int32_t test_length = 0;
+    uint8_t hash[MZ_HASH_SHA1_SIZE];
+    uint8_t hash256[MZ_HASH_SHA256_SIZE];
+
+    key_length = (int32_t)strlen(key);
+    test_length = (int32_t)strlen(test);
+
+    printf("Hmac sha1 key - %s\n", key);
+    printf("Hmac sha1 input - %s\n", test);
+
+    mz_crypt_hmac_create(&hmac);
+    mz_crypt_hmac_set_algorithm(hmac, MZ_HASH_SHA1);
+    mz_crypt_hmac_init(hmac, key, key_length);
+    mz_crypt_hmac_update(hmac, test, test_length);
+    mz_crypt_hmac_end(hmac, hash, sizeof(hash));
+    mz_crypt_hmac_delete(&hmac);
+
+    printf("Hmac sha1 output hash hex\n");
+    convert_buffer_to_hex_string(hash, sizeof(hash), computed_hash, sizeof(computed_hash));
+    printf("%s\n", computed_hash);
+
+    printf("Hmac sha1 expected\n");
+    printf("c785a02ff303c886c304d9a4c06073dfe4c24aa9\n");
+
+    if (strcmp(computed_hash, "c785a02ff303c886c304d9a4c06073dfe4c24aa9") != 0)
+        return MZ_CRYPT_ERROR;
+
+    printf("Hmac sha256 key - %s\n", key);
+    printf("Hmac sha256 input - %s\n", test);
+
+    mz_crypt_hmac_create(&hmac);
+    mz_crypt_hmac_set_algorithm(hmac, MZ_HASH_SHA256);
+    mz_crypt_hmac_init(hmac, key, key_length);
+    mz_crypt_hmac_update(hmac, test, test_length);
+    mz_crypt_hmac_end(hmac, hash256, sizeof(hash256));
+    mz_crypt_hmac_delete(&hmac);
+
+    printf("Hmac sha256 output hash hex\n");
+    convert_buffer_to_hex_string(hash256, sizeof(hash256), computed_hash, sizeof(computed_hash));
+    printf("%s\n", computed_hash);
+
+    printf("Hmac sha256 expected\n");
+    printf("fb22a9c715a47a06bad4f6cee9badc31c921562f5d6b24adf2be009f73181f7a\n");
+
+    if (strcmp(computed_hash, "fb22a9c715a47a06bad4f6cee9badc31c921562f5d6b24adf2be009f73181f7a") != 0)
+        return MZ_CRYPT_ERROR;
+
+    printf("Hmac.. OK\n");
+    return MZ_OK;
+}
+#endif
+
+
+/***************************************************************************/
+
+int main(int argc, const char *argv[])
+{
+    int32_t err = MZ_OK;
+
+    MZ_UNUSED(argc);
+    MZ_UNUSED(argv);
+
+    err |= test_path_resolve();
+    err |= test_path_glob();
+    err |= test_utf8();
+    err |= test_stream_find();
+    err |= test_stream_find_reverse();
+    err |= test_stream_buffered();
+    err |= test_stream_os_hints();
+    err |= test_crypt_crc32();
+#if !defined(MZ_ZIP_NO_COMPRESSION) && !defined(MZ_ZIP_NO_DECOMPRESSION)
+    err |= test_stream_writev();
+    err |= test_zip_locate();
+    err |= test_zip_entry_table();
+    err |= test_zip_index_file();
+    err |= test_zip_cd_paged();
+    err |= test_zip_open_tail();
+    err |= test_zip_prefix();
+    err |= test_zip_prefix_children();
+    err |= test_zip_path_check();
+    err |= test_zip_entry_read_stream();
+#ifdef HAVE_PTHREAD
+    err |= test_zip_entry_read_threads();
+#endif
+    err |= test_zip_entry_copy();
+    err |= test_zip_writer_direct();
+#ifdef HAVE_MMAP
+    err |= test_stream_mmap();
+#endif
+#ifdef HAVE_URING
+    err |= test_stream_uring();
+#endif
+#ifdef HAVE_PTHREAD
+    err |= test_stream_readahead();
+#endif
+#endif
+#if !defined(MZ_ZIP_NO_COMPRESSION) && !defined(MZ_ZIP_NO_DECOMPRESSION)
+#ifdef HAVE_BZIP2
+    err |= test_stream_bzip();
+#endif
+#ifdef HAVE_ZLIB
+    err |= test_stream_zlib();
+    err |= test_stream_zlib_mem();
+    err |= test_stream_zlib_threads();
+    err |= test_zip_codec_reuse();
+    err |= test_zip_buffer_oneshot();
+#endif
+#ifdef HAVE_ZSTD
+    err |= test_stream_zstd();
+#endif
+#endif
+#if !defined(MZ_ZIP_NO_ENCRYPTION)
+#ifdef HAVE_PKCRYPT
+    err |= test_stream_pkcrypt();
+#endif
+#ifdef HAVE_WZAES
+    err |= test_stream_wzaes();
+#endif
+    err |= test_crypt_sha();
+    err |= test_crypt_aes();
+    err |= test_crypt_hmac();
+#endif
+    return err;
+}
+
+/***************************************************************************/
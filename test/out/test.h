@@ -0,0 +1,52 @@
+#ifndef _MZ_TEST_H
+#define _MZ_TEST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/***************************************************************************/
+
+int32_t test_stream_bzip(void);
+int32_t test_stream_pkcrypt(void);
+int32_t test_stream_wzaes(void);
+int32_t test_stream_zlib(void);
+int32_t test_stream_zlib_mem(void);
+int32_t test_stream_zlib_threads(void);
+int32_t test_stream_zstd(void);
+int32_t test_stream_find(void);
+int32_t test_stream_find_reverse(void);
+int32_t test_stream_buffered(void);
+int32_t test_stream_os_hints(void);
+int32_t test_stream_writev(void);
+int32_t test_stream_mmap(void);
+int32_t test_stream_uring(void);
+int32_t test_stream_readahead(void);
+
+int32_t test_zip_locate(void);
+int32_t test_zip_entry_table(void);
+int32_t test_zip_index_file(void);
+int32_t test_zip_cd_paged(void);
+int32_t test_zip_open_tail(void);
+int32_t test_zip_prefix(void);
+int32_t test_zip_prefix_children(void);
+int32_t test_zip_path_check(void);
+int32_t test_zip_entry_read_stream(void);
+int32_t test_zip_entry_read_threads(void);
+int32_t test_zip_entry_copy(void);
+int32_t test_zip_writer_direct(void);
+int32_t test_zip_codec_reuse(void);
+int32_t test_zip_buffer_oneshot(void);
+
+int32_t test_crypt_crc32(void);
+int32_t test_crypt_sha(void);
+int32_t test_crypt_aes(void);
+int32_t test_crypt_hmac(void);
+
+/***************************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif